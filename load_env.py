@@ -14,6 +14,5 @@ try:
             value = value.strip().strip('"').strip("'")
             env.Append(CPPDEFINES=[(key, env.StringifyMacro(value))])
 except FileNotFoundError:
-    print("ERROR: .env file not found!")
-    print("Copy .env.example to .env and fill in your credentials")
-    env.Exit(1)
+    print("WARNING: .env file not found - building without default credentials")
+    print("Provision them over the serial settings console, or copy .env.example to .env")
@@ -0,0 +1,21 @@
+#ifndef ARENA_JSON_H
+#define ARENA_JSON_H
+
+#include <ArduinoJson.h>
+#include "wake_arena.h"
+
+// ArduinoJson memory from the wake arena. A document using it must be
+// gone before the arena is released past the point it was created at.
+class ArenaJsonAllocator : public Allocator {
+public:
+    void* allocate(size_t size) override { return arenaAlloc(size); }
+    void deallocate(void* ptr) override { arenaFree(ptr); }
+    void* reallocate(void* ptr, size_t size) override { return arenaRealloc(ptr, size); }
+
+    static ArenaJsonAllocator* instance() {
+        static ArenaJsonAllocator allocator;
+        return &allocator;
+    }
+};
+
+#endif // ARENA_JSON_H
@@ -0,0 +1,58 @@
+#include "board.h"
+#include "config.h"
+#include "wake_metrics.h"
+#include <M5Unified.h>
+
+static bool boardStarted = false;
+
+const char* bootProfileName(BootProfile profile) {
+    switch (profile) {
+        case BootProfile::ClockTick: return "clock tick";
+        case BootProfile::Update: return "update";
+        case BootProfile::Interactive: return "interactive";
+        default: return "none";
+    }
+}
+
+void boardBeginSerial(BootProfile profile) {
+    Serial.begin(115200);
+    if (profile != BootProfile::Interactive) return;
+
+    unsigned long start = millis();
+    while (!Serial && millis() - start < SERIAL_READY_TIMEOUT_MS) {
+        delay(10);
+    }
+}
+
+void boardBegin(BootProfile profile) {
+    if (boardStarted) return;
+    boardStarted = true;
+
+    auto cfg = M5.config();
+    cfg.serial_baudrate = 0;    // Already open, see boardBeginSerial
+    cfg.clear_display = false;  // Keep the last frame; no refresh on boot
+    cfg.internal_imu = false;
+    cfg.internal_rtc = false;   // The system clock keeps time through deep sleep
+    cfg.internal_spk = false;
+    cfg.internal_mic = false;
+    cfg.external_imu = false;
+    cfg.external_rtc = false;
+    cfg.external_spk = false;
+    cfg.external_display.module_display = false;
+    cfg.external_display.atom_display = false;
+    cfg.external_display.unit_glass = false;
+    cfg.external_display.module_rca = false;
+    cfg.external_display.unit_oled = false;
+    cfg.external_display.unit_lcd = false;
+    cfg.external_display.unit_rca = false;
+    cfg.led_brightness = 0;
+    M5.begin(cfg);
+    Serial.printf("Board up in %lu ms (%s)\n", millis(), bootProfileName(profile));
+}
+
+void boardMarkWork(BootProfile profile) {
+    WakeMetrics& metrics = wakeMetrics();
+    if (metrics.bootProfile != BootProfile::None) return;
+    metrics.bootProfile = profile;
+    metrics.firstWorkMs = millis();
+}
@@ -0,0 +1,29 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stdint.h>
+
+// Hardware bring-up per wake path. A default M5.begin() probes every
+// peripheral the board might have; each wake path starts only what it
+// draws on, and only once it is about to draw.
+enum class BootProfile : uint8_t {
+    None = 0,
+    ClockTick,    // Panel only, without M5Unified (header clock refresh)
+    Update,       // Timer wake: panel, power and touch; no IMU, RTC chip, audio or LED
+    Interactive,  // Power-on/reset: as Update, after waiting for the USB serial host
+};
+
+const char* bootProfileName(BootProfile profile);
+
+// Serial port, and for Interactive a bounded wait until the USB host has
+// opened it, so the settings console prompt is not lost
+void boardBeginSerial(BootProfile profile);
+
+// Start M5Unified trimmed to the profile; later calls do nothing. The
+// panel keeps its image.
+void boardBegin(BootProfile profile);
+
+// Record when this wake's first useful work starts (for the wake metrics)
+void boardMarkWork(BootProfile profile);
+
+#endif // BOARD_H
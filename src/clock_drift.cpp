@@ -0,0 +1,102 @@
+#include "clock_drift.h"
+#include <string.h>
+
+#define CLOCK_DRIFT_MAGIC 0x44524654  // "DRFT"
+
+// Shorter sleeps are dominated by the boot time the uptime does not see
+#define DRIFT_MIN_SLEEP_US (600LL * 1000000)
+
+// Anything beyond this is a clock step or a missed wake, not drift
+#define DRIFT_MAX_PPM 60000.0f
+
+#define DRIFT_UNCALIBRATED_MARGIN_SECONDS 30
+#define DRIFT_MIN_MARGIN_SECONDS 2
+
+// ROM and bootloader time before the uptime starts, counted for each
+// unsynced wake inside a span
+#define DRIFT_BOOT_US 300000LL
+
+// Assumed spread after the first sample (0.1 %)
+#define DRIFT_INITIAL_SPREAD_PPM 1000.0f
+
+static float absf(float v) {
+    return v < 0 ? -v : v;
+}
+
+void driftInit(ClockDrift& drift) {
+    if (drift.magic == CLOCK_DRIFT_MAGIC) return;
+    memset(&drift, 0, sizeof(drift));
+    drift.magic = CLOCK_DRIFT_MAGIC;
+}
+
+uint64_t driftTimerFor(const ClockDrift& drift, uint64_t sleepUs) {
+    if (drift.samples == 0) return sleepUs;
+    return (uint64_t)(sleepUs / (1.0 + drift.ppm * 1e-6));
+}
+
+uint32_t driftMarginSeconds(const ClockDrift& drift, uint32_t sleepSeconds) {
+    if (drift.samples < 2) return DRIFT_UNCALIBRATED_MARGIN_SECONDS;
+    float margin = DRIFT_MIN_MARGIN_SECONDS + 3.0f * drift.spreadPpm * 1e-6f * sleepSeconds;
+    if (margin > DRIFT_UNCALIBRATED_MARGIN_SECONDS) return DRIFT_UNCALIBRATED_MARGIN_SECONDS;
+    return (uint32_t)(margin + 0.5f);
+}
+
+static void setClockCorrection(ClockDrift& drift, uint64_t timerUs) {
+    drift.clockCorrectionUs = drift.samples ? (int64_t)(timerUs * (double)drift.ppm * 1e-6) : 0;
+}
+
+void driftRecordSleep(ClockDrift& drift, int64_t nowUs, uint64_t timerUs) {
+    driftInit(drift);
+    drift.sleepStartUs = nowUs;
+    drift.timerUs = timerUs;
+    drift.awakeUs = 0;
+    setClockCorrection(drift, timerUs);
+}
+
+void driftExtendSleep(ClockDrift& drift, int64_t uptimeUs, uint64_t timerUs) {
+    driftInit(drift);
+    if (drift.sleepStartUs != 0) {
+        drift.timerUs += timerUs;
+        drift.awakeUs += uptimeUs + DRIFT_BOOT_US;
+    }
+    setClockCorrection(drift, timerUs);
+}
+
+int64_t driftTakeClockCorrection(ClockDrift& drift) {
+    driftInit(drift);
+    int64_t us = drift.clockCorrectionUs;
+    drift.clockCorrectionUs = 0;
+    return us;
+}
+
+bool driftObserveWake(ClockDrift& drift, int64_t nowUs, int64_t uptimeUs, int32_t& wakeErrorMs) {
+    driftInit(drift);
+    int64_t startUs = drift.sleepStartUs;
+    uint64_t timerUs = drift.timerUs;
+    drift.sleepStartUs = 0;
+    if (startUs == 0 || timerUs < (uint64_t)DRIFT_MIN_SLEEP_US) return false;
+
+    // The boot ROM and bootloader run before the uptime starts, so this
+    // reads a few hundred ms long; harmless at hours of sleep
+    int64_t sleptUs = nowUs - uptimeUs - startUs - (int64_t)drift.awakeUs;
+    float sample = (float)((double)sleptUs / timerUs - 1.0) * 1e6f;
+    if (absf(sample) > DRIFT_MAX_PPM) return false;
+
+    // The timers were aimed using the estimate from before this sample
+    double aimedUs = timerUs * (1.0 + (drift.samples ? drift.ppm * 1e-6 : 0.0));
+    wakeErrorMs = (int32_t)((sleptUs - aimedUs) / 1000);
+
+    if (drift.samples == 0) {
+        drift.ppm = sample;
+        drift.spreadPpm = DRIFT_INITIAL_SPREAD_PPM;
+    } else {
+        float residual = absf(sample - drift.ppm);
+        drift.ppm += (sample - drift.ppm) / 4;
+        // Quick to widen, slow to narrow: a run of lucky samples must not
+        // shrink the margin below what the next one can be off by
+        float step = residual > drift.spreadPpm ? 2 : 8;
+        drift.spreadPpm += (residual - drift.spreadPpm) / step;
+    }
+    if (drift.samples < 255) drift.samples++;
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef CLOCK_DRIFT_H
+#define CLOCK_DRIFT_H
+
+#include <stdint.h>
+
+// Deep sleep is timed by the RTC slow clock, which runs fast or slow by up
+// to a few percent (minutes over a 6 h sleep). A wake whose clock is synced
+// compares the real time slept since the last synced sleep with the timer
+// values programmed since (wakes without a sync in between, like clock
+// ticks, only extend the span), and the learned error is applied to the
+// next timer and to the clock after each sleep. Kept in RTC memory across
+// deep sleep.
+struct ClockDrift {
+    uint32_t magic;
+    float ppm;                 // Sleep timer error, + = sleeps long
+    float spreadPpm;           // Deviation of recent samples from ppm
+    uint8_t samples;           // Samples taken (saturates)
+    int64_t sleepStartUs;      // UTC when the span began, 0 = none open
+    uint64_t timerUs;          // Timer values programmed in the span
+    uint64_t awakeUs;          // Time awake in the span's unsynced wakes
+    int64_t clockCorrectionUs; // To add to the clock after the current sleep
+};
+
+// Initialize the state if it is not valid (cold boot / corrupted RTC)
+void driftInit(ClockDrift& drift);
+
+// Timer value that makes a sleep last sleepUs of real time
+uint64_t driftTimerFor(const ClockDrift& drift, uint64_t sleepUs);
+
+// Seconds to wake after a target so the remaining timer error cannot make
+// the wake early: 30 s until calibrated, then three times the spread
+uint32_t driftMarginSeconds(const ClockDrift& drift, uint32_t sleepSeconds);
+
+// About to sleep with the clock synced (nowUs is UTC in microseconds):
+// start a new span
+void driftRecordSleep(ClockDrift& drift, int64_t nowUs, uint64_t timerUs);
+
+// About to sleep without a sync this wake: extend the open span, if any,
+// by this wake's uptime and the new timer
+void driftExtendSleep(ClockDrift& drift, int64_t uptimeUs, uint64_t timerUs);
+
+// The RTC clock advances by the timer value while asleep; this is the
+// learned difference to real time for the last sleep (read once per boot)
+int64_t driftTakeClockCorrection(ClockDrift& drift);
+
+// Clock synced again after a timer wake; uptimeUs is the time since boot.
+// Returns false if no sample was taken (no open span, too short to
+// measure, or an implausible result). wakeErrorMs is the real wake time
+// minus the one the timers were aimed at.
+bool driftObserveWake(ClockDrift& drift, int64_t nowUs, int64_t uptimeUs, int32_t& wakeErrorMs);
+
+#endif // CLOCK_DRIFT_H
@@ -1,20 +1,31 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-// WiFi Configuration (set in .env file)
+// Most values below are defaults for the runtime settings stored in NVS
+// (see settings.h); they can be changed over the USB serial console
+// without rebuilding.
+
+// WiFi Configuration (defaults from .env file, or provision over serial)
 #ifndef WIFI_SSID
-#error "WIFI_SSID not defined - create .env file from .env.example"
+#define WIFI_SSID ""
 #endif
 #ifndef WIFI_PASSWORD
-#error "WIFI_PASSWORD not defined - create .env file from .env.example"
+#define WIFI_PASSWORD ""
 #endif
-#define WIFI_TIMEOUT_MS 30000
 
-// OpenWeatherMap API Configuration (key set in .env file)
+// OpenWeatherMap API Configuration (key from .env file, or provision over serial)
 #ifndef OWM_API_KEY
-#error "OWM_API_KEY not defined - create .env file from .env.example"
+#define OWM_API_KEY ""
 #endif
 #define OWM_API_HOST "api.openweathermap.org"
+#define OWM_API_PORT 443
+
+// The resolver does not expose record TTLs, so cached API addresses are
+// trusted for this long (a failed connect re-resolves immediately)
+#define DNS_CACHE_TTL_SECONDS (12 * 3600)
+
+// Cached TLS sessions older than this are not offered for resumption
+#define TLS_SESSION_MAX_AGE_SECONDS (24 * 3600)
 
 // Location: Longmont, Colorado
 #define LOCATION_LAT 40.1672
@@ -31,6 +42,10 @@
 
 // Time Configuration
 #define NTP_SERVER "pool.ntp.org"
+// POSIX TZ rules for local time (see timezone.h). Leave empty to use the
+// offset the weather API reports for the location; the fixed offsets
+// below are only used until the first successful fetch.
+#define TIMEZONE "MST7MDT,M3.2.0,M11.1.0"  // Mountain Time with US DST
 #define GMT_OFFSET_SEC (-7 * 3600)  // Mountain Time (GMT-7)
 #define DAYLIGHT_OFFSET_SEC 0       // Adjust for DST if needed
 
@@ -40,6 +55,52 @@
 const int UPDATE_TIMES[] = {0, 6, 12, 18};
 #define NUM_UPDATE_TIMES 4
 
+// A wake this close before an update hour counts as that update
+#define WAKE_EARLY_TOLERANCE_SECONDS 600
+
+// Between updates, wake every this many minutes to redraw only the clock
+// in the header (partial refresh, no WiFi). 0 = off. Each tick is a wake
+// of about 0.65 s; every 15 minutes more than doubles the daily charge.
+#define CLOCK_TICK_MINUTES 0
+
+// Fetch new data on every Nth scheduled update (1 = every update). The
+// updates between rebuild the screen offline from the cached 5-day
+// forecast, unless the cache is older than the max age or covers fewer
+// slots (3 h each) ahead than the minimum. Current conditions ease from
+// the last observation into the forecast; an observation inside the
+// forecast's span keeps its difference from it, fading over the fade time.
+#define FETCH_EVERY_UPDATES 1
+#define ROLL_FORWARD_MAX_AGE_SECONDS (24 * 3600)
+#define ROLL_FORWARD_MIN_SLOTS 16
+#define ROLL_FORWARD_BIAS_FADE_SECONDS (6 * 3600)
+
+// Ask the API for the 5-day forecast only (1) instead of also the current
+// weather (0): one HTTPS request per fetch instead of two. Current
+// conditions then come from the nearest forecast slot, which can be up to
+// 3 hours ahead, and sunrise/sunset are computed on the device (solar.h).
+#define SINGLE_REQUEST 0
+
+// Every update wake is held to a time budget. Each phase may run until its
+// share of the budget, counted from the start of the update, is used up;
+// time a phase leaves unused carries over to the later ones. The shares
+// are for the default budget and scale with the configured one. A phase
+// that runs out of time ends the attempt; as after any failure that is
+// retried, the cached forecast is then rolled forward and shown, when there
+// is one, rather than an error. Render's share is kept free for that.
+#define WAKE_BUDGET_SECONDS 30
+#define WAKE_BUDGET_CONNECT_MS 10000  // WiFi association and DHCP
+#define WAKE_BUDGET_TIME_MS 8000      // NTP; only waited for when the clock is unset
+#define WAKE_BUDGET_FETCH_MS 8000     // DNS, TLS and the HTTP requests
+#define WAKE_BUDGET_PARSE_MS 1000
+#define WAKE_BUDGET_RENDER_MS 3000
+
+// CPU clock while an update wake waits for WiFi, SNTP or the panel (see
+// wake_events.h); 80 MHz is the lowest the WiFi driver runs at
+#define WAKE_WAIT_CPU_MHZ 80
+
+// Per-request HTTP timeout, further cut to the fetch phase's deadline
+#define HTTP_TIMEOUT_MS 15000
+
 // Error retry interval (5 minutes)
 #define ERROR_RETRY_SECONDS 300
 
@@ -47,4 +108,27 @@ const int UPDATE_TIMES[] = {0, 6, 12, 18};
 #define HOURLY_FORECAST_COUNT 5   // Number of hourly forecasts to show
 #define DAILY_FORECAST_COUNT 7    // Number of daily forecasts to show
 
+// Serial settings console (opened on power-on/reset, not on timer wakes)
+#define PROVISION_WINDOW_MS 3000   // Time to wait for the first command
+#define SERIAL_READY_TIMEOUT_MS 1000  // Wait for the USB host to open the port
+#define PROVISION_IDLE_MS 60000    // Console closes after this much inactivity
+
+// Per-wake scratch memory in PSRAM for requests, responses and parsed JSON
+// (see wake_arena.h). A forecast fetch peaks at about 40 KB.
+#define WAKE_ARENA_BYTES (128 * 1024)
+
+// Lowest memory an update wake may get down to (checked by the WAKE_MEM_PROBES
+// build, see mem_probe.h). A TLS connection needs a 16 KB record buffer in
+// one piece; the loop task has 8 KB of stack.
+#define MEM_BUDGET_INTERNAL_FREE (32 * 1024)
+#define MEM_BUDGET_INTERNAL_BLOCK (20 * 1024)
+#define MEM_BUDGET_STACK_FREE 1024
+
+// Last good weather data on LittleFS (see weather_snapshot.h)
+#define SNAPSHOT_PATH "/weather.snap"
+
+// Observation log segments on LittleFS (see observation_log.h)
+#define OBS_LOG_DIR "/obs"
+#define OBS_YESTERDAY_TOLERANCE_SECONDS (3 * 3600)
+
 #endif // CONFIG_H
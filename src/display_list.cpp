@@ -0,0 +1,350 @@
+#include "display_list.h"
+#include <string.h>
+
+// Serialized form: this header, then count items, then textUsed bytes
+#define DL_MAGIC 0x54534C44  // "DLST"
+#define DL_VERSION 2  // 2: moon phase moved from color to x1
+
+struct DlHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t itemSize;
+    uint16_t count;
+    uint16_t textUsed;
+};
+
+// Items this far apart in the two lists can still be matched after an
+// insertion or removal
+#define DL_DIFF_WINDOW 16
+
+static int16_t clamp16(int v) {
+    return v < -32768 ? -32768 : (v > 32767 ? 32767 : (int16_t)v);
+}
+
+static DlItem* append(DisplayList& list, DlOp op, uint16_t color) {
+    if (list.count >= DISPLAY_LIST_MAX_ITEMS) {
+        list.overflowed = true;
+        return nullptr;
+    }
+    DlItem* item = &list.items[list.count++];
+    memset(item, 0, sizeof(*item));
+    item->op = op;
+    item->color = color;
+    return item;
+}
+
+static void setPoints(DlItem* item, int x0, int y0, int x1, int y1) {
+    item->x0 = clamp16(x0);
+    item->y0 = clamp16(y0);
+    item->x1 = clamp16(x1);
+    item->y1 = clamp16(y1);
+}
+
+void dlClear(DisplayList& list) {
+    list.count = 0;
+    list.textUsed = 0;
+    list.overflowed = false;
+}
+
+void dlLine(DisplayList& list, int x0, int y0, int x1, int y1, uint16_t color) {
+    DlItem* item = append(list, DlOp::Line, color);
+    if (item) setPoints(item, x0, y0, x1, y1);
+}
+
+static void box(DisplayList& list, DlOp op, int x, int y, int w, int h, uint16_t color, int radius) {
+    if (w <= 0 || h <= 0) return;
+    DlItem* item = append(list, op, color);
+    if (!item) return;
+    setPoints(item, x, y, w, h);
+    item->r = (uint16_t)(radius > 0 ? radius : 0);
+}
+
+void dlRect(DisplayList& list, int x, int y, int w, int h, uint16_t color, int radius) {
+    box(list, DlOp::Rect, x, y, w, h, color, radius);
+}
+
+void dlFillRect(DisplayList& list, int x, int y, int w, int h, uint16_t color, int radius) {
+    box(list, DlOp::FillRect, x, y, w, h, color, radius);
+}
+
+void dlShade(DisplayList& list, int x, int y, int w, int h, uint8_t gray) {
+    if (w <= 0 || h <= 0) return;
+    DlItem* item = append(list, DlOp::Shade, 0);
+    if (!item) return;
+    setPoints(item, x, y, w, h);
+    item->style = gray;
+}
+
+static void circle(DisplayList& list, DlOp op, int cx, int cy, int r, uint16_t color) {
+    if (r < 0) return;
+    DlItem* item = append(list, op, color);
+    if (!item) return;
+    setPoints(item, cx, cy, 0, 0);
+    item->r = (uint16_t)r;
+}
+
+void dlCircle(DisplayList& list, int cx, int cy, int r, uint16_t color) {
+    circle(list, DlOp::Circle, cx, cy, r, color);
+}
+
+void dlFillCircle(DisplayList& list, int cx, int cy, int r, uint16_t color) {
+    circle(list, DlOp::FillCircle, cx, cy, r, color);
+}
+
+void dlFillTriangle(DisplayList& list, int x0, int y0, int x1, int y1, int x2, int y2, uint16_t color) {
+    DlItem* item = append(list, DlOp::FillTriangle, color);
+    if (!item) return;
+    setPoints(item, x0, y0, x1, y1);
+    item->x2 = clamp16(x2);
+    item->y2 = clamp16(y2);
+}
+
+void dlText(DisplayList& list, const char* text, int x, int y, DlAlign align, uint8_t font,
+            uint8_t size, int width, int height, uint16_t color) {
+    size_t len = strlen(text);
+    if (len == 0) return;
+    if (len + 1 > (size_t)(DISPLAY_LIST_TEXT_BYTES - list.textUsed)) {
+        list.overflowed = true;
+        return;
+    }
+    DlItem* item = append(list, DlOp::Text, color);
+    if (!item) return;
+    setPoints(item, x, y, width, height);
+    item->x2 = (int16_t)list.textUsed;
+    item->y2 = (int16_t)len;
+    item->style = font;
+    item->r = size;
+    item->arg = align;
+    memcpy(list.text + list.textUsed, text, len + 1);
+    list.textUsed += (uint16_t)(len + 1);
+}
+
+void dlIcon(DisplayList& list, int x, int y, int size, int weatherId, bool night, uint16_t moonPhase) {
+    DlItem* item = append(list, DlOp::Icon, 0);
+    if (!item) return;
+    setPoints(item, x, y, 0, 0);
+    item->x1 = (int16_t)moonPhase;
+    item->r = (uint16_t)size;
+    item->arg = (uint16_t)weatherId;
+    item->style = night ? 1 : 0;
+}
+
+const char* dlItemText(const DisplayList& list, const DlItem& item) {
+    return list.text + (uint16_t)item.x2;
+}
+
+static DlRect rectSpan(int left, int top, int right, int bottom) {
+    DlRect rect;
+    rect.x = clamp16(left);
+    rect.y = clamp16(top);
+    rect.w = clamp16(right - left + 1);
+    rect.h = clamp16(bottom - top + 1);
+    return rect;
+}
+
+static int min2(int a, int b) {
+    return a < b ? a : b;
+}
+
+static int max2(int a, int b) {
+    return a > b ? a : b;
+}
+
+static int min3(int a, int b, int c) {
+    return min2(min2(a, b), c);
+}
+
+static int max3(int a, int b, int c) {
+    return max2(max2(a, b), c);
+}
+
+DlRect dlItemBounds(const DlItem& item) {
+    switch (item.op) {
+    case DlOp::Line:
+        return rectSpan(min2(item.x0, item.x1), min2(item.y0, item.y1),
+                        max2(item.x0, item.x1), max2(item.y0, item.y1));
+    case DlOp::FillTriangle:
+        return rectSpan(min3(item.x0, item.x1, item.x2), min3(item.y0, item.y1, item.y2),
+                        max3(item.x0, item.x1, item.x2), max3(item.y0, item.y1, item.y2));
+    case DlOp::Circle:
+    case DlOp::FillCircle:
+        return rectSpan(item.x0 - item.r, item.y0 - item.r, item.x0 + item.r, item.y0 + item.r);
+    case DlOp::Text: {
+        int left = item.x0 - (item.arg % 3) * item.x1 / 2;
+        int top = item.y0 - (item.arg / 3) * item.y1 / 2;
+        return rectSpan(left, top, left + item.x1 - 1, top + item.y1 - 1);
+    }
+    case DlOp::Icon: {
+        int margin = item.r / 4;
+        return rectSpan(item.x0 - margin, item.y0 - margin,
+                        item.x0 + item.r + margin, item.y0 + item.r + margin);
+    }
+    default:  // Rect, FillRect, Shade
+        return rectSpan(item.x0, item.y0, item.x0 + item.x1 - 1, item.y0 + item.y1 - 1);
+    }
+}
+
+static bool sameItem(const DisplayList& a, const DlItem& x, const DisplayList& b, const DlItem& y) {
+    if (x.op != y.op) return false;
+    if (x.op != DlOp::Text) return memcmp(&x, &y, sizeof(x)) == 0;
+
+    // Same text at a different pool offset is the same item
+    DlItem xs = x;
+    DlItem ys = y;
+    xs.x2 = ys.x2 = 0;
+    return memcmp(&xs, &ys, sizeof(xs)) == 0 && strcmp(dlItemText(a, x), dlItemText(b, y)) == 0;
+}
+
+static bool touches(const DlRect& p, const DlRect& q) {
+    return p.x <= q.x + q.w && q.x <= p.x + p.w && p.y <= q.y + q.h && q.y <= p.y + p.h;
+}
+
+static DlRect unite(const DlRect& p, const DlRect& q) {
+    return rectSpan(min2(p.x, q.x), min2(p.y, q.y),
+                    max2(p.x + p.w, q.x + q.w) - 1, max2(p.y + p.h, q.y + q.h) - 1);
+}
+
+static long area(const DlRect& r) {
+    return (long)r.w * r.h;
+}
+
+static void addRegion(DlRect* regions, int& count, int maxRegions, DlRect rect) {
+    // Absorb every region the new one touches, then each that the grown
+    // one touches in turn
+    for (int i = 0; i < count;) {
+        if (touches(regions[i], rect)) {
+            rect = unite(regions[i], rect);
+            regions[i] = regions[--count];
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    if (count < maxRegions) {
+        regions[count++] = rect;
+        return;
+    }
+
+    // Full: grow the region that gains the least area, which may then
+    // reach others
+    int best = 0;
+    long bestGrowth = 0;
+    for (int i = 0; i < count; i++) {
+        DlRect grown = unite(regions[i], rect);
+        long growth = area(grown) - area(regions[i]);
+        if (i == 0 || growth < bestGrowth) {
+            best = i;
+            bestGrowth = growth;
+        }
+    }
+    rect = unite(regions[best], rect);
+    regions[best] = regions[--count];
+    addRegion(regions, count, maxRegions, rect);
+}
+
+int dlDiff(const DisplayList& a, const DisplayList& b, DlRect* regions, int maxRegions) {
+    int count = 0;
+    if (maxRegions <= 0) return 0;
+
+    int i = 0;
+    int j = 0;
+    while (i < a.count || j < b.count) {
+        if (i < a.count && j < b.count && sameItem(a, a.items[i], b, b.items[j])) {
+            i++;
+            j++;
+            continue;
+        }
+
+        // Nearest pair that matches again, trying the smallest total skip
+        // first; failing that, both items changed in place
+        int skipA = 1;
+        int skipB = 1;
+        bool found = false;
+        for (int total = 1; total <= DL_DIFF_WINDOW && !found; total++) {
+            for (int da = 0; da <= total; da++) {
+                int db = total - da;
+                if (i + da < a.count && j + db < b.count &&
+                    sameItem(a, a.items[i + da], b, b.items[j + db])) {
+                    skipA = da;
+                    skipB = db;
+                    found = true;
+                    break;
+                }
+            }
+        }
+        if (!found) {
+            skipA = i < a.count ? 1 : 0;
+            skipB = j < b.count ? 1 : 0;
+        }
+        for (int k = 0; k < skipA; k++) {
+            addRegion(regions, count, maxRegions, dlItemBounds(a.items[i + k]));
+        }
+        for (int k = 0; k < skipB; k++) {
+            addRegion(regions, count, maxRegions, dlItemBounds(b.items[j + k]));
+        }
+        i += skipA;
+        j += skipB;
+    }
+    return count;
+}
+
+size_t dlSerializedSize(const DisplayList& list) {
+    return sizeof(DlHeader) + list.count * sizeof(DlItem) + list.textUsed;
+}
+
+size_t dlSerialize(const DisplayList& list, void* out, size_t capacity) {
+    size_t size = dlSerializedSize(list);
+    if (size > capacity) return 0;
+
+    DlHeader header;
+    header.magic = DL_MAGIC;
+    header.version = DL_VERSION;
+    header.itemSize = sizeof(DlItem);
+    header.count = list.count;
+    header.textUsed = list.textUsed;
+
+    uint8_t* p = (uint8_t*)out;
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    memcpy(p, list.items, list.count * sizeof(DlItem));
+    p += list.count * sizeof(DlItem);
+    memcpy(p, list.text, list.textUsed);
+    return size;
+}
+
+bool dlDeserialize(const void* data, size_t length, DisplayList& list) {
+    DlHeader header;
+    if (length < sizeof(header)) return false;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != DL_MAGIC || header.version != DL_VERSION ||
+        header.itemSize != sizeof(DlItem) || header.count > DISPLAY_LIST_MAX_ITEMS ||
+        header.textUsed > DISPLAY_LIST_TEXT_BYTES ||
+        length != sizeof(header) + header.count * sizeof(DlItem) + header.textUsed) {
+        return false;
+    }
+
+    // Every op known and every text run inside the pool and terminated,
+    // checked in the input so a bad list leaves the caller's untouched
+    const uint8_t* items = (const uint8_t*)data + sizeof(header);
+    const char* text = (const char*)(items + header.count * sizeof(DlItem));
+    for (int i = 0; i < header.count; i++) {
+        DlItem item;
+        memcpy(&item, items + i * sizeof(DlItem), sizeof(item));
+        if ((uint8_t)item.op > (uint8_t)DlOp::Icon) return false;
+        if (item.op == DlOp::Text) {
+            uint16_t offset = (uint16_t)item.x2;
+            uint16_t len = (uint16_t)item.y2;
+            if (item.arg > DL_ALIGN_BR || offset + len >= header.textUsed ||
+                text[offset + len] != '\0') {
+                return false;
+            }
+        }
+    }
+
+    memcpy(list.items, items, header.count * sizeof(DlItem));
+    memcpy(list.text, text, header.textUsed);
+    list.count = header.count;
+    list.textUsed = header.textUsed;
+    list.overflowed = false;
+    return true;
+}
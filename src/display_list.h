@@ -0,0 +1,106 @@
+#ifndef DISPLAY_LIST_H
+#define DISPLAY_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// A frame kept as the drawing primitives that make it up instead of as
+// pixels. DisplayManager's render functions record into one and then play
+// it onto the canvas or the panel. Being a fixed-size plain struct, a list
+// can be compared with another to find the regions that changed without
+// rasterizing either, and stored (a few KB where a framebuffer takes
+// 260 KB) to be played back later, e.g. as fixed benchmark input.
+//
+// Items are drawn in order over a white screen. Coordinates are screen
+// pixels, colors RGB565 as M5GFX takes them. Plain C++: fonts and icons
+// are referred to by number and drawn by the player.
+#define DISPLAY_LIST_MAX_ITEMS 1024
+#define DISPLAY_LIST_TEXT_BYTES 1024
+
+// What each item's fields hold, by op
+enum class DlOp : uint8_t {
+    Line,          // (x0, y0) to (x1, y1)
+    Rect,          // Outline: top left (x0, y0), size (x1, y1), corner radius r
+    FillRect,
+    Circle,        // Outline: centre (x0, y0), radius r
+    FillCircle,
+    FillTriangle,  // Corners (x0, y0), (x1, y1), (x2, y2)
+    Shade,         // Dithered gray: top left (x0, y0), size (x1, y1), style = level
+    Text,          // Anchor (x0, y0), arg = DlAlign, measured size (x1, y1),
+                   // pool offset x2 and length y2, style = font, r = text size
+    Icon,          // Weather icon: top left (x0, y0), r = size, arg = condition
+                   // ID, style = 1 at night, x1 = moon phase in 1/65536 cycle
+                   // (as uint16_t; 0 unless a clear night), color unused
+};
+
+// Which point of its box a text run is anchored at: horizontal
+// (left, centre, right) + 3 * vertical (top, middle, bottom)
+enum DlAlign : uint8_t {
+    DL_ALIGN_TL, DL_ALIGN_TC, DL_ALIGN_TR,
+    DL_ALIGN_ML, DL_ALIGN_MC, DL_ALIGN_MR,
+    DL_ALIGN_BL, DL_ALIGN_BC, DL_ALIGN_BR,
+};
+
+struct DlItem {
+    DlOp op;
+    uint8_t style;
+    uint16_t color;
+    int16_t x0, y0;
+    int16_t x1, y1;
+    int16_t x2, y2;
+    uint16_t r;
+    uint16_t arg;
+};
+
+struct DisplayList {
+    uint16_t count;
+    uint16_t textUsed;
+    bool overflowed;  // Items or text were dropped for lack of room
+    DlItem items[DISPLAY_LIST_MAX_ITEMS];
+    char text[DISPLAY_LIST_TEXT_BYTES];
+};
+
+struct DlRect {
+    int16_t x, y, w, h;
+};
+
+void dlClear(DisplayList& list);
+
+void dlLine(DisplayList& list, int x0, int y0, int x1, int y1, uint16_t color);
+void dlRect(DisplayList& list, int x, int y, int w, int h, uint16_t color, int radius = 0);
+void dlFillRect(DisplayList& list, int x, int y, int w, int h, uint16_t color, int radius = 0);
+void dlCircle(DisplayList& list, int cx, int cy, int r, uint16_t color);
+void dlFillCircle(DisplayList& list, int cx, int cy, int r, uint16_t color);
+void dlFillTriangle(DisplayList& list, int x0, int y0, int x1, int y1, int x2, int y2, uint16_t color);
+void dlShade(DisplayList& list, int x, int y, int w, int h, uint8_t gray);
+
+// width and height are the run's size in its font, as measured by the
+// caller; the text is copied into the list
+void dlText(DisplayList& list, const char* text, int x, int y, DlAlign align, uint8_t font,
+            uint8_t size, int width, int height, uint16_t color);
+
+// moonPhase in 1/65536 cycle: 0 new, 32768 full (shown by clear night icons)
+void dlIcon(DisplayList& list, int x, int y, int size, int weatherId, bool night, uint16_t moonPhase);
+
+// Text of a Text item (NUL-terminated in the pool)
+const char* dlItemText(const DisplayList& list, const DlItem& item);
+
+// Pixels an item may touch. Icons get a margin of a quarter of their size.
+DlRect dlItemBounds(const DlItem& item);
+
+// Regions where frame b differs from frame a: the bounds of the items
+// that only one of them has, merged where they touch. Items are matched
+// in drawing order, resynchronising after up to 16 items were inserted
+// or removed. Returns the number of regions, at most maxRegions: past
+// that, each is merged into the one it grows least.
+int dlDiff(const DisplayList& a, const DisplayList& b, DlRect* regions, int maxRegions);
+
+// Compact form for storage: header, used items, used text. Size of that
+// form, writing it (returns bytes written, 0 if out is too small) and
+// reading it back (false if the data is not a valid list, which leaves
+// list as it was).
+size_t dlSerializedSize(const DisplayList& list);
+size_t dlSerialize(const DisplayList& list, void* out, size_t capacity);
+bool dlDeserialize(const void* data, size_t length, DisplayList& list);
+
+#endif // DISPLAY_LIST_H
@@ -1,18 +1,79 @@
 #include "display_manager.h"
 #include "config.h"
+#include "geometry.h"
+#include "dither.h"
+#include "settings.h"
+#include "solar.h"
+#include "timezone.h"
+#include "wake_metrics.h"
 #include <time.h>
 
 // Use actual display dimensions
 #define SCREEN_W 540
 #define SCREEN_H 960
 
+// Set once a weather frame has been refreshed onto the panel. E-ink keeps
+// the image through deep sleep, so later wakes can leave it in place.
+RTC_DATA_ATTR static bool weatherFrameShown = false;
+
+// Frames are recorded here, about 21 KB. Static so a frame can never be
+// lost to a failed allocation. EXT_RAM_ATTR puts it in PSRAM only when the
+// SDK is built with CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY, which the
+// prebuilt Arduino-ESP32 libraries of espressif32@6.4.0 leave unset; until
+// then it is internal RAM, so keep it from growing unnoticed.
+EXT_RAM_ATTR static DisplayList frameList;
+#if !CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY
+static_assert(sizeof(DisplayList) <= 22 * 1024,
+              "frameList is in internal RAM without CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY");
+#endif
+
+// Header clock position (top right) and its glyphs, captured from Font0 at
+// size 2 so clock tick wakes can draw the time without the font renderer
+#define CLOCK_RIGHT (SCREEN_W - 15)
+#define CLOCK_TOP 20
+#define CLOCK_GLYPH_W 12
+#define CLOCK_GLYPH_H 16
+#define CLOCK_GLYPH_BYTES ((CLOCK_GLYPH_W + 7) / 8)
+#define CLOCK_MAX_CHARS 8  // "12:59 PM"
+#define CLOCK_GLYPHS_MAGIC 0x434C4B47  // "CLKG"
+
+static const char CLOCK_CHARSET[] = "0123456789:AMP";
+
+struct ClockGlyphs {
+    uint32_t magic;
+    uint8_t bits[sizeof(CLOCK_CHARSET) - 1][CLOCK_GLYPH_H][CLOCK_GLYPH_BYTES];  // 1 = ink, MSB left
+};
+
+RTC_DATA_ATTR static ClockGlyphs clockGlyphs;
+
+// Fonts a frame may use, by the number its display list records
+enum { FONT_0, FONT_SANS_9, FONT_SANS_BOLD_9, FONT_SANS_BOLD_12, FONT_COUNT };
+static const lgfx::IFont* const FONTS[FONT_COUNT] = {
+    &fonts::Font0, &fonts::FreeSans9pt7b, &fonts::FreeSansBold9pt7b, &fonts::FreeSansBold12pt7b,
+};
+
+// Text datum for each DlAlign
+static const textdatum_t DATUMS[] = {
+    TL_DATUM, TC_DATUM, TR_DATUM, ML_DATUM, MC_DATUM, MR_DATUM, BL_DATUM, BC_DATUM, BR_DATUM,
+};
+
 DisplayManager::DisplayManager() {
     // Calculate section positions for 540x960 portrait
     headerY = 0;
     currentY = 65;           // After header
     hourlyY = 320;           // After current weather (reduced gap)
-    dailyY = 430;            // After hourly (moved up)
+    graphY = 430;            // After hourly
+    dailyY = graphY + GRAPH_HEIGHT;
     footerY = SCREEN_H - 40; // Bottom footer
+    moonPhase = 16384;  // First quarter until a forecast sets it
+
+    // Draw straight to the panel until begin() has set up the canvas
+    gfx = &M5.Display;
+    fb = framebufferWrap(nullptr, 0, 0);
+    list = &frameList;
+    penFont = FONT_0;
+    penSize = 2;
+    penAlign = DL_ALIGN_TL;
 }
 
 void DisplayManager::begin() {
@@ -27,11 +88,25 @@ void DisplayManager::begin() {
     M5.Display.setEpdMode(epd_mode_t::epd_quality);
     Serial.println("  EPD mode set to quality");
 
+    // Off-screen 4bpp canvas in PSRAM; the frame is pushed to the panel once
+    canvas.setColorDepth(4);
+    canvas.setPsram(true);
+    if (canvas.createSprite(SCREEN_W, SCREEN_H)) {
+        canvas.createPalette();  // Grayscale: 0 = black, 15 = white
+        gfx = &canvas;
+        fb = framebufferWrap(canvas.getBuffer(), SCREEN_W, SCREEN_H);
+        Serial.println("  Canvas allocated in PSRAM (4bpp)");
+    } else {
+        Serial.println("  Canvas allocation failed, drawing direct to panel");
+    }
+
+    dlClear(*list);
+
     // Set default text settings
-    M5.Display.setFont(&fonts::Font0);
-    M5.Display.setTextSize(2);
-    M5.Display.setTextColor(TFT_BLACK, TFT_WHITE);
-    M5.Display.setTextDatum(TL_DATUM);
+    gfx->setFont(&fonts::Font0);
+    gfx->setTextSize(2);
+    gfx->setTextColor(TFT_BLACK, TFT_WHITE);
+    gfx->setTextDatum(TL_DATUM);
     Serial.println("  Text settings configured");
 
     clear();
@@ -39,67 +114,188 @@ void DisplayManager::begin() {
 }
 
 void DisplayManager::clear() {
-    M5.Display.fillScreen(TFT_WHITE);
+    gfx->fillScreen(TFT_WHITE);
 }
 
 void DisplayManager::update() {
     Serial.println("  Pushing to e-ink display...");
-    M5.Display.display();
-    Serial.println("  Display update complete");
+    if (gfx == &canvas) {
+        // Single bulk transfer of the finished frame into the panel
+        canvas.pushSprite(&M5.Display, 0, 0);
+    }
+    M5.Display.display();  // Refreshes in the background (see wakeWaitDisplay)
+    wakeMetrics().epdFullRefreshes++;
+    Serial.println("  Display refresh started");
+}
+
+// Start recording a frame, with the pen as begin() left it
+void DisplayManager::beginFrame() {
+    dlClear(*list);
+    setFont(FONT_0);
+    setTextSize(2);
+    setAlign(DL_ALIGN_TL);
 }
 
 void DisplayManager::renderWeather(WeatherData& weather) {
-    clear();
+    beginFrame();
+    moonPhase = (uint16_t)(uint32_t)(solarMoonPhase(weather.current.timestamp) * 65536.0f);
 
     renderHeader();
-    renderCurrentWeather(weather.current);
-    renderHourlyForecast(weather.hourly, min(weather.hourlyCount, 5));
-    renderDailyForecast(weather.daily, min(weather.dailyCount, 7));
-    renderFooter();
-
+    renderCurrentWeather(weather.current, weather.trend);
+    const Settings& cfg = settings();
+    renderHourlyForecast(weather.hourly, min(weather.hourlyCount, (int)cfg.hourlyCount));
+    renderTrendGraph(weather.series);
+    renderDailyForecast(weather.daily, min(weather.dailyCount, (int)cfg.dailyCount));
+    renderFooter(weather);
+
+    play(*list);
     update();
+    weatherFrameShown = true;
 }
 
-void DisplayManager::renderError(const String& message) {
-    clear();
+void DisplayManager::renderError(const char* message, int32_t retrySeconds) {
+    beginFrame();
 
     int centerX = SCREEN_W / 2;
     int centerY = SCREEN_H / 2;
 
     // Decorative border
-    M5.Display.drawRoundRect(50, centerY - 100, SCREEN_W - 100, 200, 10, TFT_BLACK);
-    M5.Display.drawRoundRect(52, centerY - 98, SCREEN_W - 104, 196, 8, TFT_BLACK);
+    dlRect(*list, 50, centerY - 100, SCREEN_W - 100, 200, TFT_BLACK, 10);
+    dlRect(*list, 52, centerY - 98, SCREEN_W - 104, 196, TFT_BLACK, 8);
+
+    setAlign(DL_ALIGN_MC);
+    setFont(FONT_SANS_BOLD_9);
+    drawText("Error", centerX, centerY - 40);
+
+    setFont(FONT_0);
+    setTextSize(2);
+    StackText<64> text;
+    text << message;
+    fitWidth(text, SCREEN_W - 120);  // Inside the border
+    drawText(text.c_str(), centerX, centerY + 5);
+
+    StackText<32> retry;
+    retry << "Will retry in ";
+    if (retrySeconds >= 5400) {
+        retry << (int)((retrySeconds + 1800) / 3600) << " hours";
+    } else {
+        int retryMinutes = (retrySeconds + 59) / 60;
+        retry << retryMinutes << (retryMinutes == 1 ? " minute" : " minutes");
+    }
+    drawText(retry.c_str(), centerX, centerY + 40);
 
-    M5.Display.setTextDatum(MC_DATUM);
-    M5.Display.setFont(&fonts::FreeSansBold9pt7b);
-    M5.Display.drawString("Error", centerX, centerY - 40);
+    play(*list);
+    update();
+    weatherFrameShown = false;
+}
 
-    M5.Display.setFont(&fonts::Font0);
-    M5.Display.setTextSize(2);
-    M5.Display.drawString(message.c_str(), centerX, centerY + 5);
+void DisplayManager::prepareClockTick() {
+    if (clockGlyphs.magic == CLOCK_GLYPHS_MAGIC) return;
+
+    M5Canvas cell;
+    cell.setColorDepth(1);
+    if (!cell.createSprite(CLOCK_GLYPH_W, CLOCK_GLYPH_H)) return;
+    cell.setFont(&fonts::Font0);
+    cell.setTextSize(2);
+    cell.setTextColor(TFT_BLACK, TFT_WHITE);
+    cell.setTextDatum(TL_DATUM);
+
+    memset(clockGlyphs.bits, 0, sizeof(clockGlyphs.bits));
+    for (int g = 0; CLOCK_CHARSET[g]; g++) {
+        cell.fillSprite(TFT_WHITE);
+        cell.drawChar(CLOCK_CHARSET[g], 0, 0);
+        for (int y = 0; y < CLOCK_GLYPH_H; y++) {
+            for (int x = 0; x < CLOCK_GLYPH_W; x++) {
+                if (cell.readPixelValue(x, y) == 0) {
+                    clockGlyphs.bits[g][y][x / 8] |= 0x80 >> (x % 8);
+                }
+            }
+        }
+    }
+    cell.deleteSprite();
+    clockGlyphs.magic = CLOCK_GLYPHS_MAGIC;
+}
 
-    M5.Display.drawString("Will retry in 5 minutes", centerX, centerY + 40);
+bool DisplayManager::renderClockTick(time_t now) {
+    if (!weatherFrameShown || clockGlyphs.magic != CLOCK_GLYPHS_MAGIC) return false;
+
+    // Same text as the header's clock, composed into one 1bpp strip
+    StackText<CLOCK_MAX_CHARS + 1> text;
+    addTime(text, now);
+
+    // Right-aligned in a strip as wide as the longest time
+    static const int STRIP_W = CLOCK_MAX_CHARS * CLOCK_GLYPH_W;
+    uint8_t strip[CLOCK_GLYPH_H][STRIP_W / 8];
+    memset(strip, 0, sizeof(strip));
+    int len = text.length();
+    for (int i = 0; i < len; i++) {
+        char c = text.c_str()[i];
+        const char* found = strchr(CLOCK_CHARSET, c);
+        if (c == ' ' || !found) continue;
+        int g = found - CLOCK_CHARSET;
+        int left = (CLOCK_MAX_CHARS - len + i) * CLOCK_GLYPH_W;
+        for (int y = 0; y < CLOCK_GLYPH_H; y++) {
+            for (int x = 0; x < CLOCK_GLYPH_W; x++) {
+                if (clockGlyphs.bits[g][y][x / 8] & (0x80 >> (x % 8))) {
+                    strip[y][(left + x) / 8] |= 0x80 >> ((left + x) % 8);
+                }
+            }
+        }
+    }
 
-    M5.Display.setTextDatum(TL_DATUM);
-    update();
+    // Keep the panel image: no reset, no clear
+    M5.Display.init_without_reset();
+    M5.Display.setRotation(DISPLAY_ROTATION);
+
+    int stripX = CLOCK_RIGHT - STRIP_W;
+    M5.Display.startWrite();
+    M5.Display.fillRect(stripX, CLOCK_TOP, STRIP_W, CLOCK_GLYPH_H, TFT_WHITE);
+    M5.Display.drawBitmap(stripX, CLOCK_TOP, &strip[0][0], STRIP_W, CLOCK_GLYPH_H, TFT_BLACK);
+    M5.Display.endWrite();
+
+    M5.Display.setEpdMode(epd_mode_t::epd_text);
+    M5.Display.display(stripX, CLOCK_TOP, STRIP_W, CLOCK_GLYPH_H);
+    wakeMetrics().epdPartialRefreshes++;
+    return true;
 }
 
-void DisplayManager::renderStatus(const String& message) {
-    clear();
+void DisplayManager::renderProgress(int step, int total, const char* label) {
+    Serial.printf("Progress %d/%d: %s\n", step, total, label);
 
-    int centerX = SCREEN_W / 2;
-    int centerY = SCREEN_H / 2;
+    // Keep the cached weather frame on screen: no refresh at all
+    if (weatherFrameShown) return;
+
+    int x = SCREEN_W - PROGRESS_W - 10;
+    int y = SCREEN_H - PROGRESS_H - 6;
 
-    // Decorative elements
-    M5.Display.drawLine(centerX - 100, centerY - 25, centerX + 100, centerY - 25, TFT_BLACK);
-    M5.Display.drawLine(centerX - 80, centerY + 25, centerX + 80, centerY + 25, TFT_BLACK);
+    // Draw straight onto the panel; only this corner gets refreshed
+    M5.Display.startWrite();
+    M5.Display.fillRect(x, y, PROGRESS_W, PROGRESS_H, TFT_WHITE);
+    M5.Display.drawRect(x, y, PROGRESS_W, PROGRESS_H, TFT_BLACK);
 
-    M5.Display.setTextDatum(MC_DATUM);
-    M5.Display.setFont(&fonts::FreeSansBold9pt7b);
-    M5.Display.drawString(message.c_str(), centerX, centerY);
+    M5.Display.setFont(&fonts::Font0);
+    M5.Display.setTextSize(1);
+    M5.Display.setTextDatum(ML_DATUM);
+    M5.Display.drawString(label, x + 6, y + PROGRESS_H / 2);
     M5.Display.setTextDatum(TL_DATUM);
 
-    update();
+    // One segment per step
+    int segX = x + PROGRESS_W - 66;
+    int segW = (60 - (total - 1) * 3) / total;
+    for (int i = 0; i < total; i++) {
+        int sx = segX + i * (segW + 3);
+        if (i < step) {
+            M5.Display.fillRect(sx, y + 9, segW, PROGRESS_H - 18, TFT_BLACK);
+        } else {
+            M5.Display.drawRect(sx, y + 9, segW, PROGRESS_H - 18, TFT_BLACK);
+        }
+    }
+    M5.Display.endWrite();
+
+    M5.Display.setEpdMode(epd_mode_t::epd_fastest);
+    M5.Display.display(x, y, PROGRESS_W, PROGRESS_H);
+    M5.Display.setEpdMode(epd_mode_t::epd_quality);
+    wakeMetrics().epdPartialRefreshes++;
 }
 
 void DisplayManager::renderHeader() {
@@ -111,90 +307,110 @@ void DisplayManager::renderHeader() {
     int batY = 18;
 
     // Rounded battery outline
-    M5.Display.drawRoundRect(batX, batY, 44, 22, 3, TFT_BLACK);
-    M5.Display.drawRoundRect(batX + 1, batY + 1, 42, 20, 2, TFT_BLACK);
-    M5.Display.fillRoundRect(batX + 44, batY + 6, 6, 10, 2, TFT_BLACK);
+    dlRect(*list, batX, batY, 44, 22, TFT_BLACK, 3);
+    dlRect(*list, batX + 1, batY + 1, 42, 20, TFT_BLACK, 2);
+    dlFillRect(*list, batX + 44, batY + 6, 6, 10, TFT_BLACK, 2);
 
     // Fill based on battery level
     int fillWidth = (batteryLevel * 38) / 100;
     if (fillWidth > 0) {
-        M5.Display.fillRoundRect(batX + 3, batY + 3, fillWidth, 16, 2, TFT_BLACK);
+        dlFillRect(*list, batX + 3, batY + 3, fillWidth, 16, TFT_BLACK, 2);
     }
 
     // Battery percentage
-    M5.Display.setFont(&fonts::Font0);
-    M5.Display.setTextSize(2);
-    M5.Display.drawString(String(batteryLevel) + "%", batX + 52, batY + 3);
+    setFont(FONT_0);
+    setTextSize(2);
+    StackText<8> percent;
+    percent << batteryLevel << '%';
+    drawText(percent.c_str(), batX + 52, batY + 3);
 
     // Location name (center)
-    M5.Display.setTextDatum(TC_DATUM);
-    M5.Display.setFont(&fonts::FreeSansBold9pt7b);
-    M5.Display.drawString(LOCATION_NAME, SCREEN_W / 2, 18);
+    setAlign(DL_ALIGN_TC);
+    setFont(FONT_SANS_BOLD_9);
+    drawText(settings().locationName, SCREEN_W / 2, 18);
 
     // Current time (right side)
     time_t now;
     time(&now);
-    String timeStr = formatTime(now);
-    M5.Display.setFont(&fonts::Font0);
-    M5.Display.setTextSize(2);
-    M5.Display.setTextDatum(TR_DATUM);
-    M5.Display.drawString(timeStr.c_str(), SCREEN_W - 15, 20);
-    M5.Display.setTextDatum(TL_DATUM);
+    StackText<CLOCK_MAX_CHARS + 1> timeStr;
+    addTime(timeStr, now);
+    setFont(FONT_0);
+    setTextSize(2);
+    setAlign(DL_ALIGN_TR);
+    drawText(timeStr.c_str(), CLOCK_RIGHT, CLOCK_TOP);
+    setAlign(DL_ALIGN_TL);
 
     // Decorative double line separator
-    M5.Display.drawLine(30, 55, SCREEN_W - 30, 55, TFT_BLACK);
-    M5.Display.drawLine(60, 60, SCREEN_W - 60, 60, TFT_BLACK);
+    dlLine(*list, 30, 55, SCREEN_W - 30, 55, TFT_BLACK);
+    dlLine(*list, 60, 60, SCREEN_W - 60, 60, TFT_BLACK);
 }
 
-void DisplayManager::renderCurrentWeather(CurrentWeather& current) {
+void DisplayManager::renderCurrentWeather(CurrentWeather& current, const ObservationTrend& trend) {
     int rightX = SCREEN_W * 2 / 3;  // Shift weather to right side
     int y = currentY + 10;
 
     // "Salo Weather" label on left side
-    M5.Display.setFont(&fonts::FreeSans9pt7b);
-    M5.Display.setTextDatum(TL_DATUM);
-    M5.Display.drawString("Salo", 20, currentY + 45);
-    M5.Display.drawString("Weather", 20, currentY + 80);
+    setFont(FONT_SANS_9);
+    setAlign(DL_ALIGN_TL);
+    drawText("Salo", 20, currentY + 45);
+    drawText("Weather", 20, currentY + 80);
+
+    bool imperial = settingsImperial(settings());
+    const char* tempUnit = imperial ? "F" : "C";
+
+    // Local history under the label
+    setFont(FONT_0);
+    setTextSize(2);
+    if (trend.hasRange) {
+        StackText<24> range;
+        range << "24h " << roundDeci(trend.low24hDeci) << '-' << roundDeci(trend.high24hDeci) << tempUnit;
+        drawText(range.c_str(), 20, currentY + 120);
+    }
+    if (trend.hasYesterday) {
+        StackText<24> vs;
+        vs.addSigned(roundDeci(trend.vsYesterdayDeci)) << tempUnit << " vs yday";
+        drawText(vs.c_str(), 20, currentY + 142);
+    }
 
     // Weather icon (shifted right)
     int iconSize = 90;
-    drawWeatherIcon(rightX - iconSize / 2, y, iconSize, current.weatherId,
-                    isNightTime(current.timestamp, current.sunrise, current.sunset));
+    drawIcon(rightX - iconSize / 2, y, iconSize, current.weatherId,
+             isNightTime(current.timestamp, current.sunrise, current.sunset));
     y += iconSize + 15;
 
     // Temperature - modern font
-    M5.Display.setTextDatum(MC_DATUM);
-    M5.Display.setFont(&fonts::FreeSansBold12pt7b);
-    String tempStr = String((int)round(current.temp)) + "F";
-    M5.Display.drawString(tempStr.c_str(), rightX, y);
+    setAlign(DL_ALIGN_MC);
+    setFont(FONT_SANS_BOLD_12);
+    StackText<48> text;
+    text << roundDeci(current.tempDeci) << tempUnit;
+    drawText(text.c_str(), rightX, y);
     y += 32;
 
     // Description
-    M5.Display.setFont(&fonts::FreeSans9pt7b);
-    String desc = capitalizeFirst(current.description);
-    M5.Display.drawString(desc.c_str(), rightX, y);
+    setFont(FONT_SANS_9);
+    text.truncate(0);
+    text.addCapitalized(weatherDescription(current.weatherId));
+    fitWidth(text, 2 * (SCREEN_W - 10 - rightX));  // Centred on rightX
+    drawText(text.c_str(), rightX, y);
     y += 22;
 
     // Feels like
-    M5.Display.setFont(&fonts::Font0);
-    M5.Display.setTextSize(2);
-    String feels = "Feels like " + String((int)round(current.feelsLike)) + "F";
-    M5.Display.drawString(feels.c_str(), rightX, y);
+    setFont(FONT_0);
+    setTextSize(2);
+    text.truncate(0);
+    text << "Feels like " << roundDeci(current.feelsLikeDeci) << tempUnit;
+    drawText(text.c_str(), rightX, y);
     y += 18;
 
     // Humidity and Wind
-    String details = String(current.humidity) + "% humidity  " +
-                     String((int)round(current.windSpeed)) + " mph wind";
-    M5.Display.drawString(details.c_str(), rightX, y);
+    text.truncate(0);
+    text << current.humidity << "% humidity  " << roundDeci(current.windSpeedDeci)
+         << (imperial ? " mph wind" : " m/s wind");
+    drawText(text.c_str(), rightX, y);
 
-    M5.Display.setTextDatum(TL_DATUM);
+    setAlign(DL_ALIGN_TL);
 
-    // Elegant separator with diamond
-    int lineY = hourlyY - 12;
-    M5.Display.drawLine(50, lineY, SCREEN_W - 50, lineY, TFT_BLACK);
-    int diamondX = SCREEN_W / 2;
-    M5.Display.fillTriangle(diamondX, lineY - 5, diamondX - 5, lineY, diamondX, lineY + 5, TFT_BLACK);
-    M5.Display.fillTriangle(diamondX, lineY - 5, diamondX + 5, lineY, diamondX, lineY + 5, TFT_BLACK);
+    drawSeparator(hourlyY - 12);
 }
 
 void DisplayManager::renderHourlyForecast(HourlyForecast* hourly, int count) {
@@ -203,9 +419,9 @@ void DisplayManager::renderHourlyForecast(HourlyForecast* hourly, int count) {
     int y = hourlyY;
 
     // Section title
-    M5.Display.setFont(&fonts::Font0);
-    M5.Display.setTextSize(1);
-    M5.Display.drawString("HOURLY FORECAST", 20, y);
+    setFont(FONT_0);
+    setTextSize(1);
+    drawText("HOURLY FORECAST", 20, y);
     y += 15;
 
     // Target hours: 8am, noon, 4pm, 8pm, midnight
@@ -225,8 +441,9 @@ void DisplayManager::renderHourlyForecast(HourlyForecast* hourly, int count) {
         int bestDiff = 999;
 
         for (int i = 0; i < count; i++) {
-            struct tm* timeinfo = localtime(&hourly[i].timestamp);
-            int hour = timeinfo->tm_hour;
+            struct tm timeinfo;
+            tzLocalTime(hourly[i].timestamp, timeinfo);
+            int hour = timeinfo.tm_hour;
 
             // Calculate difference handling midnight wrap
             int diff;
@@ -244,30 +461,90 @@ void DisplayManager::renderHourlyForecast(HourlyForecast* hourly, int count) {
         }
 
         // Time label
-        M5.Display.setTextDatum(TC_DATUM);
-        M5.Display.setFont(&fonts::Font0);
-        M5.Display.setTextSize(2);
-        M5.Display.drawString(timeLabels[t], colX, y);
+        setAlign(DL_ALIGN_TC);
+        setFont(FONT_0);
+        setTextSize(2);
+        drawText(timeLabels[t], colX, y);
 
         // Weather icon and temp (allow up to 3 hour difference for 3-hour API intervals)
         if (bestMatch >= 0 && bestDiff <= 3) {
             int iconSize = 36;
-            drawWeatherIcon(colX - iconSize / 2, y + 18, iconSize, hourly[bestMatch].weatherId);
+            drawIcon(colX - iconSize / 2, y + 18, iconSize, hourly[bestMatch].weatherId);
 
-            M5.Display.setFont(&fonts::FreeSansBold9pt7b);
-            String temp = String((int)round(hourly[bestMatch].temp));
-            M5.Display.drawString(temp.c_str(), colX, y + 58);
+            setFont(FONT_SANS_BOLD_9);
+            StackText<8> temp;
+            temp << roundDeci(hourly[bestMatch].tempDeci);
+            drawText(temp.c_str(), colX, y + 58);
         }
     }
 
-    M5.Display.setTextDatum(TL_DATUM);
+    setAlign(DL_ALIGN_TL);
 
-    // Elegant separator with diamond
-    int lineY = dailyY - 12;
-    M5.Display.drawLine(50, lineY, SCREEN_W - 50, lineY, TFT_BLACK);
-    int diamondX = SCREEN_W / 2;
-    M5.Display.fillTriangle(diamondX, lineY - 5, diamondX - 5, lineY, diamondX, lineY + 5, TFT_BLACK);
-    M5.Display.fillTriangle(diamondX, lineY - 5, diamondX + 5, lineY, diamondX, lineY + 5, TFT_BLACK);
+    drawSeparator(graphY - 12);
+}
+
+void DisplayManager::renderTrendGraph(const ForecastSeries& series) {
+    if (series.count < 2) return;
+
+    int y = graphY;
+
+    // Section title
+    setFont(FONT_0);
+    setTextSize(1);
+    setAlign(DL_ALIGN_TL);
+    drawText("5-DAY TREND", 20, y);
+    y += 16;
+
+    // Plot area: temperature labels on the left, day labels underneath
+    int plotX = 60;
+    int plotW = SCREEN_W - plotX - 20;
+    int plotH = 76;
+
+    SeriesGraph graph;
+    seriesComputeGraph(series, plotX, y, plotW, plotH, graph);
+
+    // Precipitation bars (shaded), one per 3-hour slot
+    int barW = max(2, plotW / series.count - 2);
+    for (int i = 0; i < graph.count; i++) {
+        int barH = y + plotH - graph.barTop[i];
+        if (barH > 0) {
+            dlShade(*list, graph.x[i] - barW / 2, graph.barTop[i], barW, barH, 190);
+        }
+    }
+
+    // Baseline and local-midnight day ticks with labels
+    dlLine(*list, plotX, y + plotH, plotX + plotW, y + plotH, TFT_BLACK);
+    setAlign(DL_ALIGN_TC);
+    for (int i = 0; i < graph.count; i++) {
+        time_t ts = seriesTime(series, i);
+        struct tm timeinfo;
+        tzLocalTime(ts, timeinfo);
+        if (timeinfo.tm_hour < 3) {
+            dlLine(*list, graph.x[i], y, graph.x[i], y + plotH + 3, TFT_BLACK);
+            if (graph.x[i] + 30 < plotX + plotW) {
+                drawText(getDayName(ts), graph.x[i] + 24, y + plotH + 5);
+            }
+        }
+    }
+
+    // Temperature curve, 2 px thick
+    for (int i = 1; i < graph.count; i++) {
+        dlLine(*list, graph.x[i - 1], graph.y[i - 1], graph.x[i], graph.y[i], TFT_BLACK);
+        dlLine(*list, graph.x[i - 1], graph.y[i - 1] + 1, graph.x[i], graph.y[i] + 1, TFT_BLACK);
+    }
+
+    // High/low scale labels
+    StackText<8> scale;
+    setAlign(DL_ALIGN_TR);
+    scale << roundDeci(graph.maxDeci);
+    drawText(scale.c_str(), plotX - 6, y);
+    setAlign(DL_ALIGN_BR);
+    scale.truncate(0);
+    scale << roundDeci(graph.minDeci);
+    drawText(scale.c_str(), plotX - 6, y + plotH);
+    setAlign(DL_ALIGN_TL);
+
+    drawSeparator(dailyY - 12);
 }
 
 void DisplayManager::renderDailyForecast(DailyForecast* daily, int count) {
@@ -276,9 +553,9 @@ void DisplayManager::renderDailyForecast(DailyForecast* daily, int count) {
     int y = dailyY;
 
     // Section title
-    M5.Display.setFont(&fonts::Font0);
-    M5.Display.setTextSize(1);
-    M5.Display.drawString("EXTENDED FORECAST", 20, y);
+    setFont(FONT_0);
+    setTextSize(1);
+    drawText("EXTENDED FORECAST", 20, y);
     y += 18;
 
     // Calculate row height
@@ -289,63 +566,161 @@ void DisplayManager::renderDailyForecast(DailyForecast* daily, int count) {
         int rowY = y + i * rowHeight;
 
         // Day name (left) - larger font
-        M5.Display.setFont(&fonts::Font0);
-        M5.Display.setTextSize(3);
-        String dayName = getDayName(daily[i].timestamp);
-        M5.Display.drawString(dayName.c_str(), 15, rowY + 10);
+        setFont(FONT_0);
+        setTextSize(3);
+        drawText(getDayName(daily[i].timestamp), 15, rowY + 10);
 
         // Weather icon
         int iconSize = 40;
-        drawWeatherIcon(80, rowY, iconSize, daily[i].weatherId);
+        drawIcon(80, rowY, iconSize, daily[i].weatherId);
 
-        // Description (middle) - larger font
-        M5.Display.setFont(&fonts::Font0);
-        M5.Display.setTextSize(3);
-        String desc = capitalizeFirst(daily[i].description);
-        if (desc.length() > 18) {
-            desc = desc.substring(0, 16) + "..";
-        }
-        M5.Display.drawString(desc.c_str(), 130, rowY + 10);
+        // High/Low temps (right aligned), measured first: the description
+        // runs up to them or to the precipitation chance
+        setFont(FONT_0);
+        setTextSize(3);
+        StackText<16> temps;
+        temps << roundDeci(daily[i].tempMaxDeci) << '/' << roundDeci(daily[i].tempMinDeci);
+        bool showPop = daily[i].pop > 20;
+        int descRight = showPop ? 310 : SCREEN_W - 15 - gfx->textWidth(temps.c_str());
 
-        // Precipitation % (if significant)
-        if (daily[i].pop > 20) {
-            M5.Display.drawString(String(daily[i].pop) + "%", 310, rowY + 10);
+        // Description (middle) - larger font
+        StackText<48> desc;
+        desc.addCapitalized(weatherDescription(daily[i].weatherId));
+        fitWidth(desc, descRight - 12 - 130);
+        drawText(desc.c_str(), 130, rowY + 10);
+
+        // Precipitation % (if significant) with a shaded probability bar
+        if (showPop) {
+            StackText<8> pop;
+            pop << daily[i].pop << '%';
+            drawText(pop.c_str(), 310, rowY + 10);
+            dlRect(*list, 310, rowY + 38, 60, 6, TFT_BLACK);
+            dlShade(*list, 311, rowY + 39, daily[i].pop * 58 / 100, 4, 96);
         }
 
-        // High/Low temps (right aligned) - larger font
-        M5.Display.setFont(&fonts::Font0);
-        M5.Display.setTextSize(3);
-        String temps = String((int)round(daily[i].tempMax)) + "/" +
-                       String((int)round(daily[i].tempMin));
-        M5.Display.setTextDatum(TR_DATUM);
-        M5.Display.drawString(temps.c_str(), SCREEN_W - 15, rowY + 10);
-        M5.Display.setTextDatum(TL_DATUM);
+        setAlign(DL_ALIGN_TR);
+        drawText(temps.c_str(), SCREEN_W - 15, rowY + 10);
+        setAlign(DL_ALIGN_TL);
 
         // Elegant dotted row divider
         if (i < count - 1 && i < 6) {
             int dotY = rowY + rowHeight - 3;
             for (int dx = 40; dx < SCREEN_W - 40; dx += 8) {
-                M5.Display.fillCircle(dx, dotY, 1, TFT_BLACK);
+                dlFillCircle(*list, dx, dotY, 1, TFT_BLACK);
             }
         }
     }
 }
 
-void DisplayManager::renderFooter() {
+void DisplayManager::renderFooter(const WeatherData& weather) {
     // Decorative double line separator
-    M5.Display.drawLine(60, footerY, SCREEN_W - 60, footerY, TFT_BLACK);
-    M5.Display.drawLine(30, footerY + 5, SCREEN_W - 30, footerY + 5, TFT_BLACK);
+    dlLine(*list, 60, footerY, SCREEN_W - 60, footerY, TFT_BLACK);
+    dlLine(*list, 30, footerY + 5, SCREEN_W - 30, footerY + 5, TFT_BLACK);
 
     // Last update time (centered)
     time_t now;
     time(&now);
 
-    M5.Display.setFont(&fonts::Font0);
-    M5.Display.setTextSize(2);
-    M5.Display.setTextDatum(MC_DATUM);
-    String updateStr = "Updated " + formatDate(now) + " " + formatTime(now);
-    M5.Display.drawString(updateStr.c_str(), SCREEN_W / 2, footerY + 25);
-    M5.Display.setTextDatum(TL_DATUM);
+    setFont(FONT_0);
+    setTextSize(2);
+    setAlign(DL_ALIGN_MC);
+    StackText<48> updateStr;
+    updateStr << "Updated ";
+    addDate(updateStr, now);
+    updateStr << ' ';
+    addTime(updateStr, now);
+    if (weather.rolledForward) {
+        // Offline update: say how old the forecast behind it is
+        updateStr << " (data ";
+        addTime(updateStr, weather.fetchedAt);
+        updateStr << ')';
+    }
+    drawText(updateStr.c_str(), SCREEN_W / 2, footerY + 25);
+    setAlign(DL_ALIGN_TL);
+}
+
+// Elegant separator with diamond
+void DisplayManager::drawSeparator(int lineY) {
+    dlLine(*list, 50, lineY, SCREEN_W - 50, lineY, TFT_BLACK);
+    int diamondX = SCREEN_W / 2;
+    dlFillTriangle(*list, diamondX, lineY - 5, diamondX - 5, lineY, diamondX, lineY + 5, TFT_BLACK);
+    dlFillTriangle(*list, diamondX, lineY - 5, diamondX + 5, lineY, diamondX, lineY + 5, TFT_BLACK);
+}
+
+void DisplayManager::setFont(uint8_t font) {
+    penFont = font;
+    gfx->setFont(FONTS[font]);
+}
+
+void DisplayManager::setTextSize(uint8_t size) {
+    penSize = size;
+    gfx->setTextSize(size);
+}
+
+void DisplayManager::drawText(const char* text, int x, int y) {
+    dlText(*list, text, x, y, penAlign, penFont, penSize, gfx->textWidth(text), gfx->fontHeight(),
+           TFT_BLACK);
+}
+
+void DisplayManager::drawIcon(int x, int y, int size, int weatherId, bool isNight) {
+    // Only the clear night icon shows the phase; other icons stay equal
+    // from frame to frame without it
+    bool moon = isNight && weatherId == 800;
+    dlIcon(*list, x, y, size, weatherId, isNight, moon ? moonPhase : 0);
+}
+
+void DisplayManager::play(const DisplayList& frame) {
+    gfx->fillScreen(TFT_WHITE);
+    for (int i = 0; i < frame.count; i++) {
+        const DlItem& item = frame.items[i];
+        switch (item.op) {
+        case DlOp::Line:
+            gfx->drawLine(item.x0, item.y0, item.x1, item.y1, item.color);
+            break;
+        case DlOp::Rect:
+            if (item.r) {
+                gfx->drawRoundRect(item.x0, item.y0, item.x1, item.y1, item.r, item.color);
+            } else {
+                gfx->drawRect(item.x0, item.y0, item.x1, item.y1, item.color);
+            }
+            break;
+        case DlOp::FillRect:
+            if (item.r) {
+                gfx->fillRoundRect(item.x0, item.y0, item.x1, item.y1, item.r, item.color);
+            } else {
+                gfx->fillRect(item.x0, item.y0, item.x1, item.y1, item.color);
+            }
+            break;
+        case DlOp::Circle:
+            gfx->drawCircle(item.x0, item.y0, item.r, item.color);
+            break;
+        case DlOp::FillCircle:
+            if (item.color == TFT_BLACK || item.color == TFT_WHITE) {
+                fillDot(item.x0, item.y0, item.r, item.color);
+            } else {
+                gfx->fillCircle(item.x0, item.y0, item.r, item.color);
+            }
+            break;
+        case DlOp::FillTriangle:
+            gfx->fillTriangle(item.x0, item.y0, item.x1, item.y1, item.x2, item.y2, item.color);
+            break;
+        case DlOp::Shade:
+            shadeRect(item.x0, item.y0, item.x1, item.y1, item.style);
+            break;
+        case DlOp::Text:
+            if (item.style >= FONT_COUNT || item.arg > DL_ALIGN_BR) break;
+            gfx->setFont(FONTS[item.style]);
+            gfx->setTextSize(item.r);
+            gfx->setTextDatum(DATUMS[item.arg]);
+            gfx->setTextColor(item.color, TFT_WHITE);
+            gfx->drawString(dlItemText(frame, item), item.x0, item.y0);
+            break;
+        case DlOp::Icon:
+            moonPhase = (uint16_t)item.x1;
+            drawWeatherIcon(item.x0, item.y0, item.r, item.arg, item.style != 0);
+            break;
+        }
+    }
 }
 
 // Weather icon drawing functions
@@ -379,8 +754,8 @@ void DisplayManager::drawSunIcon(int x, int y, int size) {
     int r = size / 4;
 
     // Sun circle with gradient effect (concentric circles)
-    M5.Display.fillCircle(cx, cy, r, TFT_BLACK);
-    M5.Display.drawCircle(cx, cy, r + 2, TFT_BLACK);
+    gfx->fillCircle(cx, cy, r, TFT_BLACK);
+    gfx->drawCircle(cx, cy, r + 2, TFT_BLACK);
 
     // Elegant rays - alternating long and short
     int rayLenLong = size * 2 / 5;
@@ -388,17 +763,17 @@ void DisplayManager::drawSunIcon(int x, int y, int size) {
     int rayGap = r + 4;
 
     for (int i = 0; i < 12; i++) {
-        float angle = i * PI / 6;
+        // One ray every 30 degrees (angle step i)
         int rayLen = (i % 2 == 0) ? rayLenLong : rayLenShort;
-        int x1 = cx + cos(angle) * rayGap;
-        int y1 = cy + sin(angle) * rayGap;
-        int x2 = cx + cos(angle) * rayLen;
-        int y2 = cy + sin(angle) * rayLen;
+        int x1 = cx + geomCos(i, rayGap);
+        int y1 = cy + geomSin(i, rayGap);
+        int x2 = cx + geomCos(i, rayLen);
+        int y2 = cy + geomSin(i, rayLen);
 
         // Thicker rays for main directions
-        M5.Display.drawLine(x1, y1, x2, y2, TFT_BLACK);
+        gfx->drawLine(x1, y1, x2, y2, TFT_BLACK);
         if (i % 3 == 0) {
-            M5.Display.drawLine(x1 + 1, y1, x2 + 1, y2, TFT_BLACK);
+            gfx->drawLine(x1 + 1, y1, x2 + 1, y2, TFT_BLACK);
         }
     }
 }
@@ -408,9 +783,21 @@ void DisplayManager::drawMoonIcon(int x, int y, int size) {
     int cy = y + size / 2;
     int r = size / 3;
 
-    // Crescent moon with elegant curve
-    M5.Display.fillCircle(cx, cy, r, TFT_BLACK);
-    M5.Display.fillCircle(cx + r * 0.55, cy - r * 0.25, r * 0.82, TFT_WHITE);
+    // Moon in its current phase: each row is lit from the terminator (an
+    // ellipse of half-width w * cos(phase)) to the limb, on the right while
+    // waxing and on the left while waning
+    int32_t terminator = geomCosTurnQ14(moonPhase);
+    bool waxing = moonPhase < 32768;
+    for (int dy = -r; dy <= r; dy++) {
+        int edge, limb;
+        geomMoonRow(r, dy, terminator, edge, limb);
+        if (waxing) {
+            gfx->drawFastHLine(cx + edge, cy + dy, limb - edge + 1, TFT_BLACK);
+        } else {
+            gfx->drawFastHLine(cx - limb, cy + dy, limb - edge + 1, TFT_BLACK);
+        }
+    }
+    gfx->drawCircle(cx, cy, r, TFT_BLACK);
 
     // Add subtle stars around moon
     int starSize = max(2, size / 20);
@@ -429,25 +816,34 @@ void DisplayManager::drawCloudIcon(int x, int y, int size) {
 
     // Fluffy cloud with multiple bumps for more natural look
     // Bottom base
-    M5.Display.fillCircle(cx - r * 1.2, cy + r * 0.4, r * 0.9, TFT_BLACK);
-    M5.Display.fillCircle(cx + r * 1.2, cy + r * 0.4, r * 0.9, TFT_BLACK);
+    gfx->fillCircle(cx + geomScale(r, -12, 10), cy + geomScale(r, 4, 10), geomScale(r, 9, 10), TFT_BLACK);
+    gfx->fillCircle(cx + geomScale(r, 12, 10), cy + geomScale(r, 4, 10), geomScale(r, 9, 10), TFT_BLACK);
 
     // Middle bumps
-    M5.Display.fillCircle(cx - r * 0.5, cy - r * 0.2, r * 1.1, TFT_BLACK);
-    M5.Display.fillCircle(cx + r * 0.5, cy, r * 1.0, TFT_BLACK);
+    gfx->fillCircle(cx + geomScale(r, -5, 10), cy + geomScale(r, -2, 10), geomScale(r, 11, 10), TFT_BLACK);
+    gfx->fillCircle(cx + geomScale(r, 5, 10), cy, r, TFT_BLACK);
 
     // Top bump
-    M5.Display.fillCircle(cx, cy - r * 0.5, r * 1.2, TFT_BLACK);
+    gfx->fillCircle(cx, cy + geomScale(r, -5, 10), geomScale(r, 12, 10), TFT_BLACK);
 
     // Fill gaps
-    M5.Display.fillRect(cx - r * 1.2, cy + r * 0.3, r * 2.4, r * 0.8, TFT_BLACK);
+    gfx->fillRect(cx + geomScale(r, -12, 10), cy + geomScale(r, 3, 10),
+                  geomScale(r, 24, 10), geomScale(r, 8, 10), TFT_BLACK);
+
+    // Shade the silhouette light-to-dark from top to bottom
+    if (fb.buf != nullptr) {
+        int left = cx + geomScale(r, -21, 10);
+        int top = cy + geomScale(r, -17, 10);
+        ditherShadeLevel(fb, left, top, geomScale(r, 42, 10) + 1, geomScale(r, 30, 10) + 1,
+                         GRAY4_BLACK, 170, 70);
+    }
 
     // Outline for definition
-    M5.Display.drawCircle(cx, cy - r * 0.5, r * 1.2, TFT_BLACK);
+    gfx->drawCircle(cx, cy + geomScale(r, -5, 10), geomScale(r, 12, 10), TFT_BLACK);
 }
 
 void DisplayManager::drawRainIcon(int x, int y, int size) {
-    drawCloudIcon(x, y - size/6, size * 0.75);
+    drawCloudIcon(x, y - size/6, geomScale(size, 3, 4));
 
     // Elegant raindrops - teardrop shape
     int dropStartY = y + size / 2 - 5;
@@ -459,8 +855,8 @@ void DisplayManager::drawRainIcon(int x, int y, int size) {
         int dy = dropStartY + (i == 0 ? 0 : 5);  // Stagger drops
 
         // Teardrop shape
-        M5.Display.fillCircle(dx, dy + dropLen, size / 15 + 1, TFT_BLACK);
-        M5.Display.fillTriangle(
+        gfx->fillCircle(dx, dy + dropLen, size / 15 + 1, TFT_BLACK);
+        gfx->fillTriangle(
             dx, dy,
             dx - size / 15 - 1, dy + dropLen,
             dx + size / 15 + 1, dy + dropLen,
@@ -470,7 +866,7 @@ void DisplayManager::drawRainIcon(int x, int y, int size) {
 }
 
 void DisplayManager::drawSnowIcon(int x, int y, int size) {
-    drawCloudIcon(x, y - size/6, size * 0.75);
+    drawCloudIcon(x, y - size/6, geomScale(size, 3, 4));
 
     // Elegant snowflakes
     int flakeY = y + size / 2;
@@ -484,7 +880,7 @@ void DisplayManager::drawSnowIcon(int x, int y, int size) {
 }
 
 void DisplayManager::drawThunderIcon(int x, int y, int size) {
-    drawCloudIcon(x, y - size/6, size * 0.75);
+    drawCloudIcon(x, y - size/6, geomScale(size, 3, 4));
 
     // Elegant lightning bolt - zigzag shape
     int bx = x + size / 2;
@@ -493,13 +889,13 @@ void DisplayManager::drawThunderIcon(int x, int y, int size) {
     int boltHeight = size / 3;
 
     // Main bolt shape
-    M5.Display.fillTriangle(
+    gfx->fillTriangle(
         bx - boltWidth / 2, by,
         bx + boltWidth, by + boltHeight / 2,
         bx, by + boltHeight / 2,
         TFT_BLACK
     );
-    M5.Display.fillTriangle(
+    gfx->fillTriangle(
         bx + boltWidth / 2, by + boltHeight / 2 - 2,
         bx - boltWidth / 2, by + boltHeight,
         bx, by + boltHeight / 2 - 2,
@@ -507,8 +903,8 @@ void DisplayManager::drawThunderIcon(int x, int y, int size) {
     );
 
     // Bolt outline for definition
-    M5.Display.drawLine(bx - boltWidth / 2, by, bx + boltWidth, by + boltHeight / 2, TFT_BLACK);
-    M5.Display.drawLine(bx + boltWidth / 2, by + boltHeight / 2 - 2, bx - boltWidth / 2, by + boltHeight, TFT_BLACK);
+    gfx->drawLine(bx - boltWidth / 2, by, bx + boltWidth, by + boltHeight / 2, TFT_BLACK);
+    gfx->drawLine(bx + boltWidth / 2, by + boltHeight / 2 - 2, bx - boltWidth / 2, by + boltHeight, TFT_BLACK);
 }
 
 void DisplayManager::drawFogIcon(int x, int y, int size) {
@@ -522,9 +918,9 @@ void DisplayManager::drawFogIcon(int x, int y, int size) {
         int endX = x + size - (i % 2 == 0 ? 15 : 5);
 
         // Draw wavy line using small segments
+        int step = 0;
         for (int wx = startX; wx < endX - 5; wx += 3) {
-            int waveOffset = (int)(sin((wx - startX) * 0.15) * 2);
-            M5.Display.fillCircle(wx, ly + waveOffset, 2, TFT_BLACK);
+            fillDot(wx, ly + geomFogWave(step++), 2, TFT_BLACK);
         }
     }
 }
@@ -536,22 +932,24 @@ void DisplayManager::drawPartlyCloudyIcon(int x, int y, int size, bool isNight)
         int mx = x + size / 6;
         int my = y + size / 6;
         int mr = size / 5;
-        M5.Display.fillCircle(mx, my, mr, TFT_BLACK);
-        M5.Display.fillCircle(mx + mr * 0.5, my - mr * 0.2, mr * 0.8, TFT_WHITE);
+        gfx->fillCircle(mx, my, mr, TFT_BLACK);
+        gfx->fillCircle(mx + geomScale(mr, 5, 10), my + geomScale(mr, -2, 10),
+                        geomScale(mr, 8, 10), TFT_WHITE);
     } else {
         // Simple sun for background
         int sx = x + size / 5;
         int sy = y + size / 5;
         int sr = size / 7;
-        M5.Display.fillCircle(sx, sy, sr, TFT_BLACK);
+        gfx->fillCircle(sx, sy, sr, TFT_BLACK);
         // A few rays peeking out
         for (int i = 0; i < 6; i++) {
-            float angle = i * PI / 3 - PI / 6;
-            int x1 = sx + cos(angle) * (sr + 2);
-            int y1 = sy + sin(angle) * (sr + 2);
-            int x2 = sx + cos(angle) * (sr + size / 10);
-            int y2 = sy + sin(angle) * (sr + size / 10);
-            M5.Display.drawLine(x1, y1, x2, y2, TFT_BLACK);
+            // Every 60 degrees, starting at -30
+            int step = i * 2 - 1;
+            int x1 = sx + geomCos(step, sr + 2);
+            int y1 = sy + geomSin(step, sr + 2);
+            int x2 = sx + geomCos(step, sr + size / 10);
+            int y2 = sy + geomSin(step, sr + size / 10);
+            gfx->drawLine(x1, y1, x2, y2, TFT_BLACK);
         }
     }
 
@@ -561,103 +959,117 @@ void DisplayManager::drawPartlyCloudyIcon(int x, int y, int size, bool isNight)
     int r = size / 7;
 
     // White background to cleanly cover sun/moon
-    M5.Display.fillCircle(cloudX, cloudY + r / 2, r + 4, TFT_WHITE);
-    M5.Display.fillCircle(cloudX + r, cloudY - r / 4, r * 1.2 + 4, TFT_WHITE);
-    M5.Display.fillCircle(cloudX + r * 2, cloudY + r / 2, r + 4, TFT_WHITE);
-    M5.Display.fillRect(cloudX - r / 2, cloudY + r / 2, r * 3, r, TFT_WHITE);
+    gfx->fillCircle(cloudX, cloudY + r / 2, r + 4, TFT_WHITE);
+    gfx->fillCircle(cloudX + r, cloudY - r / 4, geomScale(r, 12, 10) + 4, TFT_WHITE);
+    gfx->fillCircle(cloudX + r * 2, cloudY + r / 2, r + 4, TFT_WHITE);
+    gfx->fillRect(cloudX - r / 2, cloudY + r / 2, r * 3, r, TFT_WHITE);
 
     // Cloud outline for elegant look
-    M5.Display.fillCircle(cloudX, cloudY + r / 2, r, TFT_BLACK);
-    M5.Display.fillCircle(cloudX + r, cloudY - r / 4, r * 1.2, TFT_BLACK);
-    M5.Display.fillCircle(cloudX + r * 2, cloudY + r / 2, r, TFT_BLACK);
-    M5.Display.fillRect(cloudX, cloudY + r / 2, r * 2, r, TFT_BLACK);
+    gfx->fillCircle(cloudX, cloudY + r / 2, r, TFT_BLACK);
+    gfx->fillCircle(cloudX + r, cloudY - r / 4, geomScale(r, 12, 10), TFT_BLACK);
+    gfx->fillCircle(cloudX + r * 2, cloudY + r / 2, r, TFT_BLACK);
+    gfx->fillRect(cloudX, cloudY + r / 2, r * 2, r, TFT_BLACK);
+}
+
+// Span-filled dot straight into the canvas memory (falls back to fillCircle)
+void DisplayManager::fillDot(int x, int y, int r, uint16_t color) {
+    if (fb.buf != nullptr) {
+        framebufferDisc(fb, x, y, r, color == TFT_BLACK ? GRAY4_BLACK : GRAY4_WHITE);
+    } else {
+        gfx->fillCircle(x, y, r, color);
+    }
+}
+
+// Flat 16-level gray fill, dithered into the canvas (solid gray on the panel)
+void DisplayManager::shadeRect(int x, int y, int w, int h, uint8_t gray) {
+    if (w <= 0 || h <= 0) return;
+    if (fb.buf != nullptr) {
+        ditherFill(fb, x, y, w, h, gray);
+    } else {
+        gfx->fillRect(x, y, w, h, M5.Display.color888(gray, gray, gray));
+    }
 }
 
 // Helper function - draw a small star
 void DisplayManager::drawStar(int x, int y, int size) {
     // Simple 4-point star
-    M5.Display.drawLine(x - size, y, x + size, y, TFT_BLACK);
-    M5.Display.drawLine(x, y - size, x, y + size, TFT_BLACK);
+    gfx->drawLine(x - size, y, x + size, y, TFT_BLACK);
+    gfx->drawLine(x, y - size, x, y + size, TFT_BLACK);
     // Diagonal lines for 8-point effect
-    int d = size * 0.7;
-    M5.Display.drawLine(x - d, y - d, x + d, y + d, TFT_BLACK);
-    M5.Display.drawLine(x + d, y - d, x - d, y + d, TFT_BLACK);
+    int d = geomScale(size, 7, 10);
+    gfx->drawLine(x - d, y - d, x + d, y + d, TFT_BLACK);
+    gfx->drawLine(x + d, y - d, x - d, y + d, TFT_BLACK);
 }
 
 // Helper function - draw an elegant snowflake
 void DisplayManager::drawSnowflake(int x, int y, int size) {
     // 6-armed snowflake
     for (int i = 0; i < 6; i++) {
-        float angle = i * PI / 3;
-        int x2 = x + cos(angle) * size;
-        int y2 = y + sin(angle) * size;
-        M5.Display.drawLine(x, y, x2, y2, TFT_BLACK);
+        int step = i * 2;  // 60 degrees per arm
+        int x2 = x + geomCos(step, size);
+        int y2 = y + geomSin(step, size);
+        gfx->drawLine(x, y, x2, y2, TFT_BLACK);
 
-        // Small branches on each arm
+        // Small branches on each arm, +/-30 degrees from 3/5 along the arm
         if (size > 3) {
-            float branchAngle1 = angle + PI / 6;
-            float branchAngle2 = angle - PI / 6;
-            int bx = x + cos(angle) * size * 0.6;
-            int by = y + sin(angle) * size * 0.6;
-            int bLen = size * 0.4;
-            M5.Display.drawLine(bx, by, bx + cos(branchAngle1) * bLen, by + sin(branchAngle1) * bLen, TFT_BLACK);
-            M5.Display.drawLine(bx, by, bx + cos(branchAngle2) * bLen, by + sin(branchAngle2) * bLen, TFT_BLACK);
+            int bx = x + geomCos(step, size, 3, 5);
+            int by = y + geomSin(step, size, 3, 5);
+            int bLen = geomScale(size, 2, 5);
+            gfx->drawLine(bx, by, bx + geomCos(step + 1, bLen), by + geomSin(step + 1, bLen), TFT_BLACK);
+            gfx->drawLine(bx, by, bx + geomCos(step - 1, bLen), by + geomSin(step - 1, bLen), TFT_BLACK);
         }
     }
     // Center dot
-    M5.Display.fillCircle(x, y, 1, TFT_BLACK);
+    gfx->fillCircle(x, y, 1, TFT_BLACK);
 }
 
 // Utility functions
-String DisplayManager::getDayName(time_t timestamp) {
-    struct tm* timeinfo = localtime(&timestamp);
-    const char* days[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
-    return String(days[timeinfo->tm_wday]);
-}
-
-String DisplayManager::formatTime(time_t timestamp) {
-    struct tm* timeinfo = localtime(&timestamp);
-    char buffer[12];
-    int hour = timeinfo->tm_hour;
-    const char* ampm = (hour >= 12) ? "PM" : "AM";
-    hour = hour % 12;
-    if (hour == 0) hour = 12;
-    sprintf(buffer, "%d:%02d %s", hour, timeinfo->tm_min, ampm);
-    return String(buffer);
-}
-
-String DisplayManager::formatHourlyTime(time_t timestamp) {
-    struct tm* timeinfo = localtime(&timestamp);
-    int hour = timeinfo->tm_hour;
-
-    // Special cases for noon and midnight
-    if (hour == 0) return "12am";
-    if (hour == 12) return "noon";
-
-    // Format as compact time
-    if (hour < 12) {
-        return String(hour) + "am";
-    } else {
-        return String(hour - 12) + "pm";
-    }
+const char* DisplayManager::getDayName(time_t timestamp) {
+    struct tm timeinfo;
+    tzLocalTime(timestamp, timeinfo);
+    static const char* const days[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    return days[timeinfo.tm_wday];
+}
+
+void DisplayManager::addTime(TextBuilder& text, time_t timestamp) {
+    struct tm timeinfo;
+    tzLocalTime(timestamp, timeinfo);
+    int hour = timeinfo.tm_hour % 12;
+    text << (hour ? hour : 12) << ':';
+    text.add2Digits(timeinfo.tm_min) << (timeinfo.tm_hour >= 12 ? " PM" : " AM");
 }
 
-String DisplayManager::formatDate(time_t timestamp) {
-    struct tm* timeinfo = localtime(&timestamp);
-    const char* months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
-                            "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
-    char buffer[12];
-    sprintf(buffer, "%s %d", months[timeinfo->tm_mon], timeinfo->tm_mday);
-    return String(buffer);
+void DisplayManager::addDate(TextBuilder& text, time_t timestamp) {
+    struct tm timeinfo;
+    tzLocalTime(timestamp, timeinfo);
+    static const char* const months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                         "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    text << months[timeinfo.tm_mon] << ' ' << timeinfo.tm_mday;
 }
 
 bool DisplayManager::isNightTime(time_t timestamp, time_t sunrise, time_t sunset) {
     return (timestamp < sunrise || timestamp > sunset);
 }
 
-String DisplayManager::capitalizeFirst(const String& str) {
-    if (str.length() == 0) return str;
-    String result = str;
-    result[0] = toupper(result[0]);
-    return result;
+void DisplayManager::fitWidth(TextBuilder& text, int32_t maxWidth) {
+    if (gfx->textWidth(text.c_str()) <= maxWidth) return;
+
+    // Longest prefix that still fits with the dots after it (a prefix is
+    // never wider than a longer one)
+    StackText<64> candidate;
+    size_t lo = 0;
+    size_t hi = min(text.length(), candidate.capacity() - 2);
+    while (lo < hi) {
+        size_t mid = (lo + hi + 1) / 2;
+        candidate.truncate(0);
+        candidate.add(text.c_str(), mid) << "..";
+        if (gfx->textWidth(candidate.c_str()) <= maxWidth) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    while (lo > 0 && text.c_str()[lo - 1] == ' ') lo--;
+    text.truncate(lo);
+    text << "..";
 }
@@ -3,6 +3,9 @@
 
 #include <M5Unified.h>
 #include "weather_api.h"
+#include "display_list.h"
+#include "framebuffer.h"
+#include "text_format.h"
 
 class DisplayManager {
 public:
@@ -17,37 +20,85 @@ public:
     // Render complete weather display
     void renderWeather(WeatherData& weather);
 
-    // Render error message
-    void renderError(const String& message);
+    // Render error message with the time until the next retry
+    void renderError(const char* message, int32_t retrySeconds);
 
-    // Render connecting/loading status
-    void renderStatus(const String& message);
+    // Show boot progress (step of total) in a small corner region using a
+    // fast partial refresh. Skipped while a weather frame is on screen.
+    void renderProgress(int step, int total, const char* label);
+
+    // Capture the header clock's glyphs into RTC memory for clock tick
+    // wakes (once per power-on, after renderWeather)
+    void prepareClockTick();
+
+    // Clock tick wake: bring up only the panel and redraw the header time
+    // with a partial refresh. Returns false if there is nothing to update
+    // (no weather frame shown or no glyphs captured).
+    bool renderClockTick(time_t now);
 
     // Push display buffer to e-ink
     void update();
 
+    // Draw a recorded frame onto the canvas (or the panel) over a white
+    // screen; update() shows it. Also used for the frames rendered here.
+    void play(const DisplayList& frame);
+
+    // The frame renderWeather or renderError last recorded (no items
+    // before that). The list is static, so there always is one.
+    const DisplayList& lastFrame() const { return *list; }
+
 private:
     // Layout constants
     static const int HEADER_HEIGHT = 40;
     static const int CURRENT_HEIGHT = 240;
     static const int HOURLY_HEIGHT = 120;
+    static const int GRAPH_HEIGHT = 130;
     static const int FOOTER_HEIGHT = 40;
+    static const int PROGRESS_W = 180;
+    static const int PROGRESS_H = 28;
 
     // Section Y positions
     int headerY;
     int currentY;
     int hourlyY;
+    int graphY;
     int dailyY;
     int footerY;
 
+    // Moon phase in 1/65536 cycle (0 new, 32768 full) of the frame being
+    // recorded, then of the icon being played
+    uint16_t moonPhase;
+
+    // Off-screen 4bpp canvas in PSRAM; gfx points at it, or at the panel
+    // when the allocation fails. fb is a direct view of the canvas memory.
+    M5Canvas canvas;
+    LovyanGFX* gfx;
+    Framebuffer4 fb;
+
+    // Frames are recorded into this list (a static one, so it is always
+    // there) and then played. The pen state is kept here as gfx keeps it;
+    // gfx gets the font and size too, so text can be measured while
+    // recording.
+    DisplayList* list;
+    uint8_t penFont;
+    uint8_t penSize;
+    DlAlign penAlign;
+    void beginFrame();
+    void setFont(uint8_t font);
+    void setTextSize(uint8_t size);
+    void setAlign(DlAlign align) { penAlign = align; }
+    void drawText(const char* text, int x, int y);
+    void drawIcon(int x, int y, int size, int weatherId, bool isNight = false);
+
     // Render individual sections
     void renderHeader();
-    void renderCurrentWeather(CurrentWeather& current);
+    void renderCurrentWeather(CurrentWeather& current, const ObservationTrend& trend);
     void renderHourlyForecast(HourlyForecast* hourly, int count);
+    void renderTrendGraph(const ForecastSeries& series);
     void renderDailyForecast(DailyForecast* daily, int count);
-    void renderFooter();
+    void renderFooter(const WeatherData& weather);
 
-    // Weather icon drawing
+    // Weather icon drawing, while playing
     void drawWeatherIcon(int x, int y, int size, int weatherId, bool isNight = false);
     void drawSunIcon(int x, int y, int size);
     void drawMoonIcon(int x, int y, int size);
@@ -59,14 +110,20 @@ private:
     void drawPartlyCloudyIcon(int x, int y, int size, bool isNight = false);
     void drawStar(int x, int y, int size);
     void drawSnowflake(int x, int y, int size);
+    void fillDot(int x, int y, int r, uint16_t color);
+    void shadeRect(int x, int y, int w, int h, uint8_t gray);
 
-    // Utility functions
-    String getDayName(time_t timestamp);
-    String formatTime(time_t timestamp);
-    String formatHourlyTime(time_t timestamp);
-    String formatDate(time_t timestamp);
+    void drawSeparator(int lineY);
+
+    // Utility functions; text goes into the caller's buffer (text_format.h)
+    const char* getDayName(time_t timestamp);
+    void addTime(TextBuilder& text, time_t timestamp);        // "7:05 PM"
+    void addDate(TextBuilder& text, time_t timestamp);        // "Mar 9"
     bool isNightTime(time_t timestamp, time_t sunrise, time_t sunset);
-    String capitalizeFirst(const String& str);
+
+    // Shorten text to at most maxWidth pixels in the current font, ending
+    // it with ".." when anything had to go
+    void fitWidth(TextBuilder& text, int32_t maxWidth);
 };
 
 #endif // DISPLAY_MANAGER_H
@@ -0,0 +1,147 @@
+#include "dither.h"
+
+// 4x4 Bayer thresholds (0..15)
+static const uint8_t BAYER[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5}
+};
+
+// Map 0..255 gray onto 0..240: high nibble is the base level, low nibble
+// the fraction compared against the Bayer threshold
+static inline uint32_t ditherQ(uint8_t gray) {
+    return (gray * 241u) >> 8;
+}
+
+static inline void putLevel(const Framebuffer4& fb, int x, int y, uint8_t level) {
+    uint8_t* p = fb.buf + y * fb.stride + (x >> 1);
+    if (x & 1) {
+        *p = (*p & 0xF0) | level;
+    } else {
+        *p = (*p & 0x0F) | (level << 4);
+    }
+}
+
+// Clip a row against the buffer, adjusting the source pointer to match
+static bool clipRow(const Framebuffer4& fb, const uint8_t*& src, int& x, int y, int& w) {
+    if (fb.buf == nullptr || y < 0 || y >= fb.height) return false;
+    if (x < 0) {
+        if (src) src -= x;
+        w += x;
+        x = 0;
+    }
+    if (x + w > fb.width) {
+        w = fb.width - x;
+    }
+    return w > 0;
+}
+
+uint8_t ditherLevel(uint8_t gray, int x, int y) {
+    uint32_t q = ditherQ(gray);
+    return (q >> 4) + ((q & 0x0F) > BAYER[y & 3][x & 3] ? 1 : 0);
+}
+
+void ditherRowScalar(const uint8_t* src, const Framebuffer4& fb, int x, int y, int w) {
+    if (!clipRow(fb, src, x, y, w)) return;
+
+    for (int i = 0; i < w; i++) {
+        putLevel(fb, x + i, y, ditherLevel(src[i], x + i, y));
+    }
+}
+
+void ditherRow(const uint8_t* src, const Framebuffer4& fb, int x, int y, int w) {
+#ifdef DITHER_SCALAR_ONLY
+    ditherRowScalar(src, fb, x, y, w);
+#else
+    if (!clipRow(fb, src, x, y, w)) return;
+
+    // Align to a whole output byte
+    if (x & 1) {
+        putLevel(fb, x, y, ditherLevel(src[0], x, y));
+        src++;
+        x++;
+        w--;
+    }
+
+    // Thresholds for the four pixels of each word; x advances by 4 so the
+    // Bayer phase stays fixed for the whole row
+    const uint8_t* bayer = BAYER[y & 3];
+    uint32_t thr = bayer[x & 3] |
+                   (bayer[(x + 1) & 3] << 8) |
+                   (bayer[(x + 2) & 3] << 16) |
+                   ((uint32_t)bayer[(x + 3) & 3] << 24);
+
+    uint8_t* out = fb.buf + y * fb.stride + (x >> 1);
+    while (w >= 4) {
+        uint32_t q = ditherQ(src[0]) |
+                     (ditherQ(src[1]) << 8) |
+                     (ditherQ(src[2]) << 16) |
+                     (ditherQ(src[3]) << 24);
+        uint32_t base = (q >> 4) & 0x0F0F0F0F;
+        uint32_t frac = q & 0x0F0F0F0F;
+
+        // Per byte: frac + 15 - thr sets bit 4 exactly when frac > thr
+        uint32_t carry = ((frac + 0x0F0F0F0F - thr) >> 4) & 0x01010101;
+        uint32_t levels = base + carry;
+
+        // Pack bytes l0 l1 l2 l3 into nibble pairs (l0 << 4 | l1), (l2 << 4 | l3)
+        uint32_t packed = (levels << 4) | (levels >> 8);
+        out[0] = (uint8_t)packed;
+        out[1] = (uint8_t)(packed >> 16);
+
+        src += 4;
+        out += 2;
+        x += 4;
+        w -= 4;
+    }
+
+    for (int i = 0; i < w; i++) {
+        putLevel(fb, x + i, y, ditherLevel(src[i], x + i, y));
+    }
+#endif
+}
+
+void ditherFrame(const uint8_t* src, int srcStride, const Framebuffer4& fb) {
+    for (int y = 0; y < fb.height; y++) {
+        ditherRow(src + y * srcStride, fb, 0, y, fb.width);
+    }
+}
+
+void ditherFill(const Framebuffer4& fb, int x, int y, int w, int h, uint8_t gray) {
+    for (int row = y; row < y + h; row++) {
+        const uint8_t* none = nullptr;
+        int rx = x;
+        int rw = w;
+        if (!clipRow(fb, none, rx, row, rw)) continue;
+
+        // The pattern repeats every 4 pixels, so build the row's levels once
+        uint8_t levels[4];
+        for (int i = 0; i < 4; i++) {
+            levels[i] = ditherLevel(gray, i, row);
+        }
+        for (int i = 0; i < rw; i++) {
+            putLevel(fb, rx + i, row, levels[(rx + i) & 3]);
+        }
+    }
+}
+
+void ditherShadeLevel(const Framebuffer4& fb, int x, int y, int w, int h,
+                      uint8_t match, uint8_t grayTop, uint8_t grayBottom) {
+    if (h <= 0) return;
+
+    for (int i = 0; i < h; i++) {
+        int row = y + i;
+        const uint8_t* none = nullptr;
+        int rx = x;
+        int rw = w;
+        if (!clipRow(fb, none, rx, row, rw)) continue;
+
+        int gray = grayTop + (h > 1 ? ((int)grayBottom - grayTop) * i / (h - 1) : 0);
+        for (int px = rx; px < rx + rw; px++) {
+            if (framebufferGet(fb, px, row) == match) {
+                putLevel(fb, px, row, ditherLevel((uint8_t)gray, px, row));
+            }
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef DITHER_H
+#define DITHER_H
+
+#include <stdint.h>
+#include "framebuffer.h"
+
+// Ordered (4x4 Bayer) dithering from 8-bit gray (0 = black, 255 = white)
+// to the 16 panel levels of a Framebuffer4.
+//
+// The row kernel has two implementations: a portable scalar loop and a
+// SWAR path that dithers and packs four pixels per 32-bit word. Define
+// DITHER_SCALAR_ONLY to force the scalar path (e.g. for comparisons).
+
+// Dithered level for a single pixel
+uint8_t ditherLevel(uint8_t gray, int x, int y);
+
+// Dither one row of 8-bit source pixels into fb at (x, y)
+void ditherRow(const uint8_t* src, const Framebuffer4& fb, int x, int y, int w);
+void ditherRowScalar(const uint8_t* src, const Framebuffer4& fb, int x, int y, int w);
+
+// Dither a full 8-bit frame (fb.width x fb.height) into fb
+void ditherFrame(const uint8_t* src, int srcStride, const Framebuffer4& fb);
+
+// Fill a rectangle with a flat dithered shade
+void ditherFill(const Framebuffer4& fb, int x, int y, int w, int h, uint8_t gray);
+
+// Replace pixels of level `match` inside the rectangle with a vertical
+// dithered gradient from grayTop to grayBottom. Used to shade shapes that
+// were drawn as solid silhouettes.
+void ditherShadeLevel(const Framebuffer4& fb, int x, int y, int w, int h,
+                      uint8_t match, uint8_t grayTop, uint8_t grayBottom);
+
+#endif // DITHER_H
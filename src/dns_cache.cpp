@@ -0,0 +1,44 @@
+#include "dns_cache.h"
+#include <string.h>
+
+#define DNS_CACHE_MAGIC 0x444E5343  // "DNSC"
+
+// Anything earlier means NTP has not set the clock
+#define DNS_CACHE_MIN_VALID_TIME 1700000000
+
+uint32_t hostNameHash(const char* host) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    while (*host) {
+        hash ^= (uint8_t)*host++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool dnsCacheLookup(const DnsCacheEntry& entry, const char* host, time_t now,
+                    uint32_t& address) {
+    if (entry.magic != DNS_CACHE_MAGIC || entry.address == 0) return false;
+    if (entry.hostHash != hostNameHash(host)) return false;
+    if (now < DNS_CACHE_MIN_VALID_TIME) return false;
+
+    // A lookup "in the future" means the clock jumped backwards: distrust it
+    if (now < entry.resolvedAt) return false;
+    if ((uint32_t)(now - entry.resolvedAt) >= entry.ttlSeconds) return false;
+
+    address = entry.address;
+    return true;
+}
+
+void dnsCacheStore(DnsCacheEntry& entry, const char* host, uint32_t address,
+                   time_t now, uint32_t ttlSeconds) {
+    entry.magic = DNS_CACHE_MAGIC;
+    entry.hostHash = hostNameHash(host);
+    entry.address = address;
+    entry.resolvedAt = now;
+    entry.ttlSeconds = ttlSeconds;
+}
+
+void dnsCacheInvalidate(DnsCacheEntry& entry) {
+    memset(&entry, 0, sizeof(entry));
+}
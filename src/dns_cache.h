@@ -0,0 +1,31 @@
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Last resolved address of a host, kept in RTC memory across deep sleep
+struct DnsCacheEntry {
+    uint32_t magic;
+    uint32_t hostHash;     // Which host the address belongs to
+    uint32_t address;      // IPv4 address as stored by IPAddress
+    time_t resolvedAt;     // Wall-clock time of the lookup
+    uint32_t ttlSeconds;
+};
+
+// Look up a cached address. Returns false if the entry is empty, belongs
+// to another host, has expired, or the clock is not set yet.
+bool dnsCacheLookup(const DnsCacheEntry& entry, const char* host, time_t now,
+                    uint32_t& address);
+
+// Remember a fresh lookup result
+void dnsCacheStore(DnsCacheEntry& entry, const char* host, uint32_t address,
+                   time_t now, uint32_t ttlSeconds);
+
+// Drop the entry (e.g. the cached address no longer accepts connections)
+void dnsCacheInvalidate(DnsCacheEntry& entry);
+
+// Stable 32-bit hash of a host name, used to key RTC caches
+uint32_t hostNameHash(const char* host);
+
+#endif // DNS_CACHE_H
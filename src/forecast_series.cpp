@@ -0,0 +1,108 @@
+#include "forecast_series.h"
+#include <string.h>
+
+int16_t quantizeDeci(float value) {
+    return (int16_t)(value * 10.0f);
+}
+
+void seriesClear(ForecastSeries& series) {
+    series.start = 0;
+    series.stepSeconds = FORECAST_STEP_SECONDS;
+    series.count = 0;
+}
+
+bool seriesAppend(ForecastSeries& series, time_t timestamp, float temp, float feelsLike,
+                  int humidity, float windSpeed, float pop, int weatherId) {
+    if (series.count >= FORECAST_SERIES_MAX) return false;
+
+    if (series.count == 0) {
+        series.start = timestamp;
+    }
+
+    int i = series.count;
+    series.tempDeci[i] = quantizeDeci(temp);
+
+    int popPercent = (int)(pop * 100.0f + 0.5f);
+    if (popPercent < 0) popPercent = 0;
+    if (popPercent > 100) popPercent = 100;
+    series.pop[i] = (uint8_t)popPercent;
+
+    series.weatherId[i] = (uint16_t)weatherId;
+    series.feelsLikeDeci[i] = quantizeDeci(feelsLike);
+    series.windSpeedDeci[i] = (uint16_t)quantizeDeci(windSpeed);
+    series.humidity[i] = (uint8_t)(humidity < 0 ? 0 : humidity > 100 ? 100 : humidity);
+    series.count++;
+    return true;
+}
+
+time_t seriesTime(const ForecastSeries& series, int i) {
+    return series.start + (time_t)i * series.stepSeconds;
+}
+
+void seriesLocate(const ForecastSeries& series, time_t t, int& i, float& frac) {
+    i = 0;
+    frac = 0;
+    if (t <= series.start || series.count < 2) return;
+
+    int64_t offset = (int64_t)(t - series.start);
+    i = (int)(offset / series.stepSeconds);
+    if (i >= series.count - 1) {
+        i = series.count - 1;
+        return;
+    }
+    frac = (float)(offset - (int64_t)i * series.stepSeconds) / series.stepSeconds;
+}
+
+int seriesDropBefore(ForecastSeries& series, time_t t) {
+    int n = 0;
+    while (n < series.count && seriesTime(series, n) + series.stepSeconds / 2 <= t) n++;
+    if (n == 0) return 0;
+
+    int keep = series.count - n;
+    memmove(series.tempDeci, series.tempDeci + n, keep * sizeof(series.tempDeci[0]));
+    memmove(series.pop, series.pop + n, keep * sizeof(series.pop[0]));
+    memmove(series.weatherId, series.weatherId + n, keep * sizeof(series.weatherId[0]));
+    memmove(series.feelsLikeDeci, series.feelsLikeDeci + n, keep * sizeof(series.feelsLikeDeci[0]));
+    memmove(series.windSpeedDeci, series.windSpeedDeci + n, keep * sizeof(series.windSpeedDeci[0]));
+    memmove(series.humidity, series.humidity + n, keep * sizeof(series.humidity[0]));
+    series.start = seriesTime(series, n);
+    series.count = keep;
+    return n;
+}
+
+void seriesComputeGraph(const ForecastSeries& series, int x, int y, int w, int h, SeriesGraph& graph) {
+    int n = series.count;
+    graph.count = n;
+    if (n == 0) {
+        graph.minDeci = 0;
+        graph.maxDeci = 0;
+        return;
+    }
+
+    // Min/max reduction
+    int16_t lo = series.tempDeci[0];
+    int16_t hi = series.tempDeci[0];
+    for (int i = 1; i < n; i++) {
+        int16_t t = series.tempDeci[i];
+        lo = t < lo ? t : lo;
+        hi = t > hi ? t : hi;
+    }
+    graph.minDeci = lo;
+    graph.maxDeci = hi;
+
+    // Points: fixed-point steps, no division inside the loop. The steps are
+    // rounded up so the last slot, the maximum and a 100% bar reach the far
+    // edge of the box instead of stopping a pixel short.
+    int32_t range = hi - lo;
+    if (range < 1) range = 1;
+    int32_t yScale = (((int32_t)(h - 1) << 16) + range - 1) / range;
+    int32_t xStep = n > 1 ? (((int32_t)(w - 1) << 16) + n - 2) / (n - 1) : 0;
+    int32_t popScale = (((int32_t)h << 16) + 99) / 100;
+    int bottom = y + h - 1;
+
+    for (int i = 0; i < n; i++) {
+        graph.x[i] = (int16_t)(x + ((xStep * i) >> 16));
+        graph.y[i] = (int16_t)(bottom - (((series.tempDeci[i] - lo) * yScale) >> 16));
+        graph.barTop[i] = (int16_t)(y + h - ((series.pop[i] * popScale) >> 16));
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef FORECAST_SERIES_H
+#define FORECAST_SERIES_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Full 5-day / 3-hour forecast kept as a compact, quantized time series.
+// Fields are stored as separate arrays so each pass over one field is a
+// tight, vectorizable loop. Slot i is at start + i * stepSeconds.
+#define FORECAST_SERIES_MAX 40
+#define FORECAST_STEP_SECONDS (3 * 3600)
+
+struct ForecastSeries {
+    time_t start;
+    uint16_t stepSeconds;
+    uint8_t count;
+    int16_t tempDeci[FORECAST_SERIES_MAX];       // Temperature in 0.1 degrees
+    uint8_t pop[FORECAST_SERIES_MAX];            // Probability of precipitation (0-100)
+    uint16_t weatherId[FORECAST_SERIES_MAX];     // OWM condition ID
+    int16_t feelsLikeDeci[FORECAST_SERIES_MAX];  // Feels-like temperature in 0.1 degrees
+    uint16_t windSpeedDeci[FORECAST_SERIES_MAX]; // Wind speed in 0.1 units
+    uint8_t humidity[FORECAST_SERIES_MAX];       // Relative humidity (%)
+};
+
+// Screen-space points for the trend graph
+struct SeriesGraph {
+    int count;
+    int16_t minDeci;
+    int16_t maxDeci;
+    int16_t x[FORECAST_SERIES_MAX];
+    int16_t y[FORECAST_SERIES_MAX];       // Temperature polyline
+    int16_t barTop[FORECAST_SERIES_MAX];  // Top of the precipitation bar
+};
+
+// Cut a value to 0.1 units (temperatures, wind speed). Truncating toward
+// zero rather than rounding means roundDeci() of the result is the value
+// rounded to a whole number, exactly as if it had not been quantized.
+int16_t quantizeDeci(float value);
+
+// Round 0.1 units to a whole number, half away from zero, for display
+inline int roundDeci(int deci) {
+    return deci < 0 ? -((5 - deci) / 10) : (deci + 5) / 10;
+}
+
+void seriesClear(ForecastSeries& series);
+
+// Append one forecast slot; returns false when the series is full
+bool seriesAppend(ForecastSeries& series, time_t timestamp, float temp, float feelsLike,
+                  int humidity, float windSpeed, float pop, int weatherId);
+
+// Timestamp of slot i
+time_t seriesTime(const ForecastSeries& series, int i);
+
+// Where time t falls: slot i and the fraction (0..1) of the way to slot
+// i + 1, clamped to the first and last slot. The series must not be empty.
+void seriesLocate(const ForecastSeries& series, time_t t, int& i, float& frac);
+
+// Drop the slots that lie more than half a step before t, so slot 0 is
+// the one nearest t or after it. Returns the number dropped.
+int seriesDropBefore(ForecastSeries& series, time_t t);
+
+// Scale the series into the box (x, y, w, h): temperature spans the full
+// height between its min and max, precipitation bars grow up from the
+// bottom edge. One reduction pass for min/max, one mapping pass for points.
+void seriesComputeGraph(const ForecastSeries& series, int x, int y, int w, int h, SeriesGraph& graph);
+
+#endif // FORECAST_SERIES_H
@@ -0,0 +1,88 @@
+#include "framebuffer.h"
+#include <string.h>
+
+Framebuffer4 framebufferWrap(void* buf, int width, int height) {
+    Framebuffer4 fb;
+    fb.buf = static_cast<uint8_t*>(buf);
+    fb.width = width;
+    fb.height = height;
+    fb.stride = (width + 1) / 2;
+    return fb;
+}
+
+void framebufferSpan(const Framebuffer4& fb, int x, int y, int w, uint8_t level) {
+    if (fb.buf == nullptr || y < 0 || y >= fb.height) return;
+
+    // Clip horizontally
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if (x + w > fb.width) {
+        w = fb.width - x;
+    }
+    if (w <= 0) return;
+
+    level &= 0x0F;
+    uint8_t* row = fb.buf + y * fb.stride;
+
+    // Leading odd pixel (low nibble)
+    if (x & 1) {
+        row[x >> 1] = (row[x >> 1] & 0xF0) | level;
+        x++;
+        w--;
+    }
+
+    // Whole bytes in one go
+    int bytes = w >> 1;
+    if (bytes > 0) {
+        memset(row + (x >> 1), (level << 4) | level, bytes);
+        x += bytes * 2;
+        w -= bytes * 2;
+    }
+
+    // Trailing even pixel (high nibble)
+    if (w > 0) {
+        row[x >> 1] = (row[x >> 1] & 0x0F) | (level << 4);
+    }
+}
+
+void framebufferRect(const Framebuffer4& fb, int x, int y, int w, int h, uint8_t level) {
+    for (int row = 0; row < h; row++) {
+        framebufferSpan(fb, x, y + row, w, level);
+    }
+}
+
+void framebufferDisc(const Framebuffer4& fb, int cx, int cy, int r, uint8_t level) {
+    if (r < 0) return;
+
+    int32_t dx = 1;
+    int32_t dy = r << 1;
+    int32_t p = -(r >> 1);
+    int32_t i = 0;
+
+    framebufferSpan(fb, cx - r, cy, dy + 1, level);
+
+    while (i < r) {
+        if (p >= 0) {
+            framebufferSpan(fb, cx - i, cy + r, (i << 1) + 1, level);
+            framebufferSpan(fb, cx - i, cy - r, (i << 1) + 1, level);
+            dy -= 2;
+            p -= dy;
+            r--;
+        }
+        dx += 2;
+        p += dx;
+        i++;
+        framebufferSpan(fb, cx - r, cy + i, (r << 1) + 1, level);
+        framebufferSpan(fb, cx - r, cy - i, (r << 1) + 1, level);
+    }
+}
+
+uint8_t framebufferGet(const Framebuffer4& fb, int x, int y) {
+    if (fb.buf == nullptr || x < 0 || y < 0 || x >= fb.width || y >= fb.height) {
+        return GRAY4_WHITE;
+    }
+    uint8_t b = fb.buf[y * fb.stride + (x >> 1)];
+    return (x & 1) ? (b & 0x0F) : (b >> 4);
+}
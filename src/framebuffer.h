@@ -0,0 +1,37 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <stdint.h>
+
+// 4-bit packed grayscale framebuffer view (two pixels per byte, left pixel
+// in the high nibble, 0 = black .. 15 = white). This matches the layout of
+// a 4bpp M5Canvas, so the hot shapes can be filled straight into the sprite
+// memory without going through per-call clipping and color conversion.
+// Plain C++ so it can be used off-device as well.
+struct Framebuffer4 {
+    uint8_t* buf;
+    int width;
+    int height;
+    int stride;  // Bytes per row
+};
+
+#define GRAY4_BLACK 0
+#define GRAY4_WHITE 15
+
+// Wrap an existing buffer (stride defaults to the packed row size)
+Framebuffer4 framebufferWrap(void* buf, int width, int height);
+
+// Fill a horizontal span, clipped to the buffer
+void framebufferSpan(const Framebuffer4& fb, int x, int y, int w, uint8_t level);
+
+// Fill an axis-aligned rectangle, clipped to the buffer
+void framebufferRect(const Framebuffer4& fb, int x, int y, int w, int h, uint8_t level);
+
+// Filled circle built from horizontal spans. Uses the same midpoint walk as
+// M5GFX fillCircle, so the pixels match the library primitive.
+void framebufferDisc(const Framebuffer4& fb, int cx, int cy, int r, uint8_t level);
+
+// Read back a pixel level (out-of-range reads return white)
+uint8_t framebufferGet(const Framebuffer4& fb, int x, int y);
+
+#endif // FRAMEBUFFER_H
@@ -0,0 +1,113 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <stdint.h>
+
+// Fixed-point geometry helpers for icon drawing.
+//
+// Every angle the icon set uses is a multiple of 30 degrees, so angles are
+// passed as "steps" (0..11, step * 30 degrees) and looked up in a Q14 table
+// instead of calling sin()/cos() per frame. The moon's phase is the one
+// angle that is not, and is turned from the nearest step. All results use floor semantics,
+// which matches the truncation of the old float code for on-screen
+// (positive) coordinates.
+
+#define GEOM_Q 14
+#define GEOM_ANGLE_STEPS 12
+
+// cos(step * 30deg) in Q14
+constexpr int16_t GEOM_COS_Q14[GEOM_ANGLE_STEPS] = {
+    16384, 14189, 8192, 0, -8192, -14189,
+    -16384, -14189, -8192, 0, 8192, 14189
+};
+
+// Fog wave offsets: (int)(sin(k * 0.45) * 2), one entry per 3-pixel step.
+// Covers fog lines up to ~190 px; longer lines wrap around the table.
+#define GEOM_FOG_WAVE_STEPS 64
+constexpr int8_t GEOM_FOG_WAVE[GEOM_FOG_WAVE_STEPS] = {
+    0, 0, 1, 1, 1, 1, 0, 0, 0, -1, -1, -1, -1, 0, 0, 0,
+    1, 1, 1, 1, 0, 0, 0, -1, -1, -1, -1, 0, 0, 0, 1, 1,
+    1, 1, 0, 0, 0, -1, -1, -1, -1, 0, 0, 0, 1, 1, 1, 1,
+    0, 0, 0, -1, -1, -1, -1, 0, 0, 0, 1, 1, 1, 1, 0, 0
+};
+
+// Floor division for a positive denominator
+static inline int32_t geomFloorDiv(int32_t num, int32_t den) {
+    int32_t q = num / den;
+    return (num % den != 0 && num < 0) ? q - 1 : q;
+}
+
+// floor(value * num / den), replaces float multipliers like r * 0.55
+static inline int32_t geomScale(int32_t value, int32_t num, int32_t den) {
+    return geomFloorDiv(value * num, den);
+}
+
+static inline int16_t geomCosQ14(int step) {
+    return GEOM_COS_Q14[((step % GEOM_ANGLE_STEPS) + GEOM_ANGLE_STEPS) % GEOM_ANGLE_STEPS];
+}
+
+// sin(a) = cos(a - 90deg)
+static inline int16_t geomSinQ14(int step) {
+    return geomCosQ14(step - 3);
+}
+
+// floor(cos(step * 30deg) * len * num / den)
+static inline int32_t geomCos(int step, int32_t len, int32_t num = 1, int32_t den = 1) {
+    return geomFloorDiv(geomCosQ14(step) * len * num, den << GEOM_Q);
+}
+
+// floor(sin(step * 30deg) * len * num / den)
+static inline int32_t geomSin(int step, int32_t len, int32_t num = 1, int32_t den = 1) {
+    return geomFloorDiv(geomSinQ14(step) * len * num, den << GEOM_Q);
+}
+
+// cos(turn / 65536 * 360deg) in Q14, for angles off the 30 degree grid
+// (the moon's phase): the nearest table step turned by the remainder,
+// under 15 degrees, whose sine and cosine short series give to within two
+// units of Q14
+static inline int32_t geomCosTurnQ14(uint16_t turn) {
+    int32_t scaled = (int32_t)turn * GEOM_ANGLE_STEPS;
+    int step = (scaled + 32768) >> 16;
+    // Remainder in Q14 radians: 1/65536 step is pi/6/65536 rad
+    int32_t b = geomFloorDiv((scaled - (step << 16)) * 8579, 1 << 16);
+    int32_t b2 = geomFloorDiv(b * b, 1 << GEOM_Q);
+    int32_t cosB = (1 << GEOM_Q) - b2 / 2 + geomFloorDiv(b2 * b2, 24 << GEOM_Q);
+    int32_t sinB = b - geomFloorDiv(b * b2, 6 << GEOM_Q);
+    return geomFloorDiv(geomCosQ14(step) * cosB - geomSinQ14(step) * sinB + (1 << (GEOM_Q - 1)),
+                        1 << GEOM_Q);
+}
+
+// floor(sqrt(n))
+static inline int32_t geomSqrt(uint32_t n) {
+    uint32_t root = 0;
+    for (uint32_t bit = 1u << 30; bit; bit >>= 2) {
+        if (n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+    }
+    return (int32_t)root;
+}
+
+// One row of a moon of radius r, dy from its centre, whose terminator is
+// cosQ14 (the cosine of the phase angle) of the way from the centre to the
+// limb: the rounded half-widths of the disc (limb) and of the terminator
+// ellipse (edge, negative past the centre)
+static inline void geomMoonRow(int r, int dy, int32_t cosQ14, int& edge, int& limb) {
+    uint32_t n = (uint32_t)(r * r - dy * dy);
+    limb = geomSqrt(n);
+    if (n > (uint32_t)(limb * limb + limb)) limb++;
+    // Half-width in 1/256 pixel (r up to 255), so the terminator rounds
+    // from close to the true width
+    int32_t w256 = geomSqrt(n << 16);
+    edge = geomFloorDiv(w256 * cosQ14 + (1 << (GEOM_Q + 7)), 1 << (GEOM_Q + 8));
+}
+
+// Vertical fog wave offset for the k-th 3-pixel step
+static inline int geomFogWave(int k) {
+    return GEOM_FOG_WAVE[k % GEOM_FOG_WAVE_STEPS];
+}
+
+#endif // GEOMETRY_H
@@ -1,10 +1,22 @@
 #include <M5Unified.h>
 #include <WiFi.h>
+#include <LittleFS.h>
 #include <time.h>
 #include "config.h"
 #include "weather_api.h"
 #include "display_manager.h"
 #include "sleep_manager.h"
+#include "settings_store.h"
+#include "weather_snapshot.h"
+#include "roll_forward.h"
+#include "observation_log.h"
+#include "observation_storage_fs.h"
+#include "wake_metrics.h"
+#include "timezone.h"
+#include "ulp_counters.h"
+#include "board.h"
+#include "wake_budget.h"
+#include "wake_events.h"
 
 // DEBUG MODE - set to false for production
 #define DEBUG_MODE false
@@ -14,39 +26,94 @@
 WeatherAPI weatherAPI;
 DisplayManager display;
 SleepManager sleepMgr;
+SettingsStore settingsStore;
+
+// Observation log index and staged records
+RTC_DATA_ATTR static ObsLogState obsLogState;
+
+// Scheduled updates shown since the last fetch (see FETCH_EVERY_UPDATES)
+RTC_DATA_ATTR static uint8_t updatesSinceFetch;
+
+// Snapshot read and write buffer, 1.3 KB, kept off the stack
+static WeatherSnapshot snapshotBuffer;
+
+// Hardware this wake brings up (see board.h)
+static BootProfile bootProfile = BootProfile::Update;
 
 // Function prototypes
+bool runClockTick();
+bool runRollForward();
+bool showCachedForecast();
+void startDisplay();
+void startWiFi();
 bool connectWiFi();
 void disconnectWiFi();
 bool syncTime();
+void retryLater(FailureClass failure, const String& message);
+bool mountStorage();
+void saveSnapshot(const WeatherData& data);
+void recordObservation(WeatherData& data);
+void loadTrend(WeatherData& data);
+void readTrend(ObservationLog& log, uint32_t now, int16_t tempDeci, ObservationTrend& trend);
 
 void setup() {
-    // Initialize M5Stack
-    auto cfg = M5.config();
-    cfg.serial_baudrate = 115200;
-    M5.begin(cfg);
+    // Apply the learned sleep timer error before anything reads the clock
+    sleepMgr.restoreClock();
+
+    // Between updates only the header clock changes: skip M5Unified, the
+    // settings, WiFi and JSON entirely
+    if (sleepMgr.isClockTickWake() && runClockTick()) {
+        return;
+    }
 
-    // Brief delay for initialization
-    delay(500);
+    // The board comes up when something is first drawn (startDisplay)
+    bool timerWake = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+    bootProfile = timerWake ? BootProfile::Update : BootProfile::Interactive;
+    boardBeginSerial(bootProfile);
 
     Serial.println("\n========================================");
     Serial.println("M5Stack Paper S3 Weather Display");
     Serial.println("========================================\n");
 
-    // Initialize display manager
-    display.begin();
-    display.renderStatus("Starting...");
+    // Load runtime settings; offer the serial console on power-on/reset
+    settingsStore.begin();
+    if (!timerWake) {
+        settingsStore.runSerialProvisioning(PROVISION_WINDOW_MS);
+    }
+    const Settings& appSettings = settings();
+    tzBegin();
+
+    UlpCounters ulp;
+    if (ulpCountersBegin(ulp)) {
+        ulpCountersPrint(ulp);
+    }
+
+    if (appSettings.wifiSsid[0] == '\0' || appSettings.apiKey[0] == '\0') {
+        Serial.println("WiFi or API key not configured - use the serial settings console");
+        retryLater(FailureClass::Config, "Not configured");
+        return;
+    }
+
+    // Between fetches the screen is rebuilt from the cached forecast
+    if (runRollForward()) {
+        return;
+    }
+
+    // From here on each phase has a deadline (see wake_budget.h)
+    budgetBegin(appSettings.wakeBudgetSeconds * 1000UL);
 
-    // Step 1: Connect to WiFi
+    // Step 1: Connect to WiFi. The association runs while the board and
+    // panel come up.
     Serial.println("Step 1: Connecting to WiFi...");
-    display.renderStatus("Connecting WiFi...");
+    budgetEnter(WakePhase::Connect);
+    boardMarkWork(bootProfile);
+    startWiFi();
+    startDisplay();
+    display.renderProgress(1, 3, "Connecting WiFi");
 
     if (!connectWiFi()) {
         Serial.println("WiFi connection failed!");
-        display.renderError("WiFi failed");
-        if (!DEBUG_MODE) {
-            sleepMgr.sleepForRetry();
-        }
+        retryLater(FailureClass::WiFi, "WiFi failed");
         return;
     }
 
@@ -56,33 +123,36 @@ void setup() {
 
     // Step 2: Sync time via NTP
     Serial.println("\nStep 2: Syncing time via NTP...");
-    display.renderStatus("Syncing time...");
+    budgetEnter(WakePhase::Time);
+    display.renderProgress(2, 3, "Syncing time");
 
     if (!syncTime()) {
         Serial.println("Time sync failed!");
-        display.renderError("Time sync failed");
         disconnectWiFi();
-        if (!DEBUG_MODE) {
-            sleepMgr.sleepForRetry();
-        }
+        retryLater(FailureClass::Time, "Time sync failed");
         return;
     }
 
     // Print current time
     time_t now;
     time(&now);
-    Serial.print("Current time: ");
-    Serial.println(ctime(&now));
+    struct tm local;
+    tzLocalTime(now, local);
+    Serial.printf("Current time: %04d-%02d-%02d %02d:%02d:%02d UTC%+g\n",
+                  local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+                  local.tm_hour, local.tm_min, local.tm_sec, tzOffsetAt(now) / 3600.0);
 
     // Step 3: Fetch weather data
     Serial.println("Step 3: Fetching weather data...");
-    display.renderStatus("Fetching weather...");
+    budgetEnter(WakePhase::Fetch);
+    display.renderProgress(3, 3, "Fetching weather");
 
     bool weatherSuccess = weatherAPI.fetchWeather(
-        LOCATION_LAT,
-        LOCATION_LON,
-        OWM_API_KEY,
-        WEATHER_UNITS
+        appSettings.lat,
+        appSettings.lon,
+        appSettings.apiKey,
+        appSettings.units,
+        appSettings.singleRequest
     );
 
     // Step 4: Disconnect WiFi to save power
@@ -92,22 +162,30 @@ void setup() {
     // Step 5: Render weather or error
     if (weatherSuccess) {
         Serial.println("\nStep 5: Rendering weather display...");
+        budgetEnter(WakePhase::Render);
         WeatherData& data = weatherAPI.getData();
+        if (appSettings.singleRequest) {
+            // Current values taken from a forecast slot are not observed
+            loadTrend(data);
+        } else {
+            recordObservation(data);
+        }
 
         Serial.printf("Current: %.1f°F, %s\n",
-                      data.current.temp,
-                      data.current.description.c_str());
+                      data.current.tempDeci / 10.0f,
+                      weatherDescription(data.current.weatherId));
         Serial.printf("Hourly forecasts: %d\n", data.hourlyCount);
         Serial.printf("Daily forecasts: %d\n", data.dailyCount);
 
         display.renderWeather(data);
+        display.prepareClockTick();
+        sleepMgr.recordSuccess();
+        saveSnapshot(data);
+        updatesSinceFetch = 0;
     } else {
         Serial.println("\nWeather fetch failed!");
         Serial.println("Error: " + weatherAPI.getError());
-        display.renderError(weatherAPI.getError());
-        if (!DEBUG_MODE) {
-            sleepMgr.sleepForRetry();
-        }
+        retryLater(weatherAPI.getFailureClass(), weatherAPI.getError());
         return;
     }
 
@@ -118,8 +196,73 @@ void setup() {
         Serial.println("DEBUG: Skipping deep sleep - staying awake");
         Serial.println("DEBUG: Will refresh every 60 seconds");
     } else {
-        sleepMgr.sleepUntilNextUpdate();
+        sleepMgr.sleepUntilNextTick();
+    }
+}
+
+bool runClockTick() {
+    boardBeginSerial(BootProfile::ClockTick);
+    boardMarkWork(BootProfile::ClockTick);
+    if (!display.renderClockTick(time(nullptr))) {
+        return false;
+    }
+    wakeMetrics().clockTick = true;  // Keeps the planned update, see sleepUntilNextTick
+    Serial.printf("Clock tick in %lu ms\n", millis());
+    if (!DEBUG_MODE) {
+        sleepMgr.sleepUntilNextTick();
+    }
+    return true;
+}
+
+bool runRollForward() {
+    const Settings& s = settings();
+    if (s.fetchEvery <= 1 || updatesSinceFetch + 1 >= s.fetchEvery) return false;
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER || !sleepMgr.isTimeSynced()) return false;
+
+    boardMarkWork(bootProfile);
+    if (!showCachedForecast()) {
+        Serial.println("Fetching instead");
+        return false;
+    }
+    updatesSinceFetch++;
+    if (!DEBUG_MODE) {
+        sleepMgr.sleepUntilNextTick();
+    }
+    return true;
+}
+
+// Draw the cached forecast rolled forward to now. False, with nothing
+// drawn, if the clock is unset or the cache is missing, stale or too short.
+bool showCachedForecast() {
+    const Settings& s = settings();
+    if (!sleepMgr.isTimeSynced() || !mountStorage()) return false;
+
+    const WeatherSnapshot* snap = snapshotReadFile(LittleFS, SNAPSHOT_PATH, snapshotBuffer);
+    if (!snap || !snapshotMatches(*snap, s.lat, s.lon, settingsImperial(s))) {
+        Serial.println("No usable cached forecast");
+        return false;
+    }
+    time_t now = time(nullptr);
+    if (now - (time_t)snap->header.createdAt > ROLL_FORWARD_MAX_AGE_SECONDS) {
+        Serial.println("Cached forecast too old");
+        return false;
+    }
+
+    WeatherData& data = weatherAPI.getData();
+    snapshotToWeather(*snap, data);
+    if (!rollForward(data, now, ROLL_FORWARD_MIN_SLOTS)) {
+        Serial.println("Cached forecast runs out too soon");
+        return false;
     }
+    loadTrend(data);
+
+    Serial.printf("Rolled forward %ld min from the cached forecast: %.1f°, %s\n",
+                  (long)(now - data.fetchedAt) / 60, data.current.tempDeci / 10.0f,
+                  weatherDescription(data.current.weatherId));
+    startDisplay();
+    display.renderWeather(data);
+    display.prepareClockTick();
+    return true;
 }
 
 void loop() {
@@ -138,25 +281,128 @@ void loop() {
     }
 }
 
-bool connectWiFi() {
+void retryLater(FailureClass failure, const String& message) {
+    // Backoff depends on the failure class and how often it has repeated
+    WakeMetrics& metrics = wakeMetrics();
+    metrics.failure = failure;
+    int32_t seconds = sleepMgr.planRetry(failure);
+
+    // Notes the phase in the metrics if it ran out of time
+    budgetExpired();
+    budgetEnter(WakePhase::Render);
+
+    // A stall or outage that will be retried keeps a forecast on screen:
+    // the cached one rolled forward, when there is one, not an error
+    if (!retryRule(failure).waitForSchedule && showCachedForecast()) {
+        metrics.cachedFallback = true;
+    } else {
+        startDisplay();
+        display.renderError(message.c_str(), seconds);
+    }
+    if (!DEBUG_MODE) {
+        sleepMgr.enterDeepSleep(seconds);
+    }
+}
+
+bool mountStorage() {
+    static bool mounted = false;
+    if (!mounted) {
+        mounted = LittleFS.begin(true);
+        if (!mounted) Serial.println("LittleFS mount failed");
+    }
+    return mounted;
+}
+
+void saveSnapshot(const WeatherData& data) {
+    if (!mountStorage()) return;
+
+    const Settings& s = settings();
+    snapshotFromWeather(data, s.lat, s.lon, settingsImperial(s), (uint32_t)time(nullptr), snapshotBuffer);
+    if (!snapshotWriteFile(LittleFS, SNAPSHOT_PATH, snapshotBuffer)) {
+        Serial.println("Snapshot write failed");
+    }
+}
+
+void recordObservation(WeatherData& data) {
+    if (!mountStorage()) return;
+
+    ObservationStorageFs storage(LittleFS, OBS_LOG_DIR);
+    ObservationLog log(obsLogState, storage);
+    log.begin();
+
+    ObservationRecord record = {};
+    record.timestamp = (uint32_t)data.current.timestamp;
+    record.tempDeci = data.current.tempDeci;
+    record.feelsLikeDeci = data.current.feelsLikeDeci;
+    record.pressure = data.current.pressure;
+    record.windSpeedDeci = data.current.windSpeedDeci;
+    record.weatherId = data.current.weatherId;
+    record.humidity = data.current.humidity;
+    log.append(record);
+    readTrend(log, record.timestamp, record.tempDeci, data.trend);
+
+    Serial.printf("Observation log: %u records\n", (unsigned)log.count());
+}
+
+// Trend for a rolled-forward update or a single-request fetch: the log is
+// read, not appended to, since the current values are forecast rather than
+// observed
+void loadTrend(WeatherData& data) {
+    data.trend.hasRange = false;
+    data.trend.hasYesterday = false;
+    if (!mountStorage()) return;
+
+    ObservationStorageFs storage(LittleFS, OBS_LOG_DIR);
+    ObservationLog log(obsLogState, storage);
+    log.begin();
+    readTrend(log, (uint32_t)data.current.timestamp, data.current.tempDeci, data.trend);
+}
+
+// 24 h range (up to now) and the change since the reading closest to 24 h ago
+void readTrend(ObservationLog& log, uint32_t now, int16_t tempDeci, ObservationTrend& trend) {
+    ObsRange range;
+    trend.hasRange = log.range(now - 24 * 3600, now, range) && range.count > 1;
+    if (trend.hasRange) {
+        trend.low24hDeci = range.minDeci;
+        trend.high24hDeci = range.maxDeci;
+    }
+    ObservationRecord past;
+    trend.hasYesterday = log.nearest(now - 24 * 3600, OBS_YESTERDAY_TOLERANCE_SECONDS, past);
+    if (trend.hasYesterday) {
+        trend.vsYesterdayDeci = tempDeci - past.tempDeci;
+    }
+}
+
+// Board and panel, on first use
+void startDisplay() {
+    static bool started = false;
+    if (started) return;
+    started = true;
+    boardBegin(bootProfile);
+    display.begin();
+}
+
+// Start associating; connectWiFi() waits for it
+void startWiFi() {
+    wakeEventsBegin();
     WiFi.mode(WIFI_STA);
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    WiFi.begin(settings().wifiSsid, settings().wifiPassword);
+}
 
+bool connectWiFi() {
     Serial.print("Connecting to ");
-    Serial.print(WIFI_SSID);
+    Serial.println(settings().wifiSsid);
 
     unsigned long startTime = millis();
 
-    while (WiFi.status() != WL_CONNECTED) {
-        if (millis() - startTime > WIFI_TIMEOUT_MS) {
-            Serial.println("\nConnection timeout!");
-            return false;
-        }
-        delay(500);
-        Serial.print(".");
+    // Woken by the driver's got-IP event, or at the phase's deadline
+    if (!wakeWaitAny(WAKE_EVENT_WIFI_UP)) {
+        budgetExpired();  // Notes the overrun
+        Serial.printf("Connection timeout after %lu ms!\n", millis() - startTime);
+        return false;
     }
 
-    Serial.println(" Connected!");
+    Serial.printf("Connected in %lu ms!\n", millis() - startTime);
     return true;
 }
 
@@ -175,30 +421,38 @@ bool syncTime() {
     };
     const int numServers = 3;
 
+    // After a timer wake the RTC has kept the time. NTP then only refines
+    // it (and measures the sleep timer), which can finish in the background
+    // while the weather is fetched.
+    sleepMgr.watchTimeSync();
+    if (sleepMgr.isTimeSynced()) {
+        configTime(0, 0, ntpServers[0], ntpServers[1], ntpServers[2]);
+        Serial.println("Clock kept through deep sleep, NTP refines it in the background");
+        return true;
+    }
+
     for (int server = 0; server < numServers; server++) {
         Serial.printf("Trying NTP server: %s\n", ntpServers[server]);
 
-        // Configure NTP with current server
-        configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, ntpServers[server]);
+        // Configure NTP with current server. The system clock stays UTC;
+        // local time comes from timezone.h.
+        configTime(0, 0, ntpServers[server]);
 
-        Serial.print("Waiting for NTP time sync");
+        Serial.println("Waiting for NTP time sync");
 
-        // Wait for time to be set (max 15 seconds per server)
-        int retry = 0;
-        const int maxRetries = 30;
+        // Wait for time to be set: up to 15 seconds per server, less when
+        // the servers left have to share what remains of the phase
+        uint32_t waitMs = budgetRemainingMs() / (numServers - server);
+        if (waitMs > 15000) waitMs = 15000;
 
-        while (!sleepMgr.isTimeSynced() && retry < maxRetries) {
-            delay(500);
-            Serial.print(".");
-            retry++;
-        }
-
-        Serial.println();
-
-        if (sleepMgr.isTimeSynced()) {
+        if (wakeWaitAny(WAKE_EVENT_TIME_SYNCED, waitMs)) {
             Serial.println("Time synchronized!");
             return true;
         }
+        if (budgetExpired()) {
+            Serial.println("Out of time for NTP");
+            return false;
+        }
 
         Serial.println("Server timeout, trying next...");
     }
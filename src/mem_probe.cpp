@@ -0,0 +1,130 @@
+#include "mem_probe.h"
+#include "config.h"
+#include <Arduino.h>
+
+bool memProbeOverBudget(const MemWakeRecord& record, WakePhase& phase, const char*& what) {
+    for (int i = 0; i < (int)WakePhase::Count; i++) {
+        if (!(record.sampled & (1 << i))) continue;
+        const MemSample& s = record.samples[i];
+        what = s.internalMinFree < MEM_BUDGET_INTERNAL_FREE ? "internal heap" :
+               s.internalLargest < MEM_BUDGET_INTERNAL_BLOCK ? "internal block" :
+               s.stackFree < MEM_BUDGET_STACK_FREE ? "stack" : nullptr;
+        if (what) {
+            phase = (WakePhase)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef WAKE_MEM_PROBES
+
+#define MEM_LOG_MAGIC 0x4D454D31
+
+struct MemLog {
+    uint32_t magic;
+    uint32_t wakes;  // Records started since the log was created
+    MemWakeRecord records[MEM_LOG_WAKES];
+};
+
+// Survives resets as well as deep sleep; garbage after power-on until the
+// magic is set
+RTC_NOINIT_ATTR static MemLog memLog;
+
+static MemWakeRecord* record = nullptr;
+
+static void takeSample(MemSample& s) {
+    s.internalFree = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    s.internalMinFree = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    s.internalLargest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    s.psramFree = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    s.psramMinFree = heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM);
+    s.psramLargest = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+    s.stackFree = uxTaskGetStackHighWaterMark(nullptr);  // Bytes on ESP-IDF
+}
+
+static void keepLowest(uint32_t& kept, uint32_t value) {
+    if (value < kept) kept = value;
+}
+
+static void printSample(const char* label, const MemSample& s) {
+    Serial.printf("    %-8s  %6.1f / %6.1f / %6.1f   %6lu / %6lu / %6lu   %5lu\n", label,
+                  s.internalFree / 1024.0f, s.internalMinFree / 1024.0f, s.internalLargest / 1024.0f,
+                  (unsigned long)s.psramFree / 1024, (unsigned long)s.psramMinFree / 1024,
+                  (unsigned long)s.psramLargest / 1024, (unsigned long)s.stackFree);
+}
+
+static const char* sampleLabel(int phase) {
+    return phase == (int)WakePhase::None ? "start" : wakePhaseName((WakePhase)phase);
+}
+
+// Sample into the record's slot for phase, keeping the lowest values if
+// it already has one
+static void store(WakePhase phase) {
+    int i = (int)phase;
+    MemSample s;
+    takeSample(s);
+    if (record->sampled & (1 << i)) {
+        MemSample& kept = record->samples[i];
+        keepLowest(kept.internalFree, s.internalFree);
+        keepLowest(kept.internalMinFree, s.internalMinFree);
+        keepLowest(kept.internalLargest, s.internalLargest);
+        keepLowest(kept.psramFree, s.psramFree);
+        keepLowest(kept.psramMinFree, s.psramMinFree);
+        keepLowest(kept.psramLargest, s.psramLargest);
+        keepLowest(kept.stackFree, s.stackFree);
+    } else {
+        record->samples[i] = s;
+        record->sampled |= 1 << i;
+    }
+    record->lastSample = (uint8_t)i;
+}
+
+void memProbeBegin() {
+    if (memLog.magic != MEM_LOG_MAGIC) {
+        memset(&memLog, 0, sizeof(memLog));
+        memLog.magic = MEM_LOG_MAGIC;
+    } else if (memLog.wakes > 0) {
+        const MemWakeRecord& last = memLog.records[(memLog.wakes - 1) % MEM_LOG_WAKES];
+        if (!last.finished && last.sampled) {
+            Serial.printf("Memory: the last update wake stopped in %s (this boot: reset reason %d)\n",
+                          wakePhaseName((WakePhase)last.phase), esp_reset_reason());
+            printSample(sampleLabel(last.lastSample), last.samples[last.lastSample]);
+        }
+    }
+
+    record = &memLog.records[memLog.wakes % MEM_LOG_WAKES];
+    memset(record, 0, sizeof(*record));
+    record->wake = memLog.wakes++;
+    record->resetReason = (uint8_t)esp_reset_reason();
+    store(WakePhase::None);
+}
+
+void memProbeSample(WakePhase ended, WakePhase next) {
+    if (!record) return;
+    record->phase = (uint8_t)next;
+    if (ended != WakePhase::None) store(ended);
+}
+
+void memProbeEnd() {
+    if (record) record->finished = 1;
+}
+
+void memProbePrint() {
+    if (!record) return;
+    Serial.println("  Memory:           KB free / lowest / largest block, internal then PSRAM; stack bytes free");
+    for (int i = 0; i < (int)WakePhase::Count; i++) {
+        if (record->sampled & (1 << i)) printSample(sampleLabel(i), record->samples[i]);
+    }
+    WakePhase phase;
+    const char* what;
+    if (memProbeOverBudget(*record, phase, what)) {
+        Serial.printf("  Memory budget:    %s too low in %s\n", what, sampleLabel((int)phase));
+    }
+}
+
+const MemWakeRecord* memProbeRecord() {
+    return record;
+}
+
+#endif
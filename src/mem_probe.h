@@ -0,0 +1,78 @@
+#ifndef MEM_PROBE_H
+#define MEM_PROBE_H
+
+#include <stdint.h>
+#include "wake_budget.h"
+
+// Optional memory instrumentation for update wakes. Define
+// WAKE_MEM_PROBES (build_flags) to sample the heap and the loop task's
+// stack at every phase boundary (budgetBegin and each budgetEnter): free
+// bytes, the lowest free since boot and the largest free block, for
+// internal RAM and PSRAM, and how much of the stack was never touched.
+// The lowest free and the stack mark only go down, so the first phase
+// whose sample shows a new low is the one that reached it.
+//
+// The samples go straight into a log of the last MEM_LOG_WAKES update
+// wakes in RTC memory that a reset does not clear. The first update wake
+// after a crash reports the phase the crashed wake was in and what it had
+// left at the last boundary it passed.
+//
+// Without the flag the hooks compile to nothing.
+
+#define MEM_LOG_WAKES 4
+
+struct MemSample {
+    uint32_t internalFree;
+    uint32_t internalMinFree;    // Lowest since boot
+    uint32_t internalLargest;    // Largest free block
+    uint32_t psramFree;
+    uint32_t psramMinFree;
+    uint32_t psramLargest;
+    uint32_t stackFree;          // Loop task stack never used so far
+};
+
+struct MemWakeRecord {
+    uint32_t wake;               // Sequence number in the log
+    uint8_t resetReason;         // esp_reset_reason() of this boot
+    uint8_t sampled;             // Bit per WakePhase with a sample
+    uint8_t lastSample;          // Phase of the newest sample
+    uint8_t phase;               // Phase running since then
+    uint8_t finished;            // Reached deep sleep
+    // [None] when the budget starts, the others when their phase ends
+    // (the lowest of each value if the phase ran more than once)
+    MemSample samples[(int)WakePhase::Count];
+};
+
+// First phase of the record whose sample breaks a MEM_BUDGET_* limit
+// (config.h), and what it broke. False when all are within budget.
+bool memProbeOverBudget(const MemWakeRecord& record, WakePhase& phase, const char*& what);
+
+#ifdef WAKE_MEM_PROBES
+
+// Start this wake's record, after reporting a previous wake that never
+// reached deep sleep (budgetBegin)
+void memProbeBegin();
+
+// Sample at the end of a phase, as the next one starts (budgetEnter)
+void memProbeSample(WakePhase ended, WakePhase next);
+
+// Mark the record finished (before deep sleep)
+void memProbeEnd();
+
+// Log this wake's samples and any budget overrun
+void memProbePrint();
+
+// This wake's record, or nullptr if it has none
+const MemWakeRecord* memProbeRecord();
+
+#else
+
+inline void memProbeBegin() {}
+inline void memProbeSample(WakePhase, WakePhase) {}
+inline void memProbeEnd() {}
+inline void memProbePrint() {}
+inline const MemWakeRecord* memProbeRecord() { return nullptr; }
+
+#endif
+
+#endif // MEM_PROBE_H
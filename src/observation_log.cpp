@@ -0,0 +1,247 @@
+#include "observation_log.h"
+#include <string.h>
+
+#define OBS_LOG_MAGIC 0x4F425331  // "OBS1"
+
+static_assert(sizeof(ObservationRecord) == 16, "observation record layout changed");
+
+ObservationLog::ObservationLog(ObsLogState& state, ObservationStorage& storage)
+    : state(state), storage(storage) {
+}
+
+void ObservationLog::begin() {
+    if (state.magic == OBS_LOG_MAGIC) return;
+    rebuild();
+}
+
+void ObservationLog::rebuild() {
+    memset(&state, 0, sizeof(state));
+    state.magic = OBS_LOG_MAGIC;
+
+    uint32_t found[OBS_MAX_SEGMENTS * 2];
+    int n = storage.list(found, OBS_MAX_SEGMENTS * 2);
+
+    // Oldest first
+    for (int i = 1; i < n; i++) {
+        uint32_t seq = found[i];
+        int j = i - 1;
+        while (j >= 0 && found[j] > seq) {
+            found[j + 1] = found[j];
+            j--;
+        }
+        found[j + 1] = seq;
+    }
+
+    // Leftovers beyond the limit (e.g. after a crash mid-rotation)
+    int first = n > OBS_MAX_SEGMENTS ? n - OBS_MAX_SEGMENTS : 0;
+    for (int i = 0; i < first; i++) {
+        storage.remove(found[i]);
+    }
+
+    ObservationRecord records[OBS_BUCKET_RECORDS];
+    for (int i = first; i < n; i++) {
+        ObsSegment& segment = state.segments[state.segmentCount++];
+        segment.sequence = found[i];
+        state.nextSequence = found[i] + 1;
+
+        // A torn final write leaves a partial record: ignore it
+        size_t stored = storage.size(found[i]) / sizeof(ObservationRecord);
+        if (stored > OBS_SEGMENT_RECORDS) stored = OBS_SEGMENT_RECORDS;
+
+        for (size_t start = 0; start < stored; start += OBS_BUCKET_RECORDS) {
+            size_t chunk = stored - start < OBS_BUCKET_RECORDS ? stored - start : OBS_BUCKET_RECORDS;
+            if (!storage.read(segment.sequence, start * sizeof(ObservationRecord), records,
+                              chunk * sizeof(ObservationRecord))) {
+                break;
+            }
+            for (size_t k = 0; k < chunk; k++) {
+                addToIndex(segment, records[k]);
+            }
+        }
+    }
+
+    // The tail may end in a torn record; new records go to a fresh segment
+    state.tailSealed = 1;
+}
+
+bool ObservationLog::append(const ObservationRecord& record) {
+    if (state.stageCount >= OBS_STAGE_RECORDS) {
+        flush();
+    }
+    if (state.stageCount >= OBS_STAGE_RECORDS) {
+        // Storage is failing: drop the oldest staged record
+        memmove(&state.stage[0], &state.stage[1], sizeof(state.stage) - sizeof(state.stage[0]));
+        state.stageCount--;
+    }
+    state.stage[state.stageCount++] = record;
+    if (state.stageCount == OBS_STAGE_RECORDS) {
+        return flush();
+    }
+    return true;
+}
+
+bool ObservationLog::flush() {
+    int done = 0;
+    while (done < state.stageCount) {
+        if (state.segmentCount == 0 || state.tailSealed ||
+            state.segments[state.segmentCount - 1].count >= OBS_SEGMENT_RECORDS) {
+            startSegment();
+            state.tailSealed = 0;
+        }
+        ObsSegment& segment = state.segments[state.segmentCount - 1];
+
+        int n = state.stageCount - done;
+        int room = OBS_SEGMENT_RECORDS - segment.count;
+        if (n > room) n = room;
+
+        if (!storage.write(segment.sequence, segment.count * sizeof(ObservationRecord),
+                           &state.stage[done], n * sizeof(ObservationRecord))) {
+            break;
+        }
+        for (int k = 0; k < n; k++) {
+            addToIndex(segment, state.stage[done + k]);
+        }
+        done += n;
+    }
+
+    // Keep whatever could not be written
+    state.stageCount -= done;
+    memmove(&state.stage[0], &state.stage[done], state.stageCount * sizeof(ObservationRecord));
+    return state.stageCount == 0;
+}
+
+void ObservationLog::startSegment() {
+    if (state.segmentCount == OBS_MAX_SEGMENTS) {
+        storage.remove(state.segments[0].sequence);
+        memmove(&state.segments[0], &state.segments[1],
+                (OBS_MAX_SEGMENTS - 1) * sizeof(ObsSegment));
+        state.segmentCount--;
+    }
+
+    ObsSegment& segment = state.segments[state.segmentCount];
+    memset(&segment, 0, sizeof(segment));
+    segment.sequence = state.nextSequence;
+
+    // A file left over from a lost RTC state must not be appended to
+    storage.remove(segment.sequence);
+
+    state.nextSequence++;
+    state.segmentCount++;
+}
+
+void ObservationLog::addToIndex(ObsSegment& segment, const ObservationRecord& record) {
+    ObsBucket& bucket = segment.buckets[segment.count / OBS_BUCKET_RECORDS];
+    if (segment.count % OBS_BUCKET_RECORDS == 0) {
+        bucket.startTs = record.timestamp;
+        bucket.endTs = record.timestamp;
+        bucket.minDeci = record.tempDeci;
+        bucket.maxDeci = record.tempDeci;
+    } else {
+        // Min/max rather than first/last: the clock can step backwards
+        if (record.timestamp < bucket.startTs) bucket.startTs = record.timestamp;
+        if (record.timestamp > bucket.endTs) bucket.endTs = record.timestamp;
+        if (record.tempDeci < bucket.minDeci) bucket.minDeci = record.tempDeci;
+        if (record.tempDeci > bucket.maxDeci) bucket.maxDeci = record.tempDeci;
+    }
+    segment.count++;
+}
+
+int ObservationLog::bucketCount(const ObsSegment& segment, int bucket) const {
+    int n = segment.count - bucket * OBS_BUCKET_RECORDS;
+    if (n < 0) return 0;
+    return n > OBS_BUCKET_RECORDS ? OBS_BUCKET_RECORDS : n;
+}
+
+bool ObservationLog::readBucket(const ObsSegment& segment, int bucket, ObservationRecord* records) {
+    return storage.read(segment.sequence, bucket * OBS_BUCKET_RECORDS * sizeof(ObservationRecord),
+                        records, bucketCount(segment, bucket) * sizeof(ObservationRecord));
+}
+
+static void rangeAdd(ObsRange& result, int16_t minDeci, int16_t maxDeci, int count) {
+    if (result.count == 0 || minDeci < result.minDeci) result.minDeci = minDeci;
+    if (result.count == 0 || maxDeci > result.maxDeci) result.maxDeci = maxDeci;
+    result.count += count;
+}
+
+bool ObservationLog::range(uint32_t from, uint32_t to, ObsRange& result) {
+    memset(&result, 0, sizeof(result));
+    ObservationRecord records[OBS_BUCKET_RECORDS];
+
+    for (int s = 0; s < state.segmentCount; s++) {
+        const ObsSegment& segment = state.segments[s];
+        for (int b = 0; b < OBS_BUCKETS_PER_SEGMENT; b++) {
+            int n = bucketCount(segment, b);
+            if (n == 0) break;
+            const ObsBucket& bucket = segment.buckets[b];
+            if (bucket.endTs < from || bucket.startTs > to) continue;
+
+            // Whole bucket inside the range: the index has the answer
+            if (bucket.startTs >= from && bucket.endTs <= to) {
+                rangeAdd(result, bucket.minDeci, bucket.maxDeci, n);
+                continue;
+            }
+
+            if (!readBucket(segment, b, records)) continue;
+            for (int k = 0; k < n; k++) {
+                if (records[k].timestamp >= from && records[k].timestamp <= to) {
+                    rangeAdd(result, records[k].tempDeci, records[k].tempDeci, 1);
+                }
+            }
+        }
+    }
+
+    for (int k = 0; k < state.stageCount; k++) {
+        const ObservationRecord& r = state.stage[k];
+        if (r.timestamp >= from && r.timestamp <= to) {
+            rangeAdd(result, r.tempDeci, r.tempDeci, 1);
+        }
+    }
+    return result.count > 0;
+}
+
+static uint32_t distance(uint32_t a, uint32_t b) {
+    return a > b ? a - b : b - a;
+}
+
+bool ObservationLog::nearest(uint32_t t, uint32_t tolerance, ObservationRecord& result) {
+    uint32_t best = tolerance + 1;
+    ObservationRecord records[OBS_BUCKET_RECORDS];
+    uint32_t from = t > tolerance ? t - tolerance : 0;
+    uint32_t to = t + tolerance;
+
+    for (int s = 0; s < state.segmentCount; s++) {
+        const ObsSegment& segment = state.segments[s];
+        for (int b = 0; b < OBS_BUCKETS_PER_SEGMENT; b++) {
+            int n = bucketCount(segment, b);
+            if (n == 0) break;
+            const ObsBucket& bucket = segment.buckets[b];
+            if (bucket.endTs < from || bucket.startTs > to) continue;
+
+            if (!readBucket(segment, b, records)) continue;
+            for (int k = 0; k < n; k++) {
+                uint32_t d = distance(records[k].timestamp, t);
+                if (d < best) {
+                    best = d;
+                    result = records[k];
+                }
+            }
+        }
+    }
+
+    for (int k = 0; k < state.stageCount; k++) {
+        uint32_t d = distance(state.stage[k].timestamp, t);
+        if (d < best) {
+            best = d;
+            result = state.stage[k];
+        }
+    }
+    return best <= tolerance;
+}
+
+uint32_t ObservationLog::count() const {
+    uint32_t total = state.stageCount;
+    for (int s = 0; s < state.segmentCount; s++) {
+        total += state.segments[s].count;
+    }
+    return total;
+}
@@ -0,0 +1,124 @@
+#ifndef OBSERVATION_LOG_H
+#define OBSERVATION_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Append-only log of current conditions, one fixed-size record per wake,
+// for "vs yesterday" and 24 h high/low without extra API calls.
+//
+// Records live in segment files of OBS_SEGMENT_RECORDS (one 4 KB flash
+// block each), named by an increasing sequence number. When the log is
+// full the oldest segment is deleted. LittleFS allocates blocks
+// round-robin, so rotating whole segments spreads wear over the
+// partition.
+//
+// New records are staged in RTC memory and written OBS_STAGE_RECORDS at a
+// time. LittleFS copies a file's partly filled tail block on every
+// append, so batching cuts flash writes several-fold. Up to
+// OBS_STAGE_RECORDS - 1 records are lost on a power cut.
+//
+// The index is also kept in RTC memory. It holds the time span and the
+// temperature min/max of every OBS_BUCKET_RECORDS-record bucket. Range
+// queries read from flash only the buckets a range cuts through. After a
+// power cut the index is rebuilt by scanning the segments.
+#define OBS_SEGMENT_RECORDS 256
+#define OBS_BUCKET_RECORDS 32
+#define OBS_BUCKETS_PER_SEGMENT (OBS_SEGMENT_RECORDS / OBS_BUCKET_RECORDS)
+#define OBS_MAX_SEGMENTS 16    // ~4000 observations
+#define OBS_STAGE_RECORDS 8
+
+struct ObservationRecord {
+    uint32_t timestamp;
+    int16_t tempDeci;
+    int16_t feelsLikeDeci;
+    uint16_t pressure;
+    uint16_t windSpeedDeci;
+    uint16_t weatherId;
+    uint8_t humidity;
+    uint8_t reserved;
+};
+
+// Summary of up to OBS_BUCKET_RECORDS consecutive records
+struct ObsBucket {
+    uint32_t startTs;     // Earliest timestamp in the bucket
+    uint32_t endTs;       // Latest timestamp in the bucket
+    int16_t minDeci;
+    int16_t maxDeci;
+};
+
+struct ObsSegment {
+    uint32_t sequence;
+    uint16_t count;
+    uint16_t reserved;
+    ObsBucket buckets[OBS_BUCKETS_PER_SEGMENT];
+};
+
+// Everything the log keeps between wakes (RTC memory)
+struct ObsLogState {
+    uint32_t magic;
+    uint32_t nextSequence;
+    uint8_t segmentCount;
+    uint8_t stageCount;
+    uint8_t tailSealed;   // Newest segment takes no more appends
+    uint8_t reserved;
+    ObsSegment segments[OBS_MAX_SEGMENTS];  // Oldest first
+    ObservationRecord stage[OBS_STAGE_RECORDS];
+};
+
+struct ObsRange {
+    uint16_t count;
+    int16_t minDeci;
+    int16_t maxDeci;
+};
+
+// Where segments are stored. Offsets and sizes are in bytes.
+class ObservationStorage {
+public:
+    virtual ~ObservationStorage() {}
+
+    // Sequence numbers of the stored segments, in any order
+    virtual int list(uint32_t* sequences, int max) = 0;
+    virtual size_t size(uint32_t sequence) = 0;
+    virtual bool read(uint32_t sequence, size_t offset, void* buffer, size_t length) = 0;
+    // Write at offset, creating the segment when offset is 0. The log
+    // passes the end of its last whole record, so a retry after a short
+    // write replaces the partial record instead of landing behind it.
+    virtual bool write(uint32_t sequence, size_t offset, const void* data, size_t length) = 0;
+    virtual bool remove(uint32_t sequence) = 0;
+};
+
+class ObservationLog {
+public:
+    ObservationLog(ObsLogState& state, ObservationStorage& storage);
+
+    // Use the RTC index, or rebuild it from storage after a power cut
+    void begin();
+
+    // Add a record; it is written to storage once the stage is full
+    bool append(const ObservationRecord& record);
+
+    // Write staged records to storage now
+    bool flush();
+
+    // Temperature min/max over [from, to]; false if no record falls in it
+    bool range(uint32_t from, uint32_t to, ObsRange& result);
+
+    // The record closest to t, at most tolerance seconds away
+    bool nearest(uint32_t t, uint32_t tolerance, ObservationRecord& result);
+
+    // Total records, stored and staged
+    uint32_t count() const;
+
+private:
+    ObsLogState& state;
+    ObservationStorage& storage;
+
+    void rebuild();
+    void startSegment();
+    void addToIndex(ObsSegment& segment, const ObservationRecord& record);
+    int bucketCount(const ObsSegment& segment, int bucket) const;
+    bool readBucket(const ObsSegment& segment, int bucket, ObservationRecord* records);
+};
+
+#endif // OBSERVATION_LOG_H
@@ -0,0 +1,60 @@
+#include "observation_storage_fs.h"
+
+ObservationStorageFs::ObservationStorageFs(fs::FS& fs, const char* dir)
+    : fs(fs), dir(dir) {
+}
+
+String ObservationStorageFs::path(uint32_t sequence) {
+    char name[16];
+    snprintf(name, sizeof(name), "/%08x.obs", (unsigned)sequence);
+    return String(dir) + name;
+}
+
+int ObservationStorageFs::list(uint32_t* sequences, int max) {
+    File root = fs.open(dir);
+    if (!root || !root.isDirectory()) {
+        fs.mkdir(dir);
+        return 0;
+    }
+
+    int n = 0;
+    File file = root.openNextFile();
+    while (file && n < max) {
+        // Entry names may or may not include the directory
+        const char* name = file.name();
+        const char* slash = strrchr(name, '/');
+        if (slash) name = slash + 1;
+
+        char* end;
+        uint32_t sequence = strtoul(name, &end, 16);
+        if (end != name && strcmp(end, ".obs") == 0) {
+            sequences[n++] = sequence;
+        }
+        file = root.openNextFile();
+    }
+    return n;
+}
+
+size_t ObservationStorageFs::size(uint32_t sequence) {
+    File file = fs.open(path(sequence).c_str(), FILE_READ);
+    if (!file) return 0;
+    return file.size();
+}
+
+bool ObservationStorageFs::read(uint32_t sequence, size_t offset, void* buffer, size_t length) {
+    File file = fs.open(path(sequence).c_str(), FILE_READ);
+    if (!file || !file.seek(offset)) return false;
+    return file.read((uint8_t*)buffer, length) == length;
+}
+
+bool ObservationStorageFs::write(uint32_t sequence, size_t offset, const void* data, size_t length) {
+    // "r+" writes where we seek to; append mode would always write at the end
+    File file = fs.open(path(sequence).c_str(), offset == 0 ? FILE_WRITE : "r+");
+    if (!file || !file.seek(offset)) return false;
+    return file.write((const uint8_t*)data, length) == length;
+}
+
+bool ObservationStorageFs::remove(uint32_t sequence) {
+    String p = path(sequence);
+    return !fs.exists(p.c_str()) || fs.remove(p.c_str());
+}
@@ -0,0 +1,25 @@
+#ifndef OBSERVATION_STORAGE_FS_H
+#define OBSERVATION_STORAGE_FS_H
+
+#include <FS.h>
+#include "observation_log.h"
+
+// Observation log segments as files "<dir>/<sequence in hex>.obs"
+class ObservationStorageFs : public ObservationStorage {
+public:
+    ObservationStorageFs(fs::FS& fs, const char* dir);
+
+    int list(uint32_t* sequences, int max) override;
+    size_t size(uint32_t sequence) override;
+    bool read(uint32_t sequence, size_t offset, void* buffer, size_t length) override;
+    bool write(uint32_t sequence, size_t offset, const void* data, size_t length) override;
+    bool remove(uint32_t sequence) override;
+
+private:
+    fs::FS& fs;
+    const char* dir;
+
+    String path(uint32_t sequence);
+};
+
+#endif // OBSERVATION_STORAGE_FS_H
@@ -0,0 +1,91 @@
+#include "retry_policy.h"
+#include <string.h>
+
+#define RETRY_STATE_MAGIC 0x52545259  // "RTRY"
+
+// Don't schedule a retry this close to (or past) the regular update
+#define RETRY_SCHEDULE_MARGIN_SECONDS 600
+
+static const RetryRule RULES[(int)FailureClass::Count] = {
+    // multiplier, maxSeconds, jitter%, waitForSchedule
+    {1, 3600, 0, false},       // None
+    {1, 2 * 3600, 20, false},  // WiFi: router outages can last hours
+    {1, 2 * 3600, 20, false},  // Time
+    {1, 2 * 3600, 20, false},  // Dns
+    {1, 2 * 3600, 20, false},  // Tls
+    {1, 6 * 3600, 0, true},    // HttpAuth: needs a new key, don't hammer
+    {3, 3 * 3600, 30, false},  // HttpRateLimit: start at 3x base
+    {1, 2 * 3600, 20, false},  // HttpServer
+    {2, 2 * 3600, 20, false},  // HttpOther
+    {1, 2 * 3600, 20, false},  // Json
+    {1, 6 * 3600, 0, true},    // Config: waits for provisioning
+};
+
+static const char* NAMES[(int)FailureClass::Count] = {
+    "none", "wifi", "time", "dns", "tls", "http-401", "http-429",
+    "http-5xx", "http", "json", "config"
+};
+
+const RetryRule& retryRule(FailureClass cls) {
+    int i = (int)cls;
+    if (i >= (int)FailureClass::Count) i = 0;
+    return RULES[i];
+}
+
+const char* failureClassName(FailureClass cls) {
+    int i = (int)cls;
+    if (i >= (int)FailureClass::Count) i = 0;
+    return NAMES[i];
+}
+
+void retryInit(RetryState& state) {
+    if (state.magic == RETRY_STATE_MAGIC) return;
+    memset(&state, 0, sizeof(state));
+    state.magic = RETRY_STATE_MAGIC;
+}
+
+void retryRecordSuccess(RetryState& state) {
+    memset(&state, 0, sizeof(state));
+    state.magic = RETRY_STATE_MAGIC;
+}
+
+uint32_t retryRecordFailure(RetryState& state, FailureClass cls, uint32_t baseSeconds,
+                            int32_t secondsUntilScheduled, uint32_t random) {
+    retryInit(state);
+
+    uint8_t& streak = state.consecutive[(int)cls];
+    if (streak < 255) streak++;
+    if (state.failuresSinceSuccess < 0xFFFF) state.failuresSinceSuccess++;
+    state.lastFailure = cls;
+
+    const RetryRule& rule = retryRule(cls);
+    bool scheduleKnown = secondsUntilScheduled > 0;
+
+    if (rule.waitForSchedule && scheduleKnown) {
+        return secondsUntilScheduled;
+    }
+
+    // Exponential backoff, shift capped so it cannot overflow
+    uint32_t delay = baseSeconds * (rule.multiplier ? rule.multiplier : 1);
+    int shift = streak - 1;
+    if (shift > 12) shift = 12;
+    delay <<= shift;
+    if (rule.maxSeconds > 0 && delay > rule.maxSeconds) {
+        delay = rule.maxSeconds;
+    }
+
+    // Symmetric jitter so a fleet does not retry in lockstep
+    if (rule.jitterPercent > 0) {
+        uint32_t span = delay * rule.jitterPercent / 100;
+        if (span > 0) {
+            delay = delay - span + (random % (2 * span + 1));
+        }
+    }
+    if (delay < 30) delay = 30;
+
+    // Align with the regular schedule: no point retrying just before it
+    if (scheduleKnown && delay + RETRY_SCHEDULE_MARGIN_SECONDS >= (uint32_t)secondsUntilScheduled) {
+        return secondsUntilScheduled;
+    }
+    return delay;
+}
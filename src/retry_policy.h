@@ -0,0 +1,55 @@
+#ifndef RETRY_POLICY_H
+#define RETRY_POLICY_H
+
+#include <stdint.h>
+
+// Failure classes for a wake that could not produce a fresh display
+enum class FailureClass : uint8_t {
+    None = 0,
+    WiFi,           // Could not join the access point
+    Time,           // NTP sync failed
+    Dns,            // API host did not resolve
+    Tls,            // TCP connect / TLS handshake / read failed
+    HttpAuth,       // 401: bad API key, will not fix itself
+    HttpRateLimit,  // 429
+    HttpServer,     // 5xx
+    HttpOther,      // Any other non-200 status
+    Json,           // Response did not parse
+    Config,         // Device not provisioned
+    Count
+};
+
+// Retry bookkeeping that survives deep sleep (kept in RTC memory)
+struct RetryState {
+    uint32_t magic;
+    uint8_t consecutive[(int)FailureClass::Count];  // Per-class failure streak
+    uint16_t failuresSinceSuccess;
+    FailureClass lastFailure;
+};
+
+// Per-class backoff: delay = baseSeconds * multiplier * 2^(streak - 1),
+// capped at maxSeconds, then +/- jitterPercent
+struct RetryRule {
+    uint8_t multiplier;
+    uint32_t maxSeconds;
+    uint8_t jitterPercent;
+    bool waitForSchedule;  // Skip retries entirely, wait for the next scheduled update
+};
+
+const RetryRule& retryRule(FailureClass cls);
+const char* failureClassName(FailureClass cls);
+
+// Initialize the state if it is not valid (cold boot / corrupted RTC)
+void retryInit(RetryState& state);
+
+// A wake succeeded: clear every streak
+void retryRecordSuccess(RetryState& state);
+
+// A wake failed: update the streak and return the seconds to sleep.
+// baseSeconds is the configured retry interval, secondsUntilScheduled the
+// time to the next regular update (< 0 if unknown), random any 32-bit
+// random value for jitter. Retries never overshoot the regular schedule.
+uint32_t retryRecordFailure(RetryState& state, FailureClass cls, uint32_t baseSeconds,
+                            int32_t secondsUntilScheduled, uint32_t random);
+
+#endif // RETRY_POLICY_H
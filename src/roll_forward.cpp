@@ -0,0 +1,116 @@
+#include "roll_forward.h"
+#include "config.h"
+#include "timezone.h"
+
+static float lerp(float a, float b, float frac) {
+    return a + (b - a) * frac;
+}
+
+// A series field at slot i, frac of the way to the next slot
+template <typename T>
+static float sample(const T* field, int i, float frac) {
+    if (frac <= 0) return field[i];
+    return lerp(field[i], field[i + 1], frac);
+}
+
+static void rollCurrent(WeatherData& data, time_t now) {
+    CurrentWeather& c = data.current;
+    const ForecastSeries& s = data.series;
+
+    // How far the last observation was off the forecast for its time.
+    // A fetch's first slot is up to 3 hours after the observation; then
+    // there is nothing to compare against, and the value eases from the
+    // observation to the first slot instead.
+    int i;
+    float frac;
+    seriesLocate(s, c.timestamp, i, frac);
+    float tempBias = c.tempDeci - sample(s.tempDeci, i, frac);
+    float feelsBias = c.feelsLikeDeci - sample(s.feelsLikeDeci, i, frac);
+    float humidityBias = c.humidity - sample(s.humidity, i, frac);
+    float windBias = c.windSpeedDeci - sample(s.windSpeedDeci, i, frac);
+
+    float fadeSeconds = c.timestamp < s.start ? s.start - c.timestamp : ROLL_FORWARD_BIAS_FADE_SECONDS;
+    float keep = 1.0f - (float)(now - c.timestamp) / fadeSeconds;
+    if (keep < 0) keep = 0;
+    if (keep > 1) keep = 1;
+
+    seriesLocate(s, now, i, frac);
+    c.tempDeci = quantizeDeci((sample(s.tempDeci, i, frac) + keep * tempBias) / 10.0f);
+    c.feelsLikeDeci = quantizeDeci((sample(s.feelsLikeDeci, i, frac) + keep * feelsBias) / 10.0f);
+    int humidity = (int)(sample(s.humidity, i, frac) + keep * humidityBias + 0.5f);
+    c.humidity = humidity < 0 ? 0 : humidity > 100 ? 100 : humidity;
+    int wind = quantizeDeci((sample(s.windSpeedDeci, i, frac) + keep * windBias) / 10.0f);
+    c.windSpeedDeci = wind < 0 ? 0 : wind;
+
+    // Conditions do not interpolate: take the nearer slot
+    int nearest = frac >= 0.5f ? i + 1 : i;
+    c.weatherId = s.weatherId[nearest];
+
+    // Sunrise and sunset move by minutes a day; shift them by whole days
+    if (now > c.sunrise) {
+        time_t days = (now - c.sunrise) / 86400;
+        c.sunrise += days * 86400;
+        c.sunset += days * 86400;
+    }
+    c.timestamp = now;
+}
+
+static void rollHourly(WeatherData& data) {
+    const ForecastSeries& s = data.series;
+    int n = s.count < 12 ? s.count : 12;
+    for (int i = 0; i < n; i++) {
+        HourlyForecast& h = data.hourly[i];
+        h.timestamp = seriesTime(s, i);
+        h.tempDeci = s.tempDeci[i];
+        h.humidity = s.humidity[i];
+        h.weatherId = s.weatherId[i];
+    }
+    data.hourlyCount = n;
+}
+
+// Same aggregation as a fetch: local days, min/max temperature, the
+// highest chance of rain, and the first slot's conditions
+static void rollDaily(WeatherData& data) {
+    const ForecastSeries& s = data.series;
+    data.dailyCount = 0;
+    int currentDay = -1;
+    for (int i = 0; i < s.count; i++) {
+        time_t ts = seriesTime(s, i);
+        struct tm local;
+        tzLocalTime(ts, local);
+        int16_t temp = s.tempDeci[i];
+
+        if (local.tm_mday != currentDay) {
+            if (data.dailyCount == 8) break;
+            currentDay = local.tm_mday;
+            DailyForecast& d = data.daily[data.dailyCount++];
+            d.timestamp = ts;
+            d.tempMinDeci = temp;
+            d.tempMaxDeci = temp;
+            d.pop = s.pop[i];
+            d.humidity = 0;
+            d.weatherId = s.weatherId[i];
+        } else {
+            DailyForecast& d = data.daily[data.dailyCount - 1];
+            if (temp < d.tempMinDeci) d.tempMinDeci = temp;
+            if (temp > d.tempMaxDeci) d.tempMaxDeci = temp;
+            if (s.pop[i] > d.pop) d.pop = s.pop[i];
+        }
+    }
+}
+
+bool rollForward(WeatherData& data, time_t now, int minSlots) {
+    ForecastSeries& s = data.series;
+    int ahead = 0;
+    for (int i = 0; i < s.count; i++) {
+        if (seriesTime(s, i) + s.stepSeconds / 2 > now) ahead++;
+    }
+    if (s.count == 0 || ahead < minSlots) return false;
+
+    rollCurrent(data, now);
+    seriesDropBefore(s, now);
+    rollHourly(data);
+    rollDaily(data);
+    data.rolledForward = true;
+    return true;
+}
@@ -0,0 +1,15 @@
+#ifndef ROLL_FORWARD_H
+#define ROLL_FORWARD_H
+
+#include <time.h>
+#include "weather_api.h"
+
+// Offline update: rebuild what a fetch at time now would show from the
+// forecast series of an earlier fetch (data as expanded from a snapshot).
+// Current conditions are interpolated between the 3-hour slots, with the
+// last observation's difference from the forecast fading out; the hourly,
+// daily and graph windows start at now. Returns false, leaving data as it
+// was, when fewer than minSlots remain ahead.
+bool rollForward(WeatherData& data, time_t now, int minSlots);
+
+#endif // ROLL_FORWARD_H
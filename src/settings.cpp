@@ -0,0 +1,248 @@
+#include "settings.h"
+#include "config.h"
+#include "timezone.h"
+#include <string.h>
+#include <stdlib.h>
+
+static Settings activeSettings;
+static bool activeLoaded = false;
+
+static void copyString(char* dst, size_t size, const char* src) {
+    strncpy(dst, src, size - 1);
+    dst[size - 1] = '\0';
+}
+
+void settingsDefaults(Settings& s) {
+    memset(&s, 0, sizeof(s));
+    s.version = SETTINGS_VERSION;
+    copyString(s.wifiSsid, sizeof(s.wifiSsid), WIFI_SSID);
+    copyString(s.wifiPassword, sizeof(s.wifiPassword), WIFI_PASSWORD);
+    copyString(s.apiKey, sizeof(s.apiKey), OWM_API_KEY);
+    copyString(s.locationName, sizeof(s.locationName), LOCATION_NAME);
+    copyString(s.units, sizeof(s.units), WEATHER_UNITS);
+    s.lat = LOCATION_LAT;
+    s.lon = LOCATION_LON;
+    s.gmtOffsetSec = GMT_OFFSET_SEC;
+    s.daylightOffsetSec = DAYLIGHT_OFFSET_SEC;
+    for (int i = 0; i < NUM_UPDATE_TIMES && i < SETTINGS_MAX_UPDATE_TIMES; i++) {
+        s.updateTimes[i] = UPDATE_TIMES[i];
+        s.numUpdateTimes++;
+    }
+    s.errorRetrySeconds = ERROR_RETRY_SECONDS;
+    s.hourlyCount = HOURLY_FORECAST_COUNT;
+    s.dailyCount = DAILY_FORECAST_COUNT;
+    copyString(s.timezone, sizeof(s.timezone), TIMEZONE);
+    s.clockTickMinutes = CLOCK_TICK_MINUTES;
+    s.fetchEvery = FETCH_EVERY_UPDATES;
+    s.singleRequest = SINGLE_REQUEST;
+    s.wakeBudgetSeconds = WAKE_BUDGET_SECONDS;
+}
+
+size_t settingsSizeForVersion(uint16_t version) {
+    switch (version) {
+        case 1: return 224;
+        case 2: return 272;
+        case 3: return 272;
+        case 4: return 272;
+        case 5: return 276;
+        case 6: return sizeof(Settings);
+        // Add the previous sizeof(Settings) here when bumping SETTINGS_VERSION
+        default: return 0;
+    }
+}
+
+bool settingsLoadBlob(Settings& s, const uint8_t* blob, size_t len) {
+    settingsDefaults(s);
+    if (blob == nullptr || len < sizeof(uint16_t)) return false;
+
+    uint16_t version;
+    memcpy(&version, blob, sizeof(version));
+    size_t expected = settingsSizeForVersion(version);
+    if (expected == 0 || len != expected || version > SETTINGS_VERSION) {
+        return false;
+    }
+
+    // Older versions are a prefix of the current layout
+    memcpy(&s, blob, len);
+    s.version = SETTINGS_VERSION;
+
+    // v1 only had fixed offsets. Keep ones changed from the defaults by
+    // leaving the zone to the weather API rather than to the default rules.
+    // Its padding overlapped the start of the zone string.
+    if (version < 2) {
+        bool offsetsChanged = s.gmtOffsetSec != GMT_OFFSET_SEC ||
+                              s.daylightOffsetSec != DAYLIGHT_OFFSET_SEC;
+        copyString(s.timezone, sizeof(s.timezone), offsetsChanged ? "" : TIMEZONE);
+    }
+
+    // v2 to v5 ended in padding where the newer fields now sit
+    if (version < 3) {
+        s.clockTickMinutes = CLOCK_TICK_MINUTES;
+    }
+    if (version < 4) {
+        s.fetchEvery = FETCH_EVERY_UPDATES;
+    }
+    if (version < 5) {
+        s.singleRequest = SINGLE_REQUEST;
+    }
+    if (version < 6) {
+        s.wakeBudgetSeconds = WAKE_BUDGET_SECONDS;
+    }
+
+    if (!settingsValid(s)) {
+        settingsDefaults(s);
+        return false;
+    }
+    return true;
+}
+
+// Parse "0,6,12,18" into ascending hours
+static bool parseUpdateTimes(Settings& s, const char* value) {
+    uint8_t hours[SETTINGS_MAX_UPDATE_TIMES];
+    int count = 0;
+    const char* p = value;
+
+    while (*p) {
+        char* end;
+        long hour = strtol(p, &end, 10);
+        if (end == p || hour < 0 || hour > 23 || count >= SETTINGS_MAX_UPDATE_TIMES) {
+            return false;
+        }
+        if (count > 0 && hour <= hours[count - 1]) {
+            return false;
+        }
+        hours[count++] = (uint8_t)hour;
+        p = end;
+        if (*p == ',') p++;
+    }
+
+    if (count == 0) return false;
+    memcpy(s.updateTimes, hours, count);
+    s.numUpdateTimes = count;
+    return true;
+}
+
+static bool parseLong(const char* value, long minValue, long maxValue, long& out) {
+    char* end;
+    long v = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || v < minValue || v > maxValue) return false;
+    out = v;
+    return true;
+}
+
+static bool parseFloat(const char* value, float minValue, float maxValue, float& out) {
+    char* end;
+    float v = strtof(value, &end);
+    if (end == value || *end != '\0' || v < minValue || v > maxValue) return false;
+    out = v;
+    return true;
+}
+
+bool settingsSet(Settings& s, const char* key, const char* value) {
+    long l;
+    float f;
+
+    if (strcmp(key, "ssid") == 0) {
+        if (strlen(value) >= sizeof(s.wifiSsid)) return false;
+        copyString(s.wifiSsid, sizeof(s.wifiSsid), value);
+    } else if (strcmp(key, "password") == 0) {
+        if (strlen(value) >= sizeof(s.wifiPassword)) return false;
+        copyString(s.wifiPassword, sizeof(s.wifiPassword), value);
+    } else if (strcmp(key, "apikey") == 0) {
+        if (strlen(value) >= sizeof(s.apiKey)) return false;
+        copyString(s.apiKey, sizeof(s.apiKey), value);
+    } else if (strcmp(key, "location") == 0) {
+        if (strlen(value) >= sizeof(s.locationName)) return false;
+        copyString(s.locationName, sizeof(s.locationName), value);
+    } else if (strcmp(key, "units") == 0) {
+        if (strcmp(value, "imperial") != 0 && strcmp(value, "metric") != 0) return false;
+        copyString(s.units, sizeof(s.units), value);
+    } else if (strcmp(key, "lat") == 0) {
+        if (!parseFloat(value, -90.0f, 90.0f, f)) return false;
+        s.lat = f;
+    } else if (strcmp(key, "lon") == 0) {
+        if (!parseFloat(value, -180.0f, 180.0f, f)) return false;
+        s.lon = f;
+    } else if (strcmp(key, "gmt_offset") == 0) {
+        if (!parseLong(value, -14 * 3600, 14 * 3600, l)) return false;
+        s.gmtOffsetSec = l;
+    } else if (strcmp(key, "dst_offset") == 0) {
+        if (!parseLong(value, 0, 2 * 3600, l)) return false;
+        s.daylightOffsetSec = l;
+    } else if (strcmp(key, "timezone") == 0) {
+        // "auto" follows the offset the weather API reports
+        TzRules rules;
+        if (strcmp(value, "auto") == 0) value = "";
+        if (strlen(value) >= sizeof(s.timezone)) return false;
+        if (value[0] && !tzParse(value, rules)) return false;
+        copyString(s.timezone, sizeof(s.timezone), value);
+    } else if (strcmp(key, "tick") == 0) {
+        // Minutes between clock ticks; must divide the hour
+        if (!parseLong(value, 0, 60, l) || (l > 0 && 60 % l != 0)) return false;
+        s.clockTickMinutes = l;
+    } else if (strcmp(key, "fetch_every") == 0) {
+        if (!parseLong(value, 1, 24, l)) return false;
+        s.fetchEvery = l;
+    } else if (strcmp(key, "single_request") == 0) {
+        if (!parseLong(value, 0, 1, l)) return false;
+        s.singleRequest = l;
+    } else if (strcmp(key, "wake_budget") == 0) {
+        if (!parseLong(value, 10, 120, l)) return false;
+        s.wakeBudgetSeconds = l;
+    } else if (strcmp(key, "update_times") == 0) {
+        return parseUpdateTimes(s, value);
+    } else if (strcmp(key, "retry") == 0) {
+        if (!parseLong(value, 30, 65535, l)) return false;
+        s.errorRetrySeconds = l;
+    } else if (strcmp(key, "hourly") == 0) {
+        if (!parseLong(value, 1, 12, l)) return false;
+        s.hourlyCount = l;
+    } else if (strcmp(key, "daily") == 0) {
+        if (!parseLong(value, 1, 8, l)) return false;
+        s.dailyCount = l;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool settingsValid(const Settings& s) {
+    if (s.numUpdateTimes == 0 || s.numUpdateTimes > SETTINGS_MAX_UPDATE_TIMES) return false;
+    for (int i = 0; i < s.numUpdateTimes; i++) {
+        if (s.updateTimes[i] > 23) return false;
+        if (i > 0 && s.updateTimes[i] <= s.updateTimes[i - 1]) return false;
+    }
+    if (s.errorRetrySeconds == 0) return false;
+    if (s.hourlyCount == 0 || s.hourlyCount > 12) return false;
+    if (s.dailyCount == 0 || s.dailyCount > 8) return false;
+    if (s.clockTickMinutes > 60 || (s.clockTickMinutes > 0 && 60 % s.clockTickMinutes != 0)) return false;
+    if (s.fetchEvery == 0 || s.fetchEvery > 24) return false;
+    if (s.singleRequest > 1) return false;
+    if (s.wakeBudgetSeconds < 10 || s.wakeBudgetSeconds > 120) return false;
+
+    // Strings must be terminated
+    if (memchr(s.wifiSsid, '\0', sizeof(s.wifiSsid)) == nullptr) return false;
+    if (memchr(s.wifiPassword, '\0', sizeof(s.wifiPassword)) == nullptr) return false;
+    if (memchr(s.apiKey, '\0', sizeof(s.apiKey)) == nullptr) return false;
+    if (memchr(s.locationName, '\0', sizeof(s.locationName)) == nullptr) return false;
+    if (memchr(s.units, '\0', sizeof(s.units)) == nullptr) return false;
+    if (memchr(s.timezone, '\0', sizeof(s.timezone)) == nullptr) return false;
+    return true;
+}
+
+bool settingsImperial(const Settings& s) {
+    return strcmp(s.units, "metric") != 0;
+}
+
+const Settings& settings() {
+    if (!activeLoaded) {
+        settingsDefaults(activeSettings);
+        activeLoaded = true;
+    }
+    return activeSettings;
+}
+
+void settingsActivate(const Settings& s) {
+    activeSettings = s;
+    activeLoaded = true;
+}
@@ -0,0 +1,71 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Runtime settings stored in NVS. Defaults come from config.h; a device can
+// be re-provisioned over USB serial without a rebuild.
+//
+// Schema rules: fields are only ever appended. Each version's struct size is
+// recorded in settingsSizeForVersion(), so an older blob is migrated by
+// copying its prefix over the defaults of the current version.
+#define SETTINGS_VERSION 6
+#define SETTINGS_MAX_UPDATE_TIMES 8
+
+struct Settings {
+    // --- version 1 ---
+    uint16_t version;
+    char wifiSsid[33];
+    char wifiPassword[65];
+    char apiKey[48];
+    char locationName[32];
+    char units[10];             // "imperial" or "metric"
+    float lat;
+    float lon;
+    int32_t gmtOffsetSec;
+    int32_t daylightOffsetSec;
+    uint8_t updateTimes[SETTINGS_MAX_UPDATE_TIMES];  // Hours, ascending
+    uint8_t numUpdateTimes;
+    uint16_t errorRetrySeconds;
+    uint8_t hourlyCount;
+    uint8_t dailyCount;
+    // --- version 2 ---
+    char timezone[48];          // POSIX TZ string; empty = offset from the weather API
+    // --- version 3 ---
+    uint8_t clockTickMinutes;   // Header clock refresh between updates, 0 = off
+    // --- version 4 ---
+    uint8_t fetchEvery;         // Fetch on every Nth update, roll the cache forward between
+    // --- version 5 ---
+    uint8_t singleRequest;      // 1 = forecast request only, current conditions derived from it
+    // --- version 6 ---
+    uint8_t wakeBudgetSeconds;  // Longest an update wake may stay awake (see WAKE_BUDGET_SECONDS)
+};
+
+// Fill with the compile-time defaults from config.h
+void settingsDefaults(Settings& s);
+
+// Stored size of a schema version (0 if unknown)
+size_t settingsSizeForVersion(uint16_t version);
+
+// Load a stored blob into s, migrating older versions. Falls back to the
+// defaults and returns false if the blob is unusable.
+bool settingsLoadBlob(Settings& s, const uint8_t* blob, size_t len);
+
+// Apply one "key value" pair (as typed on the provisioning console).
+// Returns false for unknown keys or invalid values.
+bool settingsSet(Settings& s, const char* key, const char* value);
+
+// Sanity check before saving
+bool settingsValid(const Settings& s);
+
+// True if the temperature unit is Fahrenheit
+bool settingsImperial(const Settings& s);
+
+// Read-only view of the active settings (defaults until activated)
+const Settings& settings();
+
+// Make s the active settings (called once at boot by SettingsStore)
+void settingsActivate(const Settings& s);
+
+#endif // SETTINGS_H
@@ -0,0 +1,180 @@
+#include "settings_store.h"
+#include "config.h"
+#include "weather_snapshot.h"
+#include <Preferences.h>
+#include <LittleFS.h>
+
+static const char* NVS_NAMESPACE = "weather";
+static const char* NVS_KEY = "settings";
+
+SettingsStore::SettingsStore() {
+}
+
+bool SettingsStore::begin() {
+    Settings s;
+    bool loaded = false;
+
+    Preferences prefs;
+    if (prefs.begin(NVS_NAMESPACE, true)) {
+        size_t len = prefs.getBytesLength(NVS_KEY);
+        if (len > 0 && len <= sizeof(Settings)) {
+            uint8_t blob[sizeof(Settings)];
+            prefs.getBytes(NVS_KEY, blob, len);
+            loaded = settingsLoadBlob(s, blob, len);
+        }
+        prefs.end();
+    }
+
+    if (!loaded) {
+        settingsDefaults(s);
+        Serial.println("Settings: using compile-time defaults");
+    } else {
+        Serial.printf("Settings: loaded from NVS (schema v%d)\n", s.version);
+    }
+
+    settingsActivate(s);
+    return loaded;
+}
+
+bool SettingsStore::save(const Settings& s) {
+    if (!settingsValid(s)) {
+        Serial.println("Settings: invalid, not saved");
+        return false;
+    }
+
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        Serial.println("Settings: NVS open failed");
+        return false;
+    }
+    size_t written = prefs.putBytes(NVS_KEY, &s, sizeof(Settings));
+    prefs.end();
+
+    if (written != sizeof(Settings)) {
+        Serial.println("Settings: NVS write failed");
+        return false;
+    }
+
+    settingsActivate(s);
+    Serial.println("Settings: saved");
+    return true;
+}
+
+void SettingsStore::printSettings(const Settings& s) {
+    Serial.printf("  ssid         %s\n", s.wifiSsid);
+    Serial.printf("  password     %s\n", s.wifiPassword[0] ? "********" : "(not set)");
+    Serial.printf("  apikey       %s\n", s.apiKey[0] ? "********" : "(not set)");
+    Serial.printf("  location     %s\n", s.locationName);
+    Serial.printf("  lat          %.4f\n", s.lat);
+    Serial.printf("  lon          %.4f\n", s.lon);
+    Serial.printf("  units        %s\n", s.units);
+    Serial.printf("  gmt_offset   %d\n", (int)s.gmtOffsetSec);
+    Serial.printf("  dst_offset   %d\n", (int)s.daylightOffsetSec);
+    Serial.printf("  timezone     %s\n", s.timezone[0] ? s.timezone : "auto");
+    Serial.print("  update_times ");
+    for (int i = 0; i < s.numUpdateTimes; i++) {
+        Serial.printf(i == 0 ? "%d" : ",%d", s.updateTimes[i]);
+    }
+    Serial.println();
+    Serial.printf("  retry        %d\n", s.errorRetrySeconds);
+    Serial.printf("  hourly       %d\n", s.hourlyCount);
+    Serial.printf("  daily        %d\n", s.dailyCount);
+    Serial.printf("  tick         %d\n", s.clockTickMinutes);
+    Serial.printf("  fetch_every  %d\n", s.fetchEvery);
+    Serial.printf("  single_request %d\n", s.singleRequest);
+    Serial.printf("  wake_budget  %d\n", s.wakeBudgetSeconds);
+}
+
+bool SettingsStore::handleCommand(char* line, Settings& edit, bool& done) {
+    // Split "command [key [value...]]"
+    char* cmd = line;
+    while (*cmd == ' ') cmd++;
+    char* key = strchr(cmd, ' ');
+    if (key) {
+        *key++ = '\0';
+        while (*key == ' ') key++;
+    }
+
+    if (strcmp(cmd, "help") == 0) {
+        Serial.println("Commands: show | set <key> <value> | save | defaults | snapshot | exit");
+    } else if (strcmp(cmd, "show") == 0) {
+        printSettings(edit);
+    } else if (strcmp(cmd, "set") == 0) {
+        char* value = key ? strchr(key, ' ') : nullptr;
+        if (!value) {
+            Serial.println("Usage: set <key> <value>");
+            return false;
+        }
+        *value++ = '\0';
+        if (!settingsSet(edit, key, value)) {
+            Serial.printf("Invalid setting: %s\n", key);
+            return false;
+        }
+        Serial.printf("OK %s\n", key);
+    } else if (strcmp(cmd, "save") == 0) {
+        return save(edit);
+    } else if (strcmp(cmd, "defaults") == 0) {
+        settingsDefaults(edit);
+        Serial.println("Defaults loaded (not saved)");
+    } else if (strcmp(cmd, "snapshot") == 0) {
+        return dumpSnapshot();
+    } else if (strcmp(cmd, "exit") == 0) {
+        done = true;
+    } else if (*cmd) {
+        Serial.printf("Unknown command: %s\n", cmd);
+        return false;
+    }
+    return true;
+}
+
+bool SettingsStore::dumpSnapshot() {
+    static WeatherSnapshot snap;
+    if (!LittleFS.begin(true) || !snapshotReadFile(LittleFS, SNAPSHOT_PATH, snap)) {
+        Serial.println("No snapshot stored");
+        return false;
+    }
+
+    // Hex lines for tools/snapshot_tool.py (it reads a saved console log)
+    const uint8_t* bytes = (const uint8_t*)&snap;
+    for (size_t i = 0; i < sizeof(snap); i += 64) {
+        Serial.print("SNAPSHOT ");
+        for (size_t j = i; j < i + 64 && j < sizeof(snap); j++) {
+            Serial.printf("%02x", bytes[j]);
+        }
+        Serial.println();
+    }
+    Serial.println("SNAPSHOT END");
+    return true;
+}
+
+void SettingsStore::runSerialProvisioning(uint32_t windowMs) {
+    Serial.printf("Settings console open for %u ms (type 'help')\n", windowMs);
+
+    Settings edit = settings();
+    char line[128];
+    size_t len = 0;
+    bool done = false;
+    unsigned long deadline = millis() + windowMs;
+
+    while (!done && (long)(millis() - deadline) < 0) {
+        if (!Serial.available()) {
+            delay(10);
+            continue;
+        }
+
+        char c = Serial.read();
+        if (c == '\r') continue;
+        if (c != '\n') {
+            if (len < sizeof(line) - 1) line[len++] = c;
+            continue;
+        }
+        line[len] = '\0';
+        len = 0;
+
+        // Keep the console open while it is being used
+        deadline = millis() + PROVISION_IDLE_MS;
+        handleCommand(line, edit, done);
+    }
+
+    Serial.println("Settings console closed");
+}
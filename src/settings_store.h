@@ -0,0 +1,31 @@
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include <Arduino.h>
+#include "settings.h"
+
+// NVS persistence and USB serial provisioning for Settings
+class SettingsStore {
+public:
+    SettingsStore();
+
+    // Load settings from NVS (migrating older schemas) and make them active.
+    // Returns false if the compile-time defaults had to be used.
+    bool begin();
+
+    // Persist settings to NVS and make them active
+    bool save(const Settings& s);
+
+    // Settings console on USB serial. Opens for windowMs and stays open
+    // while commands keep arriving. Type 'help' for the command list.
+    void runSerialProvisioning(uint32_t windowMs);
+
+private:
+    void printSettings(const Settings& s);
+    bool handleCommand(char* line, Settings& edit, bool& done);
+
+    // Print the stored weather snapshot as hex for the host tools
+    bool dumpSnapshot();
+};
+
+#endif // SETTINGS_STORE_H
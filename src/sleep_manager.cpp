@@ -1,7 +1,44 @@
 #include "sleep_manager.h"
+#include "clock_drift.h"
 #include "config.h"
+#include "settings.h"
+#include "timezone.h"
+#include "mem_probe.h"
+#include "wake_arena.h"
+#include "wake_budget.h"
+#include "wake_events.h"
+#include "wake_metrics.h"
 #include <M5Unified.h>
 #include <time.h>
+#include <sys/time.h>
+#include <esp_sntp.h>
+
+// Backoff streaks survive deep sleep
+RTC_DATA_ATTR static RetryState retryState;
+
+// Learned sleep timer error
+RTC_DATA_ATTR static ClockDrift clockDrift;
+
+// Clock tick schedule: the last sleep was a tick, the next update hour
+// (UTC, before the drift margin), and the tick interval (kept so a tick
+// wake needs no settings)
+RTC_DATA_ATTR static bool tickSleep = false;
+RTC_DATA_ATTR static time_t nextUpdateAt = 0;
+RTC_DATA_ATTR static uint8_t tickMinutesKept = 0;
+
+// Set from the SNTP task when a server answered during this wake
+static volatile bool timeSyncedNow = false;
+
+static void onTimeSync(struct timeval*) {
+    timeSyncedNow = true;
+    wakeEventSet(WAKE_EVENT_TIME_SYNCED);
+}
+
+static int64_t utcMicros() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
 
 SleepManager::SleepManager() {
 }
@@ -13,15 +50,49 @@ bool SleepManager::isTimeSynced() {
     return (now > 1577836800);  // Jan 1, 2020
 }
 
+void SleepManager::watchTimeSync() {
+    sntp_set_time_sync_notification_cb(onTimeSync);
+}
+
+void SleepManager::restoreClock() {
+    int64_t correctionUs = driftTakeClockCorrection(clockDrift);
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER || correctionUs == 0) return;
+
+    int64_t us = utcMicros() + correctionUs;
+    struct timeval tv;
+    tv.tv_sec = (time_t)(us / 1000000);
+    tv.tv_usec = (suseconds_t)(us % 1000000);
+    settimeofday(&tv, nullptr);
+}
+
+bool SleepManager::isClockTickWake() {
+    return tickSleep && tickMinutesKept > 0 && isTimeSynced() &&
+           esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+}
+
+void SleepManager::calibrateClock() {
+    if (!timeSyncedNow || esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER) return;
+
+    int32_t errorMs;
+    if (!driftObserveWake(clockDrift, utcMicros(), esp_timer_get_time(), errorMs)) return;
+
+    WakeMetrics& metrics = wakeMetrics();
+    metrics.wakeErrorValid = true;
+    metrics.wakeErrorMs = errorMs;
+    Serial.printf("Woke %+.1f s from target; sleep timer %+.0f ppm (spread %.0f ppm, %d samples)\n",
+                  errorMs / 1000.0, clockDrift.ppm, clockDrift.spreadPpm, clockDrift.samples);
+}
+
 int SleepManager::getNextUpdateHour(int currentHour) {
     // Find the next scheduled update time
-    for (int i = 0; i < NUM_UPDATE_TIMES; i++) {
-        if (UPDATE_TIMES[i] > currentHour) {
-            return UPDATE_TIMES[i];
+    const Settings& cfg = settings();
+    for (int i = 0; i < cfg.numUpdateTimes; i++) {
+        if (cfg.updateTimes[i] > currentHour) {
+            return cfg.updateTimes[i];
         }
     }
     // Wrap to first update time of next day
-    return UPDATE_TIMES[0] + 24;
+    return cfg.updateTimes[0] + 24;
 }
 
 int32_t SleepManager::getSecondsUntilNextUpdate() {
@@ -30,49 +101,73 @@ int32_t SleepManager::getSecondsUntilNextUpdate() {
         return -1;
     }
 
+    calibrateClock();
+
     time_t now;
     time(&now);
-    struct tm* timeinfo = localtime(&now);
-
-    int currentHour = timeinfo->tm_hour;
-    int currentMinute = timeinfo->tm_min;
-    int currentSecond = timeinfo->tm_sec;
-
-    // Get next update hour
-    int nextHour = getNextUpdateHour(currentHour);
-
-    // Calculate hours until next update
-    int hoursUntil = nextHour - currentHour;
-    if (hoursUntil <= 0) {
-        hoursUntil += 24;
-    }
-
-    // Calculate total seconds
-    // Next update is at nextHour:00:00
-    // Current time is currentHour:currentMinute:currentSecond
-    int32_t secondsUntil = (hoursUntil * 3600) - (currentMinute * 60) - currentSecond;
-
-    // Add a small buffer (30 seconds) to ensure we wake up slightly after the target time
-    secondsUntil += 30;
-
-    Serial.printf("Current time: %02d:%02d:%02d\n", currentHour, currentMinute, currentSecond);
-    Serial.printf("Next update at: %02d:00:00 (in %d hours)\n", nextHour % 24, hoursUntil);
+    struct tm local;
+    tzLocalTime(now, local);
+
+    // A wake shortly before an update hour stands in for it, so a timer
+    // that ran fast does not cost another full cycle
+    struct tm aligned;
+    tzLocalTime(now + WAKE_EARLY_TOLERANCE_SECONDS, aligned);
+
+    // Next update hour as a local wall-clock time, converted with the zone
+    // rules so the sleep spans a DST change correctly
+    int nextHour = getNextUpdateHour(aligned.tm_hour);
+    struct tm target = aligned;
+    target.tm_mday += nextHour / 24;
+    target.tm_hour = nextHour % 24;
+    target.tm_min = 0;
+    target.tm_sec = 0;
+    nextUpdateAt = tzMakeTime(target);
+    int32_t secondsUntil = (int32_t)(nextUpdateAt - now);
+
+    // Wake slightly after the target; the buffer shrinks as the timer error is learned
+    driftInit(clockDrift);
+    secondsUntil += driftMarginSeconds(clockDrift, secondsUntil);
+
+    Serial.printf("Current time: %02d:%02d:%02d%s\n", local.tm_hour, local.tm_min, local.tm_sec,
+                  local.tm_isdst ? " (DST)" : "");
+    Serial.printf("Next update at: %02d:00:00 (in %.1f hours)\n", nextHour % 24, secondsUntil / 3600.0);
     Serial.printf("Sleep duration: %d seconds (%.1f hours)\n", secondsUntil, secondsUntil / 3600.0);
 
     return secondsUntil;
 }
 
 void SleepManager::enterDeepSleep(int32_t seconds) {
+    startSleep(seconds, false);
+}
+
+void SleepManager::startSleep(int32_t seconds, bool clockTick) {
     if (seconds <= 0) {
         Serial.println("Invalid sleep duration, using error retry interval");
-        seconds = ERROR_RETRY_SECONDS;
+        seconds = settings().errorRetrySeconds;
     }
 
+    // Refreshes run on while the wake carries on; cutting the panel's
+    // power halfway through one would leave a half-drawn frame
+    wakeWaitDisplay();
+    budgetEnter(WakePhase::None);  // Close the phase still running
+    arenaReset();
+    memProbeEnd();
+    wakeMetricsPrint();
     Serial.printf("Entering deep sleep for %d seconds...\n", seconds);
     Serial.flush();
 
-    // Use ESP32 native deep sleep timer (~7uA, works on both USB and battery)
-    esp_sleep_enable_timer_wakeup((uint64_t)seconds * 1000000ULL);
+    // Use ESP32 native deep sleep timer (~7uA, works on both USB and battery),
+    // corrected for the slow clock's learned error
+    calibrateClock();
+    driftInit(clockDrift);
+    uint64_t timerUs = driftTimerFor(clockDrift, (uint64_t)seconds * 1000000ULL);
+    if (timeSyncedNow) {
+        driftRecordSleep(clockDrift, utcMicros(), timerUs);
+    } else {
+        driftExtendSleep(clockDrift, esp_timer_get_time(), timerUs);
+    }
+    tickSleep = clockTick;
+    esp_sleep_enable_timer_wakeup(timerUs);
     esp_deep_sleep_start();
 }
 
@@ -82,13 +177,68 @@ void SleepManager::sleepUntilNextUpdate() {
     if (seconds < 0) {
         // Time not synced, use error retry
         Serial.println("Cannot calculate next update, using retry interval");
-        seconds = ERROR_RETRY_SECONDS;
+        seconds = settings().errorRetrySeconds;
+    }
+
+    enterDeepSleep(seconds);
+}
+
+void SleepManager::sleepUntilNextTick() {
+    bool tickWake = wakeMetrics().clockTick;
+    if (!tickWake) tickMinutesKept = settings().clockTickMinutes;
+    uint8_t tickMinutes = tickMinutesKept;
+    if (tickMinutes == 0) {
+        sleepUntilNextUpdate();
+        return;
+    }
+
+    // A full wake plans the next update; tick wakes keep that plan, as the
+    // early-wake tolerance would otherwise skip past an update due shortly
+    if (!tickWake && getSecondsUntilNextUpdate() < 0) {
+        enterDeepSleep(settings().errorRetrySeconds);
+        return;
+    }
+    time_t now = time(nullptr);
+    if (nextUpdateAt <= now) {
+        sleepUntilNextUpdate();
+        return;
     }
 
+    // Ticks fall on local multiples of the interval; the interval divides
+    // the hour, so the update hour is one of them and takes its place
+    struct tm local;
+    tzLocalTime(now, local);
+    int32_t period = tickMinutes * 60;
+    int32_t intoHour = local.tm_min * 60 + local.tm_sec;
+    int32_t seconds = period - intoHour % period;
+
+    bool update = now + seconds >= nextUpdateAt;
+    if (update) seconds = (int32_t)(nextUpdateAt - now);
+
+    driftInit(clockDrift);
+    seconds += driftMarginSeconds(clockDrift, seconds);
+    startSleep(seconds, !update);
+}
+
+int32_t SleepManager::planRetry(FailureClass failure) {
+    int32_t untilScheduled = isTimeSynced() ? getSecondsUntilNextUpdate() : -1;
+    uint32_t seconds = retryRecordFailure(retryState, failure, settings().errorRetrySeconds,
+                                          untilScheduled, esp_random());
+
+    Serial.printf("Failure '%s' (streak %d, %d since last success): retry in %u seconds\n",
+                  failureClassName(failure),
+                  retryState.consecutive[(int)failure],
+                  retryState.failuresSinceSuccess,
+                  seconds);
+    return seconds;
+}
+
+void SleepManager::sleepForRetry(FailureClass failure) {
+    int32_t seconds = planRetry(failure);
+    Serial.printf("Sleeping for retry in %d seconds...\n", seconds);
     enterDeepSleep(seconds);
 }
 
-void SleepManager::sleepForRetry() {
-    Serial.printf("Sleeping for retry in %d seconds...\n", ERROR_RETRY_SECONDS);
-    enterDeepSleep(ERROR_RETRY_SECONDS);
+void SleepManager::recordSuccess() {
+    retryRecordSuccess(retryState);
 }
@@ -2,6 +2,7 @@
 #define SLEEP_MANAGER_H
 
 #include <Arduino.h>
+#include "retry_policy.h"
 
 class SleepManager {
 public:
@@ -17,15 +18,42 @@ public:
     // Enter deep sleep until next scheduled update
     void sleepUntilNextUpdate();
 
-    // Enter short error retry sleep (5 minutes)
-    void sleepForRetry();
+    // Enter deep sleep until the next header clock tick, or the next
+    // update if that comes first
+    void sleepUntilNextTick();
+
+    // Woken by the timer from a clock tick sleep: only the clock needs redrawing
+    bool isClockTickWake();
+
+    // Apply the learned timer error to the clock after a timer wake (call
+    // first thing in setup)
+    void restoreClock();
+
+    // Record a failed wake and return the backoff sleep for its class.
+    // Streaks are kept in RTC memory across deep sleep.
+    int32_t planRetry(FailureClass failure);
+
+    // Enter the backoff sleep for a failed wake
+    void sleepForRetry(FailureClass failure);
+
+    // Clear the backoff state after a successful update
+    void recordSuccess();
 
     // Check if current time is synced via NTP
     bool isTimeSynced();
 
+    // Note SNTP answers from now on (call before configTime). An answer
+    // after a timer wake measures the sleep timer's error.
+    void watchTimeSync();
+
 private:
     // Find next update time from schedule
     int getNextUpdateHour(int currentHour);
+
+    // Learn the sleep timer error once NTP has answered after a timer wake
+    void calibrateClock();
+
+    void startSleep(int32_t seconds, bool clockTick);
 };
 
 #endif // SLEEP_MANAGER_H
@@ -0,0 +1,75 @@
+#include "solar.h"
+#include <math.h>
+
+#define J2000 2451545.0
+#define UNIX_EPOCH_JD 2440587.5
+#define DEG (M_PI / 180.0)
+
+// Sun's altitude at rise and set: refraction and the solar radius
+#define HORIZON_DEG -0.833
+
+static double wrap360(double deg) {
+    deg = fmod(deg, 360.0);
+    return deg < 0 ? deg + 360.0 : deg;
+}
+
+static double daysSinceJ2000(time_t t) {
+    return t / 86400.0 + UNIX_EPOCH_JD - J2000;
+}
+
+static time_t fromJulian(double jd) {
+    return (time_t)floor((jd - UNIX_EPOCH_JD) * 86400.0 + 0.5);
+}
+
+// Sun's mean anomaly and ecliptic longitude (degrees) d days after J2000
+static void sunPosition(double d, double& anomaly, double& longitude) {
+    anomaly = wrap360(357.5291 + 0.98560028 * d);
+    double m = anomaly * DEG;
+    double center = 1.9148 * sin(m) + 0.0200 * sin(2 * m) + 0.0003 * sin(3 * m);
+    longitude = wrap360(anomaly + center + 180.0 + 102.9372);
+}
+
+bool solarSunTimes(time_t t, float lat, float lon, time_t& sunrise, time_t& sunset) {
+    // Mean solar noon nearest t (east longitudes are positive)
+    double n = floor(daysSinceJ2000(t) + lon / 360.0 + 0.5);
+    double noon = n - lon / 360.0;
+
+    double anomaly, longitude;
+    sunPosition(noon, anomaly, longitude);
+    double transit = J2000 + noon + 0.0053 * sin(anomaly * DEG) - 0.0069 * sin(2 * longitude * DEG);
+
+    double sinDecl = sin(longitude * DEG) * sin(23.4397 * DEG);
+    double cosDecl = sqrt(1 - sinDecl * sinDecl);
+    double phi = lat * DEG;
+    double cosHour = (sin(HORIZON_DEG * DEG) - sin(phi) * sinDecl) / (cos(phi) * cosDecl);
+
+    double halfDay;
+    bool crosses = cosHour >= -1 && cosHour <= 1;
+    if (cosHour > 1) {
+        halfDay = 0;    // Polar night
+    } else if (cosHour < -1) {
+        halfDay = 0.5;  // Midnight sun
+    } else {
+        halfDay = acos(cosHour) / DEG / 360.0;
+    }
+    sunrise = fromJulian(transit - halfDay);
+    sunset = fromJulian(transit + halfDay);
+    return crosses;
+}
+
+float solarMoonPhase(time_t t) {
+    double d = daysSinceJ2000(t);
+    double sunAnomaly, sunLongitude;
+    sunPosition(d, sunAnomaly, sunLongitude);
+
+    // Moon's mean longitude and anomaly, with the largest periodic terms
+    // (equation of center, evection, variation, annual equation)
+    double meanLongitude = 218.316 + 13.176396 * d;
+    double moonAnomaly = (134.963 + 13.064993 * d) * DEG;
+    double elongation = (meanLongitude - sunLongitude) * DEG;
+    double moonLongitude = meanLongitude + 6.289 * sin(moonAnomaly) +
+                           1.274 * sin(2 * elongation - moonAnomaly) +
+                           0.658 * sin(2 * elongation) - 0.186 * sin(sunAnomaly * DEG);
+
+    return (float)(wrap360(moonLongitude - sunLongitude) / 360.0);
+}
@@ -0,0 +1,21 @@
+#ifndef SOLAR_H
+#define SOLAR_H
+
+#include <time.h>
+
+// Sun and moon from the date and location alone, for when the weather API
+// is not asked for them. Low-precision formulas (the sunrise equation and
+// a few lunar terms): sun times within a few minutes up to 65 degrees of
+// latitude, the moon phase within two hours.
+
+// Sunrise and sunset of the solar day whose noon is nearest t, so t lies
+// between them by day and outside them by night. Returns false when the
+// sun does not cross the horizon that day: in polar night both are solar
+// noon, under the midnight sun they are 12 hours either side of it.
+bool solarSunTimes(time_t t, float lat, float lon, time_t& sunrise, time_t& sunset);
+
+// Moon phase as a fraction of the synodic month: 0 new, 0.25 first
+// quarter, 0.5 full, 0.75 last quarter
+float solarMoonPhase(time_t t);
+
+#endif // SOLAR_H
@@ -0,0 +1,88 @@
+#include "text_format.h"
+#include <ctype.h>
+#include <string.h>
+
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+size_t textFormatInt(char* out, int32_t value) {
+    char digits[10];
+    char* p = digits + sizeof(digits);
+    uint32_t v = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    while (v >= 100) {
+        uint32_t pair = v % 100;
+        v /= 100;
+        p -= 2;
+        memcpy(p, DIGIT_PAIRS + pair * 2, 2);
+    }
+    if (v >= 10) {
+        p -= 2;
+        memcpy(p, DIGIT_PAIRS + v * 2, 2);
+    } else {
+        *--p = (char)('0' + v);
+    }
+
+    size_t n = 0;
+    if (value < 0) out[n++] = '-';
+    size_t count = digits + sizeof(digits) - p;
+    memcpy(out + n, p, count);
+    return n + count;
+}
+
+TextBuilder::TextBuilder(char* buffer, size_t capacity) : buf(buffer), cap(capacity), len(0) {
+    buf[0] = '\0';
+}
+
+TextBuilder& TextBuilder::add(const char* text, size_t length) {
+    size_t room = cap - 1 - len;
+    if (length > room) length = room;
+    memcpy(buf + len, text, length);
+    len += length;
+    buf[len] = '\0';
+    return *this;
+}
+
+TextBuilder& TextBuilder::operator<<(const char* text) {
+    return text ? add(text, strlen(text)) : *this;
+}
+
+TextBuilder& TextBuilder::operator<<(char c) {
+    return add(&c, 1);
+}
+
+TextBuilder& TextBuilder::operator<<(int value) {
+    char digits[11];
+    return add(digits, textFormatInt(digits, value));
+}
+
+TextBuilder& TextBuilder::addSigned(int value) {
+    if (value > 0) *this << '+';
+    return *this << value;
+}
+
+TextBuilder& TextBuilder::add2Digits(int value) {
+    if (value >= 0 && value < 10) *this << '0';
+    return *this << value;
+}
+
+TextBuilder& TextBuilder::addCapitalized(const char* text) {
+    if (!text || !*text) return *this;
+    *this << (char)toupper((unsigned char)text[0]);
+    return *this << text + 1;
+}
+
+void TextBuilder::truncate(size_t length) {
+    if (length < len) {
+        len = length;
+        buf[len] = '\0';
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef TEXT_FORMAT_H
+#define TEXT_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Screen text built in a fixed buffer, usually on the stack, instead of
+// with String: nothing is allocated. Appends that do not fit are cut off;
+// the text is always NUL-terminated.
+class TextBuilder {
+public:
+    TextBuilder(char* buffer, size_t capacity);
+    TextBuilder(const TextBuilder&) = delete;
+    TextBuilder& operator=(const TextBuilder&) = delete;
+
+    TextBuilder& add(const char* text, size_t length);
+    TextBuilder& operator<<(const char* text);
+    TextBuilder& operator<<(char c);
+    TextBuilder& operator<<(int value);
+
+    // Explicit sign: "+3", "-2", "0"
+    TextBuilder& addSigned(int value);
+
+    // At least two digits, zero padded ("07")
+    TextBuilder& add2Digits(int value);
+
+    // Text with its first letter upper-cased
+    TextBuilder& addCapitalized(const char* text);
+
+    // Keep the first length characters
+    void truncate(size_t length);
+
+    const char* c_str() const { return buf; }
+    size_t length() const { return len; }
+    size_t capacity() const { return cap - 1; }
+
+private:
+    char* buf;
+    size_t cap;
+    size_t len;
+};
+
+// A TextBuilder with room for N - 1 characters
+template <size_t N>
+class StackText : public TextBuilder {
+public:
+    StackText() : TextBuilder(storage, N) {}
+
+private:
+    char storage[N];
+};
+
+// Decimal digits of value into out (at least 11 bytes), two at a time;
+// not NUL-terminated. Returns the number of characters.
+size_t textFormatInt(char* out, int32_t value);
+
+#endif // TEXT_FORMAT_H
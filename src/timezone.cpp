@@ -0,0 +1,327 @@
+#include "timezone.h"
+#include "settings.h"
+#include <Arduino.h>
+#include <ctype.h>
+#include <stdlib.h>
+
+#define TZ_OBSERVED_MAGIC 0x545A4F42  // "TZOB"
+#define SECONDS_PER_DAY 86400L
+
+// Offset reported by the weather API, kept for the next wake's schedule
+struct ObservedOffset {
+    uint32_t magic;
+    int32_t offset;
+};
+RTC_DATA_ATTR static ObservedOffset observed;
+
+// Kept through deep sleep so a clock tick wake can convert without
+// loading the settings
+RTC_DATA_ATTR static TzRules activeRules = {0, 0, false, {'M', 3, 2, 0, 0, 7200}, {'M', 11, 1, 0, 0, 7200}};
+static bool fromTzString = false;
+
+// Transitions in three consecutive years, sorted, and the UTC range they
+// describe. Rebuilt when a conversion falls outside it.
+struct Transition {
+    int64_t at;
+    int32_t offsetAfter;
+};
+static Transition transitions[6];
+static int numTransitions = 0;
+static int32_t offsetBeforeFirst = 0;
+static int64_t cacheFrom = 1;
+static int64_t cacheTo = 0;
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's
+// days_from_civil). mday may run past the end of the month.
+static int64_t daysFromCivil(int64_t y, int m, int d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void civilFromDays(int64_t z, int64_t& y, int& m, int& d) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    y = yoe + era * 400 + (m <= 2);
+}
+
+static int64_t floorDiv(int64_t a, int64_t b) {
+    return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+static bool isLeap(int64_t y) {
+    return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+static int daysInMonth(int64_t y, int m) {
+    static const uint8_t days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return m == 2 && isLeap(y) ? 29 : days[m - 1];
+}
+
+// Local seconds since the epoch at which a rule fires in year y
+static int64_t ruleLocalTime(const TzRuleDate& rule, int64_t y) {
+    int64_t day;
+    if (rule.kind == 'M') {
+        int64_t first = daysFromCivil(y, rule.month, 1);
+        int firstWeekday = (int)((first + 4) % 7 + 7) % 7;  // 1970-01-01 was a Thursday
+        int mday = 1 + (rule.weekday - firstWeekday + 7) % 7 + 7 * (rule.week - 1);
+        while (mday > daysInMonth(y, rule.month)) mday -= 7;
+        day = first + mday - 1;
+    } else if (rule.kind == 'J') {
+        day = daysFromCivil(y, 1, 1) + rule.day - 1 + (isLeap(y) && rule.day >= 60);
+    } else {
+        day = daysFromCivil(y, 1, 1) + rule.day;
+    }
+    return day * SECONDS_PER_DAY + rule.seconds;
+}
+
+static void buildCache(int64_t utc) {
+    int64_t y;
+    int m, d;
+    civilFromDays(floorDiv(utc, SECONDS_PER_DAY), y, m, d);
+
+    // Keep a day clear of the year boundaries so offsets and rule times
+    // past midnight cannot move a transition out of its year
+    cacheFrom = (daysFromCivil(y - 1, 1, 1) + 1) * SECONDS_PER_DAY;
+    cacheTo = (daysFromCivil(y + 2, 1, 1) - 1) * SECONDS_PER_DAY;
+    numTransitions = 0;
+
+    if (!activeRules.hasDst) {
+        offsetBeforeFirst = activeRules.stdOffset;
+        return;
+    }
+
+    for (int64_t year = y - 1; year <= y + 1; year++) {
+        Transition start = {ruleLocalTime(activeRules.start, year) - activeRules.stdOffset,
+                            activeRules.dstOffset};
+        Transition end = {ruleLocalTime(activeRules.end, year) - activeRules.dstOffset,
+                          activeRules.stdOffset};
+        if (start.at < end.at) {
+            transitions[numTransitions++] = start;
+            transitions[numTransitions++] = end;
+        } else {
+            transitions[numTransitions++] = end;
+            transitions[numTransitions++] = start;
+        }
+    }
+    // Southern hemisphere zones start the year on daylight time
+    offsetBeforeFirst = transitions[0].offsetAfter == activeRules.dstOffset
+                            ? activeRules.stdOffset
+                            : activeRules.dstOffset;
+}
+
+static int32_t offsetAt(int64_t utc) {
+    if (utc < cacheFrom || utc >= cacheTo) buildCache(utc);
+    int32_t offset = offsetBeforeFirst;
+    for (int i = 0; i < numTransitions && utc >= transitions[i].at; i++) {
+        offset = transitions[i].offsetAfter;
+    }
+    return offset;
+}
+
+int32_t tzOffsetAt(time_t utc) {
+    return offsetAt(utc);
+}
+
+void tzLocalTime(time_t utc, struct tm& local) {
+    int32_t offset = offsetAt(utc);
+    int64_t t = (int64_t)utc + offset;
+    int64_t days = floorDiv(t, SECONDS_PER_DAY);
+    int32_t secs = (int32_t)(t - days * SECONDS_PER_DAY);
+
+    int64_t y;
+    int m, d;
+    civilFromDays(days, y, m, d);
+
+    local.tm_year = (int)(y - 1900);
+    local.tm_mon = m - 1;
+    local.tm_mday = d;
+    local.tm_hour = secs / 3600;
+    local.tm_min = secs / 60 % 60;
+    local.tm_sec = secs % 60;
+    local.tm_wday = (int)((days + 4) % 7 + 7) % 7;
+    local.tm_yday = (int)(days - daysFromCivil(y, 1, 1));
+    local.tm_isdst = activeRules.hasDst && offset == activeRules.dstOffset;
+}
+
+time_t tzMakeTime(const struct tm& local) {
+    int64_t y = 1900 + (int64_t)local.tm_year + floorDiv(local.tm_mon, 12);
+    int m = (int)(local.tm_mon - floorDiv(local.tm_mon, 12) * 12) + 1;
+    int64_t t = daysFromCivil(y, m, 1) * SECONDS_PER_DAY
+              + (int64_t)(local.tm_mday - 1) * SECONDS_PER_DAY
+              + local.tm_hour * 3600L + local.tm_min * 60L + local.tm_sec;
+
+    // Try both offsets; a repeated time is valid with either (take the
+    // earlier instant), a skipped one with neither
+    int32_t a = activeRules.stdOffset;
+    int32_t b = activeRules.hasDst ? activeRules.dstOffset : a;
+    bool aValid = offsetAt(t - a) == a;
+    bool bValid = offsetAt(t - b) == b;
+    if (aValid && bValid) return (time_t)(t - (a > b ? a : b));
+    if (aValid) return (time_t)(t - a);
+    if (bValid) return (time_t)(t - b);
+    return (time_t)(t - (a < b ? a : b));
+}
+
+// Zone name: three or more letters, or anything in <>
+static const char* parseName(const char* p) {
+    const char* start;
+    if (*p == '<') {
+        start = ++p;
+        while (*p && *p != '>') p++;
+        if (*p != '>' || p - start < 3) return nullptr;
+        return p + 1;
+    }
+    start = p;
+    while (isalpha((unsigned char)*p)) p++;
+    return p - start >= 3 ? p : nullptr;
+}
+
+// [+-]hh[:mm[:ss]] in seconds
+static const char* parseHms(const char* p, int maxHours, int32_t& seconds) {
+    int sign = 1;
+    if (*p == '+' || *p == '-') {
+        if (*p == '-') sign = -1;
+        p++;
+    }
+    char* end;
+    long parts[3] = {0, 0, 0};
+    for (int i = 0; i < 3; i++) {
+        if (!isdigit((unsigned char)*p)) return nullptr;
+        parts[i] = strtol(p, &end, 10);
+        if (end == p || end - p > (i == 0 ? 3 : 2)) return nullptr;
+        p = end;
+        if (*p != ':' || i == 2) break;
+        p++;
+    }
+    if (parts[0] > maxHours || parts[1] > 59 || parts[2] > 59) return nullptr;
+    seconds = sign * (int32_t)(parts[0] * 3600 + parts[1] * 60 + parts[2]);
+    return p;
+}
+
+// Mm.w.d, Jn or n, then an optional /time
+static const char* parseRuleDate(const char* p, TzRuleDate& rule) {
+    char* end;
+    rule.month = rule.week = rule.weekday = 0;
+    rule.day = 0;
+    if (*p == 'M') {
+        long v[3];
+        p++;
+        for (int i = 0; i < 3; i++) {
+            v[i] = strtol(p, &end, 10);
+            if (end == p) return nullptr;
+            p = end;
+            if (i < 2) {
+                if (*p != '.') return nullptr;
+                p++;
+            }
+        }
+        if (v[0] < 1 || v[0] > 12 || v[1] < 1 || v[1] > 5 || v[2] < 0 || v[2] > 6) return nullptr;
+        rule.kind = 'M';
+        rule.month = v[0];
+        rule.week = v[1];
+        rule.weekday = v[2];
+    } else {
+        bool julian = *p == 'J';
+        if (julian) p++;
+        if (!isdigit((unsigned char)*p)) return nullptr;
+        long n = strtol(p, &end, 10);
+        if (julian ? (n < 1 || n > 365) : n > 365) return nullptr;
+        p = end;
+        rule.kind = julian ? 'J' : 'D';
+        rule.day = n;
+    }
+
+    rule.seconds = 7200;
+    if (*p == '/') {
+        p = parseHms(p + 1, 167, rule.seconds);
+    }
+    return p;
+}
+
+bool tzParse(const char* posix, TzRules& rules) {
+    const char* p = parseName(posix);
+    int32_t offset;
+    if (!p || !(p = parseHms(p, 24, offset))) return false;
+
+    rules.stdOffset = -offset;
+    rules.dstOffset = rules.stdOffset;
+    rules.hasDst = false;
+    if (*p == '\0') return true;
+
+    if (!(p = parseName(p))) return false;
+    rules.hasDst = true;
+    rules.dstOffset = rules.stdOffset + 3600;
+    if (*p && *p != ',') {
+        if (!(p = parseHms(p, 24, offset))) return false;
+        rules.dstOffset = -offset;
+    }
+
+    if (*p == '\0') {
+        // No rules given: the current US ones
+        static const TzRuleDate usStart = {'M', 3, 2, 0, 0, 7200};
+        static const TzRuleDate usEnd = {'M', 11, 1, 0, 0, 7200};
+        rules.start = usStart;
+        rules.end = usEnd;
+        return true;
+    }
+    if (*p != ',' || !(p = parseRuleDate(p + 1, rules.start))) return false;
+    if (*p != ',' || !(p = parseRuleDate(p + 1, rules.end))) return false;
+    return *p == '\0';
+}
+
+void tzFixed(TzRules& rules, int32_t offsetSeconds) {
+    rules.stdOffset = offsetSeconds;
+    rules.dstOffset = offsetSeconds;
+    rules.hasDst = false;
+}
+
+void tzActivate(const TzRules& rules) {
+    activeRules = rules;
+    cacheFrom = 1;
+    cacheTo = 0;
+}
+
+void tzBegin() {
+    const Settings& cfg = settings();
+    TzRules rules;
+
+    fromTzString = cfg.timezone[0] && tzParse(cfg.timezone, rules);
+    if (fromTzString) {
+        Serial.printf("Timezone: %s\n", cfg.timezone);
+    } else if (observed.magic == TZ_OBSERVED_MAGIC) {
+        tzFixed(rules, observed.offset);
+        Serial.printf("Timezone: UTC%+g from weather API\n", observed.offset / 3600.0);
+    } else {
+        tzFixed(rules, cfg.gmtOffsetSec + cfg.daylightOffsetSec);
+        Serial.printf("Timezone: UTC%+g from settings\n", rules.stdOffset / 3600.0);
+    }
+    tzActivate(rules);
+}
+
+void tzObserveOffset(int32_t offsetSeconds, time_t at) {
+    observed.magic = TZ_OBSERVED_MAGIC;
+    observed.offset = offsetSeconds;
+
+    if (fromTzString) {
+        int32_t expected = tzOffsetAt(at);
+        if (expected != offsetSeconds) {
+            Serial.printf("Timezone: rules give UTC%+g but the weather API says UTC%+g\n",
+                          expected / 3600.0, offsetSeconds / 3600.0);
+        }
+    } else if (!activeRules.hasDst && activeRules.stdOffset != offsetSeconds) {
+        TzRules rules;
+        tzFixed(rules, offsetSeconds);
+        tzActivate(rules);
+        Serial.printf("Timezone: UTC%+g from weather API\n", offsetSeconds / 3600.0);
+    }
+}
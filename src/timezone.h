@@ -0,0 +1,60 @@
+#ifndef TIMEZONE_H
+#define TIMEZONE_H
+
+#include <stdint.h>
+#include <time.h>
+
+// UTC to local time from POSIX TZ rules ("MST7MDT,M3.2.0,M11.1.0"), without
+// the C library's TZ handling. The DST transitions of three years around
+// the last converted time are cached, so a conversion is a short scan of
+// that table plus integer date math.
+
+// When a DST transition happens, in the local time then in effect
+struct TzRuleDate {
+    char kind;        // 'M' month.week.weekday, 'J' day 1-365 without Feb 29, 'D' day 0-365
+    uint8_t month;    // 1-12
+    uint8_t week;     // 1-5, 5 = last
+    uint8_t weekday;  // 0 = Sunday
+    uint16_t day;     // For 'J' and 'D'
+    int32_t seconds;  // Time of day, may be negative or past 24 h
+};
+
+struct TzRules {
+    int32_t stdOffset;  // Seconds east of UTC (the opposite sign of the TZ string)
+    int32_t dstOffset;
+    bool hasDst;
+    TzRuleDate start;   // Standard to daylight time
+    TzRuleDate end;     // Daylight to standard time
+};
+
+// Parse a POSIX TZ string. Names are checked but not kept.
+bool tzParse(const char* posix, TzRules& rules);
+
+// Rules for a fixed offset without DST
+void tzFixed(TzRules& rules, int32_t offsetSeconds);
+
+// Make rules the zone used by every conversion below
+void tzActivate(const TzRules& rules);
+
+// Pick the zone at boot: the configured TZ string if there is one,
+// otherwise the offset last reported by the weather API, otherwise the
+// fixed gmt/dst offsets from the settings
+void tzBegin();
+
+// The weather API's offset for the location at the time of the response.
+// Used as the zone when no TZ string is configured; remembered across
+// deep sleep.
+void tzObserveOffset(int32_t offsetSeconds, time_t at);
+
+// Offset from UTC in effect at a UTC time
+int32_t tzOffsetAt(time_t utc);
+
+// Local broken-down time (tm_isdst set, tm_zone/tm_gmtoff untouched)
+void tzLocalTime(time_t utc, struct tm& local);
+
+// UTC time of a local wall-clock time (tm_year/mon/mday/hour/min/sec).
+// Times skipped by a spring-forward transition map to after it, repeated
+// times to their first occurrence.
+time_t tzMakeTime(const struct tm& local);
+
+#endif // TIMEZONE_H
@@ -0,0 +1,331 @@
+#include "tls_client.h"
+#include "wake_budget.h"
+#include "wake_metrics.h"
+#include <lwip/sockets.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/version.h>
+#include <time.h>
+
+#define TLS_CONNECT_TIMEOUT_MS 10000
+#define TLS_HANDSHAKE_TIMEOUT_MS 15000
+#define TLS_IO_TIMEOUT_MS 15000  // All three are cut to the wake budget's current deadline
+
+struct TlsConnection {
+    mbedtls_net_context net;
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+};
+
+static bool wouldBlock(int ret) {
+    return ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+// Sleep until the socket can take what mbedtls asked for (ret is
+// WANT_READ or WANT_WRITE), at most timeoutMs; false on timeout
+static bool waitSocket(int fd, int ret, uint32_t timeoutMs) {
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(fd, &fds);
+    struct timeval tv;
+    tv.tv_sec = timeoutMs / 1000;
+    tv.tv_usec = (timeoutMs % 1000) * 1000;
+    bool forWrite = ret == MBEDTLS_ERR_SSL_WANT_WRITE;
+    return lwip_select(fd + 1, forWrite ? nullptr : &fds, forWrite ? &fds : nullptr, nullptr, &tv) > 0;
+}
+
+// The handshake state is private from mbedtls 3 on, which has a query for
+// its end since 3.2; 2.x only has the field. Which message comes after
+// ServerHello (the certificate, or ChangeCipherSpec on resumption) has no
+// public query in either, so it is read where the version allows.
+static bool handshakeOver(const mbedtls_ssl_context& ssl) {
+#if MBEDTLS_VERSION_NUMBER >= 0x03020000
+    return mbedtls_ssl_is_handshake_over(&ssl);
+#else
+    return ssl.state == MBEDTLS_SSL_HANDSHAKE_OVER;
+#endif
+}
+
+static int handshakeState(const mbedtls_ssl_context& ssl) {
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+    return ssl.MBEDTLS_PRIVATE(state);
+#else
+    return ssl.state;
+#endif
+}
+
+TlsClient::TlsClient()
+    : conn(nullptr), sessionCache(nullptr), sessionMaxAge(0), peeked(-1),
+      lastOffered(false), lastResumed(false), lastHandshakeMillis(0) {
+}
+
+TlsClient::~TlsClient() {
+    stop();
+}
+
+void TlsClient::setSessionCache(TlsSessionCache* cache, uint32_t maxAgeSeconds) {
+    sessionCache = cache;
+    sessionMaxAge = maxAgeSeconds;
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, const char* host) {
+    return open(ip, port, host, TLS_CONNECT_TIMEOUT_MS);
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port) {
+    return open(ip, port, nullptr, TLS_CONNECT_TIMEOUT_MS);
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, int32_t timeoutMs) {
+    return open(ip, port, nullptr, timeoutMs);
+}
+
+int TlsClient::connect(const char* host, uint16_t port) {
+    return connect(host, port, TLS_CONNECT_TIMEOUT_MS);
+}
+
+int TlsClient::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+    IPAddress ip;
+    if (!WiFi.hostByName(host, ip)) {
+        return 0;
+    }
+    return open(ip, port, host, timeoutMs);
+}
+
+int TlsClient::open(IPAddress ip, uint16_t port, const char* host, uint32_t timeoutMs) {
+    stop();
+
+    bool offer = host != nullptr && sessionCache != nullptr;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        conn = new TlsConnection;
+        mbedtls_net_init(&conn->net);
+        mbedtls_ssl_init(&conn->ssl);
+        mbedtls_ssl_config_init(&conn->conf);
+        mbedtls_entropy_init(&conn->entropy);
+        mbedtls_ctr_drbg_init(&conn->drbg);
+
+        if (!openSocket(ip, port, budgetClampMs(timeoutMs))) {
+            stop();
+            return 0;
+        }
+        if (handshake(host, offer, budgetClampMs(TLS_HANDSHAKE_TIMEOUT_MS))) {
+            return 1;
+        }
+        stop();
+
+        // Servers should fall back to a full handshake on an unknown
+        // session, but some abort instead: retry once without it
+        if (!lastOffered) break;
+        Serial.println("TLS: resumed handshake failed, retrying without session");
+        tlsSessionInvalidate(*sessionCache);
+        offer = false;
+    }
+    return 0;
+}
+
+bool TlsClient::openSocket(IPAddress ip, uint16_t port, uint32_t timeoutMs) {
+    int sock = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        return false;
+    }
+    conn->net.fd = sock;
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = (uint32_t)ip;
+    addr.sin_port = htons(port);
+
+    // Non-blocking connect so the timeout is ours, not lwIP's
+    lwip_fcntl(sock, F_SETFL, lwip_fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    if (lwip_connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        return false;
+    }
+
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(sock, &writable);
+    struct timeval tv;
+    tv.tv_sec = timeoutMs / 1000;
+    tv.tv_usec = (timeoutMs % 1000) * 1000;
+    if (lwip_select(sock + 1, nullptr, &writable, nullptr, &tv) <= 0) {
+        return false;
+    }
+
+    int error = 0;
+    socklen_t len = sizeof(error);
+    lwip_getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &len);
+    return error == 0;
+}
+
+bool TlsClient::handshake(const char* host, bool offerSession, uint32_t timeoutMs) {
+    lastOffered = false;
+    lastResumed = false;
+
+    int ret = mbedtls_ctr_drbg_seed(&conn->drbg, mbedtls_entropy_func, &conn->entropy, nullptr, 0);
+    if (ret == 0) {
+        ret = mbedtls_ssl_config_defaults(&conn->conf, MBEDTLS_SSL_IS_CLIENT,
+                                          MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+    if (ret == 0) {
+        mbedtls_ssl_conf_authmode(&conn->conf, MBEDTLS_SSL_VERIFY_NONE);
+        mbedtls_ssl_conf_rng(&conn->conf, mbedtls_ctr_drbg_random, &conn->drbg);
+        ret = mbedtls_ssl_setup(&conn->ssl, &conn->conf);
+    }
+    if (ret == 0 && host) {
+        ret = mbedtls_ssl_set_hostname(&conn->ssl, host);
+    }
+    if (ret != 0) {
+        Serial.printf("TLS: setup failed (-0x%04x)\n", -ret);
+        return false;
+    }
+    mbedtls_ssl_set_bio(&conn->ssl, &conn->net, mbedtls_net_send, mbedtls_net_recv, nullptr);
+
+    if (offerSession) {
+        lastOffered = tlsSessionOffer(*sessionCache, host, time(nullptr), sessionMaxAge, &conn->ssl);
+    }
+
+    // Step through the handshake so we can see which path the server took:
+    // a resumed session goes from ServerHello straight to ChangeCipherSpec
+    unsigned long start = millis();
+    bool fullHandshake = false;
+    while (!handshakeOver(conn->ssl)) {
+        ret = mbedtls_ssl_handshake_step(&conn->ssl);
+        if (handshakeState(conn->ssl) == MBEDTLS_SSL_SERVER_CERTIFICATE) {
+            fullHandshake = true;
+        }
+        if (ret == 0) continue;
+        if (!wouldBlock(ret)) {
+            Serial.printf("TLS: handshake failed (-0x%04x)\n", -ret);
+            return false;
+        }
+        uint32_t elapsed = millis() - start;
+        if (elapsed >= timeoutMs || !waitSocket(conn->net.fd, ret, timeoutMs - elapsed)) {
+            Serial.println("TLS: handshake timed out");
+            return false;
+        }
+    }
+
+    lastHandshakeMillis = millis() - start;
+    lastResumed = lastOffered && !fullHandshake;
+    Serial.printf("TLS: handshake %lu ms (%s)\n", (unsigned long)lastHandshakeMillis,
+                  lastResumed ? "resumed" : lastOffered ? "session rejected, full" : "full");
+
+    WakeMetrics& metrics = wakeMetrics();
+    if (lastResumed) {
+        metrics.tlsResumedMillis += lastHandshakeMillis;
+        metrics.tlsResumedHandshakes++;
+    } else {
+        metrics.tlsFullMillis += lastHandshakeMillis;
+        metrics.tlsFullHandshakes++;
+    }
+
+    // Save every time: the server may have issued a fresh ticket
+    if (host && sessionCache && !tlsSessionSave(*sessionCache, host, time(nullptr), &conn->ssl)) {
+        Serial.println("TLS: session too large to cache");
+    }
+    return true;
+}
+
+size_t TlsClient::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t TlsClient::write(const uint8_t* buf, size_t size) {
+    size_t sent = 0;
+    unsigned long start = millis();
+    uint32_t timeoutMs = budgetClampMs(TLS_IO_TIMEOUT_MS);
+    while (conn && sent < size) {
+        int ret = mbedtls_ssl_write(&conn->ssl, buf + sent, size - sent);
+        uint32_t elapsed = millis() - start;
+        if (ret > 0) {
+            sent += ret;
+        } else if (!wouldBlock(ret) || elapsed >= timeoutMs ||
+                   !waitSocket(conn->net.fd, ret, timeoutMs - elapsed)) {
+            stop();
+        }
+    }
+    return sent;
+}
+
+int TlsClient::available() {
+    int pending = peeked >= 0 ? 1 : 0;
+    if (!conn) {
+        return pending;
+    }
+
+    // A zero-length read processes any record that has arrived
+    int ret = mbedtls_ssl_read(&conn->ssl, nullptr, 0);
+    int avail = mbedtls_ssl_get_bytes_avail(&conn->ssl);
+    if (ret < 0 && !wouldBlock(ret) && avail == 0) {
+        // Closed by the peer, or failed
+        closeConnection();
+    }
+    return avail + pending;
+}
+
+int TlsClient::read() {
+    uint8_t b;
+    return read(&b, 1) > 0 ? b : -1;
+}
+
+int TlsClient::read(uint8_t* buf, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    int count = 0;
+    if (peeked >= 0) {
+        buf[count++] = (uint8_t)peeked;
+        peeked = -1;
+        if (--size == 0) return count;
+    }
+    if (!conn) {
+        return count > 0 ? count : -1;
+    }
+
+    int ret = mbedtls_ssl_read(&conn->ssl, buf + count, size);
+    if (ret > 0) {
+        return count + ret;
+    }
+    if (!wouldBlock(ret)) {
+        // 0 is a clean close_notify, anything negative an error
+        closeConnection();
+    }
+    return count > 0 ? count : -1;
+}
+
+int TlsClient::peek() {
+    if (peeked < 0) {
+        peeked = read();
+    }
+    return peeked;
+}
+
+void TlsClient::flush() {
+}
+
+void TlsClient::stop() {
+    peeked = -1;
+    closeConnection();
+}
+
+uint8_t TlsClient::connected() {
+    if (conn) {
+        available();
+    }
+    return conn != nullptr || peeked >= 0;
+}
+
+void TlsClient::closeConnection() {
+    if (!conn) return;
+    mbedtls_ssl_free(&conn->ssl);
+    mbedtls_ssl_config_free(&conn->conf);
+    mbedtls_ctr_drbg_free(&conn->drbg);
+    mbedtls_entropy_free(&conn->entropy);
+    mbedtls_net_free(&conn->net);  // Closes the socket
+    delete conn;
+    conn = nullptr;
+}
@@ -0,0 +1,62 @@
+#ifndef TLS_CLIENT_H
+#define TLS_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "tls_session_cache.h"
+
+struct TlsConnection;
+
+// Minimal TLS client (mbedtls over an lwIP socket) that can resume the
+// session cached from a previous wake. Server certificates are not
+// verified, matching what HTTPClient did for us before.
+class TlsClient : public WiFiClient {
+public:
+    TlsClient();
+    ~TlsClient();
+
+    // Cache to resume from and save to; nullptr disables resumption
+    void setSessionCache(TlsSessionCache* cache, uint32_t maxAgeSeconds);
+
+    // Connect to ip:port and handshake with host as SNI
+    int connect(IPAddress ip, uint16_t port, const char* host);
+
+    // Client interface, also used by HTTPClient if it has to reconnect.
+    // Connecting by address alone sends no SNI and does not resume.
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port, int32_t timeoutMs) override;
+    int connect(const char* host, uint16_t port) override;
+    int connect(const char* host, uint16_t port, int32_t timeoutMs) override;
+
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+
+    // Whether the last handshake resumed the cached session
+    bool resumed() const { return lastResumed; }
+
+    // Duration of the last handshake
+    uint32_t handshakeMillis() const { return lastHandshakeMillis; }
+
+private:
+    TlsConnection* conn;
+    TlsSessionCache* sessionCache;
+    uint32_t sessionMaxAge;
+    int peeked;
+    bool lastOffered;
+    bool lastResumed;
+    uint32_t lastHandshakeMillis;
+
+    int open(IPAddress ip, uint16_t port, const char* host, uint32_t timeoutMs);
+    bool openSocket(IPAddress ip, uint16_t port, uint32_t timeoutMs);
+    bool handshake(const char* host, bool offerSession, uint32_t timeoutMs);
+    void closeConnection();
+};
+
+#endif // TLS_CLIENT_H
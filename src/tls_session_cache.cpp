@@ -0,0 +1,52 @@
+#include "tls_session_cache.h"
+#include "dns_cache.h"
+#include <string.h>
+
+#define TLS_SESSION_MAGIC 0x544C5353  // "TLSS"
+
+bool tlsSessionOffer(const TlsSessionCache& cache, const char* host, time_t now,
+                     uint32_t maxAgeSeconds, mbedtls_ssl_context* ssl) {
+    if (cache.magic != TLS_SESSION_MAGIC || cache.length == 0) return false;
+    if (cache.length > TLS_SESSION_CACHE_SIZE) return false;
+    if (cache.hostHash != hostNameHash(host)) return false;
+    if (now < cache.savedAt || (uint32_t)(now - cache.savedAt) >= maxAgeSeconds) return false;
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+
+    // Load fails on blobs from another mbedtls version or configuration
+    bool ok = mbedtls_ssl_session_load(&session, cache.blob, cache.length) == 0 &&
+              mbedtls_ssl_set_session(ssl, &session) == 0;
+
+    mbedtls_ssl_session_free(&session);
+    return ok;
+}
+
+bool tlsSessionSave(TlsSessionCache& cache, const char* host, time_t now,
+                    const mbedtls_ssl_context* ssl) {
+    tlsSessionInvalidate(cache);
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+
+    size_t length = 0;
+    bool ok = mbedtls_ssl_get_session(ssl, &session) == 0 &&
+              mbedtls_ssl_session_save(&session, cache.blob, sizeof(cache.blob), &length) == 0;
+
+    mbedtls_ssl_session_free(&session);
+    if (!ok) {
+        tlsSessionInvalidate(cache);
+        return false;
+    }
+
+    cache.magic = TLS_SESSION_MAGIC;
+    cache.hostHash = hostNameHash(host);
+    cache.savedAt = now;
+    cache.length = (uint16_t)length;
+    return true;
+}
+
+void tlsSessionInvalidate(TlsSessionCache& cache) {
+    cache.magic = 0;
+    cache.length = 0;
+}
@@ -0,0 +1,36 @@
+#ifndef TLS_SESSION_CACHE_H
+#define TLS_SESSION_CACHE_H
+
+#include <stdint.h>
+#include <time.h>
+#include <mbedtls/ssl.h>
+
+// Room for a serialized TLS 1.2 session: ticket plus the server's leaf
+// certificate, which mbedtls keeps with the session
+#define TLS_SESSION_CACHE_SIZE 2560
+
+// Last negotiated TLS session for one host, kept in RTC memory so the next
+// wake can do an abbreviated handshake
+struct TlsSessionCache {
+    uint32_t magic;
+    uint32_t hostHash;
+    time_t savedAt;
+    uint16_t length;
+    uint8_t blob[TLS_SESSION_CACHE_SIZE];
+};
+
+// Offer the cached session on ssl before the handshake. Returns false if
+// there is nothing usable (empty, other host, older than maxAgeSeconds, or
+// saved by a different mbedtls build).
+bool tlsSessionOffer(const TlsSessionCache& cache, const char* host, time_t now,
+                     uint32_t maxAgeSeconds, mbedtls_ssl_context* ssl);
+
+// Save the session of a completed handshake. Returns false if it does not
+// fit the cache (the cache is then left empty).
+bool tlsSessionSave(TlsSessionCache& cache, const char* host, time_t now,
+                    const mbedtls_ssl_context* ssl);
+
+// Forget the cached session (e.g. the server failed the resumed handshake)
+void tlsSessionInvalidate(TlsSessionCache& cache);
+
+#endif // TLS_SESSION_CACHE_H
@@ -0,0 +1,116 @@
+#include "ulp_counters.h"
+#include <Arduino.h>
+
+#ifdef ULP_WAKE_COUNTERS
+
+#include <esp32s3/ulp.h>
+#include <sdkconfig.h>
+
+// How often the ULP wakes to count (its own timer, not the CPU's)
+#define ULP_PERIOD_US 10000000
+
+#define ULP_COUNTERS_MAGIC 0x554C
+
+// Layout of the ULP's reserved RTC slow memory, in 32-bit words. The ULP
+// and the CPU only use the low 16 bits of each data word.
+#define ULP_PROGRAM_WORD 0
+#define ULP_DATA_WORD 32
+enum {
+    ULP_CYCLES_LO,
+    ULP_CYCLES_HI,
+    ULP_TIMER_WAKES,
+    ULP_RESET_WAKES,
+    ULP_OTHER_WAKES,
+    ULP_MAGIC,
+    ULP_DATA_WORDS
+};
+
+#if CONFIG_ESP32S3_ULP_COPROC_RESERVE_MEM < (ULP_DATA_WORD + ULP_DATA_WORDS) * 4
+#error "ULP_WAKE_COUNTERS needs more ULP reserved memory (CONFIG_ESP32S3_ULP_COPROC_RESERVE_MEM)"
+#endif
+
+static volatile uint32_t* ulpData() {
+    return RTC_SLOW_MEM + ULP_DATA_WORD;
+}
+
+static uint16_t ulpWord(int index) {
+    return ulpData()[index] & 0xFFFF;
+}
+
+static void ulpBump(int index) {
+    uint16_t v = ulpWord(index);
+    if (v < 0xFFFF) ulpData()[index] = v + 1;
+}
+
+// Increment the 32-bit cycle count held in two 16-bit halves
+static const ulp_insn_t program[] = {
+    I_MOVI(R3, ULP_DATA_WORD),
+    I_LD(R0, R3, ULP_CYCLES_LO),
+    I_ADDI(R0, R0, 1),
+    I_ST(R0, R3, ULP_CYCLES_LO),
+    M_BXF(1),                       // Low half wrapped: carry
+    I_HALT(),
+    M_LABEL(1),
+    I_LD(R0, R3, ULP_CYCLES_HI),
+    I_ADDI(R0, R0, 1),
+    I_ST(R0, R3, ULP_CYCLES_HI),
+    I_HALT(),
+};
+
+bool ulpCountersBegin(UlpCounters& counters) {
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+    bool running = cause == ESP_SLEEP_WAKEUP_TIMER && ulpWord(ULP_MAGIC) == ULP_COUNTERS_MAGIC;
+
+    if (ulpWord(ULP_MAGIC) != ULP_COUNTERS_MAGIC) {
+        for (int i = 0; i < ULP_DATA_WORDS; i++) ulpData()[i] = 0;
+        ulpData()[ULP_MAGIC] = ULP_COUNTERS_MAGIC;
+    }
+
+    // The ULP only touches the count every ULP_PERIOD_US, so a read and
+    // restart here cannot race it in practice
+    counters.cycles = ((uint32_t)ulpWord(ULP_CYCLES_HI) << 16) | ulpWord(ULP_CYCLES_LO);
+    ulpData()[ULP_CYCLES_LO] = 0;
+    ulpData()[ULP_CYCLES_HI] = 0;
+
+    if (cause == ESP_SLEEP_WAKEUP_TIMER) {
+        ulpBump(ULP_TIMER_WAKES);
+    } else if (cause == ESP_SLEEP_WAKEUP_UNDEFINED) {
+        ulpBump(ULP_RESET_WAKES);
+    } else {
+        ulpBump(ULP_OTHER_WAKES);
+    }
+    counters.timerWakes = ulpWord(ULP_TIMER_WAKES);
+    counters.resetWakes = ulpWord(ULP_RESET_WAKES);
+    counters.otherWakes = ulpWord(ULP_OTHER_WAKES);
+
+    // After a reset the program has to be loaded again; it keeps running
+    // through deep sleep on its own
+    if (!running) {
+        size_t size = sizeof(program) / sizeof(ulp_insn_t);
+        if (ulp_process_macros_and_load(ULP_PROGRAM_WORD, program, &size) != ESP_OK ||
+            ulp_set_wakeup_period(0, ULP_PERIOD_US) != ESP_OK ||
+            ulp_run(ULP_PROGRAM_WORD) != ESP_OK) {
+            Serial.println("ULP: program failed to start");
+            return false;
+        }
+    }
+    return true;
+}
+
+void ulpCountersPrint(const UlpCounters& counters) {
+    Serial.printf("ULP: %lu cycles (~%lu s) since the last boot; wakes: %u timer, %u reset, %u other\n",
+                  (unsigned long)counters.cycles,
+                  (unsigned long)((uint64_t)counters.cycles * ULP_PERIOD_US / 1000000),
+                  counters.timerWakes, counters.resetWakes, counters.otherWakes);
+}
+
+#else
+
+bool ulpCountersBegin(UlpCounters& counters) {
+    return false;
+}
+
+void ulpCountersPrint(const UlpCounters& counters) {
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef ULP_COUNTERS_H
+#define ULP_COUNTERS_H
+
+#include <stdint.h>
+
+// Optional wake bookkeeping on the ULP coprocessor. Define
+// ULP_WAKE_COUNTERS (build_flags) to load a small ULP-FSM program that
+// counts its own cycles through deep sleep without waking the main CPU;
+// boot adds the wake reason to counters in the same RTC words. The ULP
+// runs on the same slow clock as the sleep timer, so the cycle count is a
+// cross-check of how long the chip slept, not a better clock.
+//
+// Without the flag both calls do nothing.
+
+struct UlpCounters {
+    uint32_t cycles;       // ULP cycles since the previous boot
+    uint16_t timerWakes;
+    uint16_t resetWakes;   // Power-on, reset button, watchdog
+    uint16_t otherWakes;
+};
+
+// Read and restart the cycle count, count this boot's wake reason and
+// make sure the program is running. Returns false if disabled.
+bool ulpCountersBegin(UlpCounters& counters);
+
+// Log the counters read at boot
+void ulpCountersPrint(const UlpCounters& counters);
+
+#endif // ULP_COUNTERS_H
@@ -0,0 +1,166 @@
+#include "wake_arena.h"
+#include "config.h"
+#include <string.h>
+
+// Every block starts with its size, so a reallocation knows what to copy
+struct BlockHeader {
+    uint32_t size;
+    uint32_t unused;  // Keeps the block 8-byte aligned
+};
+
+static uint8_t* base = nullptr;
+static bool tried = false;
+static uint32_t top = 0;
+static ArenaStats stats;
+
+static uint32_t align8(size_t n) {
+    return (uint32_t)((n + 7) & ~(size_t)7);
+}
+
+static bool ready() {
+    if (!tried) {
+        tried = true;
+        base = (uint8_t*)ps_malloc(WAKE_ARENA_BYTES);
+        if (base) {
+            stats.capacity = WAKE_ARENA_BYTES;
+        } else {
+            Serial.println("Wake arena: no PSRAM, using the heap");
+        }
+    }
+    return base != nullptr;
+}
+
+static bool owns(const void* ptr) {
+    return base && ptr >= base && ptr < base + stats.capacity;
+}
+
+static BlockHeader* headerOf(void* ptr) {
+    return (BlockHeader*)ptr - 1;
+}
+
+static uint32_t offsetOf(void* ptr) {
+    return (uint32_t)((uint8_t*)ptr - base);
+}
+
+// Blocks past the top were released and may hold someone else's data
+static bool isNewest(void* ptr) {
+    uint32_t start = offsetOf(ptr);
+    return start < top && start + align8(headerOf(ptr)->size) == top;
+}
+
+static void setTop(uint32_t newTop) {
+    top = newTop;
+    stats.used = top;
+    if (top > stats.peak) stats.peak = top;
+}
+
+void* arenaAlloc(size_t size) {
+    uint32_t need = sizeof(BlockHeader) + align8(size);
+    if (ready() && need <= stats.capacity - top) {
+        BlockHeader* header = (BlockHeader*)(base + top);
+        header->size = (uint32_t)size;
+        setTop(top + need);
+        stats.allocations++;
+        return header + 1;
+    }
+    stats.fallbacks++;
+    return malloc(size);
+}
+
+void* arenaRealloc(void* ptr, size_t size) {
+    if (!ptr) return arenaAlloc(size);
+    if (!owns(ptr)) return realloc(ptr, size);
+
+    BlockHeader* header = headerOf(ptr);
+    bool newest = isNewest(ptr);
+    uint32_t start = offsetOf(ptr);
+    if (newest && align8(size) <= stats.capacity - start) {
+        header->size = (uint32_t)size;
+        setTop(start + align8(size));
+        stats.allocations++;
+        return ptr;
+    }
+
+    // Otherwise copy it to a new block. The newest block gives its space
+    // back first; not having had room to grow, its copy goes to the heap.
+    size_t keep = header->size < size ? header->size : size;
+    if (newest) setTop(start - sizeof(BlockHeader));
+    void* moved = arenaAlloc(size);
+    if (moved) memmove(moved, ptr, keep);
+    return moved;
+}
+
+void arenaFree(void* ptr) {
+    if (!ptr) return;
+    if (!owns(ptr)) {
+        free(ptr);
+    } else if (isNewest(ptr)) {
+        setTop(offsetOf(ptr) - sizeof(BlockHeader));
+    }
+}
+
+ArenaMark arenaMark() {
+    return top;
+}
+
+void arenaRelease(ArenaMark mark) {
+    if (mark < top) setTop(mark);
+}
+
+void arenaReset() {
+    setTop(0);
+}
+
+const ArenaStats& arenaStats() {
+    return stats;
+}
+
+ArenaString::ArenaString() : buf(nullptr), len(0), cap(0) {
+}
+
+ArenaString::~ArenaString() {
+    arenaFree(buf);
+}
+
+bool ArenaString::reserve(size_t capacity) {
+    if (capacity <= cap) return true;
+    char* grown = (char*)arenaRealloc(buf, capacity + 1);
+    if (!grown) return false;
+    buf = grown;
+    cap = capacity;
+    buf[len] = '\0';
+    return true;
+}
+
+bool ArenaString::append(const char* text, size_t length) {
+    if (len + length > cap) {
+        // Half as much again, so a body written a byte at a time stays linear
+        // when the block cannot grow in place
+        size_t want = cap + cap / 2;
+        if (want < len + length) want = len + length;
+        if (want < 32) want = 32;
+        if (!reserve(want)) return false;
+    }
+    memcpy(buf + len, text, length);
+    len += length;
+    buf[len] = '\0';
+    return true;
+}
+
+ArenaString& ArenaString::operator+=(const char* text) {
+    if (text) append(text, strlen(text));
+    return *this;
+}
+
+ArenaString& ArenaString::operator+=(char c) {
+    append(&c, 1);
+    return *this;
+}
+
+size_t ArenaString::write(uint8_t c) {
+    return append((const char*)&c, 1) ? 1 : 0;
+}
+
+size_t ArenaString::write(const uint8_t* data, size_t size) {
+    return append((const char*)data, size) ? size : 0;
+}
@@ -0,0 +1,78 @@
+#ifndef WAKE_ARENA_H
+#define WAKE_ARENA_H
+
+#include <Arduino.h>
+
+// Scratch memory for one wake: a bump allocator over a single PSRAM block
+// (WAKE_ARENA_BYTES). Request URLs, response bodies and parsed JSON come
+// from it instead of the heap. Blocks are not freed one by one; everything
+// allocated after a mark goes at once when the arena is released back to
+// it, and all of it before deep sleep. Without PSRAM, or when the block is
+// full, requests fall back to the heap and are counted.
+
+struct ArenaStats {
+    uint32_t allocations;  // Blocks served from the arena, reallocations included
+    uint32_t fallbacks;    // Blocks the heap had to serve instead
+    uint32_t used;         // Bytes in use now, headers and alignment included
+    uint32_t peak;         // Most bytes in use at once
+    uint32_t capacity;     // Size of the block (0 until first use, or without PSRAM)
+};
+
+// 8-byte aligned memory; nullptr only if the heap fails too
+void* arenaAlloc(size_t size);
+
+// Grows in place when ptr is the newest block, otherwise copies
+void* arenaRealloc(void* ptr, size_t size);
+
+// Heap fallbacks are freed; an arena block is only taken back if it is
+// the newest one
+void arenaFree(void* ptr);
+
+typedef uint32_t ArenaMark;
+
+ArenaMark arenaMark();
+
+// Drop every arena block allocated since the mark. Nothing made after it
+// may be used afterwards.
+void arenaRelease(ArenaMark mark);
+
+// Drop everything (before deep sleep)
+void arenaReset();
+
+const ArenaStats& arenaStats();
+
+// Growable text in the arena, for URLs and response bodies. A Stream so
+// HTTPClient::writeToStream() can fill it, and print() formats numbers.
+class ArenaString : public Stream {
+public:
+    ArenaString();
+    ~ArenaString();
+    ArenaString(const ArenaString&) = delete;
+    ArenaString& operator=(const ArenaString&) = delete;
+
+    bool reserve(size_t capacity);
+    bool append(const char* text, size_t length);
+
+    ArenaString& operator+=(const char* text);
+    ArenaString& operator+=(char c);
+
+    const char* c_str() const { return buf ? buf : ""; }
+    size_t length() const { return len; }
+
+    // Print
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t size) override;
+
+    // Stream: a sink only, nothing to read back
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+private:
+    char* buf;
+    size_t len;
+    size_t cap;
+};
+
+#endif // WAKE_ARENA_H
@@ -0,0 +1,83 @@
+#include "wake_budget.h"
+#include "config.h"
+#include "mem_probe.h"
+#include "wake_metrics.h"
+#include <Arduino.h>
+
+static const uint32_t SHARES_MS[(int)WakePhase::Count] = {
+    0,
+    WAKE_BUDGET_CONNECT_MS,
+    WAKE_BUDGET_TIME_MS,
+    WAKE_BUDGET_FETCH_MS,
+    WAKE_BUDGET_PARSE_MS,
+    WAKE_BUDGET_RENDER_MS,
+};
+
+static const char* NAMES[(int)WakePhase::Count] = {
+    "none", "connect", "time", "fetch", "parse", "render"
+};
+
+static bool started = false;
+static uint32_t startMs;
+static uint32_t deadlineMs[(int)WakePhase::Count];  // From startMs
+static WakePhase current = WakePhase::None;
+static uint32_t enteredMs;
+
+const char* wakePhaseName(WakePhase phase) {
+    int i = (int)phase;
+    if (i >= (int)WakePhase::Count) i = 0;
+    return NAMES[i];
+}
+
+void budgetBegin(uint32_t totalMs) {
+    uint32_t sum = 0;
+    for (int i = 0; i < (int)WakePhase::Count; i++) sum += SHARES_MS[i];
+
+    // Each phase ends where the shares up to and including it add up to
+    uint32_t shares = 0;
+    for (int i = 0; i < (int)WakePhase::Count; i++) {
+        shares += SHARES_MS[i];
+        deadlineMs[i] = (uint32_t)((uint64_t)shares * totalMs / sum);
+    }
+
+    startMs = millis();
+    enteredMs = startMs;
+    current = WakePhase::None;
+    started = true;
+    memProbeBegin();
+}
+
+void budgetEnter(WakePhase phase) {
+    uint32_t now = millis();
+    if (current != WakePhase::None) {
+        wakeMetrics().phaseMs[(int)current] += now - enteredMs;
+    }
+    memProbeSample(current, phase);
+    current = phase;
+    enteredMs = now;
+}
+
+WakePhase budgetPhase() {
+    return current;
+}
+
+uint32_t budgetRemainingMs() {
+    if (!started || current == WakePhase::None) return UINT32_MAX;
+    uint32_t elapsed = millis() - startMs;
+    uint32_t deadline = deadlineMs[(int)current];
+    return elapsed < deadline ? deadline - elapsed : 0;
+}
+
+uint32_t budgetClampMs(uint32_t ms) {
+    uint32_t remaining = budgetRemainingMs();
+    return ms < remaining ? ms : remaining;
+}
+
+bool budgetExpired() {
+    if (budgetRemainingMs() > 0) return false;
+    WakeMetrics& metrics = wakeMetrics();
+    if (metrics.overrun == WakePhase::None) {
+        metrics.overrun = current;
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef WAKE_BUDGET_H
+#define WAKE_BUDGET_H
+
+#include <stdint.h>
+
+// Time limits for an update wake. The wake as a whole gets a budget, and
+// each phase may run until its share of it, counted from the start, is
+// used up: a phase finishing early leaves its time to the later ones, a
+// stalled one cannot take theirs. Blocking waits and network timeouts are
+// cut to what is left of the current phase.
+enum class WakePhase : uint8_t {
+    None = 0,  // Outside the budget (before budgetBegin, or after the wake's work)
+    Connect,   // WiFi association and DHCP
+    Time,      // NTP
+    Fetch,     // DNS, TLS and the HTTP requests
+    Parse,     // JSON responses
+    Render,    // Drawing and the panel refresh
+    Count
+};
+
+const char* wakePhaseName(WakePhase phase);
+
+// Start the budget now, splitting totalMs across the phases in proportion
+// to their WAKE_BUDGET_*_MS shares (config.h)
+void budgetBegin(uint32_t totalMs);
+
+// Switch to a phase. The time since the last switch is added to the
+// previous phase in the wake metrics.
+void budgetEnter(WakePhase phase);
+
+WakePhase budgetPhase();
+
+// Milliseconds until the current phase's deadline: 0 once it has passed,
+// UINT32_MAX while no budget applies
+uint32_t budgetRemainingMs();
+
+// ms, or less if the current phase's deadline comes sooner
+uint32_t budgetClampMs(uint32_t ms);
+
+// True once the current phase is past its deadline. The first phase that
+// runs over is recorded in the wake metrics.
+bool budgetExpired();
+
+#endif // WAKE_BUDGET_H
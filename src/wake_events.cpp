@@ -0,0 +1,56 @@
+#include "wake_events.h"
+#include "config.h"
+#include "wake_budget.h"
+#include <Arduino.h>
+#include <M5Unified.h>
+#include <WiFi.h>
+#include <freertos/event_groups.h>
+
+static EventGroupHandle_t group = nullptr;
+
+// Drops the CPU clock for as long as it is in scope. Nothing runs on the
+// loop task meanwhile; the WiFi driver and the panel task keep going.
+class ClockedDown {
+public:
+    ClockedDown() : mhz(getCpuFrequencyMhz()) {
+        if (mhz > WAKE_WAIT_CPU_MHZ) setCpuFrequencyMhz(WAKE_WAIT_CPU_MHZ);
+    }
+    ~ClockedDown() {
+        if (mhz > WAKE_WAIT_CPU_MHZ) setCpuFrequencyMhz(mhz);
+    }
+
+private:
+    uint32_t mhz;
+};
+
+static void onWiFiGotIp(arduino_event_id_t) {
+    wakeEventSet(WAKE_EVENT_WIFI_UP);
+}
+
+void wakeEventsBegin() {
+    if (group) return;
+    group = xEventGroupCreate();
+    WiFi.onEvent(onWiFiGotIp, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+}
+
+void wakeEventSet(uint32_t events) {
+    if (group) xEventGroupSetBits(group, events);
+}
+
+uint32_t wakeWaitAny(uint32_t events, uint32_t maxMs) {
+    if (!group) return 0;
+    uint32_t waitMs = budgetClampMs(maxMs);
+    EventBits_t set = xEventGroupGetBits(group);
+    if ((set & events) || waitMs == 0) return set & events;
+
+    ClockedDown clockedDown;
+    TickType_t ticks = waitMs == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(waitMs);
+    set = xEventGroupWaitBits(group, events, pdFALSE, pdFALSE, ticks);
+    return set & events;
+}
+
+void wakeWaitDisplay() {
+    if (!M5.Display.displayBusy()) return;
+    ClockedDown clockedDown;
+    M5.Display.waitDisplay();
+}
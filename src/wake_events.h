@@ -0,0 +1,29 @@
+#ifndef WAKE_EVENTS_H
+#define WAKE_EVENTS_H
+
+#include <stdint.h>
+
+// What an update wake waits for. The WiFi and SNTP tasks set bits in a
+// FreeRTOS event group as things happen; the loop task blocks on it rather
+// than polling, clocked down to WAKE_WAIT_CPU_MHZ (config.h), and carries
+// on as soon as a bit is set or the current budget phase runs out.
+enum WakeEvent : uint32_t {
+    WAKE_EVENT_WIFI_UP = 1 << 0,      // Station has an IP address
+    WAKE_EVENT_TIME_SYNCED = 1 << 1,  // SNTP has set the clock
+};
+
+// Create the event group and hook the WiFi events (before WiFi.begin)
+void wakeEventsBegin();
+
+// Safe from any task; does nothing before wakeEventsBegin
+void wakeEventSet(uint32_t events);
+
+// Block until one of the events is set, for at most maxMs and never past
+// the current phase's deadline. Returns those that are set, 0 on timeout.
+uint32_t wakeWaitAny(uint32_t events, uint32_t maxMs = UINT32_MAX);
+
+// Block until the panel has finished refreshing, clocked down.
+// M5.Display.display() only starts a refresh.
+void wakeWaitDisplay();
+
+#endif // WAKE_EVENTS_H
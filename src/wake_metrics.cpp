@@ -0,0 +1,51 @@
+#include "wake_metrics.h"
+#include "mem_probe.h"
+#include "wake_arena.h"
+#include <Arduino.h>
+
+static WakeMetrics metrics;
+
+WakeMetrics& wakeMetrics() {
+    return metrics;
+}
+
+void wakeMetricsPrint() {
+    Serial.println("Wake metrics:");
+    Serial.printf("  Result:           %s\n",
+                  metrics.clockTick ? "clock tick" :
+                  metrics.failure == FailureClass::None ? "ok" : failureClassName(metrics.failure));
+    Serial.printf("  Awake:            %lu ms\n", millis());
+    Serial.printf("  First work:       %lu ms (%s)\n",
+                  (unsigned long)metrics.firstWorkMs, bootProfileName(metrics.bootProfile));
+    if (metrics.phaseMs[(int)WakePhase::Connect] || metrics.phaseMs[(int)WakePhase::Render]) {
+        Serial.print("  Phases:          ");
+        for (int i = 1; i < (int)WakePhase::Count; i++) {
+            Serial.printf(" %s %lu", wakePhaseName((WakePhase)i), (unsigned long)metrics.phaseMs[i]);
+        }
+        Serial.println(" ms");
+    }
+    if (metrics.overrun != WakePhase::None) {
+        Serial.printf("  Over budget:      %s\n", wakePhaseName(metrics.overrun));
+    }
+    if (metrics.cachedFallback) {
+        Serial.println("  Shown:            cached forecast, rolled forward");
+    }
+    if (metrics.wakeErrorValid) {
+        Serial.printf("  Wake timing:      %+ld ms\n", (long)metrics.wakeErrorMs);
+    }
+    const ArenaStats& arena = arenaStats();
+    if (arena.allocations || arena.fallbacks) {
+        Serial.printf("  Arena:            %lu allocations, peak %.1f of %lu KB, %lu from the heap\n",
+                      (unsigned long)arena.allocations, arena.peak / 1024.0f,
+                      (unsigned long)arena.capacity / 1024, (unsigned long)arena.fallbacks);
+    }
+    memProbePrint();
+    Serial.printf("  EPD refreshes:    %d full, %d partial\n",
+                  metrics.epdFullRefreshes, metrics.epdPartialRefreshes);
+    Serial.printf("  DNS:              %lu ms (%d lookups)\n",
+                  (unsigned long)metrics.dnsMillis, metrics.dnsLookups);
+    Serial.printf("  TLS full:         %lu ms (%d handshakes)\n",
+                  (unsigned long)metrics.tlsFullMillis, metrics.tlsFullHandshakes);
+    Serial.printf("  TLS resumed:      %lu ms (%d handshakes)\n",
+                  (unsigned long)metrics.tlsResumedMillis, metrics.tlsResumedHandshakes);
+}
@@ -0,0 +1,36 @@
+#ifndef WAKE_METRICS_H
+#define WAKE_METRICS_H
+
+#include <stdint.h>
+#include "board.h"
+#include "retry_policy.h"
+#include "wake_budget.h"
+
+// Counters and timings for the current wake, printed before deep sleep
+struct WakeMetrics {
+    uint16_t epdFullRefreshes;     // Full-screen e-ink refreshes
+    uint16_t epdPartialRefreshes;  // Partial (region) refreshes
+    uint32_t dnsMillis;            // Time spent in DNS lookups
+    uint8_t dnsLookups;            // Lookups made (0 = cached address used)
+    uint32_t tlsFullMillis;        // Time in full TLS handshakes
+    uint32_t tlsResumedMillis;     // Time in abbreviated (resumed) handshakes
+    uint8_t tlsFullHandshakes;
+    uint8_t tlsResumedHandshakes;
+    FailureClass failure;          // Why this wake ends in a retry (None = fresh data shown)
+    bool wakeErrorValid;           // Set when NTP measured this timer wake
+    int32_t wakeErrorMs;           // Actual wake minus the planned one
+    bool clockTick;                // Header clock refresh only, no update
+    BootProfile bootProfile;       // Hardware brought up for this wake
+    uint32_t firstWorkMs;          // Uptime when the wake's real work started
+    uint32_t phaseMs[(int)WakePhase::Count];  // Time spent in each budgeted phase
+    WakePhase overrun;             // First phase that ran out of time (None = all in budget)
+    bool cachedFallback;           // Failed, and showed the cached forecast instead of an error
+};
+
+// Metrics for the current wake (reset on every boot)
+WakeMetrics& wakeMetrics();
+
+// Log the metrics to serial
+void wakeMetricsPrint();
+
+#endif // WAKE_METRICS_H
@@ -1,162 +1,263 @@
 #include "weather_api.h"
+#include "arena_json.h"
 #include "config.h"
+#include "dns_cache.h"
+#include "solar.h"
+#include "timezone.h"
+#include "tls_client.h"
+#include "wake_budget.h"
+#include "wake_metrics.h"
 #include <WiFi.h>
 #include <HTTPClient.h>
-#include <ArduinoJson.h>
+
+// API host address, reused across wakes until its TTL runs out
+RTC_DATA_ATTR static DnsCacheEntry apiDnsCache;
+
+// Last TLS session with the API host, for an abbreviated handshake
+RTC_DATA_ATTR static TlsSessionCache apiTlsSession;
 
 WeatherAPI::WeatherAPI() {
     data.valid = false;
     data.hourlyCount = 0;
     data.dailyCount = 0;
+    seriesClear(data.series);
+    data.trend.hasRange = false;
+    data.trend.hasYesterday = false;
+    data.fetchedAt = 0;
+    data.rolledForward = false;
+    failureClass = FailureClass::None;
 }
 
-bool WeatherAPI::fetchWeather(float lat, float lon, const char* apiKey, const char* units) {
+bool WeatherAPI::fetchWeather(float lat, float lon, const char* apiKey, const char* units,
+                              bool singleRequest) {
     data.valid = false;
     data.errorMessage = "";
+    failureClass = FailureClass::None;
 
     if (WiFi.status() != WL_CONNECTED) {
         data.errorMessage = "WiFi not connected";
+        failureClass = FailureClass::WiFi;
         return false;
     }
 
+    // One client for both requests; the connection is kept alive between them
+    // when the server allows it
+    TlsClient client;
+    client.setSessionCache(&apiTlsSession, TLS_SESSION_MAX_AGE_SECONDS);
+
+    // Each response and its JSON live in the wake arena until parsed into data
+    ArenaMark mark = arenaMark();
+
     // Fetch current weather using free API
-    if (!fetchCurrentWeather(lat, lon, apiKey, units)) {
-        return false;
-    }
+    bool ok = singleRequest || fetchCurrentWeather(client, lat, lon, apiKey, units);
+    arenaRelease(mark);
 
     // Fetch forecast using free API
-    if (!fetchForecast(lat, lon, apiKey, units)) {
+    ok = ok && fetchForecast(client, lat, lon, apiKey, units, singleRequest);
+    arenaRelease(mark);
+    if (!ok) {
         return false;
     }
+    client.stop();
 
+    data.fetchedAt = time(nullptr);
+    data.rolledForward = false;
     data.valid = true;
     Serial.printf("Weather parsed: %.1f°, %d hourly, %d daily forecasts\n",
-                  data.current.temp, data.hourlyCount, data.dailyCount);
+                  data.current.tempDeci / 10.0f, data.hourlyCount, data.dailyCount);
 
     return true;
 }
 
-bool WeatherAPI::fetchCurrentWeather(float lat, float lon, const char* apiKey, const char* units) {
-    // Build API URL for free current weather API
-    String url = "https://";
-    url += OWM_API_HOST;
-    url += "/data/2.5/weather?lat=";
-    url += String(lat, 4);
+bool WeatherAPI::request(TlsClient& client, const char* what, const char* path, float lat, float lon,
+                         const char* apiKey, const char* units, ArenaString& body) {
+    ArenaString url;
+    url += "https://" OWM_API_HOST;
+    url += path;
+    url += "?lat=";
+    url.print(lat, 4);
     url += "&lon=";
-    url += String(lon, 4);
+    url.print(lon, 4);
     url += "&units=";
     url += units;
     url += "&appid=";
     url += apiKey;
 
-    Serial.println("Fetching current weather: " + url);
+    Serial.printf("%s: GET %s\n", what, url.c_str());
+
+    budgetEnter(WakePhase::Fetch);
+    if (!connectApi(client)) {
+        return false;
+    }
 
     HTTPClient http;
-    http.begin(url);
-    http.setTimeout(15000);
+    http.begin(client, url.c_str());
+    http.setTimeout(budgetClampMs(HTTP_TIMEOUT_MS));
 
     int httpCode = http.GET();
 
     if (httpCode != HTTP_CODE_OK) {
-        data.errorMessage = "Current weather HTTP error: " + String(httpCode);
-        Serial.println(data.errorMessage);
+        setHttpError(what, httpCode);
         http.end();
         return false;
     }
 
-    String payload = http.getString();
+    // Straight into the arena; a chunked body is decoded on the way
+    if (http.getSize() > 0) {
+        body.reserve(http.getSize());
+    }
+    int length = http.writeToStream(&body);
     http.end();
+    if (length < 0) {
+        setHttpError(what, length);
+        return false;
+    }
+    return true;
+}
+
+// The "main", "wind" and "visibility" fields, shared by the current
+// weather and forecast slot objects
+static void parseMain(JsonObject item, CurrentWeather& current) {
+    current.tempDeci = quantizeDeci(item["main"]["temp"].as<float>());
+    current.feelsLikeDeci = quantizeDeci(item["main"]["feels_like"].as<float>());
+    current.humidity = item["main"]["humidity"].as<uint8_t>();
+    current.pressure = item["main"]["pressure"].as<uint16_t>();
+    current.windSpeedDeci = (uint16_t)quantizeDeci(item["wind"]["speed"].as<float>());
+    current.windDeg = item["wind"]["deg"].as<uint16_t>();
+    current.visibility = item["visibility"].as<uint16_t>();
+}
+
+bool WeatherAPI::fetchCurrentWeather(TlsClient& client, float lat, float lon, const char* apiKey, const char* units) {
+    ArenaString payload;
+    if (!request(client, "Current weather", "/data/2.5/weather", lat, lon, apiKey, units, payload)) {
+        return false;
+    }
 
     // Parse current weather response
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, payload);
+    budgetEnter(WakePhase::Parse);
+    JsonDocument doc(ArenaJsonAllocator::instance());
+    DeserializationError error = deserializeJson(doc, payload.c_str(), payload.length());
     if (error) {
         data.errorMessage = "JSON parse error: " + String(error.c_str());
+        failureClass = FailureClass::Json;
         Serial.println(data.errorMessage);
         return false;
     }
 
     // Parse main data
     data.current.timestamp = doc["dt"].as<time_t>();
-    data.current.temp = doc["main"]["temp"].as<float>();
-    data.current.feelsLike = doc["main"]["feels_like"].as<float>();
-    data.current.humidity = doc["main"]["humidity"].as<int>();
-    data.current.pressure = doc["main"]["pressure"].as<int>();
-    data.current.windSpeed = doc["wind"]["speed"].as<float>();
-    data.current.windDeg = doc["wind"]["deg"].as<int>();
-    data.current.visibility = doc["visibility"].as<int>();
+    parseMain(doc.as<JsonObject>(), data.current);
 
     // Parse sunrise/sunset from sys
     data.current.sunrise = doc["sys"]["sunrise"].as<time_t>();
     data.current.sunset = doc["sys"]["sunset"].as<time_t>();
 
+    // Local offset at the location, including DST
+    JsonVariant offset = doc["timezone"];
+    data.current.utcOffset = offset.isNull() ? 0 : offset.as<int32_t>();
+    if (!offset.isNull()) {
+        tzObserveOffset(data.current.utcOffset, data.current.timestamp);
+    }
+
     // Parse weather condition
     JsonArray weather = doc["weather"];
     if (weather.size() > 0) {
-        data.current.weatherId = weather[0]["id"].as<int>();
-        data.current.description = weather[0]["description"].as<String>();
-        data.current.icon = weather[0]["icon"].as<String>();
+        data.current.weatherId = weather[0]["id"].as<uint16_t>();
     }
 
-    Serial.printf("Current: %.1f°F, %s\n", data.current.temp, data.current.description.c_str());
+    Serial.printf("Current: %.1f°F, %s\n", data.current.tempDeci / 10.0f,
+                  weatherDescription(data.current.weatherId));
     return true;
 }
 
-bool WeatherAPI::fetchForecast(float lat, float lon, const char* apiKey, const char* units) {
-    // Build API URL for free 5-day forecast API
-    String url = "https://";
-    url += OWM_API_HOST;
-    url += "/data/2.5/forecast?lat=";
-    url += String(lat, 4);
-    url += "&lon=";
-    url += String(lon, 4);
-    url += "&units=";
-    url += units;
-    url += "&appid=";
-    url += apiKey;
-
-    Serial.println("Fetching forecast: " + url);
+// Current conditions from the forecast slot nearest now, with the sun
+// times computed on the device
+static void currentFromForecast(JsonArray list, JsonObject city, float lat, float lon,
+                                CurrentWeather& current) {
+    time_t now = time(nullptr);
+    JsonObject nearest;
+    time_t nearestGap = 0;
+    for (JsonObject item : list) {
+        time_t gap = item["dt"].as<time_t>() - now;
+        if (gap < 0) gap = -gap;
+        if (nearest.isNull() || gap < nearestGap) {
+            nearest = item;
+            nearestGap = gap;
+        }
+    }
+    if (nearest.isNull()) return;
+
+    // Stamped now rather than with the slot time, so day and night and the
+    // trend lookup follow the time of the fetch. Forecast values, so they
+    // are not recorded in the observation log
+    current.timestamp = now;
+    parseMain(nearest, current);
+    solarSunTimes(now, lat, lon, current.sunrise, current.sunset);
+
+    JsonVariant offset = city["timezone"];
+    current.utcOffset = offset.isNull() ? 0 : offset.as<int32_t>();
+    if (!offset.isNull()) {
+        tzObserveOffset(current.utcOffset, now);
+    }
 
-    HTTPClient http;
-    http.begin(url);
-    http.setTimeout(15000);
+    JsonArray weather = nearest["weather"];
+    if (weather.size() > 0) {
+        current.weatherId = weather[0]["id"].as<uint16_t>();
+    }
 
-    int httpCode = http.GET();
+    Serial.printf("Current (forecast slot %+ld min): %.1f°, %s\n", (long)(nearest["dt"].as<time_t>() - now) / 60,
+                  current.tempDeci / 10.0f, weatherDescription(current.weatherId));
+}
 
-    if (httpCode != HTTP_CODE_OK) {
-        data.errorMessage = "Forecast HTTP error: " + String(httpCode);
-        Serial.println(data.errorMessage);
-        http.end();
+bool WeatherAPI::fetchForecast(TlsClient& client, float lat, float lon, const char* apiKey,
+                               const char* units, bool withCurrent) {
+    ArenaString payload;
+    if (!request(client, "Forecast", "/data/2.5/forecast", lat, lon, apiKey, units, payload)) {
         return false;
     }
 
-    String payload = http.getString();
-    http.end();
-
     // Parse forecast response
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, payload);
+    budgetEnter(WakePhase::Parse);
+    JsonDocument doc(ArenaJsonAllocator::instance());
+    DeserializationError error = deserializeJson(doc, payload.c_str(), payload.length());
     if (error) {
         data.errorMessage = "Forecast JSON parse error: " + String(error.c_str());
+        failureClass = FailureClass::Json;
         Serial.println(data.errorMessage);
         return false;
     }
 
     JsonArray list = doc["list"];
+    if (withCurrent) {
+        // Before the daily aggregation below, which needs the zone
+        currentFromForecast(list, doc["city"], lat, lon, data.current);
+    }
+
+    // Keep every slot as a compact series for the trend graph
+    seriesClear(data.series);
+    for (int i = 0; i < list.size(); i++) {
+        JsonObject item = list[i];
+        seriesAppend(data.series,
+                     item["dt"].as<time_t>(),
+                     item["main"]["temp"].as<float>(),
+                     item["main"]["feels_like"].as<float>(),
+                     item["main"]["humidity"].as<int>(),
+                     item["wind"]["speed"].as<float>(),
+                     item["pop"].as<float>(),
+                     item["weather"][0]["id"].as<int>());
+    }
 
     // Parse hourly forecasts (every 3 hours, take first 5 = 15 hours)
     data.hourlyCount = 0;
     for (int i = 0; i < list.size() && data.hourlyCount < 12; i++) {
         JsonObject item = list[i];
         data.hourly[data.hourlyCount].timestamp = item["dt"].as<time_t>();
-        data.hourly[data.hourlyCount].temp = item["main"]["temp"].as<float>();
-        data.hourly[data.hourlyCount].humidity = item["main"]["humidity"].as<int>();
+        data.hourly[data.hourlyCount].tempDeci = quantizeDeci(item["main"]["temp"].as<float>());
+        data.hourly[data.hourlyCount].humidity = item["main"]["humidity"].as<uint8_t>();
 
         JsonArray weather = item["weather"];
         if (weather.size() > 0) {
-            data.hourly[data.hourlyCount].weatherId = weather[0]["id"].as<int>();
-            data.hourly[data.hourlyCount].description = weather[0]["description"].as<String>();
-            data.hourly[data.hourlyCount].icon = weather[0]["icon"].as<String>();
+            data.hourly[data.hourlyCount].weatherId = weather[0]["id"].as<uint16_t>();
         }
         data.hourlyCount++;
     }
@@ -165,29 +266,32 @@ bool WeatherAPI::fetchForecast(float lat, float lon, const char* apiKey, const c
     // The 5-day forecast gives 3-hour intervals, we need to find daily min/max
     data.dailyCount = 0;
     int currentDay = -1;
-    float dayMin = 999, dayMax = -999;
-    int dayWeatherId = 0;
-    String dayDesc = "";
+    int16_t dayMin = 0, dayMax = 0;
+    uint16_t dayWeatherId = 0;
     time_t dayTimestamp = 0;
     int dayPop = 0;
 
     for (int i = 0; i < list.size() && data.dailyCount < 8; i++) {
         JsonObject item = list[i];
         time_t ts = item["dt"].as<time_t>();
-        struct tm* timeinfo = localtime(&ts);
-        int day = timeinfo->tm_mday;
+        struct tm timeinfo;
+        tzLocalTime(ts, timeinfo);
+        int day = timeinfo.tm_mday;
 
-        float temp = item["main"]["temp"].as<float>();
-        int pop = (int)(item["pop"].as<float>() * 100);
+        int16_t temp = quantizeDeci(item["main"]["temp"].as<float>());
+        // Rounded and clamped like the hourly series, so a day's pop matches
+        // its wettest slot
+        int pop = (int)(item["pop"].as<float>() * 100.0f + 0.5f);
+        if (pop < 0) pop = 0;
+        if (pop > 100) pop = 100;
 
         if (day != currentDay) {
             // Save previous day if exists
             if (currentDay != -1 && data.dailyCount < 8) {
                 data.daily[data.dailyCount].timestamp = dayTimestamp;
-                data.daily[data.dailyCount].tempMin = dayMin;
-                data.daily[data.dailyCount].tempMax = dayMax;
+                data.daily[data.dailyCount].tempMinDeci = dayMin;
+                data.daily[data.dailyCount].tempMaxDeci = dayMax;
                 data.daily[data.dailyCount].weatherId = dayWeatherId;
-                data.daily[data.dailyCount].description = dayDesc;
                 data.daily[data.dailyCount].pop = dayPop;
                 data.daily[data.dailyCount].humidity = 0;
                 data.dailyCount++;
@@ -202,8 +306,7 @@ bool WeatherAPI::fetchForecast(float lat, float lon, const char* apiKey, const c
 
             JsonArray weather = item["weather"];
             if (weather.size() > 0) {
-                dayWeatherId = weather[0]["id"].as<int>();
-                dayDesc = weather[0]["description"].as<String>();
+                dayWeatherId = weather[0]["id"].as<uint16_t>();
             }
         } else {
             // Update min/max
@@ -216,19 +319,88 @@ bool WeatherAPI::fetchForecast(float lat, float lon, const char* apiKey, const c
     // Don't forget last day
     if (currentDay != -1 && data.dailyCount < 8) {
         data.daily[data.dailyCount].timestamp = dayTimestamp;
-        data.daily[data.dailyCount].tempMin = dayMin;
-        data.daily[data.dailyCount].tempMax = dayMax;
+        data.daily[data.dailyCount].tempMinDeci = dayMin;
+        data.daily[data.dailyCount].tempMaxDeci = dayMax;
         data.daily[data.dailyCount].weatherId = dayWeatherId;
-        data.daily[data.dailyCount].description = dayDesc;
         data.daily[data.dailyCount].pop = dayPop;
         data.daily[data.dailyCount].humidity = 0;
         data.dailyCount++;
     }
 
-    Serial.printf("Parsed %d hourly, %d daily forecasts\n", data.hourlyCount, data.dailyCount);
+    Serial.printf("Parsed %d hourly, %d daily forecasts, %d series slots\n",
+                  data.hourlyCount, data.dailyCount, data.series.count);
     return true;
 }
 
+bool WeatherAPI::resolveApiHost(IPAddress& address) {
+    unsigned long start = millis();
+    int ok = WiFi.hostByName(OWM_API_HOST, address);
+    WakeMetrics& metrics = wakeMetrics();
+    metrics.dnsMillis += millis() - start;
+    metrics.dnsLookups++;
+
+    if (!ok) {
+        data.errorMessage = "DNS lookup failed";
+        failureClass = FailureClass::Dns;
+        Serial.println(data.errorMessage);
+        return false;
+    }
+
+    dnsCacheStore(apiDnsCache, OWM_API_HOST, (uint32_t)address, time(nullptr),
+                  DNS_CACHE_TTL_SECONDS);
+    Serial.printf("Resolved %s to %s\n", OWM_API_HOST, address.toString().c_str());
+    return true;
+}
+
+bool WeatherAPI::connectApi(TlsClient& client) {
+    if (budgetExpired()) {
+        data.errorMessage = "Out of time for the weather request";
+        failureClass = FailureClass::Tls;
+        Serial.println(data.errorMessage);
+        return false;
+    }
+
+    // Still open from the previous request
+    if (client.connected()) {
+        return true;
+    }
+
+    IPAddress address;
+    uint32_t cached;
+    bool fromCache = dnsCacheLookup(apiDnsCache, OWM_API_HOST, time(nullptr), cached);
+    if (fromCache) {
+        address = cached;
+    } else if (!resolveApiHost(address)) {
+        return false;
+    }
+
+    // Connect by address; the host name still goes out as SNI
+    if (client.connect(address, OWM_API_PORT, OWM_API_HOST)) {
+        return true;
+    }
+
+    // The host may have moved: resolve again and retry once. Not when the
+    // connect only ran out of time; the address is likely still good.
+    if (fromCache && !budgetExpired()) {
+        Serial.println("Cached API address failed, resolving again");
+        dnsCacheInvalidate(apiDnsCache);
+        if (!resolveApiHost(address)) {
+            return false;
+        }
+        if (client.connect(address, OWM_API_PORT, OWM_API_HOST)) {
+            return true;
+        }
+    }
+
+    if (!budgetExpired()) {
+        dnsCacheInvalidate(apiDnsCache);
+    }
+    data.errorMessage = "Connection to " OWM_API_HOST " failed";
+    failureClass = FailureClass::Tls;
+    Serial.println(data.errorMessage);
+    return false;
+}
+
 WeatherData& WeatherAPI::getData() {
     return data;
 }
@@ -237,6 +409,30 @@ String WeatherAPI::getError() {
     return data.errorMessage;
 }
 
+FailureClass WeatherAPI::getFailureClass() {
+    return failureClass;
+}
+
+void WeatherAPI::setHttpError(const char* what, int httpCode) {
+    if (httpCode < 0) {
+        // HTTPClient error codes: connect, TLS handshake or read failures
+        data.errorMessage = String(what) + " connection error: " + HTTPClient::errorToString(httpCode);
+        failureClass = FailureClass::Tls;
+    } else {
+        data.errorMessage = String(what) + " HTTP error: " + String(httpCode);
+        if (httpCode == 401) {
+            failureClass = FailureClass::HttpAuth;
+        } else if (httpCode == 429) {
+            failureClass = FailureClass::HttpRateLimit;
+        } else if (httpCode >= 500) {
+            failureClass = FailureClass::HttpServer;
+        } else {
+            failureClass = FailureClass::HttpOther;
+        }
+    }
+    Serial.println(data.errorMessage);
+}
+
 String WeatherAPI::getWeatherCategory(int weatherId) {
     if (weatherId >= 200 && weatherId < 300) return "thunderstorm";
     if (weatherId >= 300 && weatherId < 400) return "drizzle";
@@ -247,3 +443,48 @@ String WeatherAPI::getWeatherCategory(int weatherId) {
     if (weatherId > 800 && weatherId < 900) return "clouds";
     return "unknown";
 }
+
+struct ConditionText {
+    uint16_t id;
+    const char* text;
+};
+
+// The API's own wording for each ID (its "description" field), so the
+// description need not be kept with the data
+static const ConditionText CONDITIONS[] = {
+    {200, "thunderstorm with light rain"}, {201, "thunderstorm with rain"},
+    {202, "thunderstorm with heavy rain"}, {210, "light thunderstorm"},
+    {211, "thunderstorm"}, {212, "heavy thunderstorm"}, {221, "ragged thunderstorm"},
+    {230, "thunderstorm with light drizzle"}, {231, "thunderstorm with drizzle"},
+    {232, "thunderstorm with heavy drizzle"},
+    {300, "light intensity drizzle"}, {301, "drizzle"}, {302, "heavy intensity drizzle"},
+    {310, "light intensity drizzle rain"}, {311, "drizzle rain"},
+    {312, "heavy intensity drizzle rain"}, {313, "shower rain and drizzle"},
+    {314, "heavy shower rain and drizzle"}, {321, "shower drizzle"},
+    {500, "light rain"}, {501, "moderate rain"}, {502, "heavy intensity rain"},
+    {503, "very heavy rain"}, {504, "extreme rain"}, {511, "freezing rain"},
+    {520, "light intensity shower rain"}, {521, "shower rain"},
+    {522, "heavy intensity shower rain"}, {531, "ragged shower rain"},
+    {600, "light snow"}, {601, "snow"}, {602, "heavy snow"}, {611, "sleet"},
+    {612, "light shower sleet"}, {613, "shower sleet"}, {615, "light rain and snow"},
+    {616, "rain and snow"}, {620, "light shower snow"}, {621, "shower snow"},
+    {622, "heavy shower snow"},
+    {701, "mist"}, {711, "smoke"}, {721, "haze"}, {731, "sand/dust whirls"}, {741, "fog"},
+    {751, "sand"}, {761, "dust"}, {762, "volcanic ash"}, {771, "squalls"}, {781, "tornado"},
+    {800, "clear sky"}, {801, "few clouds"}, {802, "scattered clouds"},
+    {803, "broken clouds"}, {804, "overcast clouds"},
+};
+
+const char* weatherDescription(int weatherId) {
+    for (size_t i = 0; i < sizeof(CONDITIONS) / sizeof(CONDITIONS[0]); i++) {
+        if (CONDITIONS[i].id == weatherId) return CONDITIONS[i].text;
+    }
+    switch (weatherId / 100) {
+        case 2: return "thunderstorm";
+        case 3: return "drizzle";
+        case 5: return "rain";
+        case 6: return "snow";
+        case 7: return "mist";
+        default: return "clouds";
+    }
+}
@@ -2,46 +2,62 @@
 #define WEATHER_API_H
 
 #include <Arduino.h>
+#include "forecast_series.h"
+#include "retry_policy.h"
+
+class TlsClient;
+class ArenaString;
+
+// Weather data is kept quantized, as the snapshot stores it: temperatures
+// and wind speed in 0.1 units (quantizeDeci), percentages and condition
+// IDs as small integers. Text comes from the condition ID when drawn.
 
 // Hourly forecast data structure
 struct HourlyForecast {
     time_t timestamp;
-    float temp;
-    int humidity;
-    String description;
-    String icon;
-    int weatherId;
+    int16_t tempDeci;
+    uint16_t weatherId;
+    uint8_t humidity;
 };
 
 // Daily forecast data structure
 struct DailyForecast {
     time_t timestamp;
-    float tempMin;
-    float tempMax;
-    int humidity;
-    String description;
-    String icon;
-    int weatherId;
-    int pop;  // Probability of precipitation (0-100)
+    int16_t tempMinDeci;
+    int16_t tempMaxDeci;
+    uint16_t weatherId;
+    uint8_t humidity;
+    uint8_t pop;  // Probability of precipitation (0-100)
 };
 
 // Current weather data structure
 struct CurrentWeather {
     time_t timestamp;
-    float temp;
-    float feelsLike;
-    int humidity;
-    float windSpeed;
-    int windDeg;
-    String description;
-    String icon;
-    int weatherId;
-    int visibility;
-    int pressure;
     time_t sunrise;
     time_t sunset;
+    int32_t utcOffset;   // Seconds east of UTC at the location, as reported by the API
+    int16_t tempDeci;
+    int16_t feelsLikeDeci;
+    uint16_t windSpeedDeci;
+    uint16_t windDeg;
+    uint16_t pressure;   // hPa
+    uint16_t visibility; // Metres (the API caps it at 10 km)
+    uint16_t weatherId;
+    uint8_t humidity;
 };
 
+// Local history from the observation log (not from the API)
+struct ObservationTrend {
+    bool hasRange;
+    int16_t low24hDeci;
+    int16_t high24hDeci;
+    bool hasYesterday;
+    int16_t vsYesterdayDeci;   // Current temperature minus the reading ~24 h ago
+};
+
+// English OWM description of a condition ID ("light rain")
+const char* weatherDescription(int weatherId);
+
 // Complete weather data
 struct WeatherData {
     bool valid;
@@ -50,6 +66,10 @@ struct WeatherData {
     int hourlyCount;
     DailyForecast daily[8];     // Up to 8 days
     int dailyCount;
+    ForecastSeries series;      // All forecast slots (up to 40)
+    ObservationTrend trend;
+    time_t fetchedAt;           // When the API answered
+    bool rolledForward;         // Rebuilt offline from the series (roll_forward.h)
     String errorMessage;
 };
 
@@ -57,8 +77,10 @@ class WeatherAPI {
 public:
     WeatherAPI();
 
-    // Fetch weather data from OpenWeatherMap
-    bool fetchWeather(float lat, float lon, const char* apiKey, const char* units);
+    // Fetch weather data from OpenWeatherMap. With singleRequest only the
+    // forecast is requested and current conditions are derived from it.
+    bool fetchWeather(float lat, float lon, const char* apiKey, const char* units,
+                      bool singleRequest = false);
 
     // Get the fetched weather data
     WeatherData& getData();
@@ -66,14 +88,35 @@ public:
     // Get error message if fetch failed
     String getError();
 
+    // Classification of the last failure (for retry backoff)
+    FailureClass getFailureClass();
+
 private:
     WeatherData data;
+    FailureClass failureClass;
+
+    // GET an API path for the location into body (in the wake arena)
+    bool request(TlsClient& client, const char* what, const char* path, float lat, float lon,
+                 const char* apiKey, const char* units, ArenaString& body);
 
     // Fetch current weather from free API
-    bool fetchCurrentWeather(float lat, float lon, const char* apiKey, const char* units);
+    bool fetchCurrentWeather(TlsClient& client, float lat, float lon,
+                             const char* apiKey, const char* units);
+
+    // Fetch forecast from free API; withCurrent also fills the current
+    // conditions from it
+    bool fetchForecast(TlsClient& client, float lat, float lon,
+                       const char* apiKey, const char* units, bool withCurrent);
+
+    // Look up the API host through DNS and cache the result
+    bool resolveApiHost(IPAddress& address);
+
+    // Open (or keep) the TLS connection to the API host, using the cached
+    // address when it is still valid
+    bool connectApi(TlsClient& client);
 
-    // Fetch forecast from free API
-    bool fetchForecast(float lat, float lon, const char* apiKey, const char* units);
+    // Record an HTTP failure and its class
+    void setHttpError(const char* what, int httpCode);
 
     // Map weather condition ID to simplified category
     String getWeatherCategory(int weatherId);
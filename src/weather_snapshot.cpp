@@ -0,0 +1,207 @@
+#include "weather_snapshot.h"
+#include <FS.h>
+#include <math.h>
+#include <string.h>
+
+// The layout is the file format: keep it identical on every compiler
+static_assert(sizeof(SnapshotHeader) == 40, "snapshot header layout changed");
+static_assert(sizeof(SnapshotCurrent) == 28, "snapshot current layout changed");
+static_assert(sizeof(SnapshotHourly) == 12, "snapshot hourly layout changed");
+static_assert(sizeof(SnapshotDaily) == 12, "snapshot daily layout changed");
+static_assert(sizeof(SnapshotSeries) == 408, "snapshot series layout changed");
+static_assert(sizeof(WeatherSnapshot) == 716, "snapshot layout changed");
+
+uint32_t snapshotCrc32(const void* data, size_t length) {
+    // Reflected CRC-32 (same as zlib), one nibble at a time
+    static const uint32_t NIBBLE[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= p[i];
+        crc = (crc >> 4) ^ NIBBLE[crc & 0x0F];
+        crc = (crc >> 4) ^ NIBBLE[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+static const uint8_t* payload(const WeatherSnapshot& snap) {
+    return (const uint8_t*)&snap + sizeof(SnapshotHeader);
+}
+
+static const size_t PAYLOAD_SIZE = sizeof(WeatherSnapshot) - sizeof(SnapshotHeader);
+
+void snapshotFromWeather(const WeatherData& data, float lat, float lon, bool imperial,
+                         uint32_t createdAt, WeatherSnapshot& snap) {
+    memset(&snap, 0, sizeof(snap));
+
+    SnapshotCurrent& c = snap.current;
+    c.timestamp = (uint32_t)data.current.timestamp;
+    c.sunrise = (uint32_t)data.current.sunrise;
+    c.sunset = (uint32_t)data.current.sunset;
+    c.tempDeci = data.current.tempDeci;
+    c.feelsLikeDeci = data.current.feelsLikeDeci;
+    c.windSpeedDeci = data.current.windSpeedDeci;
+    c.windDeg = data.current.windDeg;
+    c.pressure = data.current.pressure;
+    c.visibility = data.current.visibility;
+    c.weatherId = data.current.weatherId;
+    c.humidity = data.current.humidity;
+
+    int hourlyCount = data.hourlyCount < SNAPSHOT_HOURLY_MAX ? data.hourlyCount : SNAPSHOT_HOURLY_MAX;
+    for (int i = 0; i < hourlyCount; i++) {
+        const HourlyForecast& src = data.hourly[i];
+        SnapshotHourly& h = snap.hourly[i];
+        h.timestamp = (uint32_t)src.timestamp;
+        h.tempDeci = src.tempDeci;
+        h.weatherId = src.weatherId;
+        h.humidity = src.humidity;
+    }
+
+    int dailyCount = data.dailyCount < SNAPSHOT_DAILY_MAX ? data.dailyCount : SNAPSHOT_DAILY_MAX;
+    for (int i = 0; i < dailyCount; i++) {
+        const DailyForecast& src = data.daily[i];
+        SnapshotDaily& d = snap.daily[i];
+        d.timestamp = (uint32_t)src.timestamp;
+        d.tempMinDeci = src.tempMinDeci;
+        d.tempMaxDeci = src.tempMaxDeci;
+        d.weatherId = src.weatherId;
+        d.humidity = src.humidity;
+        d.pop = src.pop;
+    }
+
+    SnapshotSeries& s = snap.series;
+    s.start = (uint32_t)data.series.start;
+    s.stepSeconds = data.series.stepSeconds;
+    s.count = data.series.count;
+    memcpy(s.tempDeci, data.series.tempDeci, sizeof(s.tempDeci));
+    memcpy(s.pop, data.series.pop, sizeof(s.pop));
+    memcpy(s.weatherId, data.series.weatherId, sizeof(s.weatherId));
+    memcpy(s.feelsLikeDeci, data.series.feelsLikeDeci, sizeof(s.feelsLikeDeci));
+    memcpy(s.windSpeedDeci, data.series.windSpeedDeci, sizeof(s.windSpeedDeci));
+    memcpy(s.humidity, data.series.humidity, sizeof(s.humidity));
+
+    SnapshotHeader& hdr = snap.header;
+    hdr.magic = SNAPSHOT_MAGIC;
+    hdr.version = SNAPSHOT_VERSION;
+    hdr.headerSize = sizeof(SnapshotHeader);
+    hdr.totalSize = sizeof(WeatherSnapshot);
+    hdr.createdAt = createdAt;
+    hdr.flags = imperial ? SNAPSHOT_FLAG_IMPERIAL : 0;
+    hdr.hourlyCount = (uint8_t)hourlyCount;
+    hdr.dailyCount = (uint8_t)dailyCount;
+    hdr.latE6 = (int32_t)lround(lat * 1e6);
+    hdr.lonE6 = (int32_t)lround(lon * 1e6);
+    hdr.currentStride = sizeof(SnapshotCurrent);
+    hdr.hourlyStride = sizeof(SnapshotHourly);
+    hdr.dailyStride = sizeof(SnapshotDaily);
+    hdr.seriesStride = sizeof(SnapshotSeries);
+    hdr.crc32 = snapshotCrc32(payload(snap), PAYLOAD_SIZE);
+}
+
+bool snapshotMatches(const WeatherSnapshot& snap, float lat, float lon, bool imperial) {
+    const SnapshotHeader& hdr = snap.header;
+    return hdr.latE6 == (int32_t)lround(lat * 1e6) &&
+           hdr.lonE6 == (int32_t)lround(lon * 1e6) &&
+           ((hdr.flags & SNAPSHOT_FLAG_IMPERIAL) != 0) == imperial;
+}
+
+const WeatherSnapshot* snapshotView(const void* buffer, size_t length) {
+    if (!buffer || length < sizeof(WeatherSnapshot)) return nullptr;
+    if (((uintptr_t)buffer & 3) != 0) return nullptr;  // Fields are read in place
+
+    const WeatherSnapshot* snap = (const WeatherSnapshot*)buffer;
+    const SnapshotHeader& hdr = snap->header;
+    if (hdr.magic != SNAPSHOT_MAGIC || hdr.version != SNAPSHOT_VERSION) return nullptr;
+    if (hdr.headerSize != sizeof(SnapshotHeader) || hdr.totalSize != sizeof(WeatherSnapshot)) return nullptr;
+    if (hdr.currentStride != sizeof(SnapshotCurrent) || hdr.hourlyStride != sizeof(SnapshotHourly) ||
+        hdr.dailyStride != sizeof(SnapshotDaily) || hdr.seriesStride != sizeof(SnapshotSeries)) {
+        return nullptr;
+    }
+    if (hdr.hourlyCount > SNAPSHOT_HOURLY_MAX || hdr.dailyCount > SNAPSHOT_DAILY_MAX ||
+        snap->series.count > FORECAST_SERIES_MAX) {
+        return nullptr;
+    }
+    if (hdr.crc32 != snapshotCrc32(payload(*snap), PAYLOAD_SIZE)) return nullptr;
+    return snap;
+}
+
+void snapshotToWeather(const WeatherSnapshot& snap, WeatherData& data) {
+    const SnapshotCurrent& c = snap.current;
+    data.current.timestamp = c.timestamp;
+    data.current.sunrise = c.sunrise;
+    data.current.sunset = c.sunset;
+    data.current.tempDeci = c.tempDeci;
+    data.current.feelsLikeDeci = c.feelsLikeDeci;
+    data.current.windSpeedDeci = c.windSpeedDeci;
+    data.current.windDeg = c.windDeg;
+    data.current.pressure = c.pressure;
+    data.current.visibility = c.visibility;
+    data.current.weatherId = c.weatherId;
+    data.current.humidity = c.humidity;
+
+    data.hourlyCount = snap.header.hourlyCount;
+    for (int i = 0; i < data.hourlyCount; i++) {
+        const SnapshotHourly& h = snap.hourly[i];
+        data.hourly[i].timestamp = h.timestamp;
+        data.hourly[i].tempDeci = h.tempDeci;
+        data.hourly[i].weatherId = h.weatherId;
+        data.hourly[i].humidity = h.humidity;
+    }
+
+    data.dailyCount = snap.header.dailyCount;
+    for (int i = 0; i < data.dailyCount; i++) {
+        const SnapshotDaily& d = snap.daily[i];
+        data.daily[i].timestamp = d.timestamp;
+        data.daily[i].tempMinDeci = d.tempMinDeci;
+        data.daily[i].tempMaxDeci = d.tempMaxDeci;
+        data.daily[i].weatherId = d.weatherId;
+        data.daily[i].humidity = d.humidity;
+        data.daily[i].pop = d.pop;
+    }
+
+    const SnapshotSeries& s = snap.series;
+    data.series.start = s.start;
+    data.series.stepSeconds = s.stepSeconds;
+    data.series.count = s.count;
+    memcpy(data.series.tempDeci, s.tempDeci, sizeof(s.tempDeci));
+    memcpy(data.series.pop, s.pop, sizeof(s.pop));
+    memcpy(data.series.weatherId, s.weatherId, sizeof(s.weatherId));
+    memcpy(data.series.feelsLikeDeci, s.feelsLikeDeci, sizeof(s.feelsLikeDeci));
+    memcpy(data.series.windSpeedDeci, s.windSpeedDeci, sizeof(s.windSpeedDeci));
+    memcpy(data.series.humidity, s.humidity, sizeof(s.humidity));
+
+    data.trend.hasRange = false;
+    data.trend.hasYesterday = false;
+    data.fetchedAt = snap.header.createdAt;
+    data.rolledForward = false;
+    data.errorMessage = "";
+    data.valid = true;
+}
+
+bool snapshotWriteFile(fs::FS& fs, const char* path, const WeatherSnapshot& snap) {
+    // Write beside the old file and swap, so a reset never leaves half a snapshot
+    String tmpPath = String(path) + ".tmp";
+    File file = fs.open(tmpPath.c_str(), FILE_WRITE);
+    if (!file) return false;
+    size_t written = file.write((const uint8_t*)&snap, sizeof(snap));
+    file.close();
+    if (written != sizeof(snap)) {
+        fs.remove(tmpPath.c_str());
+        return false;
+    }
+    fs.remove(path);
+    return fs.rename(tmpPath.c_str(), path);
+}
+
+const WeatherSnapshot* snapshotReadFile(fs::FS& fs, const char* path, WeatherSnapshot& buffer) {
+    File file = fs.open(path, FILE_READ);
+    if (!file) return nullptr;
+    size_t length = file.read((uint8_t*)&buffer, sizeof(buffer));
+    file.close();
+    return snapshotView(&buffer, length);
+}
@@ -0,0 +1,122 @@
+#ifndef WEATHER_SNAPSHOT_H
+#define WEATHER_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "weather_api.h"
+
+namespace fs { class FS; }
+
+// Binary snapshot of WeatherData for LittleFS/SD and the host tools
+// (tools/snapshot_tool.py). Little-endian, fixed size, every field
+// naturally aligned: once snapshotView() has validated a buffer (a file
+// read, an mmap, a flash mapping) it is used in place, with no parsing.
+//
+// Schema rules: any layout change bumps SNAPSHOT_VERSION. Readers reject
+// other versions; a snapshot is a cache, not an archive.
+#define SNAPSHOT_MAGIC 0x504E5357  // "WSNP"
+#define SNAPSHOT_VERSION 3
+#define SNAPSHOT_HOURLY_MAX 12
+#define SNAPSHOT_DAILY_MAX 8
+
+#define SNAPSHOT_FLAG_IMPERIAL 0x0001
+
+struct SnapshotHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;      // sizeof(SnapshotHeader)
+    uint32_t totalSize;       // sizeof(WeatherSnapshot)
+    uint32_t crc32;           // CRC-32 (IEEE) of everything after the header
+    uint32_t createdAt;       // Unix time the snapshot was taken
+    uint16_t flags;
+    uint8_t hourlyCount;
+    uint8_t dailyCount;
+    int32_t latE6;            // Location in micro-degrees
+    int32_t lonE6;
+    uint16_t currentStride;   // Record sizes, so readers can check the layout
+    uint16_t hourlyStride;
+    uint16_t dailyStride;
+    uint16_t seriesStride;
+};
+
+// The records hold WeatherData's quantized fields as they are. Temperatures
+// and wind are in 0.1 units of the snapshot's unit system; descriptions
+// are looked up from weatherId (version 3 dropped the stored text).
+struct SnapshotCurrent {
+    uint32_t timestamp;
+    uint32_t sunrise;
+    uint32_t sunset;
+    int16_t tempDeci;
+    int16_t feelsLikeDeci;
+    uint16_t windSpeedDeci;
+    uint16_t windDeg;
+    uint16_t pressure;        // hPa
+    uint16_t visibility;      // Meters
+    uint16_t weatherId;
+    uint8_t humidity;
+    uint8_t reserved;
+};
+
+struct SnapshotHourly {
+    uint32_t timestamp;
+    int16_t tempDeci;
+    uint16_t weatherId;
+    uint8_t humidity;
+    uint8_t reserved[3];
+};
+
+struct SnapshotDaily {
+    uint32_t timestamp;
+    int16_t tempMinDeci;
+    int16_t tempMaxDeci;
+    uint16_t weatherId;
+    uint8_t humidity;
+    uint8_t pop;
+};
+
+// Same struct-of-arrays layout as ForecastSeries
+struct SnapshotSeries {
+    uint32_t start;
+    uint16_t stepSeconds;
+    uint8_t count;
+    uint8_t reserved;
+    int16_t tempDeci[FORECAST_SERIES_MAX];
+    uint8_t pop[FORECAST_SERIES_MAX];
+    uint16_t weatherId[FORECAST_SERIES_MAX];
+    int16_t feelsLikeDeci[FORECAST_SERIES_MAX];   // Version 2
+    uint16_t windSpeedDeci[FORECAST_SERIES_MAX];
+    uint8_t humidity[FORECAST_SERIES_MAX];
+};
+
+struct WeatherSnapshot {
+    SnapshotHeader header;
+    SnapshotCurrent current;
+    SnapshotHourly hourly[SNAPSHOT_HOURLY_MAX];
+    SnapshotDaily daily[SNAPSHOT_DAILY_MAX];
+    SnapshotSeries series;
+};
+
+// Build a snapshot (unused slots zeroed, CRC filled in)
+void snapshotFromWeather(const WeatherData& data, float lat, float lon, bool imperial,
+                         uint32_t createdAt, WeatherSnapshot& snap);
+
+// Whether a snapshot was taken for this location and unit system
+bool snapshotMatches(const WeatherSnapshot& snap, float lat, float lon, bool imperial);
+
+// Validate a buffer and return it as a snapshot, or nullptr if it is not
+// a complete, intact snapshot of this version
+const WeatherSnapshot* snapshotView(const void* buffer, size_t length);
+
+// Expand a snapshot back into WeatherData (e.g. to replay it into the renderer)
+void snapshotToWeather(const WeatherSnapshot& snap, WeatherData& data);
+
+uint32_t snapshotCrc32(const void* data, size_t length);
+
+// Store a snapshot as a file (written to a temp name, then renamed)
+bool snapshotWriteFile(fs::FS& fs, const char* path, const WeatherSnapshot& snap);
+
+// Read a snapshot file into buffer with a single read. Returns the
+// validated snapshot (buffer itself) or nullptr.
+const WeatherSnapshot* snapshotReadFile(fs::FS& fs, const char* path, WeatherSnapshot& buffer);
+
+#endif // WEATHER_SNAPSHOT_H
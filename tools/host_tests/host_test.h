@@ -0,0 +1,33 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+// Checks for the host tests (see run.sh). A failed check prints where and
+// what, and the test carries on; main() returns hostTestExit().
+#include <stdio.h>
+
+static int hostTestFailures = 0;
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            hostTestFailures++;                                                      \
+        }                                                                            \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                    \
+    do {                                                                              \
+        long long a_ = (long long)(actual);                                           \
+        long long e_ = (long long)(expected);                                         \
+        if (a_ != e_) {                                                               \
+            fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, \
+                    #actual, a_, e_);                                                 \
+            hostTestFailures++;                                                       \
+        }                                                                             \
+    } while (0)
+
+static inline int hostTestExit() {
+    return hostTestFailures ? 1 : 0;
+}
+
+#endif // HOST_TEST_H
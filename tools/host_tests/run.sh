@@ -0,0 +1,72 @@
+#!/bin/sh
+# Build and run the host tests: checks of firmware logic that needs no
+# hardware, compiled against the SDK stand-ins of the wake simulator.
+#
+#   tools/host_tests/run.sh [extra compiler flags, e.g. -fsanitize=address]
+#
+# Each test_<name>.cpp is one program, linked with the firmware sources
+# listed for it below. Exits non-zero if any test fails to build or pass.
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+src="$here/../../src"
+sim="$here/../wake_sim"
+out="$here/bin"
+CXX=${CXX:-g++}
+extra="$*"
+failed=0
+mkdir -p "$out"
+
+# check NAME [firmware source ...]
+check() {
+    name=$1
+    shift
+    files=""
+    for f in "$@"; do files="$files $src/$f"; done
+    build "$name" $files
+}
+
+# checkSim NAME: linked with the whole firmware but main.cpp, running on
+# the wake simulator's platform
+checkSim() {
+    name=$1
+    files=""
+    for f in "$src"/*.cpp; do
+        case $(basename "$f") in
+            main.cpp|tls_client.cpp|tls_session_cache.cpp) ;;
+            *) files="$files $f" ;;
+        esac
+    done
+    build "$name" $files "$here"/sim_wake.cpp "$sim"/sim_model.cpp "$sim"/sim_memory.cpp "$sim"/sim_platform.cpp \
+        "$sim"/sim_server.cpp "$sim"/sim_tls.cpp
+}
+
+build() {
+    name=$1
+    shift
+    # shellcheck disable=SC2086
+    $CXX -std=gnu++11 -O1 -g -Wall -Wno-unused-parameter -Wno-sign-compare \
+        -I"$here" -I"$sim" -I"$sim/host" -I"$src" $extra \
+        -o "$out/test_$name" "$here/test_$name.cpp" "$@"
+    if "$out/test_$name"; then
+        echo "ok    $name"
+    else
+        echo "FAIL  $name"
+        failed=1
+    fi
+}
+
+check geometry
+checkSim forecast_series
+checkSim settings
+check retry_policy retry_policy.cpp
+check observation_log observation_log.cpp
+check clock_drift clock_drift.cpp
+check dither dither.cpp framebuffer.cpp
+checkSim weather_snapshot
+checkSim timezone
+check solar solar.cpp
+check text_format text_format.cpp
+check display_list display_list.cpp
+
+exit $failed
@@ -0,0 +1,9 @@
+// Wakes in the simulator end in deep sleep, which returns to the wake loop
+// (wake_sim.cpp). Tests linked with the simulator's platform never sleep.
+#include <stdio.h>
+#include <stdlib.h>
+
+void simEndWake() {
+    fprintf(stderr, "unexpected deep sleep\n");
+    exit(1);
+}
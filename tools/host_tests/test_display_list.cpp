@@ -0,0 +1,282 @@
+// Display lists: dlDiff must find exactly the items that differ between
+// two frames (none for the same frame, the inserted or removed ones while
+// the lists can resynchronise, everything after the change once they
+// cannot), merge down to the regions asked for without losing any, and a
+// list must survive serialization unchanged while truncated or corrupted
+// data is refused with the caller's list left as it was.
+#include <stdio.h>
+#include <string.h>
+
+#include "display_list.h"
+#include "host_test.h"
+
+#define CELLS 100
+#define COLUMNS 12
+#define CELL 40
+#define INSERTED 1000  // Cell numbers of inserted items, drawn below the rest
+
+// Cell k of a frame: one item of a kind and place that depend on k only,
+// on a 40 px grid with 20 px between items so no two bounds touch
+static void addCell(DisplayList& list, int k, uint16_t color = 0) {
+    int x = (k % COLUMNS) * CELL + 10;
+    int y = (k / COLUMNS) * CELL + 10;
+    switch (k % 5) {
+    case 0:
+        dlFillRect(list, x, y, 20, 20, color);
+        break;
+    case 1:
+        dlCircle(list, x + 10, y + 10, 8, color);
+        break;
+    case 2:
+        dlLine(list, x, y, x + 19, y + 19, color);
+        break;
+    case 3: {
+        char text[16];
+        snprintf(text, sizeof(text), "c%d", k);
+        dlText(list, text, x, y, DL_ALIGN_TL, 1, 1, 20, 16, color);
+        break;
+    }
+    default:
+        dlIcon(list, x + 2, y + 2, 16, 800, true, (uint16_t)(k * 655));
+        break;
+    }
+}
+
+// Cells 0 to CELLS - 1, with count cells numbered from INSERTED put in
+// before cell at
+static void build(DisplayList& list, int at = 0, int count = 0) {
+    dlClear(list);
+    for (int k = 0; k < CELLS; k++) {
+        if (k == at) {
+            for (int n = 0; n < count; n++) addCell(list, INSERTED + n);
+        }
+        addCell(list, k);
+    }
+}
+
+static DlRect cellBounds(int k) {
+    DisplayList* one = new DisplayList;
+    dlClear(*one);
+    addCell(*one, k);
+    DlRect bounds = dlItemBounds(one->items[0]);
+    delete one;
+    return bounds;
+}
+
+static bool inside(const DlRect& inner, const DlRect& outer) {
+    return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.w <= outer.x + outer.w &&
+           inner.y + inner.h <= outer.y + outer.h;
+}
+
+static bool overlaps(const DlRect& p, const DlRect& q) {
+    return p.x < q.x + q.w && q.x < p.x + p.w && p.y < q.y + q.h && q.y < p.y + p.h;
+}
+
+static bool covered(int k, const DlRect* regions, int count) {
+    DlRect bounds = cellBounds(k);
+    for (int i = 0; i < count; i++) {
+        if (inside(bounds, regions[i])) return true;
+    }
+    return false;
+}
+
+static bool touched(int k, const DlRect* regions, int count) {
+    DlRect bounds = cellBounds(k);
+    for (int i = 0; i < count; i++) {
+        if (overlaps(bounds, regions[i])) return true;
+    }
+    return false;
+}
+
+static DisplayList a, b;
+static DlRect regions[256];
+
+static void checkUnchanged() {
+    build(a);
+    build(b);
+    CHECK_EQ(dlDiff(a, b, regions, 16), 0);
+
+    // The same text at other pool offsets is the same frame
+    memmove(b.text + 3, b.text, b.textUsed);
+    memcpy(b.text, "xx", 3);
+    b.textUsed += 3;
+    for (int i = 0; i < b.count; i++) {
+        if (b.items[i].op == DlOp::Text) b.items[i].x2 += 3;
+    }
+    CHECK_EQ(dlDiff(a, b, regions, 16), 0);
+
+    // Nothing asked for, nothing given
+    build(b, 50, 1);
+    CHECK_EQ(dlDiff(a, b, regions, 0), 0);
+}
+
+// count items inserted before cell 50, then the same removed
+static void checkInserted(int count) {
+    build(a);
+    build(b, 50, count);
+    for (int removed = 0; removed < 2; removed++) {
+        int n = removed ? dlDiff(b, a, regions, 256) : dlDiff(a, b, regions, 256);
+        for (int k = 0; k < count; k++) CHECK(covered(INSERTED + k, regions, n));
+        if (count == 1) {
+            CHECK_EQ(n, 1);
+            DlRect bounds = cellBounds(INSERTED);
+            CHECK(memcmp(&regions[0], &bounds, sizeof(bounds)) == 0);
+        }
+        int spilled = 0;
+        for (int k = 0; k < CELLS; k++) {
+            if (touched(k, regions, n)) spilled++;
+        }
+        if (count <= 16) {
+            CHECK_EQ(spilled, 0);
+        } else {
+            // Past the window the lists cannot resynchronise: every cell
+            // from the insertion on counts as changed
+            CHECK_EQ(spilled, CELLS - 50);
+            for (int k = 50; k < CELLS; k++) CHECK(covered(k, regions, n));
+        }
+    }
+}
+
+// Every fifth cell recolored, in as many regions as asked for
+static void checkMerged() {
+    build(a);
+    dlClear(b);
+    for (int k = 0; k < CELLS; k++) addCell(b, k, k % 5 == 2 ? 0x8410 : 0);
+    int changed = CELLS / 5;
+
+    CHECK_EQ(dlDiff(a, b, regions, 256), changed);
+    static const int limits[] = {16, 4, 2, 1};
+    for (int limit : limits) {
+        int n = dlDiff(a, b, regions, limit);
+        CHECK_EQ(n, limit);
+        for (int k = 2; k < CELLS; k += 5) CHECK(covered(k, regions, n));
+        // Merged regions do not overlap
+        for (int i = 0; i < n; i++) {
+            for (int j = i + 1; j < n; j++) CHECK(!overlaps(regions[i], regions[j]));
+        }
+    }
+
+    // One region: the box around every change
+    int left = 32767, top = 32767, right = 0, bottom = 0;
+    for (int k = 2; k < CELLS; k += 5) {
+        DlRect bounds = cellBounds(k);
+        if (bounds.x < left) left = bounds.x;
+        if (bounds.y < top) top = bounds.y;
+        if (bounds.x + bounds.w > right) right = bounds.x + bounds.w;
+        if (bounds.y + bounds.h > bottom) bottom = bounds.y + bounds.h;
+    }
+    dlDiff(a, b, regions, 1);
+    CHECK_EQ(regions[0].x, left);
+    CHECK_EQ(regions[0].y, top);
+    CHECK_EQ(regions[0].x + regions[0].w, right);
+    CHECK_EQ(regions[0].y + regions[0].h, bottom);
+}
+
+// The serialized header as display_list.cpp writes it
+struct Header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t itemSize;
+    uint16_t count;
+    uint16_t textUsed;
+};
+
+static uint8_t data[sizeof(DisplayList) + 64];
+static uint8_t bad[sizeof(DisplayList) + 64];
+
+// The list a failed read must leave alone
+static void previous(DisplayList& list) {
+    memset(&list, 0xA5, sizeof(list));
+    dlClear(list);
+    for (int k = 200; k < 210; k++) addCell(list, k);
+}
+
+static bool refused(const uint8_t* bytes, size_t length) {
+    static DisplayList target, before;
+    previous(target);
+    memcpy(&before, &target, sizeof(target));
+    bool ok = dlDeserialize(bytes, length, target);
+    CHECK(memcmp(&before, &target, sizeof(target)) == 0);
+    return !ok;
+}
+
+static void checkSerialized() {
+    build(a);
+    size_t size = dlSerializedSize(a);
+    dlClear(b);
+    CHECK_EQ(dlSerializedSize(b), sizeof(Header));
+    CHECK_EQ(dlSerialize(a, data, size - 1), 0);
+    CHECK_EQ(dlSerialize(a, data, sizeof(data)), size);
+
+    previous(b);
+    b.overflowed = true;
+    CHECK(dlDeserialize(data, size, b));
+    CHECK_EQ(b.count, a.count);
+    CHECK_EQ(b.textUsed, a.textUsed);
+    CHECK(!b.overflowed);
+    CHECK(memcmp(b.items, a.items, a.count * sizeof(DlItem)) == 0);
+    CHECK(memcmp(b.text, a.text, a.textUsed) == 0);
+    CHECK_EQ(dlDiff(a, b, regions, 16), 0);
+
+    // Cut short anywhere, or with a byte too many
+    int accepted = 0;
+    for (size_t length = 0; length < size; length++) {
+        if (!refused(data, length)) accepted++;
+    }
+    CHECK_EQ(accepted, 0);
+    memcpy(bad, data, size);
+    bad[size] = 0;
+    CHECK(refused(bad, size + 1));
+
+    // Header fields
+    Header header;
+    memcpy(&header, data, sizeof(header));
+    for (int field = 0; field < 6; field++) {
+        Header h = header;
+        switch (field) {
+        case 0: h.magic ^= 1; break;
+        case 1: h.version = 1; break;
+        case 2: h.version++; break;
+        case 3: h.itemSize--; break;
+        case 4: h.count = DISPLAY_LIST_MAX_ITEMS + 1; break;
+        default: h.textUsed = DISPLAY_LIST_TEXT_BYTES + 1; break;
+        }
+        memcpy(bad, data, size);
+        memcpy(bad, &h, sizeof(h));
+        CHECK(refused(bad, size));
+    }
+
+    // Items: an unknown op, and text runs that are out of the pool, not
+    // terminated or aligned to nowhere
+    int text = -1;
+    for (int i = 0; i < a.count && text < 0; i++) {
+        if (a.items[i].op == DlOp::Text) text = i;
+    }
+    CHECK(text >= 0);
+    for (int defect = 0; defect < 5; defect++) {
+        memcpy(bad, data, size);
+        DlItem item = a.items[text];
+        switch (defect) {
+        case 0: item.op = (DlOp)((uint8_t)DlOp::Icon + 1); break;
+        case 1: item.x2 = (int16_t)a.textUsed; break;
+        case 2: item.x2 = -1; break;
+        case 3: item.y2++; break;
+        default: item.arg = DL_ALIGN_BR + 1; break;
+        }
+        memcpy(bad + sizeof(Header) + text * sizeof(DlItem), &item, sizeof(item));
+        CHECK(refused(bad, size));
+    }
+    // The pool's last terminator
+    memcpy(bad, data, size);
+    bad[size - 1] = 'x';
+    CHECK(refused(bad, size));
+}
+
+int main() {
+    checkUnchanged();
+    static const int inserted[] = {1, 5, 16, 17, 40};
+    for (int count : inserted) checkInserted(count);
+    checkMerged();
+    checkSerialized();
+    return hostTestExit();
+}
@@ -0,0 +1,120 @@
+// Ordered dithering: the SWAR row kernel against the scalar one. Both must
+// write the same packed bytes for any source, offset and width, on a
+// gradient and on random frames, and leave the pixels outside the row as
+// they were. Also times a full frame through each.
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+#include "dither.h"
+#include "host_test.h"
+
+#define FRAME_W 540
+#define FRAME_H 960
+#define FRAME_BYTES (FRAME_W / 2 * FRAME_H)
+
+static uint32_t randomState = 1;
+
+static uint8_t randomByte() {
+    randomState = randomState * 1664525 + 1013904223;
+    return (uint8_t)(randomState >> 24);
+}
+
+// Left to right black to white, shifted a little on each row so every
+// gray meets every Bayer phase
+static void gradient(std::vector<uint8_t>& src) {
+    for (int y = 0; y < FRAME_H; y++) {
+        for (int x = 0; x < FRAME_W; x++) {
+            src[y * FRAME_W + x] = (uint8_t)((x * 255 / (FRAME_W - 1) + y) & 0xFF);
+        }
+    }
+}
+
+static void noise(std::vector<uint8_t>& src) {
+    for (size_t i = 0; i < src.size(); i++) src[i] = randomByte();
+}
+
+static void scalarFrame(const uint8_t* src, const Framebuffer4& fb) {
+    for (int y = 0; y < fb.height; y++) {
+        ditherRowScalar(src + y * FRAME_W, fb, 0, y, fb.width);
+    }
+}
+
+// Whole frames, from a background that is not white, so a nibble written
+// by one path and not the other shows
+static void checkFrame(const std::vector<uint8_t>& src, const char* what) {
+    std::vector<uint8_t> swar(FRAME_BYTES, 0x5A);
+    std::vector<uint8_t> scalar(FRAME_BYTES, 0x5A);
+    ditherFrame(src.data(), FRAME_W, framebufferWrap(swar.data(), FRAME_W, FRAME_H));
+    scalarFrame(src.data(), framebufferWrap(scalar.data(), FRAME_W, FRAME_H));
+    if (swar != scalar) {
+        size_t i = 0;
+        while (swar[i] == scalar[i]) i++;
+        fprintf(stderr, "%s: byte %zu is %02x, scalar %02x\n", what, i, swar[i], scalar[i]);
+        hostTestFailures++;
+    }
+}
+
+// Rows at every start phase and width, including the unaligned head, the
+// tail shorter than a word and clipping at both edges
+static void checkRows(const std::vector<uint8_t>& src) {
+    const int w = 64;
+    const int h = 4;
+    std::vector<uint8_t> swar(w / 2 * h);
+    std::vector<uint8_t> scalar(w / 2 * h);
+    Framebuffer4 fbSwar = framebufferWrap(swar.data(), w, h);
+    Framebuffer4 fbScalar = framebufferWrap(scalar.data(), w, h);
+    int mismatches = 0;
+    for (int y = -1; y <= h; y++) {
+        for (int x = -9; x < w + 2; x++) {
+            for (int len = 0; len <= 40; len++) {
+                memset(swar.data(), 0xA5, swar.size());
+                memset(scalar.data(), 0xA5, scalar.size());
+                const uint8_t* row = src.data() + ((y + 1) * 97 % FRAME_H) * FRAME_W + 20;
+                ditherRow(row, fbSwar, x, y, len);
+                ditherRowScalar(row, fbScalar, x, y, len);
+                if (swar != scalar) mismatches++;
+            }
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+static double elapsedMs(const struct timespec& start, const struct timespec& end, int count) {
+    return ((end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6) / count;
+}
+
+static void benchmark(const std::vector<uint8_t>& src) {
+    const int rounds = 50;
+    std::vector<uint8_t> out(FRAME_BYTES);
+    Framebuffer4 fb = framebufferWrap(out.data(), FRAME_W, FRAME_H);
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int n = 0; n < rounds; n++) ditherFrame(src.data(), FRAME_W, fb);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double swarMs = elapsedMs(start, end, rounds);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int n = 0; n < rounds; n++) scalarFrame(src.data(), fb);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double scalarMs = elapsedMs(start, end, rounds);
+
+    printf("dither: %dx%d frame %.2f ms SWAR, %.2f ms scalar (host)\n", FRAME_W, FRAME_H, swarMs,
+           scalarMs);
+}
+
+int main() {
+    std::vector<uint8_t> src(FRAME_W * FRAME_H);
+    gradient(src);
+    checkFrame(src, "gradient");
+    checkRows(src);
+    for (int i = 0; i < 4; i++) {
+        noise(src);
+        checkFrame(src, "random");
+    }
+    checkRows(src);
+    benchmark(src);
+    return hostTestExit();
+}
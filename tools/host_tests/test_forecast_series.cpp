@@ -0,0 +1,194 @@
+// The trend graph: seriesComputeGraph against hand-computed points, and
+// the band renderWeather draws from them, hashed. The band hashes are
+// golden values: when a change to the graph is intended, check the new
+// frame (wake_sim --frames) and update them from this test's output.
+// Also the quantization of parsed values to 0.1 units.
+#include <math.h>
+#include <string.h>
+
+#include "display_manager.h"
+#include "forecast_series.h"
+#include "host_test.h"
+#include "sim_model.h"
+#include "timezone.h"
+#include "weather_api.h"
+
+// The band as rendered from the series built by trendSeries()
+#define BAND_ITEMS_HASH 0xc3d7c3f7bc8929dfULL
+#define BAND_PIXELS_HASH 0xfc4f17839d1f5f11ULL
+
+// Canvas width (display_manager.cpp), 2 pixels a byte
+#define ROW_BYTES (540 / 2)
+
+DisplayManager display;
+
+static void checkGraph(const SeriesGraph& graph, const int* x, const int* y, const int* barTop) {
+    for (int i = 0; i < graph.count; i++) {
+        CHECK_EQ(graph.x[i], x[i]);
+        CHECK_EQ(graph.y[i], y[i]);
+        CHECK_EQ(graph.barTop[i], barTop[i]);
+    }
+}
+
+// Five slots in a 101 x 51 box: x steps by 25, temperatures 5..20 span
+// y 50..0 at 1/3 px per 0.1 degree, bars are 51 px at 100%
+static void checkSmallGraph() {
+    static const float temps[] = {10, 15, 20, 12.5f, 5};
+    static const float pops[] = {0, 0.5f, 1, 0.3f, 0.05f};
+    ForecastSeries series;
+    seriesClear(series);
+    for (int i = 0; i < 5; i++) {
+        seriesAppend(series, 1000 + i * FORECAST_STEP_SECONDS, temps[i], temps[i], 50, 3, pops[i], 800);
+    }
+
+    SeriesGraph graph;
+    seriesComputeGraph(series, 0, 0, 101, 51, graph);
+    CHECK_EQ(graph.count, 5);
+    CHECK_EQ(graph.minDeci, 50);
+    CHECK_EQ(graph.maxDeci, 200);
+    static const int x[] = {0, 25, 50, 75, 100};
+    static const int y[] = {34, 17, 0, 25, 50};
+    static const int barTop[] = {51, 26, 0, 36, 49};
+    checkGraph(graph, x, y, barTop);
+
+    // Offset box, uneven steps: the last slot still lands on the right edge
+    seriesComputeGraph(series, 60, 100, 400, 76, graph);
+    static const int x2[] = {60, 159, 259, 359, 459};
+    static const int y2[] = {150, 125, 100, 138, 175};
+    static const int barTop2[] = {176, 138, 100, 154, 173};
+    checkGraph(graph, x2, y2, barTop2);
+}
+
+// A flat series sits on the bottom edge; one slot sits on the left edge
+static void checkDegenerateGraphs() {
+    ForecastSeries series;
+    seriesClear(series);
+    SeriesGraph graph;
+    seriesComputeGraph(series, 0, 0, 100, 50, graph);
+    CHECK_EQ(graph.count, 0);
+
+    seriesAppend(series, 1000, 7, 7, 50, 3, 0, 800);
+    seriesComputeGraph(series, 10, 20, 100, 50, graph);
+    CHECK_EQ(graph.count, 1);
+    CHECK_EQ(graph.x[0], 10);
+    CHECK_EQ(graph.y[0], 69);
+
+    for (int i = 1; i < 4; i++) {
+        seriesAppend(series, 1000 + i * FORECAST_STEP_SECONDS, 7, 7, 50, 3, 0, 800);
+    }
+    seriesComputeGraph(series, 10, 20, 100, 50, graph);
+    for (int i = 0; i < 4; i++) {
+        CHECK_EQ(graph.y[i], 69);
+        CHECK_EQ(graph.barTop[i], 70);
+    }
+    CHECK_EQ(graph.x[3], 109);
+}
+
+// Five days of made-up forecast from midnight UTC, 18 Oct 2025
+static void trendSeries(ForecastSeries& series) {
+    seriesClear(series);
+    for (int i = 0; i < FORECAST_SERIES_MAX; i++) {
+        float temp = 8 + (i * 37 % 23) * 0.45f - (i % 8 < 4 ? 2.5f : 0);
+        float pop = (i * 13 % 11) / 10.0f;
+        seriesAppend(series, 1760745600 + i * FORECAST_STEP_SECONDS, temp, temp - 1, 70, 4, pop,
+                     i % 3 ? 500 : 803);
+    }
+}
+
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t length) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ p[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static int findText(const DisplayList& frame, const char* text) {
+    for (int i = 0; i < frame.count; i++) {
+        if (frame.items[i].op == DlOp::Text && strcmp(dlItemText(frame, frame.items[i]), text) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Render a frame around the series and hash what lies between the trend
+// title and the next section's: the recorded items, and the canvas rows
+static void checkTrendBand() {
+    static WeatherData weather;
+    weather.valid = true;
+    weather.current.timestamp = 1760745600;
+    weather.current.tempDeci = 123;
+    weather.current.weatherId = 800;
+    weather.fetchedAt = weather.current.timestamp;
+    weather.daily[0].timestamp = weather.current.timestamp;
+    weather.daily[0].weatherId = 500;
+    weather.dailyCount = 1;
+    trendSeries(weather.series);
+
+    tzBegin();
+    display.begin();
+    display.renderWeather(weather);
+    const DisplayList& frame = display.lastFrame();
+    int first = findText(frame, "5-DAY TREND");
+    int last = findText(frame, "EXTENDED FORECAST");
+    CHECK(first >= 0 && last > first);
+    if (first < 0 || last <= first) return;
+
+    uint64_t items = 0xcbf29ce484222325ULL;
+    for (int i = first; i < last; i++) {
+        DlItem item = frame.items[i];
+        if (item.op == DlOp::Text) {
+            const char* text = dlItemText(frame, item);
+            items = fnv1a(items, text, strlen(text));
+            item.x2 = 0;  // Pool offset, depends on what came before
+        }
+        items = fnv1a(items, &item, sizeof(item));
+    }
+
+    int top = frame.items[first].y0;
+    int bottom = frame.items[last].y0;
+    const uint8_t* pixels = simPanelPixels();
+    uint64_t rows = 0xcbf29ce484222325ULL;
+    if (pixels) {
+        rows = fnv1a(rows, pixels + top * ROW_BYTES, (size_t)(bottom - top) * ROW_BYTES);
+    }
+
+    printf("forecast_series: trend band of %d items, items %#llx, pixels %#llx\n", last - first,
+           (unsigned long long)items, (unsigned long long)rows);
+    CHECK_EQ(items, BAND_ITEMS_HASH);
+    CHECK_EQ(rows, BAND_PIXELS_HASH);
+}
+
+// Truncating to 0.1 units and rounding that for display must show the
+// value rounded once (half away from zero), as before quantizing: checked
+// for every 0.1 from -1000 to 1000 and every 0.01 over the range weather
+// takes, each as the float the JSON parser makes of it
+static void checkQuantize() {
+    int mismatches = 0;
+    for (int k = -10000; k <= 10000; k++) {
+        float v = (float)(k / 10.0);
+        if (roundDeci(quantizeDeci(v)) != (int)lround(v)) mismatches++;
+    }
+    for (int k = -6000; k <= 15000; k++) {
+        float v = (float)(k / 100.0);
+        if (roundDeci(quantizeDeci(v)) != (int)lround(v)) mismatches++;
+    }
+    CHECK_EQ(mismatches, 0);
+
+    // Truncation toward zero, on both sides
+    CHECK_EQ(quantizeDeci(72.46f), 724);
+    CHECK_EQ(quantizeDeci(-72.46f), -724);
+    CHECK_EQ(roundDeci(724), 72);
+    CHECK_EQ(roundDeci(725), 73);
+    CHECK_EQ(roundDeci(-725), -73);
+    CHECK_EQ(roundDeci(-724), -72);
+}
+
+int main() {
+    checkQuantize();
+    checkSmallGraph();
+    checkDegenerateGraphs();
+    checkTrendBand();
+    return hostTestExit();
+}
@@ -0,0 +1,239 @@
+// The fixed-point icon geometry (geometry.h) against the float code it
+// replaced: every coordinate the icons compute, over the sizes they are
+// drawn at, must land on the same pixel. The float code truncated, so it
+// sometimes landed one pixel short of a point that is exactly on the grid
+// (2.9999998 for 3); there the tables must give the exact pixel instead.
+// Also times both versions of the sun icon's rays.
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+#include <cmath>
+
+#include "Arduino.h"
+#include "geometry.h"
+#include "host_test.h"
+
+// Icon sizes and the lengths derived from them stay well inside this
+#define MAX_LEN 160
+// Screen position of the icon centre; coordinates are only compared on screen
+#define CENTRE 270
+
+static int exactPixels = 0;
+static int correctedPixels = 0;
+
+// newValue is the table version of a coordinate whose float version was
+// oldValue and whose true value is exact
+static void comparePixel(int newValue, int oldValue, long double exact, const char* what, int len) {
+    if (newValue == oldValue) {
+        exactPixels++;
+        return;
+    }
+    bool onGrid = fabsl(exact - roundl(exact)) < 1e-9L;
+    if (onGrid && oldValue == newValue - 1 && newValue == (int)roundl(exact)) {
+        correctedPixels++;
+        return;
+    }
+    fprintf(stderr, "%s, length %d: table %d, float %d, exact %.6Lf\n", what, len, newValue,
+            oldValue, exact);
+    hostTestFailures++;
+}
+
+static long double exactCos(int step) {
+    return cosl(step * 3.14159265358979323846264338327950288L / 6);
+}
+
+static long double exactSin(int step) {
+    return sinl(step * 3.14159265358979323846264338327950288L / 6);
+}
+
+// drawSunIcon, drawSnowflake (arms): float angle = i * PI / 6;
+// x = cx + cos(angle) * len
+static void checkRays() {
+    for (int len = 0; len <= MAX_LEN; len++) {
+        for (int i = 0; i < 12; i++) {
+            float angle = i * PI / 6;
+            int oldX = CENTRE + std::cos(angle) * len;
+            int oldY = CENTRE + std::sin(angle) * len;
+            comparePixel(CENTRE + geomCos(i, len), oldX, CENTRE + exactCos(i) * len, "ray x", len);
+            comparePixel(CENTRE + geomSin(i, len), oldY, CENTRE + exactSin(i) * len, "ray y", len);
+        }
+    }
+}
+
+// drawPartlyCloudyIcon: float angle = i * PI / 3 - PI / 6
+static void checkPartlyCloudyRays() {
+    for (int len = 0; len <= MAX_LEN; len++) {
+        for (int i = 0; i < 6; i++) {
+            float angle = i * PI / 3 - PI / 6;
+            int step = i * 2 - 1;
+            int oldX = CENTRE + std::cos(angle) * len;
+            int oldY = CENTRE + std::sin(angle) * len;
+            comparePixel(CENTRE + geomCos(step, len), oldX, CENTRE + exactCos(step) * len,
+                         "partly cloudy ray x", len);
+            comparePixel(CENTRE + geomSin(step, len), oldY, CENTRE + exactSin(step) * len,
+                         "partly cloudy ray y", len);
+        }
+    }
+}
+
+// drawSnowflake branches: the root 0.6 along the arm, int bLen = size * 0.4,
+// ends at angle +/- PI / 6 from the arm
+static void checkSnowflakeBranches() {
+    for (int size = 4; size <= MAX_LEN; size++) {
+        int oldLen = size * 0.4;
+        int newLen = geomScale(size, 2, 5);
+        comparePixel(newLen, oldLen, size * 0.4L, "branch length", size);
+        for (int i = 0; i < 6; i++) {
+            float angle = i * PI / 3;
+            int step = i * 2;
+            int oldBx = CENTRE + std::cos(angle) * size * 0.6;
+            int oldBy = CENTRE + std::sin(angle) * size * 0.6;
+            comparePixel(CENTRE + geomCos(step, size, 3, 5), oldBx,
+                         CENTRE + exactCos(step) * size * 0.6L, "branch root x", size);
+            comparePixel(CENTRE + geomSin(step, size, 3, 5), oldBy,
+                         CENTRE + exactSin(step) * size * 0.6L, "branch root y", size);
+
+            float branchAngle1 = angle + PI / 6;
+            float branchAngle2 = angle - PI / 6;
+            comparePixel(CENTRE + geomCos(step + 1, newLen), CENTRE + std::cos(branchAngle1) * oldLen,
+                         CENTRE + exactCos(step + 1) * newLen, "branch end x", size);
+            comparePixel(CENTRE + geomSin(step + 1, newLen), CENTRE + std::sin(branchAngle1) * oldLen,
+                         CENTRE + exactSin(step + 1) * newLen, "branch end y", size);
+            comparePixel(CENTRE + geomCos(step - 1, newLen), CENTRE + std::cos(branchAngle2) * oldLen,
+                         CENTRE + exactCos(step - 1) * newLen, "branch end x", size);
+            comparePixel(CENTRE + geomSin(step - 1, newLen), CENTRE + std::sin(branchAngle2) * oldLen,
+                         CENTRE + exactSin(step - 1) * newLen, "branch end y", size);
+        }
+    }
+}
+
+// The float multipliers of the cloud, moon and star shapes: cx - r * 1.2,
+// r * 0.9, size * 0.75 and friends, against geomScale(r, num, den)
+static void checkScales() {
+    static const struct {
+        int num, den;
+        double literal;
+    } scales[] = {
+        {-12, 10, -1.2}, {-5, 10, -0.5}, {-2, 10, -0.2}, {3, 10, 0.3},  {4, 10, 0.4},
+        {5, 10, 0.5},    {7, 10, 0.7},   {8, 10, 0.8},   {9, 10, 0.9},  {11, 10, 1.1},
+        {12, 10, 1.2},   {24, 10, 2.4},  {3, 4, 0.75},
+    };
+    for (size_t s = 0; s < sizeof(scales) / sizeof(scales[0]); s++) {
+        for (int len = 0; len <= MAX_LEN; len++) {
+            int oldValue = CENTRE + len * scales[s].literal;
+            comparePixel(CENTRE + geomScale(len, scales[s].num, scales[s].den), oldValue,
+                         CENTRE + (long double)len * scales[s].num / scales[s].den, "scale", len);
+        }
+    }
+}
+
+// drawFogIcon: (int)(sin((wx - startX) * 0.15) * 2) for wx stepping by 3
+static void checkFogWave() {
+    for (int k = 0; k < GEOM_FOG_WAVE_STEPS; k++) {
+        CHECK_EQ(geomFogWave(k), (int)(sin(k * 3 * 0.15) * 2));
+    }
+}
+
+// drawMoonIcon: the phase cosine at every 1/65536 turn, square roots, and
+// the lit span of every row against the float code it replaced. Those
+// rounded from cosf() and sqrtf(), so a row may end a pixel off where the
+// true width is within a hair of a half pixel, and nowhere else.
+static void checkMoon() {
+    int worstCos = 0;
+    for (uint32_t turn = 0; turn < 65536; turn++) {
+        long double exact = cosl(turn * 2 * 3.14159265358979323846264338327950288L / 65536) * 16384;
+        int error = abs(geomCosTurnQ14((uint16_t)turn) - (int)roundl(exact));
+        worstCos = error > worstCos ? error : worstCos;
+    }
+    CHECK(worstCos <= 2);
+
+    for (uint32_t n = 0; n < (1u << 20); n++) {
+        uint32_t root = (uint32_t)geomSqrt(n);
+        CHECK(root * root <= n && (root + 1) * (root + 1) > n);
+    }
+    CHECK_EQ(geomSqrt(0xFFFFFFFFu), 65535);
+
+    int rows = 0;
+    int offByOne = 0;
+    for (int r = 0; r <= MAX_LEN / 3; r++) {
+        for (uint32_t turn = 0; turn < 65536; turn += 16) {
+            float phase = turn / 65536.0f;
+            float terminator = cosf(2 * (float)M_PI * phase);
+            int32_t cosQ14 = geomCosTurnQ14((uint16_t)turn);
+            for (int dy = -r; dy <= r; dy++) {
+                float w = sqrtf((float)(r * r - dy * dy));
+                int oldEdge = (int)lroundf(w * terminator);
+                int oldLimb = (int)lroundf(w);
+                int edge, limb;
+                geomMoonRow(r, dy, cosQ14, edge, limb);
+                rows++;
+                CHECK_EQ(limb, oldLimb);
+                if (edge == oldEdge) continue;
+                // Only where the float result sat on a rounding boundary
+                double exact = sqrt((double)(r * r - dy * dy)) * cos(2 * M_PI * turn / 65536.0);
+                if (abs(edge - oldEdge) == 1 && fabs(fabs(exact - floor(exact)) - 0.5) < 0.05) {
+                    offByOne++;
+                } else if (hostTestFailures++ < 5) {
+                    fprintf(stderr, "moon r %d dy %d turn %u: edge %d, float %d, exact %.4f\n", r,
+                            dy, turn, edge, oldEdge, exact);
+                }
+            }
+        }
+    }
+    printf("geometry: moon phase cosine within %d/16384, %d of %d rows a pixel off by rounding\n",
+           worstCos, offByOne, rows);
+}
+
+static double elapsedNs(const struct timespec& start, const struct timespec& end, int count) {
+    return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / count;
+}
+
+// The sun icon's 12 rays, both ways; the sink keeps the loops from being
+// optimised away
+static void benchmark() {
+    const int rounds = 20000;
+    volatile int sink = 0;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int n = 0; n < rounds; n++) {
+        int gap = 10 + n % 50;
+        for (int i = 0; i < 12; i++) {
+            float angle = i * PI / 6;
+            sink += CENTRE + std::cos(angle) * gap;
+            sink += CENTRE + std::sin(angle) * gap;
+            sink += CENTRE + std::cos(angle) * (gap + 12);
+            sink += CENTRE + std::sin(angle) * (gap + 12);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double floatNs = elapsedNs(start, end, rounds);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int n = 0; n < rounds; n++) {
+        int gap = 10 + n % 50;
+        for (int i = 0; i < 12; i++) {
+            sink += CENTRE + geomCos(i, gap);
+            sink += CENTRE + geomSin(i, gap);
+            sink += CENTRE + geomCos(i, gap + 12);
+            sink += CENTRE + geomSin(i, gap + 12);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double tableNs = elapsedNs(start, end, rounds);
+
+    printf("geometry: sun rays %.0f ns float, %.0f ns tables (host)\n", floatNs, tableNs);
+}
+
+int main() {
+    checkRays();
+    checkPartlyCloudyRays();
+    checkSnowflakeBranches();
+    checkScales();
+    checkFogWave();
+    checkMoon();
+    printf("geometry: %d pixels as before, %d moved onto the exact grid point\n", exactPixels,
+           correctedPixels);
+    benchmark();
+    return hostTestExit();
+}
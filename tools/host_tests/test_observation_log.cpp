@@ -0,0 +1,129 @@
+// Observation log over storage that can fail: a write that stops partway
+// must not shift the records written after it, in the RTC index or after
+// a rebuild from storage.
+#include <string.h>
+
+#include <map>
+#include <vector>
+
+#include "host_test.h"
+#include "observation_log.h"
+
+// Segments in memory. A failing write stores the first shortBytes of the
+// data, as flash running out or a power dip partway through would.
+class MemoryStorage : public ObservationStorage {
+public:
+    std::map<uint32_t, std::vector<uint8_t>> files;
+    int failWrites = 0;
+    size_t shortBytes = 0;
+
+    int list(uint32_t* sequences, int max) override {
+        int n = 0;
+        for (auto& f : files) {
+            if (n < max) sequences[n++] = f.first;
+        }
+        return n;
+    }
+
+    size_t size(uint32_t sequence) override {
+        auto f = files.find(sequence);
+        return f == files.end() ? 0 : f->second.size();
+    }
+
+    bool read(uint32_t sequence, size_t offset, void* buffer, size_t length) override {
+        auto f = files.find(sequence);
+        if (f == files.end() || offset + length > f->second.size()) return false;
+        memcpy(buffer, f->second.data() + offset, length);
+        return true;
+    }
+
+    bool write(uint32_t sequence, size_t offset, const void* data, size_t length) override {
+        if (offset > 0 && files.find(sequence) == files.end()) return false;
+        std::vector<uint8_t>& file = files[sequence];
+        if (offset == 0) file.clear();
+        if (offset > file.size()) return false;
+
+        size_t n = length;
+        if (failWrites > 0) {
+            failWrites--;
+            n = shortBytes < length ? shortBytes : length;
+        }
+        if (file.size() < offset + n) file.resize(offset + n);
+        memcpy(file.data() + offset, data, n);
+        return n == length;
+    }
+
+    bool remove(uint32_t sequence) override {
+        files.erase(sequence);
+        return true;
+    }
+};
+
+static ObservationRecord record(uint32_t i) {
+    ObservationRecord r;
+    memset(&r, 0, sizeof(r));
+    r.timestamp = 1000000 + i * 600;
+    r.tempDeci = (int16_t)(i * 7 % 300 - 100);
+    r.humidity = (uint8_t)(i % 100);
+    return r;
+}
+
+// Every record i in [0, count) is found with its own values
+static void checkAll(ObservationLog& log, uint32_t count) {
+    CHECK_EQ(log.count(), count);
+    for (uint32_t i = 0; i < count; i++) {
+        ObservationRecord want = record(i);
+        ObservationRecord got;
+        CHECK(log.nearest(want.timestamp, 60, got));
+        if (memcmp(&got, &want, sizeof(got)) != 0) {
+            fprintf(stderr, "record %u read back as %u/%d\n", i, got.timestamp, got.tempDeci);
+            hostTestFailures++;
+            return;
+        }
+    }
+}
+
+static void checkShortWrites(size_t shortBytes) {
+    static ObsLogState state;
+    memset(&state, 0, sizeof(state));
+    MemoryStorage storage;
+    ObservationLog log(state, storage);
+    log.begin();
+
+    // The first flush writes whole; the second stops partway, and the
+    // records stay staged for the next flush, which writes them again
+    uint32_t n = 0;
+    for (; n < OBS_STAGE_RECORDS; n++) CHECK(log.append(record(n)));
+    storage.failWrites = 1;
+    storage.shortBytes = shortBytes;
+    for (; n < 2 * OBS_STAGE_RECORDS - 1; n++) CHECK(log.append(record(n)));
+    CHECK(!log.append(record(n++)));
+    CHECK(log.flush());
+
+    // Fill the segment, then fail the first write of the next one
+    while (n < OBS_SEGMENT_RECORDS) log.append(record(n++));
+    storage.failWrites = 1;
+    while (n < OBS_SEGMENT_RECORDS + 2 * OBS_STAGE_RECORDS + 3) log.append(record(n++));
+    CHECK(log.flush());
+
+    CHECK_EQ(storage.size(state.segments[0].sequence), OBS_SEGMENT_RECORDS * sizeof(ObservationRecord));
+    checkAll(log, n);
+
+    // As after a power cut: the index is rebuilt from the segment files
+    memset(&state, 0, sizeof(state));
+    ObservationLog rebuilt(state, storage);
+    rebuilt.begin();
+    checkAll(rebuilt, n);
+
+    ObsRange range;
+    CHECK(rebuilt.range(record(0).timestamp, record(n - 1).timestamp, range));
+    CHECK_EQ(range.count, n);
+}
+
+int main() {
+    // Less than a record, a record and a bit, all but the last byte
+    checkShortWrites(5);
+    checkShortWrites(sizeof(ObservationRecord) + 3);
+    checkShortWrites(OBS_STAGE_RECORDS * sizeof(ObservationRecord) - 1);
+    return hostTestExit();
+}
@@ -0,0 +1,179 @@
+// Retry backoff: per-class doubling from the class multiplier up to its
+// cap, jitter inside its bounds, the 30 s floor, snapping to the regular
+// schedule, and the classes that wait for the schedule outright.
+#include <string.h>
+
+#include "host_test.h"
+#include "retry_policy.h"
+
+#define BASE 300
+#define NO_SCHEDULE (-1)
+#define FAR_SCHEDULE (24 * 3600)
+
+static void freshState(RetryState& state) {
+    memset(&state, 0xA5, sizeof(state));  // What RTC memory holds after power-on
+    retryInit(state);
+}
+
+static const FailureClass ALL_CLASSES[] = {
+    FailureClass::WiFi,       FailureClass::Time,          FailureClass::Dns,
+    FailureClass::Tls,        FailureClass::HttpAuth,      FailureClass::HttpRateLimit,
+    FailureClass::HttpServer, FailureClass::HttpOther,     FailureClass::Json,
+    FailureClass::Config,
+};
+
+// Without jitter (random chosen to land on the middle of the span) each
+// failure doubles base * multiplier until the cap
+static void checkDoubling() {
+    for (FailureClass cls : ALL_CLASSES) {
+        const RetryRule& rule = retryRule(cls);
+        if (rule.waitForSchedule) continue;
+
+        RetryState state;
+        freshState(state);
+        uint32_t expected = BASE * rule.multiplier;
+        for (int streak = 1; streak <= 20; streak++) {
+            uint32_t capped = expected < rule.maxSeconds ? expected : rule.maxSeconds;
+            uint32_t span = capped * rule.jitterPercent / 100;
+            uint32_t delay = retryRecordFailure(state, cls, BASE, NO_SCHEDULE, span);
+            if (delay != capped) {
+                fprintf(stderr, "%s, failure %d: %u s, expected %u s\n", failureClassName(cls),
+                        streak, delay, capped);
+                hostTestFailures++;
+            }
+            CHECK_EQ(state.consecutive[(int)cls], streak);
+            if (expected < rule.maxSeconds) expected *= 2;
+        }
+    }
+}
+
+// Classes keep separate streaks; any success clears them all
+static void checkStreaks() {
+    RetryState state;
+    freshState(state);
+    CHECK_EQ(retryRecordFailure(state, FailureClass::HttpServer, BASE, NO_SCHEDULE, 60), 300);
+    CHECK_EQ(retryRecordFailure(state, FailureClass::HttpServer, BASE, NO_SCHEDULE, 120), 600);
+    CHECK_EQ(retryRecordFailure(state, FailureClass::Dns, BASE, NO_SCHEDULE, 60), 300);
+    CHECK_EQ(retryRecordFailure(state, FailureClass::HttpServer, BASE, NO_SCHEDULE, 240), 1200);
+    CHECK_EQ(state.failuresSinceSuccess, 4);
+    CHECK(state.lastFailure == FailureClass::HttpServer);
+
+    retryRecordSuccess(state);
+    CHECK_EQ(state.failuresSinceSuccess, 0);
+    CHECK(state.lastFailure == FailureClass::None);
+    CHECK_EQ(retryRecordFailure(state, FailureClass::HttpServer, BASE, NO_SCHEDULE, 60), 300);
+
+    // A valid state survives retryInit (a timer wake), the streak carries on
+    retryInit(state);
+    CHECK_EQ(retryRecordFailure(state, FailureClass::HttpServer, BASE, NO_SCHEDULE, 120), 600);
+
+    // Streaks saturate instead of wrapping
+    for (int i = 0; i < 300; i++) {
+        retryRecordFailure(state, FailureClass::Tls, BASE, NO_SCHEDULE, 0);
+    }
+    CHECK_EQ(state.consecutive[(int)FailureClass::Tls], 255);
+}
+
+// Jitter stays within +/- jitterPercent of the capped delay and reaches
+// both ends
+static void checkJitter() {
+    for (FailureClass cls : ALL_CLASSES) {
+        const RetryRule& rule = retryRule(cls);
+        if (rule.waitForSchedule) continue;
+
+        for (int streak = 1; streak <= 8; streak++) {
+            uint32_t nominal = (BASE * rule.multiplier) << (streak - 1);
+            if (nominal > rule.maxSeconds) nominal = rule.maxSeconds;
+            uint32_t span = nominal * rule.jitterPercent / 100;
+
+            uint32_t lowest = UINT32_MAX;
+            uint32_t highest = 0;
+            for (uint32_t random = 0; random <= 2 * span + 1; random++) {
+                RetryState state;
+                freshState(state);
+                state.consecutive[(int)cls] = streak - 1;
+                uint32_t delay = retryRecordFailure(state, cls, BASE, NO_SCHEDULE, random);
+                lowest = delay < lowest ? delay : lowest;
+                highest = delay > highest ? delay : highest;
+            }
+            CHECK_EQ(lowest, nominal - span);
+            CHECK_EQ(highest, nominal + span);
+        }
+    }
+}
+
+// No retry sooner than 30 s, whatever the configured base or the jitter
+static void checkFloor() {
+    for (uint32_t base = 0; base <= 40; base++) {
+        for (uint32_t random = 0; random < 64; random++) {
+            RetryState state;
+            freshState(state);
+            uint32_t delay = retryRecordFailure(state, FailureClass::WiFi, base, NO_SCHEDULE, random);
+            CHECK(delay >= 30);
+            if (base * 6 / 5 < 30) CHECK_EQ(delay, 30);
+        }
+    }
+}
+
+// A retry due within 10 minutes of the regular update (or after it) is
+// dropped in favour of the update
+static void checkScheduleSnap() {
+    RetryState state;
+    freshState(state);
+    // 300 s retry, update in 1000 s: 300 + 600 < 1000, retry stands
+    CHECK_EQ(retryRecordFailure(state, FailureClass::Json, BASE, 1000, 60), 300);
+    // 600 s retry, update in 1200 s: 600 + 600 reaches it, snap
+    CHECK_EQ(retryRecordFailure(state, FailureClass::Json, BASE, 1200, 120), 1200);
+
+    freshState(state);
+    CHECK_EQ(retryRecordFailure(state, FailureClass::Json, BASE, 901, 60), 300);
+    freshState(state);
+    CHECK_EQ(retryRecordFailure(state, FailureClass::Json, BASE, 900, 60), 900);
+
+    // Past the update: the update comes first
+    freshState(state);
+    CHECK_EQ(retryRecordFailure(state, FailureClass::HttpRateLimit, BASE, 200, 0), 200);
+
+    // Jitter decides on which side of the margin a retry lands
+    freshState(state);
+    CHECK_EQ(retryRecordFailure(state, FailureClass::WiFi, BASE, 841, 0), 240);
+    freshState(state);
+    CHECK_EQ(retryRecordFailure(state, FailureClass::WiFi, BASE, 841, 120), 841);
+
+    // Unknown schedule (clock not set): plain backoff
+    freshState(state);
+    CHECK_EQ(retryRecordFailure(state, FailureClass::Json, BASE, 0, 60), 300);
+}
+
+// 401 and missing configuration do not retry at all while the schedule is
+// known; without it they back off slowly up to 6 hours
+static void checkWaitForSchedule() {
+    const FailureClass waiting[] = {FailureClass::HttpAuth, FailureClass::Config};
+    for (FailureClass cls : waiting) {
+        CHECK(retryRule(cls).waitForSchedule);
+
+        RetryState state;
+        freshState(state);
+        for (int i = 0; i < 5; i++) {
+            CHECK_EQ(retryRecordFailure(state, cls, BASE, FAR_SCHEDULE, 0), FAR_SCHEDULE);
+        }
+        CHECK_EQ(retryRecordFailure(state, cls, BASE, 45, 0), 45);
+        CHECK_EQ(state.consecutive[(int)cls], 6);
+
+        freshState(state);
+        static const uint32_t expected[] = {300, 600, 1200, 2400, 4800, 9600, 19200, 21600, 21600};
+        for (uint32_t want : expected) {
+            CHECK_EQ(retryRecordFailure(state, cls, BASE, NO_SCHEDULE, 999), want);
+        }
+    }
+}
+
+int main() {
+    checkDoubling();
+    checkStreaks();
+    checkJitter();
+    checkFloor();
+    checkScheduleSnap();
+    checkWaitForSchedule();
+    return hostTestExit();
+}
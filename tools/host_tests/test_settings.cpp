@@ -0,0 +1,194 @@
+// Settings migration: a blob saved by each schema version loads into the
+// current layout with its own fields kept, the fields added since at their
+// defaults, and the padding an old version ended in never read as data.
+// Layout offsets and sizes are worked out by hand from the field list, so
+// a field inserted anywhere but at the end shows up here.
+#include <stddef.h>
+#include <string.h>
+
+#include "config.h"
+#include "host_test.h"
+#include "settings.h"
+
+// Where each version's last field ends, and its stored (padded) size
+static const struct {
+    uint16_t version;
+    size_t fieldsEnd;
+    size_t size;
+} layouts[] = {
+    {1, 222, 224},  // dailyCount at 221, then padding to the 4-byte alignment
+    {2, 270, 272},  // timezone[48] at 222
+    {3, 271, 272},  // clockTickMinutes at 270
+    {4, 272, 272},  // fetchEvery at 271
+    {5, 273, 276},  // singleRequest at 272
+    {6, 274, 276},  // wakeBudgetSeconds at 273
+};
+
+static const int LAYOUTS = sizeof(layouts) / sizeof(layouts[0]);
+
+static void checkLayout() {
+    CHECK_EQ(offsetof(Settings, wifiSsid), 2);
+    CHECK_EQ(offsetof(Settings, lat), 192);
+    CHECK_EQ(offsetof(Settings, updateTimes), 208);
+    CHECK_EQ(offsetof(Settings, errorRetrySeconds), 218);
+    CHECK_EQ(offsetof(Settings, dailyCount), 221);
+    CHECK_EQ(offsetof(Settings, timezone), 222);
+    CHECK_EQ(offsetof(Settings, clockTickMinutes), 270);
+    CHECK_EQ(offsetof(Settings, fetchEvery), 271);
+    CHECK_EQ(offsetof(Settings, singleRequest), 272);
+    CHECK_EQ(offsetof(Settings, wakeBudgetSeconds), 273);
+    CHECK_EQ(sizeof(Settings), 276);
+
+    CHECK_EQ(LAYOUTS, SETTINGS_VERSION);
+    for (int i = 0; i < LAYOUTS; i++) {
+        CHECK_EQ(settingsSizeForVersion(layouts[i].version), layouts[i].size);
+    }
+    CHECK_EQ(settingsSizeForVersion(0), 0);
+    CHECK_EQ(settingsSizeForVersion(SETTINGS_VERSION + 1), 0);
+}
+
+// Settings as a device might have saved them: every field off its default
+static void customized(Settings& s) {
+    settingsDefaults(s);
+    CHECK(settingsSet(s, "ssid", "home"));
+    CHECK(settingsSet(s, "password", "secret"));
+    CHECK(settingsSet(s, "apikey", "0123456789abcdef"));
+    CHECK(settingsSet(s, "location", "Tromso"));
+    CHECK(settingsSet(s, "units", "metric"));
+    CHECK(settingsSet(s, "lat", "69.65"));
+    CHECK(settingsSet(s, "lon", "18.96"));
+    CHECK(settingsSet(s, "update_times", "5,11,17,23"));
+    CHECK(settingsSet(s, "retry", "900"));
+    CHECK(settingsSet(s, "hourly", "5"));
+    CHECK(settingsSet(s, "daily", "4"));
+    CHECK(settingsSet(s, "timezone", "CET-1CEST,M3.5.0,M10.5.0/3"));
+    CHECK(settingsSet(s, "tick", "15"));
+    CHECK(settingsSet(s, "fetch_every", "3"));
+    CHECK(settingsSet(s, "single_request", SINGLE_REQUEST ? "0" : "1"));
+    CHECK(settingsSet(s, "wake_budget", "45"));
+}
+
+// The blob a version saved: its fields, then padding that held whatever
+// was in memory (0xAA is out of range for every small field)
+static size_t savedBlob(const Settings& s, int layout, uint8_t* blob) {
+    memset(blob, 0, sizeof(Settings));
+    memcpy(blob, &s, layouts[layout].fieldsEnd);
+    memcpy(blob, &layouts[layout].version, sizeof(uint16_t));
+    memset(blob + layouts[layout].fieldsEnd, 0xAA, layouts[layout].size - layouts[layout].fieldsEnd);
+    return layouts[layout].size;
+}
+
+static void checkMigrations() {
+    Settings saved;
+    customized(saved);
+    Settings defaults;
+    settingsDefaults(defaults);
+
+    for (int i = 0; i < LAYOUTS; i++) {
+        uint16_t version = layouts[i].version;
+        uint8_t blob[sizeof(Settings)];
+        size_t len = savedBlob(saved, i, blob);
+
+        Settings s;
+        CHECK(settingsLoadBlob(s, blob, len));
+        CHECK_EQ(s.version, SETTINGS_VERSION);
+
+        // Version 1 fields always survive
+        CHECK(strcmp(s.wifiSsid, "home") == 0);
+        CHECK(strcmp(s.wifiPassword, "secret") == 0);
+        CHECK(strcmp(s.apiKey, "0123456789abcdef") == 0);
+        CHECK(strcmp(s.locationName, "Tromso") == 0);
+        CHECK(strcmp(s.units, "metric") == 0);
+        CHECK(s.lat == saved.lat && s.lon == saved.lon);
+        CHECK_EQ(s.numUpdateTimes, 4);
+        CHECK(memcmp(s.updateTimes, saved.updateTimes, 4) == 0);
+        CHECK_EQ(s.errorRetrySeconds, 900);
+        CHECK_EQ(s.hourlyCount, 5);
+        CHECK_EQ(s.dailyCount, 4);
+
+        // Later fields: the saved value if the version had it, else the default
+        if (version >= 2) {
+            CHECK(strcmp(s.timezone, saved.timezone) == 0);
+        } else {
+            CHECK(strcmp(s.timezone, TIMEZONE) == 0);
+        }
+        CHECK_EQ(s.clockTickMinutes, version >= 3 ? saved.clockTickMinutes : defaults.clockTickMinutes);
+        CHECK_EQ(s.fetchEvery, version >= 4 ? saved.fetchEvery : defaults.fetchEvery);
+        CHECK_EQ(s.singleRequest, version >= 5 ? saved.singleRequest : defaults.singleRequest);
+        CHECK_EQ(s.wakeBudgetSeconds, version >= 6 ? saved.wakeBudgetSeconds : defaults.wakeBudgetSeconds);
+        CHECK(settingsValid(s));
+    }
+}
+
+// Version 1 had only fixed offsets: changed ones hand the zone to the
+// weather API, the default ones keep the default rules
+static void checkVersion1Offsets() {
+    Settings saved;
+    customized(saved);
+    uint8_t blob[sizeof(Settings)];
+    Settings s;
+
+    CHECK(settingsSet(saved, "gmt_offset", "3600"));
+    CHECK(settingsLoadBlob(s, blob, savedBlob(saved, 0, blob)));
+    CHECK_EQ(s.gmtOffsetSec, 3600);
+    CHECK_EQ(s.timezone[0], '\0');
+
+    saved.gmtOffsetSec = GMT_OFFSET_SEC;
+    CHECK(settingsSet(saved, "dst_offset", "3600"));
+    CHECK(settingsLoadBlob(s, blob, savedBlob(saved, 0, blob)));
+    CHECK_EQ(s.timezone[0], '\0');
+
+    saved.daylightOffsetSec = DAYLIGHT_OFFSET_SEC;
+    CHECK(settingsLoadBlob(s, blob, savedBlob(saved, 0, blob)));
+    CHECK(strcmp(s.timezone, TIMEZONE) == 0);
+}
+
+// Blobs that cannot be migrated load the defaults and report it
+static void checkRejected() {
+    Settings saved;
+    customized(saved);
+    Settings defaults;
+    settingsDefaults(defaults);
+    uint8_t blob[sizeof(Settings) + 4];
+    Settings s;
+
+    CHECK(!settingsLoadBlob(s, nullptr, 0));
+    CHECK(memcmp(&s, &defaults, sizeof(s)) == 0);
+    CHECK(!settingsLoadBlob(s, blob, 1));
+
+    // Size of a different version
+    size_t len = savedBlob(saved, 1, blob);
+    CHECK(!settingsLoadBlob(s, blob, len - 4));
+    CHECK(!settingsLoadBlob(s, blob, len + 4));
+    CHECK(memcmp(&s, &defaults, sizeof(s)) == 0);
+
+    // Versions this firmware does not know
+    uint16_t version = SETTINGS_VERSION + 1;
+    memcpy(blob, &saved, sizeof(Settings));
+    memcpy(blob, &version, sizeof(version));
+    CHECK(!settingsLoadBlob(s, blob, sizeof(Settings)));
+    version = 0;
+    memcpy(blob, &version, sizeof(version));
+    CHECK(!settingsLoadBlob(s, blob, sizeof(Settings)));
+
+    // The right size but invalid content
+    Settings broken = saved;
+    broken.numUpdateTimes = 0;
+    CHECK(!settingsLoadBlob(s, (const uint8_t*)&broken, sizeof(broken)));
+    CHECK(memcmp(&s, &defaults, sizeof(s)) == 0);
+    broken = saved;
+    memset(broken.units, 'x', sizeof(broken.units));
+    CHECK(!settingsLoadBlob(s, (const uint8_t*)&broken, sizeof(broken)));
+
+    // And the current version as saved comes back unchanged
+    CHECK(settingsLoadBlob(s, (const uint8_t*)&saved, sizeof(saved)));
+    CHECK(memcmp(&s, &saved, sizeof(s)) == 0);
+}
+
+int main() {
+    checkLayout();
+    checkMigrations();
+    checkVersion1Offsets();
+    checkRejected();
+    return hostTestExit();
+}
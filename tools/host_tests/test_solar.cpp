@@ -0,0 +1,224 @@
+// Sun and moon without the weather API, against reference values.
+//
+// Sun times are compared with NOAA's solar calculator, whose equations
+// (Meeus, with the event re-evaluated at its own time as the calculator
+// does) are written out below, for every third day of 2024 to 2026 over a
+// grid of latitudes and longitudes. Up to 65 degrees the times must agree
+// within the few minutes solar.h promises. Beyond it the error grows as
+// the sun's path grazes the horizon: within 12 minutes while the hour
+// angle's cosine stays under 0.8, and whether the sun crosses at all must
+// agree except within a day of polar day or night starting or ending. Fixed
+// days deep inside those are checked against the conventions of
+// solarSunTimes.
+//
+// Moon phases are compared with USNO's times of new and full moons (those
+// of eclipses, where the date is beyond doubt) within two hours.
+#include <math.h>
+#include <stdlib.h>
+
+#include "host_test.h"
+#include "solar.h"
+
+#define DEG (M_PI / 180.0)
+#define SYNODIC_DAYS 29.530589
+#define FROM 1704067200LL  // 2024-01-01 UTC
+#define TO 1798761600LL    // 2027-01-01 UTC
+
+// NOAA: sunrise (rising) or sunset in minutes after 00:00 UTC of the day
+// starting at jdMidnight, evaluated at jdMidnight + minutes. Returns false
+// when the sun does not cross the horizon; cosHour is what decided it.
+static bool noaaEventAt(double jd, double lat, double lon, bool rising, double& minutes,
+                        double& cosHour) {
+    double t = (jd - 2451545.0) / 36525.0;
+    double l0 = fmod(280.46646 + t * (36000.76983 + t * 0.0003032), 360.0);
+    double m = 357.52911 + t * (35999.05029 - 0.0001537 * t);
+    double e = 0.016708634 - t * (0.000042037 + 0.0000001267 * t);
+    double c = sin(m * DEG) * (1.914602 - t * (0.004817 + 0.000014 * t)) +
+               sin(2 * m * DEG) * (0.019993 - 0.000101 * t) + sin(3 * m * DEG) * 0.000289;
+    double omega = 125.04 - 1934.136 * t;
+    double apparent = l0 + c - 0.00569 - 0.00478 * sin(omega * DEG);
+    double meanObliquity =
+        23.0 + (26.0 + (21.448 - t * (46.8150 + t * (0.00059 - t * 0.001813))) / 60.0) / 60.0;
+    double obliquity = meanObliquity + 0.00256 * cos(omega * DEG);
+    double decl = asin(sin(obliquity * DEG) * sin(apparent * DEG));
+
+    double y = tan(obliquity * DEG / 2) * tan(obliquity * DEG / 2);
+    double eqTime = 4 / DEG *
+                    (y * sin(2 * l0 * DEG) - 2 * e * sin(m * DEG) +
+                     4 * e * y * sin(m * DEG) * cos(2 * l0 * DEG) - 0.5 * y * y * sin(4 * l0 * DEG) -
+                     1.25 * e * e * sin(2 * m * DEG));
+
+    cosHour = cos(90.833 * DEG) / (cos(lat * DEG) * cos(decl)) - tan(lat * DEG) * tan(decl);
+    if (cosHour < -1 || cosHour > 1) return false;
+    double hourAngle = acos(cosHour) / DEG;
+    minutes = 720 - 4 * lon - eqTime + (rising ? -4 : 4) * hourAngle;
+    return true;
+}
+
+static bool noaaEvent(double jdMidnight, double lat, double lon, bool rising, double& minutes,
+                      double& cosHour) {
+    // First at local noon, then at the time that gave
+    if (!noaaEventAt(jdMidnight + 0.5 - lon / 360.0, lat, lon, rising, minutes, cosHour)) {
+        return false;
+    }
+    return noaaEventAt(jdMidnight + minutes / 1440.0, lat, lon, rising, minutes, cosHour);
+}
+
+struct Grid {
+    double worstMinutes;
+    double worstPolarMinutes;  // Above 65 degrees, |cos(hour angle)| < 0.8
+    int days;
+    int polarDays;
+    int edgeDays;
+};
+
+static void checkDay(long long midnight, double lat, double lon, Grid& grid) {
+    // Local solar noon, so the day asked for is this one
+    time_t noon = (time_t)(midnight + 43200 - (long long)(lon * 240));
+    time_t sunrise, sunset;
+    bool crosses = solarSunTimes(noon, (float)lat, (float)lon, sunrise, sunset);
+
+    double jd = midnight / 86400.0 + 2440587.5;
+    double riseMin = 0, setMin = 0, riseCos = 0, setCos = 0;
+    bool riseOk = noaaEvent(jd, lat, lon, true, riseMin, riseCos);
+    bool setOk = noaaEvent(jd, lat, lon, false, setMin, setCos);
+    grid.days++;
+
+    if (!riseOk || !setOk || !crosses) {
+        // Near the start or end of polar day or night the two formulas may
+        // fall either side of the horizon; deep inside they must agree
+        double cosHour = riseOk ? setCos : riseCos;
+        if (fabs(fabs(cosHour) - 1) < 0.02 || (riseOk != setOk)) {
+            grid.edgeDays++;
+            return;
+        }
+        grid.polarDays++;
+        if (crosses || riseOk || setOk) {
+            if (hostTestFailures++ < 10) {
+                fprintf(stderr, "lat %.2f lon %.2f day %lld: crosses %d, NOAA %d (cos %.3f)\n", lat,
+                        lon, midnight, crosses, riseOk && setOk, cosHour);
+            }
+        }
+        return;
+    }
+
+    double riseError = fabs((sunrise - midnight) / 60.0 - riseMin);
+    double setError = fabs((sunset - midnight) / 60.0 - setMin);
+    double error = riseError > setError ? riseError : setError;
+    double limit;
+    if (fabs(lat) <= 65) {
+        limit = 4;
+        if (error > grid.worstMinutes) grid.worstMinutes = error;
+    } else if (fabs(riseCos) < 0.8) {
+        limit = 12;
+        if (error > grid.worstPolarMinutes) grid.worstPolarMinutes = error;
+    } else {
+        return;
+    }
+    if (error > limit && hostTestFailures++ < 10) {
+        fprintf(stderr, "lat %.2f lon %.2f day %lld: %.1f min off NOAA\n", lat, lon, midnight, error);
+    }
+}
+
+static void checkSunGrid() {
+    static const double lats[] = {-65, -60, -50, -40, -33.87, -20, -10, 0, 10, 23.44, 30,
+                                   40.17, 45, 51.48, 55, 60, 62, 65, 67, 69.65, 72, 78.22, -77.85};
+    static const double lons[] = {-179.5, -105.1, -74.0, 0, 18.96, 139.69, 151.21, 179.5};
+    Grid grid = {0, 0, 0, 0, 0};
+    for (double lat : lats) {
+        for (double lon : lons) {
+            for (long long day = FROM; day < TO; day += 3 * 86400) checkDay(day, lat, lon, grid);
+        }
+    }
+    CHECK(grid.polarDays > 0);
+    printf("solar: sun times within %.1f min of NOAA to 65 deg, %.1f min beyond; %d days, %d polar, "
+           "%d at its edge\n",
+           grid.worstMinutes, grid.worstPolarMinutes, grid.days, grid.polarDays, grid.edgeDays);
+}
+
+// Deep in polar night and under the midnight sun: no crossing, and the
+// times solar.h describes around solar noon
+static void checkPolar(const char* date, long long midnight, double lat, double lon, bool day) {
+    time_t noon = (time_t)(midnight + 43200 - (long long)(lon * 240));
+    time_t sunrise, sunset;
+    if (solarSunTimes(noon, (float)lat, (float)lon, sunrise, sunset)) {
+        fprintf(stderr, "%s at %.2f: sun crosses the horizon\n", date, lat);
+        hostTestFailures++;
+        return;
+    }
+    long long transit = (sunrise + sunset) / 2;
+    CHECK(llabs(transit - noon) < 20 * 60);
+    CHECK_EQ(sunset - sunrise, day ? 86400 : 0);
+    // By day under the midnight sun, by night in polar night, at noon too
+    CHECK((noon >= sunrise && noon <= sunset) == day);
+}
+
+static void checkPolarDays() {
+    checkPolar("2025-12-21 Tromso", 1766275200LL, 69.65, 18.96, false);
+    checkPolar("2025-06-21 Tromso", 1750464000LL, 69.65, 18.96, true);
+    checkPolar("2026-01-20 Longyearbyen", 1768867200LL, 78.22, 15.65, false);
+    checkPolar("2026-07-20 Longyearbyen", 1784505600LL, 78.22, 15.65, true);
+    checkPolar("2025-06-21 McMurdo", 1750464000LL, -77.85, 166.67, false);
+    checkPolar("2025-12-21 McMurdo", 1766275200LL, -77.85, 166.67, true);
+}
+
+// Phase difference in hours, wrapped to the nearest cycle
+static double phaseErrorHours(float phase, double expected) {
+    double diff = phase - expected;
+    diff -= floor(diff + 0.5);
+    return fabs(diff) * SYNODIC_DAYS * 24;
+}
+
+static void checkMoonPhases() {
+    // USNO, UTC
+    static const struct {
+        const char* what;
+        long long time;
+        double phase;
+    } phases[] = {
+        {"new 2017-08-21 18:30", 1503340200LL, 0.0},   // Total solar eclipse
+        {"new 2019-07-02 19:16", 1562094960LL, 0.0},   // Total solar eclipse
+        {"full 2021-05-26 11:14", 1622027640LL, 0.5},  // Total lunar eclipse
+        {"full 2022-11-08 11:02", 1667905320LL, 0.5},  // Total lunar eclipse
+        {"new 2023-04-20 04:12", 1681963920LL, 0.0},   // Hybrid solar eclipse
+        {"new 2024-04-08 18:21", 1712600460LL, 0.0},   // Total solar eclipse
+        {"full 2025-03-14 06:55", 1741935300LL, 0.5},  // Total lunar eclipse
+        {"full 2025-09-07 18:09", 1757268540LL, 0.5},  // Total lunar eclipse
+    };
+    double worst = 0;
+    for (size_t i = 0; i < sizeof(phases) / sizeof(phases[0]); i++) {
+        double hours = phaseErrorHours(solarMoonPhase((time_t)phases[i].time), phases[i].phase);
+        if (hours > 2) {
+            fprintf(stderr, "%s: %.1f h off\n", phases[i].what, hours);
+            hostTestFailures++;
+        }
+        worst = hours > worst ? hours : worst;
+    }
+
+    // In between it only grows, wrapping once a month, and at the mean
+    // rate within the moon's speeding up and slowing down
+    int wraps = 0;
+    float previous = solarMoonPhase((time_t)FROM);
+    for (long long t = FROM + 3600; t < TO; t += 3600) {
+        float phase = solarMoonPhase((time_t)t);
+        CHECK(phase >= 0 && phase < 1);
+        float step = phase - previous;
+        if (step < 0) {
+            step += 1;
+            wraps++;
+        }
+        double rate = step * SYNODIC_DAYS * 24;  // 1 for the mean hour
+        CHECK(rate > 0.75 && rate < 1.25);
+        previous = phase;
+    }
+    // 37 new moons from 2024-01-11 to 2026-12-09
+    CHECK_EQ(wraps, 37);
+    printf("solar: moon phase within %.2f h of USNO\n", worst);
+}
+
+int main() {
+    checkSunGrid();
+    checkPolarDays();
+    checkMoonPhases();
+    return hostTestExit();
+}
@@ -0,0 +1,130 @@
+// Text building without String against snprintf: textFormatInt must give
+// the same digits as "%d" for the extremes, every power of ten and its
+// neighbours, and a dense and a random sweep; a TextBuilder of any
+// capacity must hold exactly what snprintf writes into a buffer of that
+// size, and never write past it. Also times textFormatInt and snprintf.
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_test.h"
+#include "text_format.h"
+
+static uint32_t randomState = 1;
+
+static int32_t randomInt() {
+    randomState = randomState * 1664525 + 1013904223;
+    return (int32_t)randomState;
+}
+
+static int intMismatches;
+
+static void compareInt(int32_t value) {
+    char want[16];
+    snprintf(want, sizeof(want), "%d", (int)value);
+    char got[16];
+    memset(got, 'x', sizeof(got));
+    size_t n = textFormatInt(got, value);
+    bool same = n == strlen(want) && memcmp(got, want, n) == 0 && got[n] == 'x';
+    if (!same && intMismatches++ < 5) {
+        fprintf(stderr, "textFormatInt(%d): \"%.*s\"\n", (int)value, (int)n, got);
+    }
+}
+
+static void checkFormatInt() {
+    static const int32_t edges[] = {INT_MIN, INT_MIN + 1, INT_MAX, INT_MAX - 1, 0, 1, -1};
+    for (int32_t value : edges) compareInt(value);
+    for (int64_t power = 10; power <= INT_MAX; power *= 10) {
+        for (int64_t v = power - 1; v <= power + 1; v++) {
+            compareInt((int32_t)v);
+            compareInt((int32_t)-v);
+        }
+    }
+    for (int32_t v = -200000; v <= 200000; v++) compareInt(v);
+    for (int i = 0; i < 1000000; i++) compareInt(randomInt());
+    CHECK_EQ(intMismatches, 0);
+}
+
+// The builder's text and length, and the guard bytes behind its buffer,
+// against snprintf of the full text into the same room
+#define GUARD 8
+
+static void compareBuilt(const TextBuilder& text, const char* buffer, size_t size, const char* full) {
+    char want[64];
+    snprintf(want, size, "%s", full);
+    CHECK(strcmp(text.c_str(), want) == 0);
+    CHECK_EQ(text.length(), strlen(want));
+    CHECK_EQ(text.capacity(), size - 1);
+    for (size_t i = size; i < size + GUARD; i++) CHECK_EQ((uint8_t)buffer[i], 0xEE);
+}
+
+static void checkBuilder() {
+    static const int32_t values[] = {INT_MIN, INT_MAX, 0, 1, -1, 7, -42, 100, 1000000000};
+    for (size_t size = 1; size <= 40; size++) {
+        char buffer[40 + GUARD];
+        for (int32_t value : values) {
+            memset(buffer, 0xEE, sizeof(buffer));
+            TextBuilder text(buffer, size);
+            text << "T" << value << ' ' << "end";
+            char full[64];
+            snprintf(full, sizeof(full), "T%d end", (int)value);
+            compareBuilt(text, buffer, size, full);
+
+            memset(buffer, 0xEE, sizeof(buffer));
+            TextBuilder sign(buffer, size);
+            sign.addSigned(value) << '/';
+            sign.add2Digits(value % 100);
+            snprintf(full, sizeof(full), value ? "%+d/" : "%d/", (int)value);
+            char two[8];
+            snprintf(two, sizeof(two), "%02d", (int)(value % 100));
+            strcat(full, two);
+            compareBuilt(sign, buffer, size, full);
+        }
+
+        memset(buffer, 0xEE, sizeof(buffer));
+        TextBuilder words(buffer, size);
+        words.addCapitalized("light rain") << (const char*)nullptr << ", " << 12 << "%";
+        compareBuilt(words, buffer, size, "Light rain, 12%");
+
+        // Nothing more fits once full, and a cut keeps a prefix
+        words << "more" << 5 << 'x';
+        compareBuilt(words, buffer, size, "Light rain, 12%more5x");
+        words.truncate(5);
+        compareBuilt(words, buffer, size, "Light");
+        words.truncate(50);
+        compareBuilt(words, buffer, size, "Light");
+    }
+}
+
+static double elapsedNs(const struct timespec& start, const struct timespec& end, int count) {
+    return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / count;
+}
+
+// Temperatures and times as the screen shows them; the sink keeps the
+// loops from being optimised away
+static void benchmark() {
+    const int rounds = 1000000;
+    volatile size_t sink = 0;
+    char out[16];
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int n = 0; n < rounds; n++) sink += textFormatInt(out, n % 2000 - 400);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double pairsNs = elapsedNs(start, end, rounds);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int n = 0; n < rounds; n++) sink += snprintf(out, sizeof(out), "%d", n % 2000 - 400);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double snprintfNs = elapsedNs(start, end, rounds);
+
+    printf("text_format: int %.1f ns digit pairs, %.1f ns snprintf (host)\n", pairsNs, snprintfNs);
+}
+
+int main() {
+    checkFormatInt();
+    checkBuilder();
+    benchmark();
+    return hostTestExit();
+}
@@ -0,0 +1,229 @@
+// The POSIX TZ engine against glibc given the same TZ string: local time,
+// offset and DST flag for every half hour of 2020 to 2040 and every
+// minute around each transition, and tzMakeTime for every local half
+// hour, including the hour skipped and the hour repeated at each
+// transition (skipped times move forward by the gap, repeated ones take
+// their first occurrence).
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_test.h"
+#include "timezone.h"
+
+static const char* const ZONES[] = {
+    "CET-1CEST,M3.5.0,M10.5.0/3",              // EU: last Sundays, 01:00 UTC
+    "EST5EDT,M3.2.0,M11.1.0",                  // US: second Sunday, first Sunday
+    "AEST-10AEDT,M10.1.0,M4.1.0/3",            // Southern hemisphere: DST over new year
+    "NZST-12NZDT,M9.5.0,M4.1.0/3",             // Last-week rule in September
+    "<+1030>-10:30<+11>-11,M10.1.0,M4.1.0",    // Half-hour offset, half-hour DST
+    "<-03>3<-02>,M3.5.0/-2,M10.5.0/-1",        // Negative rule times (America/Nuuk)
+    "XST3XDT,J60/1,300/4",                     // Julian and zero-based day rules
+    "JST-9",                                   // No DST
+    "IST-5:30",                                // No DST, half-hour offset
+};
+
+#define FROM 1577836800LL  // 2020-01-01 UTC
+#define TO 2209017600LL    // 2040-01-01 UTC
+#define STEP 1800
+
+static int wallMismatches;
+
+// Local fields as seconds since the epoch as if they were UTC
+static long long wallSeconds(const struct tm& t) {
+    struct tm copy = t;
+    return (long long)timegm(&copy);
+}
+
+static void compareLocal(const char* zone, time_t utc) {
+    struct tm want, got;
+    localtime_r(&utc, &want);
+    memset(&got, 0, sizeof(got));
+    tzLocalTime(utc, got);
+    bool same = wallSeconds(got) == wallSeconds(want) && got.tm_isdst == want.tm_isdst &&
+                got.tm_wday == want.tm_wday && got.tm_yday == want.tm_yday &&
+                tzOffsetAt(utc) == want.tm_gmtoff;
+    if (!same) {
+        if (wallMismatches++ < 5) {
+            fprintf(stderr, "%s at %lld: %04d-%02d-%02d %02d:%02d dst %d, glibc %04d-%02d-%02d %02d:%02d dst %d\n",
+                    zone, (long long)utc, got.tm_year + 1900, got.tm_mon + 1, got.tm_mday, got.tm_hour,
+                    got.tm_min, got.tm_isdst, want.tm_year + 1900, want.tm_mon + 1, want.tm_mday,
+                    want.tm_hour, want.tm_min, want.tm_isdst);
+        }
+    }
+}
+
+static long glibcOffset(time_t utc) {
+    struct tm t;
+    localtime_r(&utc, &t);
+    return t.tm_gmtoff;
+}
+
+// The UTC instants glibc shows as this wall time (0, 1 or 2 of them)
+static int glibcInstants(long long wall, const TzRules& rules, time_t* out) {
+    int32_t offsets[2] = {rules.stdOffset, rules.hasDst ? rules.dstOffset : rules.stdOffset};
+    int n = 0;
+    for (int i = 0; i < (rules.hasDst ? 2 : 1); i++) {
+        time_t t = (time_t)(wall - offsets[i]);
+        if (glibcOffset(t) == offsets[i]) out[n++] = t;
+    }
+    if (n == 2 && out[1] < out[0]) {
+        time_t swap = out[0];
+        out[0] = out[1];
+        out[1] = swap;
+    }
+    return n;
+}
+
+struct Counts {
+    int skipped;
+    int repeated;
+    int makeMismatches;
+};
+
+static void compareMake(const char* zone, long long wall, const TzRules& rules, Counts& counts) {
+    time_t wallTime = (time_t)wall;
+    struct tm local;
+    gmtime_r(&wallTime, &local);
+    time_t got = tzMakeTime(local);
+
+    time_t instants[2];
+    int n = glibcInstants(wall, rules, instants);
+    time_t want;
+    if (n == 1) {
+        want = instants[0];
+        // glibc's own mktime must agree where there is no ambiguity
+        struct tm m = local;
+        m.tm_isdst = -1;
+        CHECK_EQ(mktime(&m), want);
+    } else if (n == 2) {
+        counts.repeated++;
+        want = instants[0];
+    } else {
+        // Skipped: read with the offset from before the gap, which lands
+        // the same distance past the transition
+        counts.skipped++;
+        int32_t before = rules.stdOffset < rules.dstOffset ? rules.stdOffset : rules.dstOffset;
+        want = (time_t)(wall - before);
+        struct tm after;
+        localtime_r(&want, &after);
+        CHECK_EQ(wallSeconds(after), wall + (rules.dstOffset > rules.stdOffset
+                                                 ? rules.dstOffset - rules.stdOffset
+                                                 : rules.stdOffset - rules.dstOffset));
+    }
+    if (got != want && counts.makeMismatches++ < 5) {
+        fprintf(stderr, "%s: tzMakeTime(%04d-%02d-%02d %02d:%02d) = %lld, expected %lld\n", zone,
+                local.tm_year + 1900, local.tm_mon + 1, local.tm_mday, local.tm_hour, local.tm_min,
+                (long long)got, (long long)want);
+    }
+}
+
+static void checkZone(const char* zone) {
+    TzRules rules;
+    CHECK(tzParse(zone, rules));
+    tzActivate(rules);
+    setenv("TZ", zone, 1);
+    tzset();
+
+    wallMismatches = 0;
+    Counts counts = {0, 0, 0};
+    int transitions = 0;
+    long previous = glibcOffset((time_t)FROM);
+    for (long long t = FROM; t < TO; t += STEP) {
+        compareLocal(zone, (time_t)t);
+        long offset = glibcOffset((time_t)t);
+        if (offset != previous) {
+            // Minute by minute over the two hours around the change, in
+            // UTC and in wall time
+            transitions++;
+            for (long long u = t - 2 * STEP; u < t + 2 * STEP; u += 60) {
+                compareLocal(zone, (time_t)u);
+                compareMake(zone, u + previous, rules, counts);
+                compareMake(zone, u + offset, rules, counts);
+            }
+            previous = offset;
+        }
+    }
+    for (long long wall = FROM; wall < TO; wall += STEP) {
+        compareMake(zone, wall, rules, counts);
+    }
+
+    if (wallMismatches) {
+        fprintf(stderr, "%s: %d local times differ from glibc\n", zone, wallMismatches);
+        hostTestFailures++;
+    }
+    if (counts.makeMismatches) {
+        fprintf(stderr, "%s: %d tzMakeTime results differ\n", zone, counts.makeMismatches);
+        hostTestFailures++;
+    }
+    if (rules.hasDst) {
+        // Two a year, and both kinds of wall time met at each
+        CHECK_EQ(transitions, 40);
+        CHECK(counts.skipped > 0 && counts.repeated > 0);
+    } else {
+        CHECK_EQ(transitions, 0);
+        CHECK_EQ(counts.skipped + counts.repeated, 0);
+    }
+}
+
+// The hour around each US transition of 2026, spelled out
+static void checkUsTransitions() {
+    TzRules rules;
+    CHECK(tzParse("MST7MDT,M3.2.0,M11.1.0", rules));
+    tzActivate(rules);
+
+    struct tm local;
+    memset(&local, 0, sizeof(local));
+    local.tm_year = 126;
+
+    // 8 March: 02:00 MST becomes 03:00 MDT; 02:30 does not exist
+    local.tm_mon = 2;
+    local.tm_mday = 8;
+    local.tm_hour = 2;
+    local.tm_min = 30;
+    time_t skipped = tzMakeTime(local);
+    CHECK_EQ(skipped, 1772962200);  // 09:30 UTC = 03:30 MDT
+    struct tm shown;
+    tzLocalTime(skipped, shown);
+    CHECK_EQ(shown.tm_hour, 3);
+    CHECK_EQ(shown.tm_min, 30);
+    CHECK_EQ(shown.tm_isdst, 1);
+    tzLocalTime(skipped - 3600, shown);  // 08:30 UTC
+    CHECK_EQ(shown.tm_hour, 1);
+    CHECK_EQ(shown.tm_isdst, 0);
+
+    // 1 November: 02:00 MDT becomes 01:00 MST; 01:30 happens twice
+    local.tm_mon = 10;
+    local.tm_mday = 1;
+    local.tm_hour = 1;
+    time_t repeated = tzMakeTime(local);
+    CHECK_EQ(repeated, 1793518200);  // 07:30 UTC, the MDT one
+    tzLocalTime(repeated, shown);
+    CHECK_EQ(shown.tm_hour, 1);
+    CHECK_EQ(shown.tm_isdst, 1);
+    tzLocalTime(repeated + 3600, shown);
+    CHECK_EQ(shown.tm_hour, 1);
+    CHECK_EQ(shown.tm_min, 30);
+    CHECK_EQ(shown.tm_isdst, 0);
+}
+
+static void checkRejectedStrings() {
+    static const char* const bad[] = {
+        "", "EST", "E5", "EST5EDT,M3.2.0", "EST5EDT,M13.2.0,M11.1.0", "EST5EDT,M3.6.0,M11.1.0",
+        "EST5EDT,M3.2.7,M11.1.0", "EST25", "<EST5", "EST5EDT,J0,J300", "EST5EDT,366,300",
+    };
+    TzRules rules;
+    for (const char* zone : bad) {
+        if (tzParse(zone, rules)) {
+            fprintf(stderr, "\"%s\" parsed\n", zone);
+            hostTestFailures++;
+        }
+    }
+}
+
+int main() {
+    for (const char* zone : ZONES) checkZone(zone);
+    checkUsTransitions();
+    checkRejectedStrings();
+    return hostTestExit();
+}
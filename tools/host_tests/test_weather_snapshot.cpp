@@ -0,0 +1,181 @@
+// Weather snapshots through the simulator's LittleFS: what is saved loads
+// back field for field, and a file that is not an intact snapshot of this
+// version (bad CRC, other version, cut short) is refused.
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <LittleFS.h>
+
+#include "host_test.h"
+#include "weather_snapshot.h"
+
+#define PATH "/snapshot.bin"
+#define LAT 40.167207f
+#define LON -105.101928f
+
+static WeatherData sample() {
+    WeatherData data = WeatherData();
+    data.valid = true;
+    data.current.timestamp = 1760745600;
+    data.current.sunrise = 1760706000;
+    data.current.sunset = 1760746800;
+    data.current.tempDeci = -37;
+    data.current.feelsLikeDeci = -91;
+    data.current.windSpeedDeci = 123;
+    data.current.windDeg = 275;
+    data.current.pressure = 1013;
+    data.current.visibility = 10000;
+    data.current.weatherId = 601;
+    data.current.humidity = 87;
+
+    data.hourlyCount = 12;
+    for (int i = 0; i < data.hourlyCount; i++) {
+        data.hourly[i].timestamp = data.current.timestamp + (i + 1) * 3600;
+        data.hourly[i].tempDeci = (int16_t)(-40 + i * 13);
+        data.hourly[i].weatherId = (uint16_t)(600 + i);
+        data.hourly[i].humidity = (uint8_t)(90 - i);
+    }
+    data.dailyCount = 5;
+    for (int i = 0; i < data.dailyCount; i++) {
+        data.daily[i].timestamp = data.current.timestamp + i * 86400;
+        data.daily[i].tempMinDeci = (int16_t)(-120 + i * 10);
+        data.daily[i].tempMaxDeci = (int16_t)(40 + i * 25);
+        data.daily[i].weatherId = (uint16_t)(800 + i);
+        data.daily[i].humidity = (uint8_t)(50 + i);
+        data.daily[i].pop = (uint8_t)(i * 20);
+    }
+
+    seriesClear(data.series);
+    data.series.start = data.current.timestamp;
+    for (int i = 0; i < FORECAST_SERIES_MAX; i++) {
+        seriesAppend(data.series, data.series.start + i * FORECAST_STEP_SECONDS, -5.5f + i * 0.7f,
+                     -9.25f + i * 0.6f, 40 + i, 3.4f + i * 0.1f, (i % 11) / 10.0f, 500 + i);
+    }
+    data.fetchedAt = data.current.timestamp;
+    return data;
+}
+
+static void writeBytes(const void* data, size_t length) {
+    File file = LittleFS.open(PATH, FILE_WRITE);
+    CHECK(file);
+    CHECK_EQ(file.write((const uint8_t*)data, length), length);
+    file.close();
+}
+
+static bool loads() {
+    static WeatherSnapshot buffer;
+    return snapshotReadFile(LittleFS, PATH, buffer) != nullptr;
+}
+
+static void checkRoundTrip() {
+    WeatherData data = sample();
+    WeatherSnapshot snap;
+    snapshotFromWeather(data, LAT, LON, true, 1760745700, snap);
+    CHECK(snapshotWriteFile(LittleFS, PATH, snap));
+
+    static WeatherSnapshot buffer;
+    const WeatherSnapshot* loaded = snapshotReadFile(LittleFS, PATH, buffer);
+    CHECK(loaded != nullptr);
+    if (!loaded) return;
+    CHECK(memcmp(loaded, &snap, sizeof(snap)) == 0);
+    CHECK(snapshotMatches(*loaded, LAT, LON, true));
+    CHECK(!snapshotMatches(*loaded, LAT, LON, false));
+    CHECK(!snapshotMatches(*loaded, LAT + 0.00001f, LON, true));
+
+    WeatherData back = WeatherData();
+    snapshotToWeather(*loaded, back);
+    CHECK(back.valid);
+    CHECK_EQ(back.fetchedAt, 1760745700);
+    CHECK(memcmp(&back.current, &data.current, offsetof(CurrentWeather, utcOffset)) == 0);
+    CHECK_EQ(back.current.tempDeci, data.current.tempDeci);
+    CHECK_EQ(back.current.feelsLikeDeci, data.current.feelsLikeDeci);
+    CHECK_EQ(back.current.windSpeedDeci, data.current.windSpeedDeci);
+    CHECK_EQ(back.current.windDeg, data.current.windDeg);
+    CHECK_EQ(back.current.pressure, data.current.pressure);
+    CHECK_EQ(back.current.visibility, data.current.visibility);
+    CHECK_EQ(back.current.weatherId, data.current.weatherId);
+    CHECK_EQ(back.current.humidity, data.current.humidity);
+
+    CHECK_EQ(back.hourlyCount, data.hourlyCount);
+    for (int i = 0; i < data.hourlyCount; i++) {
+        CHECK_EQ(back.hourly[i].timestamp, data.hourly[i].timestamp);
+        CHECK_EQ(back.hourly[i].tempDeci, data.hourly[i].tempDeci);
+        CHECK_EQ(back.hourly[i].weatherId, data.hourly[i].weatherId);
+        CHECK_EQ(back.hourly[i].humidity, data.hourly[i].humidity);
+    }
+    CHECK_EQ(back.dailyCount, data.dailyCount);
+    for (int i = 0; i < data.dailyCount; i++) {
+        CHECK_EQ(back.daily[i].timestamp, data.daily[i].timestamp);
+        CHECK_EQ(back.daily[i].tempMinDeci, data.daily[i].tempMinDeci);
+        CHECK_EQ(back.daily[i].tempMaxDeci, data.daily[i].tempMaxDeci);
+        CHECK_EQ(back.daily[i].weatherId, data.daily[i].weatherId);
+        CHECK_EQ(back.daily[i].humidity, data.daily[i].humidity);
+        CHECK_EQ(back.daily[i].pop, data.daily[i].pop);
+    }
+    CHECK(memcmp(&back.series, &data.series, sizeof(data.series)) == 0);
+
+    // No temp file left behind by the rename
+    CHECK(!LittleFS.exists(PATH ".tmp"));
+}
+
+static void checkRejected() {
+    WeatherSnapshot snap;
+    snapshotFromWeather(sample(), LAT, LON, false, 1760745700, snap);
+    writeBytes(&snap, sizeof(snap));
+    CHECK(loads());
+
+    // A flipped bit anywhere in the payload fails the CRC
+    for (size_t at = sizeof(SnapshotHeader); at < sizeof(snap); at += 97) {
+        WeatherSnapshot bad = snap;
+        ((uint8_t*)&bad)[at] ^= 0x10;
+        writeBytes(&bad, sizeof(bad));
+        if (loads()) {
+            fprintf(stderr, "corrupted byte %zu accepted\n", at);
+            hostTestFailures++;
+        }
+    }
+    WeatherSnapshot badCrc = snap;
+    badCrc.header.crc32 ^= 1;
+    writeBytes(&badCrc, sizeof(badCrc));
+    CHECK(!loads());
+
+    // Other versions, even with a good CRC
+    static const uint16_t versions[] = {0, SNAPSHOT_VERSION - 1, SNAPSHOT_VERSION + 1};
+    for (uint16_t version : versions) {
+        WeatherSnapshot other = snap;
+        other.header.version = version;
+        writeBytes(&other, sizeof(other));
+        CHECK(!loads());
+    }
+
+    // Cut short at every length, as after a reset mid-write
+    int accepted = 0;
+    for (size_t length = 0; length < sizeof(snap); length++) {
+        writeBytes(&snap, length);
+        if (loads()) accepted++;
+    }
+    CHECK_EQ(accepted, 0);
+
+    // Missing file
+    LittleFS.remove(PATH);
+    CHECK(!loads());
+}
+
+int main() {
+    // The CRC is zlib's: the standard check value
+    CHECK_EQ(snapshotCrc32("123456789", 9), 0xCBF43926u);
+
+    char root[] = "/tmp/test_weather_snapshot.XXXXXX";
+    if (!mkdtemp(root)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    LittleFS.setRoot(root);
+    checkRoundTrip();
+    checkRejected();
+
+    LittleFS.remove(PATH);
+    rmdir(root);
+    return hostTestExit();
+}
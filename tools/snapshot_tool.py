@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Read and write weather snapshots (src/weather_snapshot.h) on the host.
+
+Input files are either raw snapshots (/weather.snap from LittleFS or SD)
+or serial console logs containing the output of the 'snapshot' command.
+
+  snapshot_tool.py info FILE...         one summary line per snapshot
+  snapshot_tool.py json FILE            full contents as JSON
+  snapshot_tool.py csv FILE...          forecast series of every file as CSV
+  snapshot_tool.py pack JSON OUT        JSON (as printed by 'json') back to binary,
+                                        e.g. to replay edited data into the renderer
+"""
+import csv
+import json
+import struct
+import sys
+import time
+import zlib
+
+MAGIC = 0x504E5357
+VERSION = 3
+HOURLY_MAX = 12
+DAILY_MAX = 8
+SERIES_MAX = 40
+FLAG_IMPERIAL = 0x0001
+
+# Must match the structs in weather_snapshot.h (little-endian, no padding)
+HEADER = struct.Struct("<IHHIIIHBBiiHHHH")
+CURRENT = struct.Struct("<IIIhhHHHHHBx")
+HOURLY = struct.Struct("<IhHB3x")
+DAILY = struct.Struct("<IhhHBB")
+SERIES = struct.Struct("<IHBx%dh%dB%dH%dh%dH%dB" % ((SERIES_MAX,) * 6))
+TOTAL = HEADER.size + CURRENT.size + HOURLY.size * HOURLY_MAX + DAILY.size * DAILY_MAX + SERIES.size
+
+CURRENT_FIELDS = ["timestamp", "sunrise", "sunset", "temp", "feels_like", "wind_speed",
+                  "wind_deg", "pressure", "visibility", "weather_id", "humidity"]
+
+
+def load_bytes(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) >= 4 and struct.unpack_from("<I", data)[0] == MAGIC:
+        return data
+    # Console log: concatenate the hex of every "SNAPSHOT <hex>" line
+    hex_parts = []
+    for line in data.decode("utf-8", "replace").splitlines():
+        line = line.strip()
+        if line.startswith("SNAPSHOT ") and line != "SNAPSHOT END":
+            hex_parts.append(line[len("SNAPSHOT "):])
+    return bytes.fromhex("".join(hex_parts))
+
+
+def decode(data):
+    if len(data) < TOTAL:
+        raise ValueError("too short: %d bytes, need %d" % (len(data), TOTAL))
+    (magic, version, header_size, total_size, crc, created, flags, hourly_count,
+     daily_count, lat_e6, lon_e6, current_stride, hourly_stride, daily_stride,
+     series_stride) = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        raise ValueError("bad magic 0x%08x" % magic)
+    if version != VERSION:
+        raise ValueError("unsupported version %d" % version)
+    if (header_size, total_size, current_stride, hourly_stride, daily_stride, series_stride) != \
+            (HEADER.size, TOTAL, CURRENT.size, HOURLY.size, DAILY.size, SERIES.size):
+        raise ValueError("layout does not match this tool")
+    if zlib.crc32(data[HEADER.size:TOTAL]) != crc:
+        raise ValueError("CRC mismatch")
+
+    offset = HEADER.size
+    c = CURRENT.unpack_from(data, offset)
+    current = dict(zip(CURRENT_FIELDS, c))
+    for key in ("temp", "feels_like", "wind_speed"):
+        current[key] /= 10.0
+    offset += CURRENT.size
+
+    hourly = []
+    for i in range(HOURLY_MAX):
+        ts, temp, wid, hum = HOURLY.unpack_from(data, offset + i * HOURLY.size)
+        if i < hourly_count:
+            hourly.append({"timestamp": ts, "temp": temp / 10.0, "weather_id": wid,
+                           "humidity": hum})
+    offset += HOURLY.size * HOURLY_MAX
+
+    daily = []
+    for i in range(DAILY_MAX):
+        ts, tmin, tmax, wid, hum, pop = DAILY.unpack_from(data, offset + i * DAILY.size)
+        if i < daily_count:
+            daily.append({"timestamp": ts, "temp_min": tmin / 10.0, "temp_max": tmax / 10.0,
+                          "weather_id": wid, "humidity": hum, "pop": pop})
+    offset += DAILY.size * DAILY_MAX
+
+    s = SERIES.unpack_from(data, offset)
+    start, step, count = s[0], s[1], s[2]
+    fields = [s[3 + k * SERIES_MAX:3 + k * SERIES_MAX + count] for k in range(6)]
+    temps, pops, ids, feels, winds, hums = fields
+    series = {"start": start, "step_seconds": step,
+              "temp": [t / 10.0 for t in temps],
+              "pop": list(pops), "weather_id": list(ids),
+              "feels_like": [t / 10.0 for t in feels],
+              "wind_speed": [w / 10.0 for w in winds],
+              "humidity": list(hums)}
+
+    return {"created_at": created, "imperial": bool(flags & FLAG_IMPERIAL),
+            "lat": lat_e6 / 1e6, "lon": lon_e6 / 1e6, "current": current,
+            "hourly": hourly, "daily": daily, "series": series}
+
+
+def deci(value):
+    return int(round(value * 10))
+
+
+def encode(snap):
+    cur = snap["current"]
+    body = CURRENT.pack(cur["timestamp"], cur["sunrise"], cur["sunset"], deci(cur["temp"]),
+                        deci(cur["feels_like"]), deci(cur["wind_speed"]), cur["wind_deg"],
+                        cur["pressure"], cur["visibility"], cur["weather_id"], cur["humidity"])
+    for i in range(HOURLY_MAX):
+        if i < len(snap["hourly"]):
+            h = snap["hourly"][i]
+            body += HOURLY.pack(h["timestamp"], deci(h["temp"]), h["weather_id"], h["humidity"])
+        else:
+            body += bytes(HOURLY.size)
+    for i in range(DAILY_MAX):
+        if i < len(snap["daily"]):
+            d = snap["daily"][i]
+            body += DAILY.pack(d["timestamp"], deci(d["temp_min"]), deci(d["temp_max"]),
+                               d["weather_id"], d["humidity"], d["pop"])
+        else:
+            body += bytes(DAILY.size)
+    s = snap["series"]
+    count = len(s["temp"])
+    pad = SERIES_MAX - count
+    body += SERIES.pack(s["start"], s["step_seconds"], count,
+                        *([deci(t) for t in s["temp"]] + [0] * pad +
+                          list(s["pop"]) + [0] * pad + list(s["weather_id"]) + [0] * pad +
+                          [deci(t) for t in s["feels_like"]] + [0] * pad +
+                          [deci(w) for w in s["wind_speed"]] + [0] * pad +
+                          list(s["humidity"]) + [0] * pad))
+
+    header = HEADER.pack(MAGIC, VERSION, HEADER.size, TOTAL, zlib.crc32(body), snap["created_at"],
+                         FLAG_IMPERIAL if snap["imperial"] else 0, len(snap["hourly"]),
+                         len(snap["daily"]), int(round(snap["lat"] * 1e6)),
+                         int(round(snap["lon"] * 1e6)), CURRENT.size, HOURLY.size, DAILY.size, SERIES.size)
+    return header + body
+
+
+def utc(ts):
+    return time.strftime("%Y-%m-%d %H:%M", time.gmtime(ts))
+
+
+def cmd_info(paths):
+    for path in paths:
+        try:
+            snap = decode(load_bytes(path))
+        except ValueError as e:
+            print("%s: invalid (%s)" % (path, e))
+            continue
+        cur = snap["current"]
+        unit = "F" if snap["imperial"] else "C"
+        print("%s: %s UTC  %.4f,%.4f  %.1f%s id %d  %d hourly, %d daily, %d series slots" % (
+            path, utc(snap["created_at"]), snap["lat"], snap["lon"], cur["temp"], unit,
+            cur["weather_id"], len(snap["hourly"]), len(snap["daily"]), len(snap["series"]["temp"])))
+
+
+def cmd_json(path):
+    json.dump(decode(load_bytes(path)), sys.stdout, indent=2)
+    print()
+
+
+def cmd_csv(paths):
+    out = csv.writer(sys.stdout)
+    out.writerow(["file", "created_at", "slot_time", "temp", "feels_like", "humidity",
+                  "wind_speed", "pop", "weather_id"])
+    for path in paths:
+        snap = decode(load_bytes(path))
+        s = snap["series"]
+        for i, temp in enumerate(s["temp"]):
+            out.writerow([path, snap["created_at"], s["start"] + i * s["step_seconds"],
+                          temp, s["feels_like"][i], s["humidity"][i], s["wind_speed"][i],
+                          s["pop"][i], s["weather_id"][i]])
+
+
+def cmd_pack(src, dst):
+    with open(src) as f:
+        data = encode(json.load(f))
+    with open(dst, "wb") as f:
+        f.write(data)
+
+
+def main(argv):
+    if len(argv) < 3:
+        print(__doc__.strip())
+        return 2
+    cmd, args = argv[1], argv[2:]
+    if cmd == "info":
+        cmd_info(args)
+    elif cmd == "json":
+        cmd_json(args[0])
+    elif cmd == "csv":
+        cmd_csv(args)
+    elif cmd == "pack" and len(args) == 2:
+        cmd_pack(args[0], args[1])
+    else:
+        print(__doc__.strip())
+        return 2
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
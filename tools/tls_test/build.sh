@@ -0,0 +1,25 @@
+#!/bin/sh
+# Build the TLS test client: the firmware's TlsClient and session cache
+# linked against the host's mbedtls (2.28, the line Arduino-ESP32 2.x
+# ships; Debian/Ubuntu: libmbedtls-dev), with the wake simulator's SDK
+# stand-ins for the rest. Real mbedtls headers take precedence over the
+# simulator's placeholder.
+#
+#   tools/tls_test/build.sh [extra compiler flags, e.g. -fsanitize=address]
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+src="$here/../../src"
+CXX=${CXX:-g++}
+
+if ! echo '#include <mbedtls/ssl.h>' | $CXX -x c++ -E - >/dev/null 2>&1; then
+    echo "mbedtls headers not found (install libmbedtls-dev)" >&2
+    exit 1
+fi
+
+$CXX -std=gnu++11 -O1 -g -Wall -Wno-unused-parameter -Wno-sign-compare \
+    -I"$here" -I"$src" -idirafter "$here/../wake_sim/host" \
+    -o "$here/tls_test" "$@" \
+    "$here"/tls_test.cpp "$here"/tls_platform.cpp \
+    "$src"/tls_client.cpp "$src"/tls_session_cache.cpp "$src"/dns_cache.cpp \
+    -lmbedtls -lmbedx509 -lmbedcrypto
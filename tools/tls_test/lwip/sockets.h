@@ -0,0 +1,20 @@
+// Host stand-in for lwIP's socket API: the lwip_ calls the TLS client
+// makes are the POSIX ones under another name.
+#ifndef TLS_TEST_LWIP_SOCKETS_H
+#define TLS_TEST_LWIP_SOCKETS_H
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define lwip_socket ::socket
+#define lwip_fcntl ::fcntl
+#define lwip_connect ::connect
+#define lwip_select ::select
+#define lwip_getsockopt ::getsockopt
+
+#endif // TLS_TEST_LWIP_SOCKETS_H
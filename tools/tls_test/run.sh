@@ -0,0 +1,61 @@
+#!/bin/bash
+# Session resumption against a local openssl s_server (TLS 1.2, session
+# tickets), one tls_test run per wake with the cache carried in a file:
+#
+#   1. no cache: full handshake, session saved
+#   2. and 3. the saved session resumes, the server's fresh ticket is saved
+#   4. the session backdated past TLS_SESSION_MAX_AGE_SECONDS: not offered
+#   5. server restarted (new ticket key): offered, refused, full handshake
+#   6. the session from 5 resumes
+#
+#   tools/tls_test/run.sh [port]
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+port=${1:-44330}
+OPENSSL=${OPENSSL:-openssl}
+work=$(mktemp -d)
+server=""
+
+cleanup() {
+    [ -n "$server" ] && kill "$server" 2>/dev/null
+    rm -rf "$work"
+}
+trap cleanup EXIT INT TERM
+
+"$here/build.sh"
+
+"$OPENSSL" req -x509 -newkey ec -pkeyopt ec_paramgen_curve:prime256v1 -nodes \
+    -keyout "$work/key.pem" -out "$work/cert.pem" -days 1 -subj /CN=localhost 2>/dev/null
+
+startServer() {
+    [ -n "$server" ] && kill "$server" 2>/dev/null && wait "$server" 2>/dev/null || true
+    "$OPENSSL" s_server -accept "$port" -cert "$work/cert.pem" -key "$work/key.pem" \
+        -tls1_2 -www -quiet >"$work/server.log" 2>&1 &
+    server=$!
+    # Listening once a plain connect gets through
+    for _ in $(seq 50); do
+        if (exec 3<>"/dev/tcp/127.0.0.1/$port") 2>/dev/null; then return 0; fi
+        sleep 0.1
+    done
+    echo "s_server did not start:" >&2
+    cat "$work/server.log" >&2
+    exit 1
+}
+
+failed=0
+wake() {
+    echo "-- expect $1"
+    if ! "$here/tls_test" 127.0.0.1 "$port" "$work/session" "$@"; then failed=1; fi
+}
+
+startServer
+wake full
+wake resumed
+wake resumed
+wake full 90000
+startServer
+wake rejected
+wake resumed
+
+exit $failed
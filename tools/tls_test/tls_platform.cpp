@@ -0,0 +1,70 @@
+// The Arduino calls the TLS client makes, on the host and in real time
+// (the wake simulator's virtual clock cannot drive a real handshake).
+// There is no wake budget here: every timeout is the client's own.
+#include <Arduino.h>
+#include <WiFi.h>
+#include <netdb.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include "wake_budget.h"
+#include "wake_metrics.h"
+
+HWCDC Serial;
+WiFiClass WiFi;
+
+size_t HWCDC::write(const uint8_t* buf, size_t size) {
+    return fwrite(buf, 1, size, stdout);
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (n < 0) return 0;
+    return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? n : sizeof(buf) - 1);
+}
+
+static uint64_t monotonicUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static const uint64_t startUs = monotonicUs();
+
+unsigned long millis() {
+    return (unsigned long)((monotonicUs() - startUs) / 1000);
+}
+
+void delay(unsigned long ms) {
+    usleep(ms * 1000);
+}
+
+int WiFiClass::hostByName(const char* host, IPAddress& result) {
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    struct addrinfo* found = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &found) != 0 || !found) return 0;
+    result = IPAddress((uint32_t)((struct sockaddr_in*)found->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(found);
+    return 1;
+}
+
+// Plain TCP is not used: TlsClient overrides every one of these
+int WiFiClient::connect(IPAddress, uint16_t) { return 0; }
+int WiFiClient::connect(IPAddress, uint16_t, int32_t) { return 0; }
+int WiFiClient::connect(const char*, uint16_t) { return 0; }
+int WiFiClient::connect(const char*, uint16_t, int32_t) { return 0; }
+int WiFiClient::read(uint8_t*, size_t) { return -1; }
+
+uint32_t budgetClampMs(uint32_t ms) {
+    return ms;
+}
+
+WakeMetrics& wakeMetrics() {
+    static WakeMetrics metrics;
+    return metrics;
+}
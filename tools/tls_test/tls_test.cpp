@@ -0,0 +1,112 @@
+// One wake's worth of TLS against a real server: load the session cache
+// (RTC memory on the device, a file here), connect with TlsClient, check
+// which handshake the server took, make a request and save the cache for
+// the next run. run.sh drives it through the cases against openssl
+// s_server.
+//
+//   tls_test HOST PORT CACHE_FILE full|resumed|rejected [AGE_SECONDS]
+//
+// full: nothing (usable) to offer, full handshake. resumed: the cached
+// session was offered and taken. rejected: offered, but the server did a
+// full handshake. AGE_SECONDS backdates the cached session first.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "tls_client.h"
+
+// SNI sent with every connection, and the host the cache is keyed on
+#define SERVER_NAME "localhost"
+
+static TlsSessionCache cache;
+
+static bool loadCache(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    bool ok = fread(&cache, sizeof(cache), 1, f) == 1;
+    fclose(f);
+    return ok;
+}
+
+static bool saveCache(const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(&cache, sizeof(cache), 1, f) == 1;
+    return fclose(f) == 0 && ok;
+}
+
+// s_server -www answers any GET with a status page
+static bool request(TlsClient& client) {
+    static const char get[] = "GET / HTTP/1.0\r\n\r\n";
+    if (client.write((const uint8_t*)get, sizeof(get) - 1) != sizeof(get) - 1) return false;
+
+    char status[16];
+    size_t n = 0;
+    unsigned long start = millis();
+    while (n < sizeof(status) - 1 && millis() - start < 5000) {
+        int c = client.read();
+        if (c >= 0) {
+            status[n++] = (char)c;
+        } else if (!client.connected()) {
+            break;
+        } else {
+            delay(1);
+        }
+    }
+    status[n] = '\0';
+    return strncmp(status, "HTTP/1.0 200", 12) == 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 5) {
+        fprintf(stderr, "usage: %s HOST PORT CACHE_FILE full|resumed|rejected [AGE_SECONDS]\n", argv[0]);
+        return 2;
+    }
+    const char* expected = argv[4];
+
+    if (!loadCache(argv[3])) {
+        tlsSessionInvalidate(cache);
+    }
+    if (argc > 5) {
+        cache.savedAt -= atol(argv[5]);
+    }
+
+    IPAddress ip;
+    if (!WiFi.hostByName(argv[1], ip)) {
+        fprintf(stderr, "cannot resolve %s\n", argv[1]);
+        return 1;
+    }
+
+    // The client offers whatever is cached for the host and young enough;
+    // run.sh only asks for "rejected" with such a session in the file
+    bool cached = cache.length > 0;
+
+    TlsClient client;
+    client.setSessionCache(&cache, TLS_SESSION_MAX_AGE_SECONDS);
+    if (!client.connect(ip, (uint16_t)atoi(argv[2]), SERVER_NAME)) {
+        fprintf(stderr, "connect failed\n");
+        return 1;
+    }
+
+    const char* handshake = client.resumed() ? "resumed" : "full";
+    bool ok;
+    if (strcmp(expected, "rejected") == 0) {
+        ok = cached && !client.resumed();
+    } else {
+        ok = strcmp(handshake, expected) == 0;
+    }
+    if (!request(client)) {
+        fprintf(stderr, "request failed\n");
+        ok = false;
+    }
+    client.stop();
+
+    if (!saveCache(argv[3])) {
+        fprintf(stderr, "cannot write %s\n", argv[3]);
+        ok = false;
+    }
+    printf("%s: %s handshake, %lu ms, %u byte session cached\n", ok ? "ok" : "FAIL", handshake,
+           (unsigned long)client.handshakeMillis(), (unsigned)cache.length);
+    return ok ? 0 : 1;
+}
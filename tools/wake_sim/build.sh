@@ -0,0 +1,25 @@
+#!/bin/sh
+# Build the wake simulator: every firmware source except the TLS client
+# (replaced by sim_tls.cpp), compiled against the SDK stand-ins in host/.
+#
+#   tools/wake_sim/build.sh [extra compiler flags, e.g. -fsanitize=address -o FILE]
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+src="$here/../../src"
+CXX=${CXX:-g++}
+
+firmware=""
+for f in "$src"/*.cpp; do
+    case $(basename "$f") in
+        tls_client.cpp|tls_session_cache.cpp) ;;
+        *) firmware="$firmware $f" ;;
+    esac
+done
+
+# shellcheck disable=SC2086
+$CXX -std=gnu++11 -O1 -g -Wall -Wno-unused-parameter -Wno-sign-compare \
+    -I"$here/host" -I"$src" \
+    -o "$here/wake_sim" "$@" \
+    "$here"/sim_model.cpp "$here"/sim_memory.cpp "$here"/sim_platform.cpp "$here"/sim_server.cpp \
+    "$here"/sim_tls.cpp "$here"/wake_sim.cpp $firmware
@@ -0,0 +1,302 @@
+// Host stand-in for the parts of the Arduino-ESP32 core the firmware uses.
+// Time is virtual: delay() advances the simulated clock (sim_model.h)
+// instead of sleeping, and Serial goes to the simulator's log.
+#ifndef WAKE_SIM_ARDUINO_H
+#define WAKE_SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <time.h>
+#include <string>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+#define PI 3.1415926535897932384626433832795
+#define DEC 10
+#define HEX 16
+
+// RTC slow memory is the one thing that survives deep sleep. The simulator
+// collects it from this section after every wake and restores it before
+// the next one; everything else starts from its initial value.
+#define RTC_DATA_ATTR __attribute__((section("rtc_sim_data")))
+#define RTC_NOINIT_ATTR RTC_DATA_ATTR
+#define IRAM_ATTR
+#define EXT_RAM_ATTR
+
+class String {
+public:
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const std::string& c) : s(c) {}
+    explicit String(char c) : s(1, c) {}
+    explicit String(int v) : s(std::to_string(v)) {}
+    explicit String(unsigned v) : s(std::to_string(v)) {}
+    explicit String(long v) : s(std::to_string(v)) {}
+    explicit String(unsigned long v) : s(std::to_string(v)) {}
+    explicit String(float v, unsigned decimals = 2) { format(v, decimals); }
+    explicit String(double v, unsigned decimals = 2) { format(v, decimals); }
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned length() const { return s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    bool reserve(unsigned size) { s.reserve(size); return true; }
+
+    char charAt(unsigned i) const { return i < s.size() ? s[i] : 0; }
+    char operator[](unsigned i) const { return charAt(i); }
+    char& operator[](unsigned i) { return s[i]; }
+
+    String substring(unsigned from) const { return from < s.size() ? String(s.substr(from)) : String(); }
+    String substring(unsigned from, unsigned to) const {
+        if (from > to) std::swap(from, to);
+        return from < s.size() ? String(s.substr(from, to - from)) : String();
+    }
+    int indexOf(char c, unsigned from = 0) const { return pos(s.find(c, from)); }
+    int indexOf(const char* t, unsigned from = 0) const { return pos(s.find(t, from)); }
+    int lastIndexOf(char c) const { return pos(s.rfind(c)); }
+    bool startsWith(const String& p) const { return s.compare(0, p.s.size(), p.s) == 0; }
+    bool endsWith(const String& p) const {
+        return s.size() >= p.s.size() && s.compare(s.size() - p.s.size(), p.s.size(), p.s) == 0;
+    }
+    void trim() {
+        size_t a = s.find_first_not_of(" \t\r\n");
+        size_t b = s.find_last_not_of(" \t\r\n");
+        s = a == std::string::npos ? std::string() : s.substr(a, b - a + 1);
+    }
+    void toUpperCase() { for (size_t i = 0; i < s.size(); i++) s[i] = toupper((unsigned char)s[i]); }
+    void toLowerCase() { for (size_t i = 0; i < s.size(); i++) s[i] = tolower((unsigned char)s[i]); }
+    void replace(const String& from, const String& to) {
+        if (from.s.empty()) return;
+        for (size_t p = s.find(from.s); p != std::string::npos; p = s.find(from.s, p + to.s.size())) {
+            s.replace(p, from.s.size(), to.s);
+        }
+    }
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return (float)atof(s.c_str()); }
+
+    String& operator+=(const String& o) { s += o.s; return *this; }
+    String& operator+=(const char* o) { s += o ? o : ""; return *this; }
+    String& operator+=(char o) { s += o; return *this; }
+    String& operator+=(int o) { s += std::to_string(o); return *this; }
+    String& operator+=(unsigned o) { s += std::to_string(o); return *this; }
+    String& operator+=(long o) { s += std::to_string(o); return *this; }
+    String& operator+=(unsigned long o) { s += std::to_string(o); return *this; }
+    String& operator+=(float o) { return *this += String(o); }
+    String& operator+=(double o) { return *this += String(o); }
+    bool concat(const String& o) { s += o.s; return true; }
+
+    bool operator==(const String& o) const { return s == o.s; }
+    bool operator==(const char* o) const { return s == (o ? o : ""); }
+    bool operator!=(const String& o) const { return s != o.s; }
+    bool operator!=(const char* o) const { return !(*this == o); }
+    bool operator<(const String& o) const { return s < o.s; }
+    bool equals(const String& o) const { return s == o.s; }
+
+    const std::string& str() const { return s; }
+
+private:
+    std::string s;
+
+    void format(double v, unsigned decimals) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+        s = buf;
+    }
+    static int pos(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+};
+
+inline String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+inline String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, char b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, int b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, unsigned b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, long b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, unsigned long b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, float b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, double b) { String r(a); r += b; return r; }
+
+class IPAddress {
+public:
+    IPAddress() : value(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : value(a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24) {}
+    IPAddress(uint32_t v) : value(v) {}
+    operator uint32_t() const { return value; }
+    uint8_t operator[](int i) const { return (value >> (8 * i)) & 0xFF; }
+    String toString() const {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+        return String(buf);
+    }
+
+private:
+    uint32_t value;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buf, size_t size) {
+        size_t n = 0;
+        while (n < size && write(buf[n])) n++;
+        return n;
+    }
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+    virtual void flush() {}
+
+    size_t print(const char* v) { return write(v); }
+    size_t print(const String& v) { return write(v.c_str()); }
+    size_t print(char v) { return write((uint8_t)v); }
+    size_t print(int v, int base = DEC) { return printNumber(v, base); }
+    size_t print(unsigned v, int base = DEC) { return printNumber(v, base); }
+    size_t print(long v, int base = DEC) { return printNumber(v, base); }
+    size_t print(unsigned long v, int base = DEC) { return printNumber(v, base); }
+    size_t print(double v, int decimals = 2) { return print(String(v, decimals)); }
+    size_t print(const IPAddress& v) { return print(v.toString()); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+    template <typename T> size_t println(const T& v, int format) { size_t n = print(v, format); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+    size_t printNumber(long long v, int base) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), base == HEX ? "%llx" : "%lld", v);
+        return write(buf);
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long ms) { timeoutMs = ms; }
+    size_t readBytes(char* buf, size_t length) { return readBytes((uint8_t*)buf, length); }
+    size_t readBytes(uint8_t* buf, size_t length) {
+        size_t n = 0;
+        while (n < length) {
+            int c = read();
+            if (c < 0) break;
+            buf[n++] = (uint8_t)c;
+        }
+        return n;
+    }
+    String readStringUntil(char terminator) {
+        String r;
+        int c;
+        while ((c = read()) >= 0 && c != terminator) r += (char)c;
+        return r;
+    }
+
+protected:
+    unsigned long timeoutMs = 1000;
+};
+
+// USB CDC console: output is the simulator log, there is never any input
+class HWCDC : public Stream {
+public:
+    void begin(unsigned long) {}
+    operator bool() const { return true; }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t size) override;
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+};
+
+extern HWCDC Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+uint32_t esp_random();
+int64_t esp_timer_get_time();
+
+// CPU clock; at 80 MHz and below the simulator charges cpu_slow_ma
+bool setCpuFrequencyMhz(uint32_t mhz);
+uint32_t getCpuFrequencyMhz();
+
+// Heap, stack and reset reason (sim_memory.cpp)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+void* ps_malloc(size_t size);
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+
+// While one is alive, host allocations and frees leave the internal heap
+// figures alone: for stand-in data the device keeps elsewhere
+class SimHeapUncounted {
+public:
+    explicit SimHeapUncounted(bool active = true);
+    ~SimHeapUncounted();
+    SimHeapUncounted(const SimHeapUncounted&) = delete;
+    SimHeapUncounted& operator=(const SimHeapUncounted&) = delete;
+
+private:
+    bool active;
+};
+
+// FreeRTOS basics, with the device's 1 ms tick
+typedef void* TaskHandle_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFu)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define pdFALSE 0
+#define pdTRUE 1
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+typedef enum {
+    ESP_RST_UNKNOWN,
+    ESP_RST_POWERON,
+    ESP_RST_EXT,
+    ESP_RST_SW,
+    ESP_RST_PANIC,
+    ESP_RST_INT_WDT,
+    ESP_RST_TASK_WDT,
+    ESP_RST_WDT,
+    ESP_RST_DEEPSLEEP,
+    ESP_RST_BROWNOUT,
+    ESP_RST_SDIO,
+} esp_reset_reason_t;
+
+esp_reset_reason_t esp_reset_reason();
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+    ESP_SLEEP_WAKEUP_TOUCHPAD,
+    ESP_SLEEP_WAKEUP_ULP,
+    ESP_SLEEP_WAKEUP_GPIO,
+} esp_sleep_wakeup_cause_t;
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause();
+int esp_sleep_enable_timer_wakeup(uint64_t timeUs);
+void esp_deep_sleep_start() __attribute__((noreturn));
+
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+void configTzTime(const char* tz, const char* server1,
+                  const char* server2 = nullptr, const char* server3 = nullptr);
+
+#endif // WAKE_SIM_ARDUINO_H
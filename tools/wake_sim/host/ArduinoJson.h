@@ -0,0 +1,448 @@
+// Host stand-in for the subset of the ArduinoJson 7 API the firmware uses:
+// a plain DOM with a recursive-descent parser. Documents really are parsed,
+// so a response the firmware cannot handle fails here too.
+#ifndef WAKE_SIM_ARDUINOJSON_H
+#define WAKE_SIM_ARDUINOJSON_H
+
+#include "Arduino.h"
+#include <memory>
+#include <set>
+#include <type_traits>
+#include <vector>
+
+namespace jsonsim {
+
+struct Node {
+    enum Type { Null, Bool, Number, Text, Array, Object } type = Null;
+    bool boolean = false;
+    double number = 0;
+    std::string text;
+    std::vector<Node*> items;       // Array elements or object values
+    std::vector<std::string> keys;  // Object keys, parallel to items
+};
+
+template <typename T, typename Enable = void>
+struct Convert {
+    static T from(const Node* n) { return n ? (T)n->number : T(); }
+};
+template <>
+struct Convert<bool> {
+    static bool from(const Node* n) {
+        if (!n) return false;
+        return n->type == Node::Bool ? n->boolean : n->number != 0;
+    }
+};
+template <>
+struct Convert<const char*> {
+    static const char* from(const Node* n) { return n && n->type == Node::Text ? n->text.c_str() : nullptr; }
+};
+template <>
+struct Convert<String> {
+    static String from(const Node* n) {
+        if (!n || n->type == Node::Null) return String("null");
+        if (n->type == Node::Text) return String(n->text);
+        if (n->type == Node::Bool) return String(n->boolean ? "true" : "false");
+        if (n->type == Node::Number) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%.9g", n->number);
+            return String(buf);
+        }
+        return String();
+    }
+};
+
+class Parser {
+public:
+    Parser(const char* p, const char* end, std::vector<std::unique_ptr<Node>>& pool)
+        : p(p), end(end), pool(pool) {}
+
+    // 0 ok, 1 empty, 2 incomplete, 3 invalid, 4 too deep
+    int parse(Node*& root) {
+        skipSpace();
+        if (p == end) return 1;
+        int err = value(root, 0);
+        if (err) return err;
+        skipSpace();
+        return 0;
+    }
+
+private:
+    const char* p;
+    const char* end;
+    std::vector<std::unique_ptr<Node>>& pool;
+
+    Node* make(Node::Type t) {
+        pool.emplace_back(new Node());
+        pool.back()->type = t;
+        return pool.back().get();
+    }
+    void skipSpace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+    }
+    bool literal(const char* word) {
+        size_t n = strlen(word);
+        if ((size_t)(end - p) < n || strncmp(p, word, n) != 0) return false;
+        p += n;
+        return true;
+    }
+
+    int value(Node*& out, int depth) {
+        if (depth > 10) return 4;
+        skipSpace();
+        if (p == end) return 2;
+        char c = *p;
+        if (c == '{') return object(out, depth);
+        if (c == '[') return array(out, depth);
+        if (c == '"') {
+            out = make(Node::Text);
+            return string(out->text);
+        }
+        if (c == 't' || c == 'f' || c == 'n') {
+            if (literal("true")) { out = make(Node::Bool); out->boolean = true; return 0; }
+            if (literal("false")) { out = make(Node::Bool); return 0; }
+            if (literal("null")) { out = make(Node::Null); return 0; }
+            return end - p < 5 ? 2 : 3;
+        }
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            std::string digits;
+            while (p < end && strchr("+-0123456789.eE", *p)) digits += *p++;
+            char* stop;
+            double v = strtod(digits.c_str(), &stop);
+            if (*stop) return 3;
+            out = make(Node::Number);
+            out->number = v;
+            return 0;
+        }
+        return 3;
+    }
+
+    int string(std::string& out) {
+        p++;  // Opening quote
+        while (p < end && *p != '"') {
+            char c = *p++;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (p == end) return 2;
+            char e = *p++;
+            switch (e) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    if (end - p < 4) return 2;
+                    unsigned cp = (unsigned)strtoul(std::string(p, 4).c_str(), nullptr, 16);
+                    p += 4;
+                    if (cp < 0x80) {
+                        out += (char)cp;
+                    } else if (cp < 0x800) {
+                        out += (char)(0xC0 | cp >> 6);
+                        out += (char)(0x80 | (cp & 0x3F));
+                    } else {
+                        out += (char)(0xE0 | cp >> 12);
+                        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+                        out += (char)(0x80 | (cp & 0x3F));
+                    }
+                    break;
+                }
+                default: out += e; break;
+            }
+        }
+        if (p == end) return 2;
+        p++;  // Closing quote
+        return 0;
+    }
+
+    int array(Node*& out, int depth) {
+        out = make(Node::Array);
+        p++;
+        skipSpace();
+        if (p < end && *p == ']') { p++; return 0; }
+        for (;;) {
+            Node* item;
+            int err = value(item, depth + 1);
+            if (err) return err;
+            out->items.push_back(item);
+            skipSpace();
+            if (p == end) return 2;
+            if (*p == ',') { p++; continue; }
+            if (*p == ']') { p++; return 0; }
+            return 3;
+        }
+    }
+
+    int object(Node*& out, int depth) {
+        out = make(Node::Object);
+        p++;
+        skipSpace();
+        if (p < end && *p == '}') { p++; return 0; }
+        for (;;) {
+            skipSpace();
+            if (p == end) return 2;
+            if (*p != '"') return 3;
+            std::string key;
+            int err = string(key);
+            if (err) return err;
+            skipSpace();
+            if (p == end) return 2;
+            if (*p++ != ':') return 3;
+            Node* item;
+            err = value(item, depth + 1);
+            if (err) return err;
+            out->keys.push_back(key);
+            out->items.push_back(item);
+            skipSpace();
+            if (p == end) return 2;
+            if (*p == ',') { p++; continue; }
+            if (*p == '}') { p++; return 0; }
+            return 3;
+        }
+    }
+};
+
+} // namespace jsonsim
+
+class JsonArray;
+class JsonObject;
+
+class JsonVariant {
+public:
+    JsonVariant() : node(nullptr) {}
+    explicit JsonVariant(const jsonsim::Node* n) : node(n) {}
+
+    template <typename T> T as() const { return jsonsim::Convert<T>::from(node); }
+    template <typename T> bool is() const;
+    bool isNull() const { return !node || node->type == jsonsim::Node::Null; }
+    template <typename T> T operator|(T fallback) const { return isNull() ? fallback : as<T>(); }
+    const char* operator|(const char* fallback) const {
+        return node && node->type == jsonsim::Node::Text ? node->text.c_str() : fallback;
+    }
+
+    JsonVariant operator[](const char* key) const {
+        if (!node || node->type != jsonsim::Node::Object) return JsonVariant();
+        for (size_t i = 0; i < node->keys.size(); i++) {
+            if (node->keys[i] == key) return JsonVariant(node->items[i]);
+        }
+        return JsonVariant();
+    }
+    JsonVariant operator[](const String& key) const { return (*this)[key.c_str()]; }
+    JsonVariant operator[](size_t index) const {
+        if (!node || node->type != jsonsim::Node::Array || index >= node->items.size()) return JsonVariant();
+        return JsonVariant(node->items[index]);
+    }
+    JsonVariant operator[](int index) const { return (*this)[(size_t)index]; }
+    size_t size() const {
+        return node && (node->type == jsonsim::Node::Array || node->type == jsonsim::Node::Object)
+                   ? node->items.size() : 0;
+    }
+
+    operator JsonArray() const;
+    operator JsonObject() const;
+
+protected:
+    const jsonsim::Node* node;
+};
+
+class JsonArray : public JsonVariant {
+public:
+    JsonArray() {}
+    explicit JsonArray(const jsonsim::Node* n)
+        : JsonVariant(n && n->type == jsonsim::Node::Array ? n : nullptr) {}
+
+    class iterator {
+    public:
+        iterator(const jsonsim::Node* const* p) : p(p) {}
+        JsonVariant operator*() const { return JsonVariant(*p); }
+        iterator& operator++() { p++; return *this; }
+        bool operator!=(const iterator& o) const { return p != o.p; }
+    private:
+        const jsonsim::Node* const* p;
+    };
+    iterator begin() const { return iterator(node ? node->items.data() : nullptr); }
+    iterator end() const { return iterator(node ? node->items.data() + node->items.size() : nullptr); }
+};
+
+class JsonObject : public JsonVariant {
+public:
+    JsonObject() {}
+    explicit JsonObject(const jsonsim::Node* n)
+        : JsonVariant(n && n->type == jsonsim::Node::Object ? n : nullptr) {}
+};
+
+namespace jsonsim {
+template <>
+struct Convert<JsonObject> {
+    static JsonObject from(const Node* n) { return JsonObject(n); }
+};
+}  // namespace jsonsim
+
+inline JsonVariant::operator JsonArray() const { return JsonArray(node); }
+inline JsonVariant::operator JsonObject() const { return JsonObject(node); }
+
+template <typename T> bool JsonVariant::is() const {
+    if (!node) return false;
+    if (std::is_same<T, JsonArray>::value) return node->type == jsonsim::Node::Array;
+    if (std::is_same<T, JsonObject>::value) return node->type == jsonsim::Node::Object;
+    if (std::is_same<T, bool>::value) return node->type == jsonsim::Node::Bool;
+    if (std::is_same<T, const char*>::value || std::is_same<T, String>::value) {
+        return node->type == jsonsim::Node::Text;
+    }
+    return node->type == jsonsim::Node::Number;
+}
+
+// Memory source for documents (ArduinoJson::Allocator)
+struct Allocator {
+    virtual void* allocate(size_t size) = 0;
+    virtual void deallocate(void* ptr) = 0;
+    virtual void* reallocate(void* ptr, size_t newSize) = 0;
+
+protected:
+    ~Allocator() {}
+};
+
+class JsonDocument {
+public:
+    JsonDocument() : root(nullptr), allocator(nullptr) {}
+    explicit JsonDocument(Allocator* allocator) : root(nullptr), allocator(allocator) {}
+    ~JsonDocument() { clear(); }
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+
+    JsonVariant operator[](const char* key) const { return JsonVariant(root)[key]; }
+    JsonVariant operator[](size_t index) const { return JsonVariant(root)[index]; }
+    template <typename T> T as() const { return JsonVariant(root).as<T>(); }
+    bool isNull() const { return JsonVariant(root).isNull(); }
+    size_t size() const { return JsonVariant(root).size(); }
+    bool overflowed() const { return false; }
+    void clear() {
+        SimHeapUncounted uncounted(allocator != nullptr);
+        release();
+        std::vector<std::unique_ptr<jsonsim::Node>>().swap(nodes);
+        root = nullptr;
+    }
+
+    // Parser entry point for deserializeJson()
+    int parse(const char* text, size_t length) {
+        clear();
+        // With an allocator the tree is charged to it (charge()), not the heap
+        SimHeapUncounted uncounted(allocator != nullptr);
+        jsonsim::Parser parser(text, text + length, nodes);
+        int err = parser.parse(root);
+        if (allocator) charge();
+        return err;
+    }
+
+private:
+    std::vector<std::unique_ptr<jsonsim::Node>> nodes;
+    jsonsim::Node* root;
+
+    // A document given an allocator draws on it roughly as ArduinoJson 7
+    // does on a 32-bit target: 8-byte slots in pages of 256, listed in a
+    // growing directory (one slot per value, one more per object key or
+    // double), and one block per distinct string, built in a 31-byte buffer
+    // and then resized to fit. The DOM itself still lives on the host heap.
+    Allocator* allocator;
+    std::vector<void*> blocks;
+    std::vector<void*> pages;
+    void* directory = nullptr;  // Sized for 32-bit pointers; pages holds them
+    size_t directoryCapacity = 0;
+    size_t slotsLeft = 0;
+    std::set<std::string> strings;
+
+    void takeSlot() {
+        if (slotsLeft == 0) {
+            if (pages.size() == directoryCapacity) {
+                directoryCapacity = directoryCapacity ? directoryCapacity * 2 : 4;
+                directory = allocator->reallocate(directory, directoryCapacity * 4);
+            }
+            pages.push_back(allocator->allocate(256 * 8));
+            slotsLeft = 256;
+        }
+        slotsLeft--;
+    }
+    void takeString(const std::string& text) {
+        void* p = allocator->allocate(8 + 31);
+        if (text.size() > 31) p = allocator->reallocate(p, 8 + text.size() + 1);
+        if (!strings.insert(text).second) {
+            allocator->deallocate(p);
+            return;
+        }
+        blocks.push_back(allocator->reallocate(p, 8 + text.size() + 1));
+    }
+    void charge() {
+        for (auto& n : nodes) {
+            takeSlot();
+            if (n->type == jsonsim::Node::Number && n->number != (double)(int32_t)n->number) takeSlot();
+            if (n->type == jsonsim::Node::Text) takeString(n->text);
+            for (auto& key : n->keys) {
+                takeSlot();
+                takeString(key);
+            }
+        }
+    }
+    void release() {
+        if (!allocator) return;
+        for (void* p : blocks) allocator->deallocate(p);
+        for (void* p : pages) allocator->deallocate(p);
+        if (directory) allocator->deallocate(directory);
+        std::vector<void*>().swap(blocks);
+        std::vector<void*>().swap(pages);
+        strings.clear();
+        directory = nullptr;
+        directoryCapacity = slotsLeft = 0;
+    }
+};
+
+class DeserializationError {
+public:
+    enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep };
+    DeserializationError(Code c = Ok) : value(c) {}
+    explicit operator bool() const { return value != Ok; }
+    bool operator==(Code c) const { return value == c; }
+    bool operator!=(Code c) const { return value != c; }
+    Code code() const { return value; }
+    const char* c_str() const {
+        static const char* names[] = {"Ok", "EmptyInput", "IncompleteInput", "InvalidInput",
+                                      "NoMemory", "TooDeep"};
+        return names[value];
+    }
+
+private:
+    Code value;
+};
+
+namespace DeserializationOption {
+// Filters are accepted but not applied: the whole document is kept
+struct Filter {
+    explicit Filter(const JsonDocument&) {}
+};
+}
+
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* input, size_t length) {
+    static const DeserializationError::Code codes[] = {
+        DeserializationError::Ok, DeserializationError::EmptyInput,
+        DeserializationError::IncompleteInput, DeserializationError::InvalidInput,
+        DeserializationError::TooDeep};
+    return codes[doc.parse(input, length)];
+}
+inline DeserializationError deserializeJson(JsonDocument& doc, const char* input) {
+    return deserializeJson(doc, input, input ? strlen(input) : 0);
+}
+inline DeserializationError deserializeJson(JsonDocument& doc, const String& input) {
+    return deserializeJson(doc, input.c_str(), input.length());
+}
+inline DeserializationError deserializeJson(JsonDocument& doc, Stream& input) {
+    std::string text;
+    int c;
+    while ((c = input.read()) >= 0) text += (char)c;
+    return deserializeJson(doc, text.data(), text.size());
+}
+template <typename Input>
+DeserializationError deserializeJson(JsonDocument& doc, Input& input, DeserializationOption::Filter) {
+    return deserializeJson(doc, input);
+}
+
+#endif // WAKE_SIM_ARDUINOJSON_H
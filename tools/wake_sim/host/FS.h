@@ -0,0 +1,77 @@
+// Host stand-in for the Arduino FS API, backed by a directory on the host.
+// Flash writes are charged to the simulated clock per kilobyte.
+#ifndef WAKE_SIM_FS_H
+#define WAKE_SIM_FS_H
+
+#include "Arduino.h"
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct FileImpl;
+
+// Handle to an open file or directory; closes with the last copy
+class File : public Stream {
+public:
+    File() {}
+    explicit File(std::shared_ptr<FileImpl> impl) : impl(impl) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buf, size_t size);
+    void flush() override;
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void close() { impl.reset(); }
+    operator bool() const { return impl != nullptr; }
+
+    const char* name() const;
+    const char* path() const;
+    bool isDirectory() const;
+    File openNextFile();
+
+private:
+    std::shared_ptr<FileImpl> impl;
+};
+
+class FS {
+public:
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) {
+        return open(path.c_str(), mode, create);
+    }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+    bool mkdir(const char* path);
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+    bool rmdir(const char* path);
+
+    // Host directory standing in for the partition
+    void setRoot(const std::string& dir) { root = dir; }
+    const std::string& hostRoot() const { return root; }
+
+protected:
+    std::string root;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif // WAKE_SIM_FS_H
@@ -0,0 +1,47 @@
+// Host stand-in for HTTPClient. Requests are answered by the simulated API
+// server (sim_server.h) over the caller's client, which must already be
+// connected; the request and transfer time is charged to the radio.
+#ifndef WAKE_SIM_HTTPCLIENT_H
+#define WAKE_SIM_HTTPCLIENT_H
+
+#include "WiFi.h"
+
+#define HTTP_CODE_OK 200
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+#define HTTPC_ERROR_NO_STREAM (-6)
+
+class HTTPClient {
+public:
+    bool begin(WiFiClient& client, const String& url);
+    void end();
+
+    void setTimeout(uint16_t ms) { timeoutMs = ms; }
+    void setConnectTimeout(int32_t) {}
+    void setReuse(bool reuse) { this->reuse = reuse; }
+    void useHTTP10(bool = true) {}
+    void addHeader(const String&, const String&) {}
+
+    int GET();
+    int getSize() const { return size; }
+    String getString();
+    int writeToStream(Stream* stream);
+    WiFiClient& getStream() { return *client; }
+    WiFiClient* getStreamPtr() { return client; }
+    bool connected() { return client && client->connected(); }
+
+    static String errorToString(int error);
+
+private:
+    WiFiClient* client = nullptr;
+    String url;
+    uint16_t timeoutMs = 5000;
+    bool reuse = true;
+    bool keepAlive = false;
+    int size = -1;
+};
+
+#endif // WAKE_SIM_HTTPCLIENT_H
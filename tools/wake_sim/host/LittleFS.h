@@ -0,0 +1,19 @@
+// Host stand-in for LittleFS (see FS.h)
+#ifndef WAKE_SIM_LITTLEFS_H
+#define WAKE_SIM_LITTLEFS_H
+
+#include "FS.h"
+
+class LittleFSFS : public fs::FS {
+public:
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs",
+               uint8_t maxOpenFiles = 10, const char* partitionLabel = "spiffs");
+    void end() {}
+    bool format();
+    size_t totalBytes() { return 1536 * 1024; }
+    size_t usedBytes();
+};
+
+extern LittleFSFS LittleFS;
+
+#endif // WAKE_SIM_LITTLEFS_H
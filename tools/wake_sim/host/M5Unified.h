@@ -0,0 +1,198 @@
+// Host stand-in for M5Unified / M5GFX. Drawing primitives do nothing;
+// canvases own a real pixel buffer (framebuffer.h writes into it) and every
+// panel refresh is charged to the simulated e-paper controller.
+#ifndef WAKE_SIM_M5UNIFIED_H
+#define WAKE_SIM_M5UNIFIED_H
+
+#include "Arduino.h"
+#include <vector>
+
+#define TFT_BLACK 0x0000u
+#define TFT_WHITE 0xFFFFu
+#define TFT_DARKGREY 0x7BEFu
+#define TFT_LIGHTGREY 0xD69Au
+
+enum textdatum_t {
+    TL_DATUM, TC_DATUM, TR_DATUM,
+    ML_DATUM, MC_DATUM, MR_DATUM,
+    BL_DATUM, BC_DATUM, BR_DATUM,
+};
+
+enum class epd_mode_t { epd_quality, epd_text, epd_fast, epd_fastest };
+
+namespace lgfx {
+struct IFont {
+    int width;
+    int height;
+};
+}
+
+namespace fonts {
+extern const lgfx::IFont Font0, Font2, Font4;
+extern const lgfx::IFont FreeSans9pt7b, FreeSans12pt7b, FreeSans18pt7b, FreeSans24pt7b;
+extern const lgfx::IFont FreeSansBold9pt7b, FreeSansBold12pt7b, FreeSansBold18pt7b, FreeSansBold24pt7b;
+}
+
+class LovyanGFX {
+public:
+    virtual ~LovyanGFX() {}
+
+    int32_t width() const { return rotation & 1 ? panelH : panelW; }
+    int32_t height() const { return rotation & 1 ? panelW : panelH; }
+    void setRotation(int r) { rotation = r & 3; }
+
+    // Text metrics follow the font's nominal cell size, enough for layout
+    void setFont(const lgfx::IFont* f) { font = f ? f : &fonts::Font0; }
+    void setTextSize(float s) { textSize = s; }
+    void setTextColor(uint32_t) {}
+    void setTextColor(uint32_t, uint32_t) {}
+    void setTextDatum(textdatum_t) {}
+    void setTextWrap(bool) {}
+    int32_t textWidth(const char* s) const { return (int32_t)(strlen(s) * font->width * textSize); }
+    int32_t textWidth(const String& s) const { return textWidth(s.c_str()); }
+    int32_t fontHeight() const { return (int32_t)(font->height * textSize); }
+
+    size_t drawString(const char* s, int32_t, int32_t) { return strlen(s); }
+    size_t drawString(const String& s, int32_t x, int32_t y) { return drawString(s.c_str(), x, y); }
+    void fillScreen(uint32_t);  // Starts a frame (see M5GFX::display)
+    void fillSprite(uint32_t) {}
+    void drawPixel(int32_t, int32_t, uint32_t) {}
+    void drawLine(int32_t, int32_t, int32_t, int32_t, uint32_t) {}
+    void drawFastHLine(int32_t, int32_t, int32_t, uint32_t) {}
+    void drawFastVLine(int32_t, int32_t, int32_t, uint32_t) {}
+    void drawRect(int32_t, int32_t, int32_t, int32_t, uint32_t) {}
+    void fillRect(int32_t, int32_t, int32_t, int32_t, uint32_t) {}
+    void drawRoundRect(int32_t, int32_t, int32_t, int32_t, int32_t, uint32_t) {}
+    void fillRoundRect(int32_t, int32_t, int32_t, int32_t, int32_t, uint32_t) {}
+    void drawCircle(int32_t, int32_t, int32_t, uint32_t) {}
+    void fillCircle(int32_t, int32_t, int32_t, uint32_t) {}
+    void drawArc(int32_t, int32_t, int32_t, int32_t, float, float, uint32_t) {}
+    void fillArc(int32_t, int32_t, int32_t, int32_t, float, float, uint32_t) {}
+    void drawTriangle(int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, uint32_t) {}
+    void fillTriangle(int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, uint32_t) {}
+    void drawEllipse(int32_t, int32_t, int32_t, int32_t, uint32_t) {}
+    void fillEllipse(int32_t, int32_t, int32_t, int32_t, uint32_t) {}
+    void pushImage(int32_t, int32_t, int32_t, int32_t, const uint8_t*) {}
+    void drawBitmap(int32_t, int32_t, const uint8_t*, int32_t, int32_t, uint32_t) {}
+    size_t drawChar(uint16_t, int32_t, int32_t) { return 1; }
+    uint32_t readPixelValue(int32_t, int32_t) { return 1; }
+    void startWrite() {}
+    void endWrite() {}
+    static uint32_t color888(uint8_t r, uint8_t g, uint8_t b) {
+        return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+    }
+
+protected:
+    int32_t panelW = 540;
+    int32_t panelH = 960;
+    int rotation = 0;
+    const lgfx::IFont* font = &fonts::Font0;
+    float textSize = 1;
+};
+
+// The e-paper panel
+class M5GFX : public LovyanGFX {
+public:
+    bool begin() { return true; }
+    bool init() { return true; }
+    bool init_without_reset();
+    void setEpdMode(epd_mode_t m) { mode = m; }
+    epd_mode_t getEpdMode() const { return mode; }
+    void setAutoDisplay(bool) {}
+
+    // A refresh runs on in the background for the panel's update time;
+    // starting another first waits for it
+    void display();
+    void display(int32_t x, int32_t y, int32_t w, int32_t h);
+    void waitDisplay();
+    bool displayBusy() const;
+
+    void sleep() {}
+    void wakeup() {}
+    void powerSaveOn() {}
+    void powerSaveOff() {}
+
+private:
+    epd_mode_t mode = epd_mode_t::epd_quality;
+};
+
+class M5Canvas : public LovyanGFX {
+public:
+    M5Canvas() {}
+    explicit M5Canvas(LovyanGFX*) {}
+    ~M5Canvas() { deleteSprite(); }
+    M5Canvas(const M5Canvas&) = delete;
+    M5Canvas& operator=(const M5Canvas&) = delete;
+
+    void setColorDepth(int bits) { depth = bits; }
+    void setPsram(bool enabled) { psram = enabled; }
+    // In PSRAM when asked for and there is room, like M5GFX
+    void* createSprite(int32_t w, int32_t h) {
+        deleteSprite();
+        size_t length = ((size_t)w * h * depth + 7) / 8;
+        pixels = (uint8_t*)(psram ? ps_malloc(length) : nullptr);
+        if (!pixels) pixels = (uint8_t*)malloc(length);
+        if (!pixels) return nullptr;
+        memset(pixels, 0xFF, length);
+        panelW = w;
+        panelH = h;
+        return pixels;
+    }
+    bool createPalette() { return true; }
+    void deleteSprite() {
+        free(pixels);
+        pixels = nullptr;
+    }
+    void* getBuffer() { return pixels; }
+
+    // Transfer of the finished frame to the panel controller
+    void pushSprite(LovyanGFX* dst, int32_t x, int32_t y);
+
+private:
+    int depth = 16;
+    bool psram = false;
+    uint8_t* pixels = nullptr;
+};
+
+// Battery gauge follows the simulated charge
+struct M5Power {
+    int getBatteryLevel();
+    int16_t getBatteryVoltage();
+};
+
+struct M5Config {
+    unsigned long serial_baudrate = 115200;
+    bool clear_display = true;
+    bool output_power = true;
+    bool internal_imu = true;
+    bool internal_rtc = true;
+    bool internal_spk = true;
+    bool internal_mic = true;
+    bool external_imu = false;
+    bool external_rtc = false;
+    bool external_spk = false;
+    struct {
+        bool module_display = true;
+        bool atom_display = true;
+        bool unit_glass = false;
+        bool module_rca = true;
+        bool unit_oled = true;
+        bool unit_lcd = true;
+        bool unit_rca = true;
+    } external_display;
+    uint8_t led_brightness = 0;
+    bool fallback_board = false;
+};
+
+struct M5UnifiedSim {
+    M5GFX Display;
+    M5Power Power;
+
+    M5Config config() { return M5Config(); }
+    void begin(const M5Config& cfg);
+    void update() {}
+};
+
+extern M5UnifiedSim M5;
+
+#endif // WAKE_SIM_M5UNIFIED_H
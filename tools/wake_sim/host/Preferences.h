@@ -0,0 +1,32 @@
+// Host stand-in for NVS Preferences: an in-memory store, provisioned by
+// the simulator before the first wake. Writes made during a wake do not
+// reach later wakes.
+#ifndef WAKE_SIM_PREFERENCES_H
+#define WAKE_SIM_PREFERENCES_H
+
+#include "Arduino.h"
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false);
+    void end() { open = false; }
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putBytes(const char* key, const void* value, size_t length);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buf, size_t maxLength);
+    size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) {
+        uint32_t v = defaultValue;
+        return getBytes(key, &v, sizeof(v)) == sizeof(v) ? v : defaultValue;
+    }
+
+private:
+    std::string space;
+    bool open = false;
+    bool readOnly = false;
+};
+
+#endif // WAKE_SIM_PREFERENCES_H
@@ -0,0 +1,95 @@
+// Host stand-in for the WiFi library. Association, DNS and link failures
+// follow the simulator's latency and fault parameters; the radio draws
+// current from WiFi.mode(WIFI_STA) until it is switched off again.
+#ifndef WAKE_SIM_WIFI_H
+#define WAKE_SIM_WIFI_H
+
+#include "Arduino.h"
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL,
+    WL_SCAN_COMPLETED,
+    WL_CONNECTED,
+    WL_CONNECT_FAILED,
+    WL_CONNECTION_LOST,
+    WL_DISCONNECTED,
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+
+// The events the stand-in raises
+typedef enum {
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef void (*WiFiEventCb)(arduino_event_id_t event);
+typedef int wifi_event_id_t;
+
+class WiFiClass {
+public:
+    bool mode(wifi_mode_t m);
+    wifi_mode_t getMode() const;
+    wl_status_t begin(const char* ssid, const char* password = nullptr, int32_t channel = 0,
+                      const uint8_t* bssid = nullptr, bool connect = true);
+    wl_status_t status();
+    bool disconnect(bool wifiOff = false, bool eraseAp = false);
+    bool isConnected() { return status() == WL_CONNECTED; }
+
+    // Called as the join completes or the link goes down; MAX is every event
+    wifi_event_id_t onEvent(WiFiEventCb callback, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+
+    bool config(IPAddress local, IPAddress gateway, IPAddress subnet,
+                IPAddress dns1 = IPAddress(), IPAddress dns2 = IPAddress());
+    bool setAutoReconnect(bool) { return true; }
+    bool persistent(bool) { return true; }
+    bool setSleep(bool) { return true; }
+
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask();
+    IPAddress dnsIP(uint8_t i = 0);
+    int32_t channel();
+    uint8_t* BSSID();
+    int8_t RSSI() { return -60; }
+
+    int hostByName(const char* host, IPAddress& result);
+};
+
+extern WiFiClass WiFi;
+
+// Base of every network client. The HTTP stand-in queues the response
+// bytes here, so firmware clients can be read the usual way.
+class WiFiClient : public Stream {
+public:
+    virtual ~WiFiClient() {}
+    virtual int connect(IPAddress ip, uint16_t port);
+    virtual int connect(IPAddress ip, uint16_t port, int32_t timeoutMs);
+    virtual int connect(const char* host, uint16_t port);
+    virtual int connect(const char* host, uint16_t port, int32_t timeoutMs);
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t*, size_t size) override { return connected() ? size : 0; }
+    int available() override { return (int)(simRx.size() - simRxPos); }
+    int read() override { return available() > 0 ? (uint8_t)simRx[simRxPos++] : -1; }
+    virtual int read(uint8_t* buf, size_t size);
+    int peek() override { return available() > 0 ? (uint8_t)simRx[simRxPos] : -1; }
+    void flush() override {}
+    virtual void stop() { simOpen = false; simClearRx(); }
+    virtual uint8_t connected() { return simOpen; }
+    operator bool() { return connected(); }
+    void setTimeout(uint32_t seconds) { Stream::setTimeout(seconds * 1000); }
+
+    // Simulator side of the connection
+    void simQueueRx(const std::string& bytes) { simRx = bytes; simRxPos = 0; }
+    void simClearRx() { simRx.clear(); simRxPos = 0; }
+
+protected:
+    bool simOpen = false;
+    std::string simRx;
+    size_t simRxPos = 0;
+};
+
+#endif // WAKE_SIM_WIFI_H
@@ -0,0 +1,12 @@
+// Host stand-in for the SNTP notification hook. The callback runs when the
+// simulated server answers (see simStartSntp).
+#ifndef WAKE_SIM_ESP_SNTP_H
+#define WAKE_SIM_ESP_SNTP_H
+
+#include <sys/time.h>
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval* tv);
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
+
+#endif // WAKE_SIM_ESP_SNTP_H
@@ -0,0 +1,19 @@
+// Host stand-in for FreeRTOS event groups. Bits are set from simulator
+// callbacks (WiFi events, SNTP); a wait advances the virtual clock a tick
+// at a time until they are, or until it times out.
+#ifndef WAKE_SIM_EVENT_GROUPS_H
+#define WAKE_SIM_EVENT_GROUPS_H
+
+#include <Arduino.h>
+
+typedef struct SimEventGroup* EventGroupHandle_t;
+typedef TickType_t EventBits_t;
+
+EventGroupHandle_t xEventGroupCreate();
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+                                BaseType_t waitForAll, TickType_t ticks);
+
+#endif // WAKE_SIM_EVENT_GROUPS_H
@@ -0,0 +1,8 @@
+// Only the type name is needed on the host: the simulator replaces
+// tls_client.cpp and tls_session_cache.cpp (sim_tls.cpp).
+#ifndef WAKE_SIM_MBEDTLS_SSL_H
+#define WAKE_SIM_MBEDTLS_SSL_H
+
+typedef struct mbedtls_ssl_context mbedtls_ssl_context;
+
+#endif // WAKE_SIM_MBEDTLS_SSL_H
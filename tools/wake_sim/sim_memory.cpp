@@ -0,0 +1,208 @@
+// Heap and stack stand-ins: ps_malloc(), heap_caps_*(),
+// uxTaskGetStackHighWaterMark() and esp_reset_reason().
+//
+// The C library's allocator is wrapped (like time() in sim_platform.cpp)
+// to count the bytes in use; the loop task's stack is painted below the
+// frame setup() runs from and scanned for the deepest byte touched.
+#include "sim_model.h"
+#include <Arduino.h>
+#include <malloc.h>
+
+#define STACK_PAINT 0xA5
+#define STACK_PAINT_BYTES (64 * 1024)  // Room for a stack_kb above the device's
+#define PSRAM_BLOCKS 8
+
+#ifdef __SANITIZE_ADDRESS__
+#define SIM_MEMORY_MEASURED 0
+#else
+#define SIM_MEMORY_MEASURED 1
+#endif
+
+static int64_t heapUsed = 0;      // Host bytes in use, as malloc_usable_size() counts them
+static int64_t heapBaseline = 0;  // heapUsed when the wake started
+static int64_t reserved = 0;      // Held by stand-in drivers
+static int64_t heapMinFree = INT64_MAX;
+static uint64_t heapAllocations = 0;
+static int64_t psramUsed = 0;
+static int64_t psramMinFree = INT64_MAX;
+static uint8_t* stackTop = nullptr;
+static int uncounted = 0;
+
+static int64_t heapFree() {
+    int64_t free = (int64_t)(simParams.heapKb * 1024) - (heapUsed - heapBaseline) - reserved;
+    return free > 0 ? free : 0;
+}
+
+static int64_t psramFree() {
+    int64_t free = (int64_t)(simParams.psramKb * 1024) - psramUsed;
+    return free > 0 ? free : 0;
+}
+
+static void heapChanged() {
+    int64_t free = heapFree();
+    if (free < heapMinFree) heapMinFree = free;
+}
+
+void simMemoryBeginWake() {
+    heapBaseline = heapUsed;
+    reserved = 0;
+    heapMinFree = INT64_MAX;
+    heapChanged();
+    psramUsed = 0;
+    psramMinFree = psramFree();
+
+    stackTop = (uint8_t*)__builtin_frame_address(0);
+#if SIM_MEMORY_MEASURED
+    // Everything below this frame is free at this point; keep clear of the
+    // bytes this function itself may still use
+    volatile uint8_t* p = stackTop - STACK_PAINT_BYTES;
+    for (size_t i = 0; i < STACK_PAINT_BYTES - 512; i++) p[i] = STACK_PAINT;
+#endif
+}
+
+void simHeapReserve(double kb) {
+    reserved += (int64_t)(kb * 1024);
+    heapChanged();
+}
+
+void simHeapRelease(double kb) {
+    reserved -= (int64_t)(kb * 1024);
+    heapChanged();
+}
+
+uint64_t simHeapAllocations() {
+    return heapAllocations;
+}
+
+SimHeapUncounted::SimHeapUncounted(bool active) : active(active) {
+    if (active) uncounted++;
+}
+
+SimHeapUncounted::~SimHeapUncounted() {
+    if (active) uncounted--;
+}
+
+#if SIM_MEMORY_MEASURED
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+static void* psramBlocks[PSRAM_BLOCKS];
+
+static bool isPsram(void* ptr) {
+    for (int i = 0; i < PSRAM_BLOCKS; i++) {
+        if (psramBlocks[i] == ptr) return true;
+    }
+    return false;
+}
+
+static void* charged(void* ptr) {
+    if (ptr && !uncounted) {
+        heapAllocations++;
+        heapUsed += malloc_usable_size(ptr);
+        heapChanged();
+    }
+    return ptr;
+}
+
+extern "C" void* malloc(size_t size) __THROW {
+    return charged(__libc_malloc(size));
+}
+
+extern "C" void* calloc(size_t count, size_t size) __THROW {
+    return charged(__libc_calloc(count, size));
+}
+
+extern "C" void* memalign(size_t alignment, size_t size) __THROW {
+    return charged(__libc_memalign(alignment, size));
+}
+
+extern "C" void* aligned_alloc(size_t alignment, size_t size) __THROW {
+    return memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void** ptr, size_t alignment, size_t size) __THROW {
+    *ptr = memalign(alignment, size);
+    return *ptr ? 0 : ENOMEM;
+}
+
+extern "C" void* realloc(void* ptr, size_t size) __THROW {
+    if (!ptr) return malloc(size);
+    if (isPsram(ptr)) return __libc_realloc(ptr, size);  // Not done by the firmware
+    size_t before = malloc_usable_size(ptr);
+    void* moved = __libc_realloc(ptr, size);
+    if ((moved || size == 0) && !uncounted) {
+        heapUsed -= before;
+        charged(moved);
+    }
+    return moved;
+}
+
+extern "C" void free(void* ptr) __THROW {
+    if (!ptr) return;
+    for (int i = 0; i < PSRAM_BLOCKS; i++) {
+        if (psramBlocks[i] == ptr) {
+            psramBlocks[i] = nullptr;
+            psramUsed -= malloc_usable_size(ptr);
+            __libc_free(ptr);
+            return;
+        }
+    }
+    if (!uncounted) heapUsed -= malloc_usable_size(ptr);
+    __libc_free(ptr);
+}
+
+void* ps_malloc(size_t size) {
+    if (size > (size_t)psramFree()) return nullptr;
+    int slot = 0;
+    while (slot < PSRAM_BLOCKS && psramBlocks[slot]) slot++;
+    if (slot == PSRAM_BLOCKS) return nullptr;
+    void* ptr = __libc_malloc(size);
+    if (!ptr) return nullptr;
+    psramBlocks[slot] = ptr;
+    psramUsed += malloc_usable_size(ptr);
+    if (psramFree() < psramMinFree) psramMinFree = psramFree();
+    return ptr;
+}
+
+#else
+
+void* ps_malloc(size_t size) {
+    return simParams.psramKb * 1024 >= size ? malloc(size) : nullptr;
+}
+
+#endif
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return caps & MALLOC_CAP_SPIRAM ? psramFree() : heapFree();
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    return caps & MALLOC_CAP_SPIRAM ? psramMinFree : heapMinFree;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) {
+    int64_t stackBytes = (int64_t)(simParams.stackKb * 1024);
+#if SIM_MEMORY_MEASURED
+    const uint8_t* p = stackTop - STACK_PAINT_BYTES;
+    size_t untouched = 0;
+    while (untouched < STACK_PAINT_BYTES && p[untouched] == STACK_PAINT) untouched++;
+    int64_t free = stackBytes - (int64_t)(STACK_PAINT_BYTES - untouched);
+    return free > 0 ? (UBaseType_t)free : 0;
+#else
+    return (UBaseType_t)stackBytes;
+#endif
+}
+
+esp_reset_reason_t esp_reset_reason() {
+    return simState.timerWake ? ESP_RST_DEEPSLEEP : ESP_RST_POWERON;
+}
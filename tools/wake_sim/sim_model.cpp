@@ -0,0 +1,287 @@
+#include "sim_model.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+SimParams simParams;
+SimState simState;
+SimWakeLedger simLedger;
+
+// Defaults are estimates for the Paper S3 on a typical home network;
+// measure the board and pass your own values for real projections.
+static const SimParamInfo PARAMS[] = {
+    {"days", &SimParams::days, 28, "simulated span in days"},
+    {"seed", &SimParams::seed, 1, "RNG seed for faults and jitter"},
+    {"start", &SimParams::start, 1767225600, "start time, Unix seconds UTC (2026-01-01)"},
+    {"capacity_mah", &SimParams::capacityMah, 1800, "battery capacity"},
+    {"jitter", &SimParams::jitter, 0.2, "+/- fraction applied to every latency"},
+
+    {"boot_ms", &SimParams::bootMs, 320, "reset to setup(): ROM, bootloader, PSRAM test"},
+    {"cpu_ma", &SimParams::cpuMa, 42, "awake current, radio and panel off"},
+    {"cpu_slow_ma", &SimParams::cpuSlowMa, 24, "awake current with the CPU at 80 MHz"},
+    {"sleep_ma", &SimParams::sleepMa, 0.012, "deep sleep current, whole board"},
+    {"m5_begin_ms", &SimParams::m5BeginMs, 140, "M5.begin() core: board detect, PMIC, panel, touch"},
+    {"imu_init_ms", &SimParams::imuInitMs, 30, "M5.begin() IMU probe and setup"},
+    {"rtc_init_ms", &SimParams::rtcInitMs, 10, "M5.begin() RTC chip"},
+    {"audio_init_ms", &SimParams::audioInitMs, 20, "M5.begin() speaker and microphone"},
+    {"ext_probe_ms", &SimParams::extProbeMs, 20, "M5.begin() probing for external displays"},
+    {"panel_init_ms", &SimParams::panelInitMs, 45, "panel bring-up alone, without M5Unified"},
+
+    {"radio_ma", &SimParams::radioMa, 75, "extra current while WiFi is on"},
+    {"wifi_connect_ms", &SimParams::wifiConnectMs, 1800, "association + DHCP"},
+    {"wifi_fail_rate", &SimParams::wifiFailRate, 0, "chance the AP cannot be joined"},
+    {"ntp_ms", &SimParams::ntpMs, 120, "SNTP round trip"},
+    {"ntp_fail_rate", &SimParams::ntpFailRate, 0, "chance one NTP server does not answer"},
+    {"dns_ms", &SimParams::dnsMs, 45, "resolver round trip"},
+    {"dns_fail_rate", &SimParams::dnsFailRate, 0, "chance a lookup fails"},
+    {"rtt_ms", &SimParams::rttMs, 60, "round trip to the API server"},
+    {"tcp_fail_rate", &SimParams::tcpFailRate, 0, "chance a TCP connect is refused"},
+    {"tls_full_ms", &SimParams::tlsFullMs, 650, "full TLS handshake"},
+    {"tls_resumed_ms", &SimParams::tlsResumedMs, 130, "abbreviated TLS handshake"},
+    {"tls_resume_rate", &SimParams::tlsResumeRate, 0.95, "chance the server resumes a cached session"},
+    {"tls_stall_rate", &SimParams::tlsStallRate, 0, "chance a TLS handshake stalls until its timeout"},
+    {"server_ms", &SimParams::serverMs, 90, "server time per request"},
+    {"link_kbps", &SimParams::linkKbps, 4000, "effective download rate"},
+    {"http_error_rate", &SimParams::httpErrorRate, 0, "chance a request fails with http_error_code"},
+    {"http_error_code", &SimParams::httpErrorCode, 503, "status returned by failed requests"},
+    {"http_stall_rate", &SimParams::httpStallRate, 0, "chance a request stalls until its timeout"},
+    {"keep_alive", &SimParams::keepAlive, 1, "1 if the server keeps connections open"},
+    {"forecast_error", &SimParams::forecastError, 1.5, "forecast temperature error per day of lead, C"},
+
+    {"epd_ma", &SimParams::epdMa, 95, "extra current while the panel refreshes"},
+    {"epd_full_ms", &SimParams::epdFullMs, 1600, "full refresh, quality mode"},
+    {"epd_fast_ms", &SimParams::epdFastMs, 450, "full refresh, fast modes"},
+    {"epd_partial_ms", &SimParams::epdPartialMs, 280, "region refresh"},
+    {"frame_push_ms", &SimParams::framePushMs, 60, "canvas to panel transfer"},
+
+    {"flash_ma", &SimParams::flashMa, 20, "extra current during flash writes"},
+    {"flash_ms_per_kb", &SimParams::flashMsPerKb, 3, "program + amortised erase time"},
+
+    {"heap_kb", &SimParams::heapKb, 300, "internal heap free when setup() starts"},
+    {"psram_kb", &SimParams::psramKb, 8000, "PSRAM free when setup() starts, 0 = none"},
+    {"wifi_heap_kb", &SimParams::wifiHeapKb, 55, "internal heap the WiFi driver holds while on"},
+    {"tls_heap_kb", &SimParams::tlsHeapKb, 42, "internal heap per TLS connection (mbedTLS)"},
+    {"stack_kb", &SimParams::stackKb, 8, "loop task stack"},
+
+    {"rtc_drift_ppm", &SimParams::rtcDriftPpm, 0, "sleep timer error, + sleeps long"},
+    {"rtc_drift_noise_ppm", &SimParams::rtcDriftNoisePpm, 0, "+/- random change of that error per sleep"},
+    {"max_awake_s", &SimParams::maxAwakeS, 180, "watchdog: a longer wake counts as a hang"},
+};
+
+const char* simLoadName(int load) {
+    static const char* NAMES[SIM_LOAD_COUNT] = {"cpu", "radio", "epd", "flash", "sleep"};
+    return load >= 0 && load < SIM_LOAD_COUNT ? NAMES[load] : "?";
+}
+
+const SimParamInfo* simParamTable(size_t& count) {
+    count = sizeof(PARAMS) / sizeof(PARAMS[0]);
+    return PARAMS;
+}
+
+void simParamsDefaults(SimParams& p) {
+    for (size_t i = 0; i < sizeof(PARAMS) / sizeof(PARAMS[0]); i++) {
+        p.*PARAMS[i].field = PARAMS[i].defaultValue;
+    }
+}
+
+bool simParamSet(SimParams& p, const char* name, const char* value) {
+    for (size_t i = 0; i < sizeof(PARAMS) / sizeof(PARAMS[0]); i++) {
+        if (strcmp(PARAMS[i].name, name) == 0) {
+            char* end;
+            double v = strtod(value, &end);
+            if (end == value || *end) return false;
+            p.*PARAMS[i].field = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- Clock and ledger ---
+
+#define SIM_TIMERS 4
+
+struct SimTimer {
+    void (*callback)();
+    int64_t dueUs;             // trueUs
+};
+
+static bool radioOn = false;
+static uint32_t cpuMhz = 240;
+static int64_t epdDoneUs = -1;
+static SimTimer timers[SIM_TIMERS];
+
+void simBeginWake() {
+    memset(&simLedger, 0, sizeof(simLedger));
+    simLedger.bootUs = simState.trueUs;
+    radioOn = false;
+    cpuMhz = 240;
+    epdDoneUs = -1;
+    memset(timers, 0, sizeof(timers));
+    simMemoryBeginWake();
+    simAdvance(simParams.bootMs);
+}
+
+// Move both clocks forward, charging the loads that are on
+static void step(int64_t us) {
+    if (us <= 0) return;
+    double ms = us / 1000.0;
+    simState.trueUs += us;
+    simState.deviceUs += us;
+    simLedger.awakeMs += ms;
+    if (cpuMhz > 80) {
+        simLedger.chargeMaMs[SIM_LOAD_CPU] += simParams.cpuMa * ms;
+    } else {
+        simLedger.slowMs += ms;
+        simLedger.chargeMaMs[SIM_LOAD_CPU] += simParams.cpuSlowMa * ms;
+    }
+    if (radioOn) {
+        simLedger.radioMs += ms;
+        simLedger.chargeMaMs[SIM_LOAD_RADIO] += simParams.radioMa * ms;
+    }
+    int64_t fromUs = simState.trueUs - us;
+    if (epdDoneUs > fromUs) {
+        double epdMs = ((epdDoneUs < simState.trueUs ? epdDoneUs : simState.trueUs) - fromUs) / 1000.0;
+        simLedger.epdMs += epdMs;
+        simLedger.chargeMaMs[SIM_LOAD_EPD] += simParams.epdMa * epdMs;
+    }
+}
+
+static SimTimer* nextTimer(int64_t untilUs) {
+    SimTimer* next = nullptr;
+    for (int i = 0; i < SIM_TIMERS; i++) {
+        SimTimer& t = timers[i];
+        if (t.callback && t.dueUs <= untilUs && (!next || t.dueUs < next->dueUs)) next = &t;
+    }
+    return next;
+}
+
+void simAdvance(double ms) {
+    if (ms <= 0) return;
+    int64_t endUs = simState.trueUs + (int64_t)llround(ms * 1000.0);
+
+    // Whatever falls due on the way happens at its time
+    while (SimTimer* t = nextTimer(endUs)) {
+        void (*callback)() = t->callback;
+        step(t->dueUs - simState.trueUs);
+        t->callback = nullptr;
+        callback();
+    }
+    step(endUs - simState.trueUs);
+
+    if (simLedger.awakeMs > simParams.maxAwakeS * 1000.0) {
+        simLedger.hung = true;
+        simEndWake();
+    }
+}
+
+void simAdvanceWith(SimLoad load, double ms) {
+    if (ms <= 0) return;
+    if (load == SIM_LOAD_FLASH) {
+        simLedger.chargeMaMs[load] += simParams.flashMa * ms;
+    }
+    simAdvance(ms);
+}
+
+void simAfter(double ms, void (*callback)()) {
+    simCancel(callback);
+    for (int i = 0; i < SIM_TIMERS; i++) {
+        if (timers[i].callback) continue;
+        timers[i].callback = callback;
+        timers[i].dueUs = simState.trueUs + (int64_t)llround(ms * 1000.0);
+        return;
+    }
+    fprintf(stderr, "simAfter: more than %d timers\n", SIM_TIMERS);
+    abort();
+}
+
+void simCancel(void (*callback)()) {
+    for (int i = 0; i < SIM_TIMERS; i++) {
+        if (timers[i].callback == callback) timers[i].callback = nullptr;
+    }
+}
+
+void simSetCpuMhz(uint32_t mhz) {
+    cpuMhz = mhz;
+}
+
+uint32_t simCpuMhz() {
+    return cpuMhz;
+}
+
+void simEpdStart(double ms) {
+    simEpdWait();
+    epdDoneUs = simState.trueUs + (int64_t)llround(ms * 1000.0);
+}
+
+bool simEpdBusy() {
+    return epdDoneUs > simState.trueUs;
+}
+
+void simEpdWait() {
+    if (simEpdBusy()) simAdvance((epdDoneUs - simState.trueUs) / 1000.0);
+}
+
+void simEpdPowerOff() {
+    if (simEpdBusy()) simLedger.epdCutMs = (epdDoneUs - simState.trueUs) / 1000.0;
+    epdDoneUs = -1;
+}
+
+void simSetRadio(bool on) {
+    radioOn = on;
+}
+
+bool simRadioOn() {
+    return radioOn;
+}
+
+double simLatency(double ms) {
+    if (simParams.jitter <= 0) return ms;
+    double u = (simRandom() / 4294967295.0) * 2.0 - 1.0;
+    return ms * (1.0 + simParams.jitter * u);
+}
+
+uint32_t simRandom() {
+    // xorshift64*
+    uint64_t& x = simState.rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+bool simChance(double probability) {
+    if (probability <= 0) return false;
+    return simRandom() < probability * 4294967296.0;
+}
+
+double simUptimeMs() {
+    return (simState.trueUs - simLedger.bootUs) / 1000.0 - simParams.bootMs;
+}
+
+int64_t simDeviceTimeUs() {
+    return simState.deviceUs;
+}
+
+// SNTP answers while the link is up; the clock steps to real time
+static void sntpAnswered() {
+    if (!simWifiConnected()) return;
+    simState.deviceUs = simState.trueUs;
+    simState.deviceClockSet = true;
+    simSntpSynced();
+}
+
+void simStartSntp() {
+    // A lost request never completes; the firmware times out and moves on
+    if (simChance(simParams.ntpFailRate)) {
+        simCancel(sntpAnswered);
+    } else {
+        simAfter(simLatency(simParams.ntpMs), sntpAnswered);
+    }
+}
+
+int simBatteryPercent() {
+    double left = 1.0 - simState.consumedMah / simParams.capacityMah;
+    if (left < 0) left = 0;
+    return (int)lround(left * 100.0);
+}
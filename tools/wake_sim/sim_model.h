@@ -0,0 +1,215 @@
+// Virtual clock, energy ledger and fault model shared by the SDK stand-ins
+// and the wake loop.
+//
+// Nothing sleeps for real: delay(), network latencies and blocking waits
+// advance the clock, and every advance charges the current drawn by the
+// loads that are on at that moment (CPU at its clock, radio, e-paper,
+// flash). Things that finish on their own, like a WiFi join, an SNTP
+// answer or a panel refresh, are due at a point on the clock and happen
+// when an advance reaches it.
+#ifndef WAKE_SIM_MODEL_H
+#define WAKE_SIM_MODEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Loads charged by the ledger
+enum SimLoad {
+    SIM_LOAD_CPU,    // Awake baseline (core, PSRAM, regulators)
+    SIM_LOAD_RADIO,  // WiFi from WIFI_STA to WIFI_OFF
+    SIM_LOAD_EPD,    // Panel refreshes
+    SIM_LOAD_FLASH,  // LittleFS writes
+    SIM_LOAD_SLEEP,  // Deep sleep floor
+    SIM_LOAD_COUNT
+};
+
+const char* simLoadName(int load);
+
+// Model parameters, all settable as name=value on the command line
+struct SimParams {
+    double days;               // Simulated span
+    double seed;               // Fault and jitter RNG seed
+    double start;              // Start time (Unix seconds, UTC)
+    double capacityMah;        // Battery capacity
+    double jitter;             // +/- fraction applied to every latency
+
+    double bootMs;             // ROM + bootloader + PSRAM init before setup()
+    double cpuMa;              // Awake current without radio or panel, 240 MHz
+    double cpuSlowMa;          // The same at 80 MHz and below
+    double sleepMa;            // Deep sleep current (whole board)
+    double m5BeginMs;          // M5.begin() core: board detect, PMIC, panel, touch
+    double imuInitMs;          // M5.begin() extras, each skipped when disabled
+    double rtcInitMs;
+    double audioInitMs;        // Speaker and microphone
+    double extProbeMs;         // Probing for external displays and units
+    double panelInitMs;        // Panel bring-up alone, without M5Unified
+
+    double radioMa;            // Extra current while the radio is on
+    double wifiConnectMs;      // Association + DHCP
+    double wifiFailRate;       // Chance the access point cannot be joined
+    double ntpMs;              // SNTP round trip
+    double ntpFailRate;        // Chance one NTP server does not answer
+    double dnsMs;              // Resolver round trip
+    double dnsFailRate;
+    double rttMs;              // Round trip to the API server
+    double tcpFailRate;        // Chance a TCP connect is refused
+    double tlsFullMs;          // Full handshake (ECDHE + RSA on the ESP32)
+    double tlsResumedMs;       // Abbreviated handshake
+    double tlsResumeRate;      // Chance the server accepts a cached session
+    double tlsStallRate;       // Chance a handshake never completes
+    double serverMs;           // API server think time per request
+    double linkKbps;           // Effective download rate
+    double httpErrorRate;      // Chance a request answers httpErrorCode
+    double httpErrorCode;
+    double httpStallRate;      // Chance a request is never answered
+    double keepAlive;          // 1 if the server keeps connections open
+    double forecastError;      // Forecast temperature error per day of lead (C)
+
+    double epdMa;              // Extra current while the panel refreshes
+    double epdFullMs;          // Full refresh in quality mode
+    double epdFastMs;          // Full refresh in fast/fastest mode
+    double epdPartialMs;       // Region refresh
+    double framePushMs;        // Canvas to panel transfer
+
+    double flashMa;            // Extra current during flash writes
+    double flashMsPerKb;       // Program + amortised erase time
+
+    double heapKb;             // Internal heap free when setup() starts
+    double psramKb;            // PSRAM free when setup() starts (0 = no PSRAM)
+    double wifiHeapKb;         // Internal heap the WiFi driver holds while on
+    double tlsHeapKb;          // Internal heap one TLS connection holds
+    double stackKb;            // Loop task stack
+
+    double rtcDriftPpm;        // Sleep timer error (+ = sleeps long)
+    double rtcDriftNoisePpm;   // +/- change of that error from sleep to sleep
+    double maxAwakeS;          // Watchdog: a wake this long is a hang
+};
+
+extern SimParams simParams;
+
+// Table of parameter names for parsing and --help
+struct SimParamInfo {
+    const char* name;
+    double SimParams::*field;
+    double defaultValue;
+    const char* help;
+};
+const SimParamInfo* simParamTable(size_t& count);
+void simParamsDefaults(SimParams& p);
+bool simParamSet(SimParams& p, const char* name, const char* value);
+
+// State that persists across wakes (owned by the wake loop, carried
+// through each wake's process and reported back)
+struct SimState {
+    int64_t trueUs;            // Real time, Unix microseconds
+    int64_t deviceUs;          // What the device clock reads
+    bool deviceClockSet;       // Set by SNTP at least once since power-on
+    bool timerWake;            // This wake was started by the sleep timer
+    uint32_t wakeIndex;
+    uint64_t rng;
+    double consumedMah;        // Battery drawn so far
+};
+
+extern SimState simState;
+
+// Per-wake accounting, reported back to the wake loop
+struct SimWakeLedger {
+    int64_t bootUs;            // trueUs at reset
+    double chargeMaMs[SIM_LOAD_COUNT];
+    double awakeMs;
+    double slowMs;             // Awake with the CPU at 80 MHz or below
+    double radioMs;
+    double epdMs;
+    double epdCutMs;           // Refresh time left when deep sleep started
+    uint32_t httpRequests;
+    uint32_t httpBytes;
+    uint32_t flashBytes;
+    uint32_t frames;           // Full frames drawn: a screen fill up to a full refresh
+    uint32_t frameAllocations; // Heap allocations while drawing them
+    uint64_t sleepUs;          // Timer requested before deep sleep (0 = none)
+    bool slept;
+    bool hung;                 // Watchdog fired
+};
+
+extern SimWakeLedger simLedger;
+
+// Start a wake: reset the ledger and charge the boot time
+void simBeginWake();
+
+// Advance the virtual clock with the current set of loads on
+void simAdvance(double ms);
+
+// Advance with one extra load on for the duration (flash)
+void simAdvanceWith(SimLoad load, double ms);
+
+// Run callback once ms from now, when an advance gets there. A callback
+// has one slot: scheduling it again moves it.
+void simAfter(double ms, void (*callback)());
+void simCancel(void (*callback)());
+
+// CPU clock (setCpuFrequencyMhz), which sets the CPU current
+void simSetCpuMhz(uint32_t mhz);
+uint32_t simCpuMhz();
+
+// Panel refresh running for ms alongside whatever the firmware does next.
+// One refresh at a time: a new one first waits for the last.
+void simEpdStart(double ms);
+bool simEpdBusy();
+void simEpdWait();
+
+// Deep sleep cuts the panel's power: note what was left of a refresh
+void simEpdPowerOff();
+
+// Pixels of the canvas last pushed to the panel (4 bpp rows, as the
+// firmware drew them), or null before the first push
+const uint8_t* simPanelPixels();
+
+void simSetRadio(bool on);
+bool simRadioOn();
+
+// Latency with the configured jitter applied
+double simLatency(double ms);
+
+// True with the given probability (deterministic per seed)
+bool simChance(double probability);
+uint32_t simRandom();
+
+// Milliseconds since the app started (millis(), esp_timer); like the chip,
+// this leaves out the ROM and bootloader time
+double simUptimeMs();
+
+// Device clock in seconds; SNTP completes on the clock when it is due
+int64_t simDeviceTimeUs();
+void simStartSntp();
+
+// Battery state for the fuel gauge
+int simBatteryPercent();
+
+// Heap and stack stand-ins (sim_memory.cpp). The internal heap counts
+// every host allocation made during the wake, plus what the WiFi and TLS
+// stand-ins reserve for the drivers they replace; ps_malloc() draws on
+// PSRAM. Neither models fragmentation: the largest free block is all that
+// is free. Host sizes are 64-bit, so figures run somewhat above the
+// device's. Not measured under AddressSanitizer.
+void simMemoryBeginWake();
+void simHeapReserve(double kb);
+void simHeapRelease(double kb);
+
+// Host allocations counted against the heap so far
+uint64_t simHeapAllocations();
+
+// Link state of the WiFi stand-in (sim_platform.cpp)
+bool simWifiConnected();
+
+// SNTP has just set the device clock (runs the firmware's callback)
+void simSntpSynced();
+
+// Destination of the firmware's Serial output (nullptr = discarded)
+extern FILE* simSerialLog;
+
+// Called from esp_deep_sleep_start() and the watchdog: hand the wake's
+// results to the wake loop and end the wake
+void simEndWake() __attribute__((noreturn));
+
+#endif // WAKE_SIM_MODEL_H
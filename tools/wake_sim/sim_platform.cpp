@@ -0,0 +1,719 @@
+// Implementations of the SDK stand-ins in host/: console, timing, sleep,
+// event groups, SNTP, WiFi, HTTP, NVS, LittleFS and the e-paper panel.
+#include "sim_model.h"
+#include "sim_server.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <Preferences.h>
+#include <LittleFS.h>
+#include <M5Unified.h>
+#include <esp_sntp.h>
+#include <freertos/event_groups.h>
+#include <dirent.h>
+#include <map>
+#include <stdarg.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+FILE* simSerialLog = nullptr;
+
+// --- Console ---
+
+HWCDC Serial;
+
+size_t HWCDC::write(const uint8_t* buf, size_t size) {
+    if (simSerialLog) fwrite(buf, 1, size, simSerialLog);
+    return size;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char stackBuf[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(stackBuf, sizeof(stackBuf), format, args);
+    va_end(args);
+    if (n < 0) return 0;
+    if ((size_t)n < sizeof(stackBuf)) return write((const uint8_t*)stackBuf, n);
+
+    std::vector<char> buf(n + 1);
+    va_start(args, format);
+    vsnprintf(buf.data(), buf.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)buf.data(), n);
+}
+
+// --- Timing, sleep and clock ---
+
+unsigned long millis() {
+    return (unsigned long)simUptimeMs();
+}
+
+unsigned long micros() {
+    return (unsigned long)(simUptimeMs() * 1000.0);
+}
+
+int64_t esp_timer_get_time() {
+    return (int64_t)(simUptimeMs() * 1000.0);
+}
+
+void delay(unsigned long ms) {
+    simAdvance(ms);
+}
+
+void delayMicroseconds(unsigned int us) {
+    simAdvance(us / 1000.0);
+}
+
+void yield() {
+}
+
+bool setCpuFrequencyMhz(uint32_t mhz) {
+    simSetCpuMhz(mhz);
+    return true;
+}
+
+uint32_t getCpuFrequencyMhz() {
+    return simCpuMhz();
+}
+
+uint32_t esp_random() {
+    return simRandom();
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+    return simState.timerWake ? ESP_SLEEP_WAKEUP_TIMER : ESP_SLEEP_WAKEUP_UNDEFINED;
+}
+
+int esp_sleep_enable_timer_wakeup(uint64_t timeUs) {
+    simLedger.sleepUs = timeUs;
+    return 0;
+}
+
+void esp_deep_sleep_start() {
+    simEpdPowerOff();
+    simLedger.slept = true;
+    simEndWake();
+}
+
+// The firmware reads the device clock through time(); this definition
+// takes precedence over the C library's
+extern "C" time_t time(time_t* t) __THROW {
+    time_t now = (time_t)(simDeviceTimeUs() / 1000000);
+    if (t) *t = now;
+    return now;
+}
+
+extern "C" int gettimeofday(struct timeval* tv, void*) __THROW {
+    int64_t us = simDeviceTimeUs();
+    tv->tv_sec = (time_t)(us / 1000000);
+    tv->tv_usec = (suseconds_t)(us % 1000000);
+    return 0;
+}
+
+extern "C" int settimeofday(const struct timeval* tv, const struct timezone*) __THROW {
+    simState.deviceUs = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+    simState.deviceClockSet = true;
+    return 0;
+}
+
+// --- Event groups ---
+
+struct SimEventGroup {
+    EventBits_t bits;
+};
+
+EventGroupHandle_t xEventGroupCreate() {
+    return new SimEventGroup();
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    return group->bits |= bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+                                BaseType_t waitForAll, TickType_t ticks) {
+    // The blocked task costs nothing beyond the CPU's current at its clock
+    for (TickType_t waited = 0;; waited++) {
+        EventBits_t set = group->bits & bits;
+        if (waitForAll ? set == bits : set != 0) {
+            EventBits_t all = group->bits;
+            if (clearOnExit) group->bits &= ~bits;
+            return all;
+        }
+        if (ticks != portMAX_DELAY && waited >= ticks) return group->bits;
+        simAdvance(1);
+    }
+}
+
+// --- SNTP ---
+
+static sntp_sync_time_cb_t sntpCallback = nullptr;
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback) {
+    sntpCallback = callback;
+}
+
+void simSntpSynced() {
+    if (!sntpCallback) return;
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    sntpCallback(&tv);
+}
+
+void configTzTime(const char* tz, const char* server1, const char*, const char*) {
+    setenv("TZ", tz, 1);
+    tzset();
+    if (server1) simStartSntp();
+}
+
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2, const char* server3) {
+    // Fixed offset, as the core builds it (POSIX TZ signs are inverted)
+    long offset = gmtOffsetSec + daylightOffsetSec;
+    long a = labs(offset);
+    char tz[32];
+    snprintf(tz, sizeof(tz), "SIM%c%ld:%02ld:%02ld", offset > 0 ? '-' : '+',
+             a / 3600, (a / 60) % 60, a % 60);
+    configTzTime(tz, server1, server2, server3);
+}
+
+// --- WiFi ---
+
+WiFiClass WiFi;
+
+static wifi_mode_t wifiMode = WIFI_OFF;
+static bool wifiJoining = false;
+static bool wifiJoinFails = false;
+static bool wifiLinkUp = false;
+
+struct WiFiHandler {
+    WiFiEventCb callback;
+    arduino_event_id_t event;
+};
+
+static std::vector<WiFiHandler> wifiHandlers;
+
+static void wifiRaise(arduino_event_id_t event) {
+    for (const WiFiHandler& h : wifiHandlers) {
+        if (h.event == event || h.event == ARDUINO_EVENT_MAX) h.callback(event);
+    }
+}
+
+static void wifiJoined() {
+    wifiLinkUp = true;
+    wifiRaise(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+}
+
+static void wifiLinkDown() {
+    simCancel(wifiJoined);
+    if (!wifiLinkUp) return;
+    wifiLinkUp = false;
+    wifiRaise(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+}
+
+bool simWifiConnected() {
+    return wifiMode != WIFI_OFF && wifiLinkUp;
+}
+
+bool WiFiClass::mode(wifi_mode_t m) {
+    if ((wifiMode == WIFI_OFF) != (m == WIFI_OFF)) {
+        if (m == WIFI_OFF) {
+            simHeapRelease(simParams.wifiHeapKb);
+        } else {
+            simHeapReserve(simParams.wifiHeapKb);
+        }
+    }
+    wifiMode = m;
+    simSetRadio(m != WIFI_OFF);
+    if (m == WIFI_OFF) {
+        wifiJoining = false;
+        wifiLinkDown();
+    }
+    return true;
+}
+
+wifi_mode_t WiFiClass::getMode() const {
+    return wifiMode;
+}
+
+wl_status_t WiFiClass::begin(const char*, const char*, int32_t, const uint8_t*, bool connect) {
+    if (wifiMode == WIFI_OFF) mode(WIFI_STA);
+    if (!connect) return WL_DISCONNECTED;
+    wifiLinkDown();
+    wifiJoining = true;
+    wifiJoinFails = simChance(simParams.wifiFailRate);
+    if (!wifiJoinFails) simAfter(simLatency(simParams.wifiConnectMs), wifiJoined);
+    return WL_DISCONNECTED;
+}
+
+wifi_event_id_t WiFiClass::onEvent(WiFiEventCb callback, arduino_event_id_t event) {
+    wifiHandlers.push_back({callback, event});
+    return (wifi_event_id_t)wifiHandlers.size();
+}
+
+wl_status_t WiFiClass::status() {
+    if (simWifiConnected()) return WL_CONNECTED;
+    return wifiJoining && wifiJoinFails ? WL_NO_SSID_AVAIL : WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool wifiOff, bool) {
+    wifiJoining = false;
+    wifiLinkDown();
+    if (wifiOff) mode(WIFI_OFF);
+    return true;
+}
+
+bool WiFiClass::config(IPAddress, IPAddress, IPAddress, IPAddress, IPAddress) {
+    return true;
+}
+
+IPAddress WiFiClass::localIP() {
+    return simWifiConnected() ? IPAddress(192, 168, 1, 50) : IPAddress();
+}
+
+IPAddress WiFiClass::gatewayIP() {
+    return simWifiConnected() ? IPAddress(192, 168, 1, 1) : IPAddress();
+}
+
+IPAddress WiFiClass::subnetMask() {
+    return IPAddress(255, 255, 255, 0);
+}
+
+IPAddress WiFiClass::dnsIP(uint8_t) {
+    return gatewayIP();
+}
+
+int32_t WiFiClass::channel() {
+    return 6;
+}
+
+uint8_t* WiFiClass::BSSID() {
+    static uint8_t bssid[6] = {0x02, 0x00, 0x00, 0x5E, 0x00, 0x01};
+    return simWifiConnected() ? bssid : nullptr;
+}
+
+int WiFiClass::hostByName(const char* host, IPAddress& result) {
+    if (!simWifiConnected()) return 0;
+    simAdvance(simLatency(simParams.dnsMs));
+    if (simChance(simParams.dnsFailRate)) return 0;
+    result = simServerAddress(host);
+    return 1;
+}
+
+// Plain clients only model the TCP connect; TlsClient adds the handshake
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    stop();
+    if (!simWifiConnected()) return 0;
+    simAdvance(simLatency(simParams.rttMs));
+    if (simChance(simParams.tcpFailRate)) return 0;
+    simOpen = true;
+    return 1;
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port, int32_t) {
+    return connect(ip, port);
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    IPAddress ip;
+    return WiFi.hostByName(host, ip) ? connect(ip, port) : 0;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port, int32_t) {
+    return connect(host, port);
+}
+
+int WiFiClient::read(uint8_t* buf, size_t size) {
+    size_t n = std::min(size, (size_t)available());
+    memcpy(buf, simRx.data() + simRxPos, n);
+    simRxPos += n;
+    return (int)n;
+}
+
+// --- HTTP ---
+
+bool HTTPClient::begin(WiFiClient& c, const String& u) {
+    client = &c;
+    url = u;
+    size = -1;
+    return true;
+}
+
+int HTTPClient::GET() {
+    if (!client || !client->connected() || !simWifiConnected()) {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+
+    std::string body;
+    int code = simServeRequest(url.c_str(), body);
+    if (code == HTTP_CODE_OK && simChance(simParams.httpErrorRate)) {
+        code = (int)simParams.httpErrorCode;
+        body = "{\"cod\":" + std::to_string(code) + ",\"message\":\"simulated error\"}";
+    }
+
+    // Request out, server time, response back at the link rate; a reply
+    // that does not start within the timeout is a read timeout
+    double responseMs = simLatency(simParams.rttMs + simParams.serverMs);
+    if (simChance(simParams.httpStallRate) || responseMs > timeoutMs) {
+        simAdvance(timeoutMs);
+        client->stop();
+        return HTTPC_ERROR_READ_TIMEOUT;
+    }
+    double transferMs = body.size() * 8.0 / simParams.linkKbps;
+    simAdvance(responseMs + transferMs);
+    simLedger.httpRequests++;
+    simLedger.httpBytes += body.size();
+
+    client->simQueueRx(body);
+    size = (int)body.size();
+    keepAlive = simParams.keepAlive > 0;
+    return code;
+}
+
+String HTTPClient::getString() {
+    if (!client) return String();
+    std::string body;
+    int c;
+    while ((c = client->read()) >= 0) body += (char)c;
+    return String(body);
+}
+
+int HTTPClient::writeToStream(Stream* stream) {
+    if (!client) return HTTPC_ERROR_NOT_CONNECTED;
+    if (!stream) return HTTPC_ERROR_NO_STREAM;
+    uint8_t buf[512];
+    int total = 0;
+    int n;
+    while ((n = client->read(buf, sizeof(buf))) > 0) {
+        stream->write(buf, n);
+        total += n;
+    }
+    return total;
+}
+
+void HTTPClient::end() {
+    if (client) {
+        client->simClearRx();
+        if (!reuse || !keepAlive) client->stop();
+    }
+    client = nullptr;
+}
+
+String HTTPClient::errorToString(int error) {
+    switch (error) {
+        case HTTPC_ERROR_CONNECTION_REFUSED: return String("connection refused");
+        case HTTPC_ERROR_SEND_HEADER_FAILED: return String("send header failed");
+        case HTTPC_ERROR_NOT_CONNECTED: return String("not connected");
+        case HTTPC_ERROR_CONNECTION_LOST: return String("connection lost");
+        case HTTPC_ERROR_READ_TIMEOUT: return String("read Timeout");
+        default: return String();
+    }
+}
+
+// --- NVS ---
+
+static std::map<std::string, std::vector<uint8_t>>& nvs() {
+    static std::map<std::string, std::vector<uint8_t>> store;
+    return store;
+}
+
+bool Preferences::begin(const char* name, bool ro) {
+    space = std::string(name) + "/";
+    readOnly = ro;
+    open = true;
+    return true;
+}
+
+bool Preferences::clear() {
+    if (!open || readOnly) return false;
+    auto& store = nvs();
+    for (auto it = store.begin(); it != store.end();) {
+        it = it->first.compare(0, space.size(), space) == 0 ? store.erase(it) : std::next(it);
+    }
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    return open && !readOnly && nvs().erase(space + key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    return open && nvs().count(space + key) > 0;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+    if (!open || readOnly) return 0;
+    const uint8_t* p = (const uint8_t*)value;
+    nvs()[space + key].assign(p, p + length);
+    return length;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    if (!open) return 0;
+    auto it = nvs().find(space + key);
+    return it == nvs().end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLength) {
+    if (!open) return 0;
+    auto it = nvs().find(space + key);
+    if (it == nvs().end() || it->second.size() > maxLength) return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+// --- LittleFS ---
+
+LittleFSFS LittleFS;
+
+namespace fs {
+
+struct FileImpl {
+    FILE* file = nullptr;
+    DIR* dir = nullptr;
+    std::string path;      // Path inside the filesystem
+    std::string hostPath;
+    std::string baseName;
+
+    ~FileImpl() {
+        if (file) fclose(file);
+        if (dir) closedir(dir);
+    }
+};
+
+size_t File::write(const uint8_t* buf, size_t size) {
+    if (!impl || !impl->file) return 0;
+    size_t n = fwrite(buf, 1, size, impl->file);
+    simLedger.flashBytes += n;
+    simAdvanceWith(SIM_LOAD_FLASH, n / 1024.0 * simParams.flashMsPerKb);
+    return n;
+}
+
+int File::available() {
+    if (!impl || !impl->file) return 0;
+    return (int)(size() - position());
+}
+
+int File::read() {
+    return impl && impl->file ? fgetc(impl->file) : -1;
+}
+
+int File::peek() {
+    if (!impl || !impl->file) return -1;
+    int c = fgetc(impl->file);
+    if (c >= 0) ungetc(c, impl->file);
+    return c;
+}
+
+size_t File::read(uint8_t* buf, size_t size) {
+    return impl && impl->file ? fread(buf, 1, size, impl->file) : 0;
+}
+
+void File::flush() {
+    if (impl && impl->file) fflush(impl->file);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    static const int WHENCE[] = {SEEK_SET, SEEK_CUR, SEEK_END};
+    return impl && impl->file && fseek(impl->file, pos, WHENCE[mode]) == 0;
+}
+
+size_t File::position() const {
+    return impl && impl->file ? (size_t)ftell(impl->file) : 0;
+}
+
+size_t File::size() const {
+    if (!impl || !impl->file) return 0;
+    struct stat st;
+    fflush(impl->file);
+    return fstat(fileno(impl->file), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+const char* File::name() const {
+    return impl ? impl->baseName.c_str() : "";
+}
+
+const char* File::path() const {
+    return impl ? impl->path.c_str() : "";
+}
+
+bool File::isDirectory() const {
+    return impl && impl->dir;
+}
+
+File File::openNextFile() {
+    if (!impl || !impl->dir) return File();
+    while (struct dirent* entry = readdir(impl->dir)) {
+        if (entry->d_name[0] == '.') continue;
+        std::string child = impl->path == "/" ? "/" : impl->path + "/";
+        return LittleFS.open((child + entry->d_name).c_str(), FILE_READ);
+    }
+    return File();
+}
+
+File FS::open(const char* path, const char* mode, bool) {
+    std::shared_ptr<FileImpl> impl(new FileImpl());
+    impl->path = path;
+    impl->hostPath = root + path;
+    const char* slash = strrchr(path, '/');
+    impl->baseName = slash ? slash + 1 : path;
+
+    struct stat st;
+    if (stat(impl->hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        impl->dir = opendir(impl->hostPath.c_str());
+        return impl->dir ? File(impl) : File();
+    }
+
+    const char* hostMode = strcmp(mode, "w") == 0    ? "wb"
+                           : strcmp(mode, "a") == 0  ? "ab"
+                           : strcmp(mode, "r+") == 0 ? "r+b"
+                                                     : "rb";
+    impl->file = fopen(impl->hostPath.c_str(), hostMode);
+    return impl->file ? File(impl) : File();
+}
+
+bool FS::exists(const char* path) {
+    struct stat st;
+    return stat((root + path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+    return ::remove((root + path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    return ::rename((root + from).c_str(), (root + to).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+    return ::mkdir((root + path).c_str(), 0755) == 0;
+}
+
+bool FS::rmdir(const char* path) {
+    return ::rmdir((root + path).c_str()) == 0;
+}
+
+} // namespace fs
+
+bool LittleFSFS::begin(bool, const char*, uint8_t, const char*) {
+    struct stat st;
+    return !root.empty() && stat(root.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool LittleFSFS::format() {
+    return false;
+}
+
+static size_t treeBytes(const std::string& dir) {
+    size_t total = 0;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return 0;
+    while (struct dirent* entry = readdir(d)) {
+        if (entry->d_name[0] == '.') continue;
+        std::string p = dir + "/" + entry->d_name;
+        struct stat st;
+        if (stat(p.c_str(), &st) != 0) continue;
+        total += S_ISDIR(st.st_mode) ? treeBytes(p) : (size_t)st.st_size;
+    }
+    closedir(d);
+    return total;
+}
+
+size_t LittleFSFS::usedBytes() {
+    return treeBytes(root);
+}
+
+// --- M5Unified ---
+
+M5UnifiedSim M5;
+
+namespace fonts {
+const lgfx::IFont Font0 = {6, 8}, Font2 = {8, 16}, Font4 = {14, 26};
+const lgfx::IFont FreeSans9pt7b = {10, 22}, FreeSans12pt7b = {13, 29};
+const lgfx::IFont FreeSans18pt7b = {20, 42}, FreeSans24pt7b = {27, 56};
+const lgfx::IFont FreeSansBold9pt7b = {11, 22}, FreeSansBold12pt7b = {14, 29};
+const lgfx::IFont FreeSansBold18pt7b = {21, 42}, FreeSansBold24pt7b = {28, 56};
+}
+
+void M5UnifiedSim::begin(const M5Config& cfg) {
+    double ms = simParams.m5BeginMs;
+    if (cfg.internal_imu || cfg.external_imu) ms += simParams.imuInitMs;
+    if (cfg.internal_rtc || cfg.external_rtc) ms += simParams.rtcInitMs;
+    if (cfg.internal_spk || cfg.internal_mic || cfg.external_spk) ms += simParams.audioInitMs;
+    const auto& ext = cfg.external_display;
+    if (ext.module_display || ext.atom_display || ext.unit_glass || ext.module_rca ||
+        ext.unit_oled || ext.unit_lcd || ext.unit_rca) {
+        ms += simParams.extProbeMs;
+    }
+    simAdvance(ms);
+}
+
+bool M5GFX::init_without_reset() {
+    simAdvance(simParams.panelInitMs);
+    return true;
+}
+
+// A full frame runs from a screen fill to the full refresh that shows it;
+// the heap allocations in between are charged to drawing
+static bool frameOpen = false;
+static uint64_t frameAllocationsAtStart = 0;
+
+void LovyanGFX::fillScreen(uint32_t) {
+    frameOpen = true;
+    frameAllocationsAtStart = simHeapAllocations();
+}
+
+void M5GFX::display() {
+    if (frameOpen) {
+        simLedger.frames++;
+        simLedger.frameAllocations += (uint32_t)(simHeapAllocations() - frameAllocationsAtStart);
+        frameOpen = false;
+    }
+    bool quality = mode == epd_mode_t::epd_quality || mode == epd_mode_t::epd_text;
+    simEpdStart(quality ? simParams.epdFullMs : simParams.epdFastMs);
+}
+
+void M5GFX::display(int32_t, int32_t, int32_t, int32_t) {
+    simEpdStart(simParams.epdPartialMs);
+}
+
+void M5GFX::waitDisplay() {
+    simEpdWait();
+}
+
+bool M5GFX::displayBusy() const {
+    return simEpdBusy();
+}
+
+static const uint8_t* panelPixels = nullptr;
+
+const uint8_t* simPanelPixels() {
+    return panelPixels;
+}
+
+void M5Canvas::pushSprite(LovyanGFX*, int32_t, int32_t) {
+    panelPixels = pixels;
+    simAdvance(simParams.framePushMs);
+}
+
+int M5Power::getBatteryLevel() {
+    return simBatteryPercent();
+}
+
+int16_t M5Power::getBatteryVoltage() {
+    // Rough Li-ion curve, enough for anything that shows a voltage
+    return (int16_t)(3300 + simBatteryPercent() * 9);
+}
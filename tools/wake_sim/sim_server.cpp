@@ -0,0 +1,295 @@
+#include "sim_server.h"
+#include "sim_model.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// --- Weather model (metric: degrees C, m/s) ---
+
+static double hash01(uint64_t key) {
+    // splitmix64
+    uint64_t z = key + (uint64_t)simParams.seed * 0x9E3779B97F4A7C15ULL + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return (z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Smooth 0..1 noise over time, one control point per period
+static double noise(double t, double periodSeconds, uint64_t channel) {
+    double x = t / periodSeconds;
+    int64_t i = (int64_t)floor(x);
+    double f = x - i;
+    double a = hash01((uint64_t)i * 131 + channel);
+    double b = hash01((uint64_t)(i + 1) * 131 + channel);
+    double w = (1 - cos(f * M_PI)) / 2;
+    return a + (b - a) * w;
+}
+
+static double dayOfYear(time_t t) {
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    return tm.tm_yday + (tm.tm_hour + tm.tm_min / 60.0) / 24.0;
+}
+
+struct Conditions {
+    double temp;
+    double feelsLike;
+    int humidity;
+    int pressure;
+    double windSpeed;
+    int windDeg;
+    double clouds;
+    double pop;
+    int weatherId;
+    const char* main;
+    const char* description;
+    const char* icon;
+};
+
+static void conditionsAt(time_t t, double lat, double lon, Conditions& c) {
+    double doy = dayOfYear(t);
+    double season = -cos(2 * M_PI * (doy - 20) / 365.25) * (lat < 0 ? -1 : 1);
+    double solarHour = fmod((t % 86400) / 3600.0 + lon / 15.0 + 48.0, 24.0);
+    double diurnal = cos(2 * M_PI * (solarHour - 15.0) / 24.0);
+
+    c.clouds = noise(t, 14 * 3600.0, 1);
+    c.temp = 9 + 12 * season + 6 * diurnal * (1 - 0.5 * c.clouds) + 10 * (noise(t, 3 * 86400.0, 2) - 0.5);
+    c.humidity = (int)lround(35 + 55 * c.clouds - 10 * diurnal);
+    c.pressure = (int)lround(1013 + 24 * (0.5 - noise(t, 2 * 86400.0, 3)));
+    c.windSpeed = 0.5 + 9 * noise(t, 9 * 3600.0, 4) * noise(t, 2 * 86400.0, 5);
+    c.windDeg = (int)(noise(t, 86400.0, 6) * 720) % 360;
+    c.feelsLike = c.temp - (c.temp < 10 ? 0.7 * c.windSpeed : 0);
+    c.pop = c.clouds > 0.6 ? (c.clouds - 0.6) * 2.5 : 0;
+
+    bool wet = c.clouds > 0.78;
+    bool cold = c.temp < 0.5;
+    if (wet && c.clouds > 0.9) {
+        c.weatherId = cold ? 601 : 501;
+        c.main = cold ? "Snow" : "Rain";
+        c.description = cold ? "snow" : "moderate rain";
+        c.icon = cold ? "13" : "10";
+    } else if (wet) {
+        c.weatherId = cold ? 600 : 500;
+        c.main = cold ? "Snow" : "Rain";
+        c.description = cold ? "light snow" : "light rain";
+        c.icon = cold ? "13" : "10";
+    } else if (c.clouds > 0.6) {
+        c.weatherId = 804; c.main = "Clouds"; c.description = "overcast clouds"; c.icon = "04";
+    } else if (c.clouds > 0.4) {
+        c.weatherId = 803; c.main = "Clouds"; c.description = "broken clouds"; c.icon = "04";
+    } else if (c.clouds > 0.25) {
+        c.weatherId = 802; c.main = "Clouds"; c.description = "scattered clouds"; c.icon = "03";
+    } else if (c.clouds > 0.12) {
+        c.weatherId = 801; c.main = "Clouds"; c.description = "few clouds"; c.icon = "02";
+    } else {
+        c.weatherId = 800; c.main = "Clear"; c.description = "clear sky"; c.icon = "01";
+    }
+}
+
+// A forecast issued at issued for time t: the truth plus an error that
+// grows with the lead time and changes with each 3-hourly model run
+static void forecastAt(time_t issued, time_t t, double lat, double lon, Conditions& c) {
+    conditionsAt(t, lat, lon, c);
+    time_t run = issued - issued % 10800;
+    double leadDays = t > run ? (t - run) / 86400.0 : 0;
+    double error = simParams.forecastError * leadDays * 2 * (noise(t, 18 * 3600.0, 7 + run / 10800 * 977) - 0.5);
+    c.temp += error;
+    c.feelsLike += error;
+}
+
+// Sunrise and sunset of the UTC day containing t
+static void sunTimes(time_t t, double lat, double lon, time_t& rise, time_t& set) {
+    double doy = dayOfYear(t);
+    double decl = 23.44 * M_PI / 180 * sin(2 * M_PI * (284 + doy) / 365.0);
+    double phi = lat * M_PI / 180;
+    double cosH = -tan(phi) * tan(decl);
+    if (cosH < -1) cosH = -1;
+    if (cosH > 1) cosH = 1;
+    double halfDayHours = acos(cosH) * 180 / M_PI / 15.0;
+    double noonUtc = 12.0 - lon / 15.0;
+    time_t midnight = t - t % 86400;
+    rise = midnight + (time_t)((noonUtc - halfDayHours) * 3600);
+    set = midnight + (time_t)((noonUtc + halfDayHours) * 3600);
+}
+
+static bool isNight(time_t t, double lat, double lon) {
+    time_t rise, set;
+    sunTimes(t, lat, lon, rise, set);
+    return t < rise || t > set;
+}
+
+// --- Request handling ---
+
+struct Query {
+    double lat = 0;
+    double lon = 0;
+    bool imperial = false;
+    bool hasKey = false;
+    int count = 40;
+};
+
+static std::string param(const char* url, const char* name) {
+    const char* q = strchr(url, '?');
+    size_t n = strlen(name);
+    for (const char* p = q; p; p = strchr(p + 1, '&')) {
+        if (strncmp(p + 1, name, n) == 0 && p[1 + n] == '=') {
+            const char* v = p + 2 + n;
+            return std::string(v, strcspn(v, "&"));
+        }
+    }
+    return std::string();
+}
+
+static double toUnits(double celsius, const Query& q) {
+    return q.imperial ? celsius * 9 / 5 + 32 : celsius;
+}
+
+static double speedUnits(double ms, const Query& q) {
+    return q.imperial ? ms * 2.23694 : ms;
+}
+
+static void append(std::string& out, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+static void append(std::string& out, const char* format, ...) {
+    char buf[512];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    out.append(buf, n < (int)sizeof(buf) ? n : sizeof(buf) - 1);
+}
+
+// The location keeps US Mountain time (DST from the second Sunday in
+// March to the first Sunday in November, at 2:00 local)
+static long utcOffsetAt(time_t t) {
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    int year = tm.tm_year;
+    auto sunday = [year](int mon, int nth) {
+        struct tm d = {};
+        d.tm_year = year;
+        d.tm_mon = mon;
+        d.tm_mday = 1;
+        time_t first = timegm(&d);
+        gmtime_r(&first, &d);
+        return first + (time_t)((7 - d.tm_wday) % 7 + 7 * (nth - 1)) * 86400;
+    };
+    time_t start = sunday(2, 2) + 9 * 3600;
+    time_t end = sunday(10, 1) + 8 * 3600;
+    return t >= start && t < end ? -6 * 3600 : -7 * 3600;
+}
+
+static void currentWeather(time_t now, const Query& q, std::string& out) {
+    // The API publishes a new observation about every 10 minutes
+    time_t dt = now - now % 600;
+    Conditions c;
+    bool night = isNight(dt, q.lat, q.lon);
+    conditionsAt(dt, q.lat, q.lon, c);
+    time_t rise, set;
+    sunTimes(dt, q.lat, q.lon, rise, set);
+
+    append(out, "{\"coord\":{\"lon\":%.4f,\"lat\":%.4f},", q.lon, q.lat);
+    append(out, "\"weather\":[{\"id\":%d,\"main\":\"%s\",\"description\":\"%s\",\"icon\":\"%s%c\"}],",
+           c.weatherId, c.main, c.description, c.icon, night ? 'n' : 'd');
+    append(out, "\"base\":\"stations\",\"main\":{\"temp\":%.2f,\"feels_like\":%.2f,\"temp_min\":%.2f,"
+           "\"temp_max\":%.2f,\"pressure\":%d,\"humidity\":%d,\"sea_level\":%d,\"grnd_level\":%d},",
+           toUnits(c.temp, q), toUnits(c.feelsLike, q), toUnits(c.temp - 1.2, q),
+           toUnits(c.temp + 0.9, q), c.pressure, c.humidity, c.pressure, c.pressure - 160);
+    append(out, "\"visibility\":10000,\"wind\":{\"speed\":%.2f,\"deg\":%d,\"gust\":%.2f},"
+           "\"clouds\":{\"all\":%d},\"dt\":%ld,",
+           speedUnits(c.windSpeed, q), c.windDeg, speedUnits(c.windSpeed * 1.6, q),
+           (int)lround(c.clouds * 100), (long)dt);
+    append(out, "\"sys\":{\"type\":2,\"id\":2004127,\"country\":\"US\",\"sunrise\":%ld,\"sunset\":%ld},"
+           "\"timezone\":%ld,\"id\":5579368,\"name\":\"Simulated\",\"cod\":200}",
+           (long)rise, (long)set, utcOffsetAt(dt));
+}
+
+static void forecast(time_t now, const Query& q, std::string& out) {
+    // 3-hourly slots from the next UTC multiple of 3 h
+    time_t first = now - now % 10800 + 10800;
+    int count = q.count < 1 ? 1 : q.count > 40 ? 40 : q.count;
+
+    append(out, "{\"cod\":\"200\",\"message\":0,\"cnt\":%d,\"list\":[", count);
+    for (int i = 0; i < count; i++) {
+        time_t dt = first + (time_t)i * 10800;
+        bool night = isNight(dt, q.lat, q.lon);
+        Conditions c;
+        forecastAt(now, dt, q.lat, q.lon, c);
+        struct tm tm;
+        gmtime_r(&dt, &tm);
+        char stamp[24];
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+
+        append(out, "%s{\"dt\":%ld,\"main\":{\"temp\":%.2f,\"feels_like\":%.2f,\"temp_min\":%.2f,"
+               "\"temp_max\":%.2f,\"pressure\":%d,\"sea_level\":%d,\"grnd_level\":%d,\"humidity\":%d,"
+               "\"temp_kf\":0},",
+               i ? "," : "", (long)dt, toUnits(c.temp, q), toUnits(c.feelsLike, q),
+               toUnits(c.temp - 0.6, q), toUnits(c.temp + 0.4, q), c.pressure, c.pressure,
+               c.pressure - 160, c.humidity);
+        append(out, "\"weather\":[{\"id\":%d,\"main\":\"%s\",\"description\":\"%s\",\"icon\":\"%s%c\"}],",
+               c.weatherId, c.main, c.description, c.icon, night ? 'n' : 'd');
+        append(out, "\"clouds\":{\"all\":%d},\"wind\":{\"speed\":%.2f,\"deg\":%d,\"gust\":%.2f},"
+               "\"visibility\":10000,\"pop\":%.2f,\"sys\":{\"pod\":\"%c\"},\"dt_txt\":\"%s\"}",
+               (int)lround(c.clouds * 100), speedUnits(c.windSpeed, q), c.windDeg,
+               speedUnits(c.windSpeed * 1.6, q), c.pop, night ? 'n' : 'd', stamp);
+    }
+    append(out, "],\"city\":{\"id\":5579368,\"name\":\"Simulated\",\"coord\":{\"lat\":%.4f,\"lon\":%.4f},"
+           "\"country\":\"US\",\"population\":0,\"timezone\":%ld}}", q.lat, q.lon,
+           utcOffsetAt(now));
+}
+
+double simServerCurrentTemp(time_t now, double lat, double lon, bool imperial) {
+    Query q;
+    q.imperial = imperial;
+    Conditions c;
+    conditionsAt(now - now % 600, lat, lon, c);
+    return toUnits(c.temp, q);
+}
+
+double simServerForecastTemp(time_t now, time_t t, double lat, double lon, bool imperial) {
+    // Linear between the slots, as the firmware reads the series
+    time_t slot = t - t % 10800;
+    double frac = (t - slot) / 10800.0;
+    Conditions a, b;
+    forecastAt(now, slot, lat, lon, a);
+    forecastAt(now, slot + 10800, lat, lon, b);
+    Query q;
+    q.imperial = imperial;
+    return toUnits(a.temp + (b.temp - a.temp) * frac, q);
+}
+
+uint32_t simServerAddress(const char*) {
+    return 0x0A0A0A0A;  // 10.10.10.10
+}
+
+int simServeRequest(const char* url, std::string& body) {
+    Query q;
+    q.lat = atof(param(url, "lat").c_str());
+    q.lon = atof(param(url, "lon").c_str());
+    q.imperial = param(url, "units") == "imperial";
+    q.hasKey = !param(url, "appid").empty();
+    std::string cnt = param(url, "cnt");
+    if (!cnt.empty()) q.count = atoi(cnt.c_str());
+
+    body.clear();
+    if (!q.hasKey) {
+        body = "{\"cod\":401,\"message\":\"Invalid API key\"}";
+        return 401;
+    }
+
+    // The server answers with real time, whatever the device clock says
+    time_t now = (time_t)(simState.trueUs / 1000000);
+    if (strstr(url, "/data/2.5/weather?")) {
+        currentWeather(now, q, body);
+        return 200;
+    }
+    if (strstr(url, "/data/2.5/forecast?")) {
+        forecast(now, q, body);
+        return 200;
+    }
+    body = "{\"cod\":\"404\",\"message\":\"Internal error\"}";
+    return 404;
+}
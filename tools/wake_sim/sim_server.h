@@ -0,0 +1,24 @@
+// Local stand-in for the OpenWeatherMap endpoints the firmware calls.
+// Responses are generated from the simulated time and the request's
+// coordinates, in the same shape (and roughly the same size) as the real
+// API, so the firmware's parsing, series and observation log all run on
+// plausible data.
+#ifndef WAKE_SIM_SERVER_H
+#define WAKE_SIM_SERVER_H
+
+#include <stdint.h>
+#include <string>
+#include <time.h>
+
+// Address the stand-in resolver returns for a host
+uint32_t simServerAddress(const char* host);
+
+// Answer a GET for url; returns the HTTP status and fills body
+int simServeRequest(const char* url, std::string& body);
+
+// What a fetch at now would show, in the display units: the current
+// temperature, and the forecast temperature for time t (between slots too)
+double simServerCurrentTemp(time_t now, double lat, double lon, bool imperial);
+double simServerForecastTemp(time_t now, time_t t, double lat, double lon, bool imperial);
+
+#endif // WAKE_SIM_SERVER_H
@@ -0,0 +1,168 @@
+// Host replacement for tls_client.cpp and tls_session_cache.cpp. The
+// handshake is a cost, not a protocol: full or abbreviated depending on
+// whether a cached session is offered and the server accepts it. The
+// session cache, logging and wake metrics behave as on the device.
+#include "sim_model.h"
+#include "dns_cache.h"
+#include "tls_client.h"
+#include "wake_budget.h"
+#include "wake_metrics.h"
+
+#define SIM_SESSION_MAGIC 0x53534C54  // "TLSS"
+#define SIM_SESSION_LENGTH 1071       // Size of a real serialized session
+#define SIM_CONNECT_TIMEOUT_MS 10000   // As in tls_client.cpp
+#define SIM_HANDSHAKE_TIMEOUT_MS 15000
+
+struct TlsConnection {
+};
+
+bool tlsSessionOffer(const TlsSessionCache& cache, const char* host, time_t now,
+                     uint32_t maxAgeSeconds, mbedtls_ssl_context*) {
+    if (cache.magic != SIM_SESSION_MAGIC || cache.length == 0) return false;
+    if (cache.hostHash != hostNameHash(host)) return false;
+    if (now < cache.savedAt || (uint32_t)(now - cache.savedAt) > maxAgeSeconds) return false;
+    return true;
+}
+
+bool tlsSessionSave(TlsSessionCache& cache, const char* host, time_t now,
+                    const mbedtls_ssl_context*) {
+    cache.magic = SIM_SESSION_MAGIC;
+    cache.hostHash = hostNameHash(host);
+    cache.savedAt = now;
+    cache.length = SIM_SESSION_LENGTH;
+    return true;
+}
+
+void tlsSessionInvalidate(TlsSessionCache& cache) {
+    cache.magic = 0;
+    cache.length = 0;
+}
+
+TlsClient::TlsClient()
+    : conn(nullptr), sessionCache(nullptr), sessionMaxAge(0), peeked(-1),
+      lastOffered(false), lastResumed(false), lastHandshakeMillis(0) {
+}
+
+TlsClient::~TlsClient() {
+    stop();
+}
+
+void TlsClient::setSessionCache(TlsSessionCache* cache, uint32_t maxAgeSeconds) {
+    sessionCache = cache;
+    sessionMaxAge = maxAgeSeconds;
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, const char* host) {
+    return open(ip, port, host, SIM_CONNECT_TIMEOUT_MS);
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port) {
+    return open(ip, port, nullptr, SIM_CONNECT_TIMEOUT_MS);
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, int32_t timeoutMs) {
+    return open(ip, port, nullptr, timeoutMs);
+}
+
+int TlsClient::connect(const char* host, uint16_t port) {
+    return connect(host, port, SIM_CONNECT_TIMEOUT_MS);
+}
+
+int TlsClient::connect(const char* host, uint16_t port, int32_t timeoutMs) {
+    IPAddress ip;
+    if (!WiFi.hostByName(host, ip)) return 0;
+    return open(ip, port, host, timeoutMs);
+}
+
+int TlsClient::open(IPAddress ip, uint16_t port, const char* host, uint32_t timeoutMs) {
+    stop();
+    if (!openSocket(ip, port, budgetClampMs(timeoutMs))) return 0;
+
+    bool offer = host && sessionCache &&
+                 tlsSessionOffer(*sessionCache, host, time(nullptr), sessionMaxAge, nullptr);
+    if (!handshake(host, offer, budgetClampMs(SIM_HANDSHAKE_TIMEOUT_MS))) {
+        closeConnection();
+        return 0;
+    }
+    return 1;
+}
+
+bool TlsClient::openSocket(IPAddress ip, uint16_t port, uint32_t timeoutMs) {
+    if (!WiFiClient::connect(ip, port)) return false;
+    conn = new TlsConnection();
+    simHeapReserve(simParams.tlsHeapKb);
+    return true;
+}
+
+bool TlsClient::handshake(const char* host, bool offerSession, uint32_t timeoutMs) {
+    unsigned long start = millis();
+    lastOffered = offerSession;
+    lastResumed = offerSession && simChance(simParams.tlsResumeRate);
+    double costMs = simLatency(lastResumed ? simParams.tlsResumedMs : simParams.tlsFullMs);
+    if (simChance(simParams.tlsStallRate) || costMs > timeoutMs) {
+        simAdvance(timeoutMs);
+        Serial.println("TLS: handshake timed out");
+        return false;
+    }
+    simAdvance(costMs);
+    lastHandshakeMillis = millis() - start;
+
+    WakeMetrics& metrics = wakeMetrics();
+    if (lastResumed) {
+        metrics.tlsResumedMillis += lastHandshakeMillis;
+        metrics.tlsResumedHandshakes++;
+    } else {
+        metrics.tlsFullMillis += lastHandshakeMillis;
+        metrics.tlsFullHandshakes++;
+    }
+    Serial.printf("TLS %s in %lu ms\n",
+                  lastResumed ? "resumed" : offerSession ? "session rejected, full" : "full",
+                  (unsigned long)lastHandshakeMillis);
+
+    if (host && sessionCache) {
+        tlsSessionSave(*sessionCache, host, time(nullptr), nullptr);
+    }
+    return true;
+}
+
+void TlsClient::closeConnection() {
+    if (conn) simHeapRelease(simParams.tlsHeapKb);
+    delete conn;
+    conn = nullptr;
+    WiFiClient::stop();
+}
+
+size_t TlsClient::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t TlsClient::write(const uint8_t* buf, size_t size) {
+    return WiFiClient::write(buf, size);
+}
+
+int TlsClient::available() {
+    return WiFiClient::available();
+}
+
+int TlsClient::read() {
+    return WiFiClient::read();
+}
+
+int TlsClient::read(uint8_t* buf, size_t size) {
+    return WiFiClient::read(buf, size);
+}
+
+int TlsClient::peek() {
+    return WiFiClient::peek();
+}
+
+void TlsClient::flush() {
+}
+
+void TlsClient::stop() {
+    closeConnection();
+}
+
+uint8_t TlsClient::connected() {
+    return conn && WiFiClient::connected() && simWifiConnected();
+}
@@ -0,0 +1,774 @@
+// Host-side wake simulator.
+//
+// Runs the firmware's real setup() on Linux, once per simulated wake, over
+// days or weeks of virtual time. The SDK stand-ins in host/ provide the
+// virtual clock, WiFi, SNTP, DNS, TLS and HTTP with configurable latency
+// and faults, a local stand-in for the weather API, and an e-paper panel
+// that only costs time and charge. Each wake runs in a forked process that
+// starts from the program's initial state; only the RTC_DATA_ATTR section
+// and the LittleFS directory carry over to the next wake, as on the device.
+//
+//   tools/wake_sim/build.sh                 builds tools/wake_sim/wake_sim
+//   wake_sim [name=value ...] [options]
+//
+//   name=value         model parameter (see --help for the list and defaults)
+//   --set key=value    firmware setting, as typed on the serial console
+//   --csv FILE         one row per wake
+//   --log FILE         firmware serial output of every wake
+//   --trace            one line per wake on stdout
+//   --frames DIR       each frame drawn, as a serialized display list
+//                      (display_list.h), one file per wake
+//   wake_sim --show FRAME.dl
+//                      lists the items of a frame saved with --frames
+//
+// Prints wake timing, time per update phase against the wake budget,
+// charge per component and the projected battery life, and how far the
+// values shown drift from what a fresh fetch would show (forecast_error
+// sets how wrong older forecasts get), and how much of the screen each
+// frame changes from the one before. Delays injected through the
+// latency, *_fail_rate and *_stall_rate parameters show up as phases
+// running over and ending the wake early.
+// Exits non-zero if a wake crashes or hangs, or goes to deep sleep while
+// the panel is still refreshing, so it can gate CI. Built with
+// -DWAKE_MEM_PROBES it also prints the lowest heap and stack per phase,
+// and a wake that goes below a MEM_BUDGET_* limit fails the run too.
+#include "sim_model.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "config.h"
+#include "display_manager.h"
+#include "mem_probe.h"
+#include "settings.h"
+#include "settings_store.h"
+#include "sim_server.h"
+#include "wake_arena.h"
+#include "wake_metrics.h"
+#include "weather_api.h"
+#include <cmath>
+#include <errno.h>
+#include <ftw.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+// Firmware entry points (main.cpp)
+void setup();
+void loop();
+
+// The firmware's weather data and display (main.cpp)
+extern WeatherAPI weatherAPI;
+extern DisplayManager display;
+
+// Linker-provided bounds of RTC_DATA_ATTR
+extern "C" uint8_t __start_rtc_sim_data[];
+extern "C" uint8_t __stop_rtc_sim_data[];
+
+#define RTC_SLOW_MEMORY_BYTES 8192
+#define MAX_CONSECUTIVE_HANGS 3
+
+// Weather values a wake put on the screen, minus what a fresh fetch at the
+// end of the wake would have shown
+struct ShownError {
+    bool valid;
+    bool rolled;               // Rebuilt from the cached forecast
+    double currentTemp;
+    int hourlyCount;
+    double hourlyTemp[12];
+};
+
+// What a wake hands back to the loop
+struct WakeReport {
+    SimState state;
+    SimWakeLedger ledger;
+    WakeMetrics metrics;
+    ArenaStats arena;
+    bool memSampled;
+    MemWakeRecord mem;
+    ShownError shown;
+    bool framed;               // A frame was recorded; frame holds it
+    DisplayList frame;
+};
+
+static int reportFd = -1;
+
+static bool writeAll(int fd, const void* data, size_t length) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (length > 0) {
+        ssize_t n = write(fd, p, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        length -= n;
+    }
+    return true;
+}
+
+static bool readAll(int fd, void* data, size_t length) {
+    uint8_t* p = (uint8_t*)data;
+    while (length > 0) {
+        ssize_t n = read(fd, p, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        length -= n;
+    }
+    return true;
+}
+
+static size_t rtcSize() {
+    return __stop_rtc_sim_data - __start_rtc_sim_data;
+}
+
+static void compareShown(ShownError& e) {
+    const WeatherData& data = weatherAPI.getData();
+    e = ShownError();
+    e.valid = data.valid && wakeMetrics().failure == FailureClass::None && !wakeMetrics().clockTick;
+    if (!e.valid) return;
+
+    const Settings& s = settings();
+    bool imperial = settingsImperial(s);
+    time_t now = (time_t)(simState.trueUs / 1000000);
+    e.rolled = data.rolledForward;
+    e.currentTemp = data.current.tempDeci / 10.0 - simServerCurrentTemp(now, s.lat, s.lon, imperial);
+    e.hourlyCount = data.hourlyCount;
+    for (int i = 0; i < data.hourlyCount; i++) {
+        e.hourlyTemp[i] = data.hourly[i].tempDeci / 10.0 -
+                          simServerForecastTemp(now, data.hourly[i].timestamp, s.lat, s.lon, imperial);
+    }
+}
+
+void simEndWake() {
+    if (simSerialLog) fflush(simSerialLog);
+    WakeReport report;
+    report.state = simState;
+    report.ledger = simLedger;
+    report.metrics = wakeMetrics();
+    report.arena = arenaStats();
+    const MemWakeRecord* mem = memProbeRecord();
+    report.memSampled = mem != nullptr;
+    if (mem) report.mem = *mem;
+    compareShown(report.shown);
+    const DisplayList& frame = display.lastFrame();
+    report.framed = frame.count > 0;
+    if (report.framed) report.frame = frame;
+    writeAll(reportFd, &report, sizeof(report));
+    writeAll(reportFd, __start_rtc_sim_data, rtcSize());
+    _exit(0);
+}
+
+// Run one wake in a child process; false if it crashed
+static bool runWake(WakeReport& report, int& status) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        exit(2);
+    }
+    if (simSerialLog) fflush(simSerialLog);
+    fflush(stdout);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(2);
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        reportFd = fds[1];
+        setenv("TZ", "UTC0", 1);
+        tzset();
+        simBeginWake();
+        setup();
+        for (;;) loop();  // Only a wake that never sleeps gets here; the watchdog ends it
+    }
+
+    close(fds[1]);
+    bool ok = readAll(fds[0], &report, sizeof(report)) &&
+              readAll(fds[0], __start_rtc_sim_data, rtcSize());
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+    return ok;
+}
+
+// --- Statistics ---
+
+struct Summary {
+    uint32_t wakes = 0;
+    uint32_t ok = 0;
+    uint32_t hangs = 0;
+    uint32_t failures[(int)FailureClass::Count] = {};
+    std::vector<double> awakeMs;
+    double chargeMaMs[SIM_LOAD_COUNT] = {};
+    double radioMs = 0;
+    double slowMs = 0;
+    uint32_t epdCut = 0;
+    uint32_t epdFull = 0;
+    uint32_t epdPartial = 0;
+    uint32_t dnsLookups = 0;
+    uint32_t tlsFull = 0;
+    uint32_t tlsResumed = 0;
+    uint64_t httpBytes = 0;
+    uint64_t flashBytes = 0;
+    std::vector<double> wakeErrorS;  // Scheduled wakes: seconds from the whole hour
+    std::vector<double> tickAwakeMs; // Clock tick wakes, kept out of the per wake figures
+    double tickMaMs = 0;
+    uint32_t rolled = 0;
+    std::vector<double> firstWorkMs[4];    // From reset, by boot profile
+    std::vector<double> currentError[2];  // |shown - fresh|, [0] fetched, [1] rolled forward
+    std::vector<double> hourlyError[2];
+    std::vector<double> phaseMs[(int)WakePhase::Count];  // Wakes that went through the phase
+    uint32_t overruns[(int)WakePhase::Count] = {};
+    uint32_t cachedFallbacks = 0;
+    std::vector<double> overrunAwakeMs;
+    std::vector<double> arenaPeak;     // Bytes, wakes that used the arena
+    uint64_t arenaAllocations = 0;
+    uint32_t arenaFallbacks = 0;
+    uint32_t frames = 0;
+    uint64_t frameAllocations = 0;
+    uint32_t frameAllocationsMax = 0;
+    std::vector<double> listItems;     // Frames recorded
+    uint32_t listTextMax = 0;
+    std::vector<double> listBytes;     // Serialized
+    uint32_t listOverflows = 0;
+    std::vector<double> changedPercent;  // Frames after another frame
+    std::vector<double> changedRegions;
+    uint32_t memWakes = 0;
+    uint8_t memSampled = 0;            // Bit per WakePhase
+    MemSample memLowest[(int)WakePhase::Count];
+    uint32_t memOverBudget = 0;
+};
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)lround(p * (v.size() - 1));
+    return v[i];
+}
+
+static double mean(const std::vector<double>& v) {
+    double sum = 0;
+    for (double x : v) sum += x;
+    return v.empty() ? 0 : sum / v.size();
+}
+
+static const char* resultName(const WakeReport& r) {
+    if (r.ledger.hung) return "hang";
+    if (r.metrics.clockTick) return "tick";
+    if (r.shown.valid && r.shown.rolled) return "rolled";
+    return r.metrics.failure == FailureClass::None ? "ok" : failureClassName(r.metrics.failure);
+}
+
+static void formatTime(int64_t us, char* buf, size_t size) {
+    time_t t = (time_t)(us / 1000000);
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(buf, size, "%Y-%m-%d %H:%M:%S", &tm);
+}
+
+static void printSummary(const Summary& s, double days, size_t rtcBytes, int budgetSeconds) {
+    double totalMaMs = 0;
+    for (int i = 0; i < SIM_LOAD_COUNT; i++) totalMaMs += s.chargeMaMs[i];
+    double totalMah = totalMaMs / 3.6e6;
+    double awakeMah = (totalMaMs - s.chargeMaMs[SIM_LOAD_SLEEP] - s.tickMaMs) / 3.6e6;
+    double perDay = days > 0 ? totalMah / days : 0;
+
+    printf("Simulated %.1f days, %u wakes: %u ok", days, s.wakes, s.ok);
+    for (int i = 1; i < (int)FailureClass::Count; i++) {
+        if (s.failures[i]) printf(", %u %s", s.failures[i], failureClassName((FailureClass)i));
+    }
+    if (s.hangs) printf(", %u hung", s.hangs);
+    if (s.rolled) printf(" (%u rolled forward)", s.rolled);
+    if (!s.tickAwakeMs.empty()) printf("; %zu clock ticks", s.tickAwakeMs.size());
+    printf("\n\n");
+
+    printf("Per wake:\n");
+    printf("  Awake:            mean %.2f s, p50 %.2f s, p95 %.2f s, max %.2f s\n",
+           mean(s.awakeMs) / 1000, percentile(s.awakeMs, 0.5) / 1000,
+           percentile(s.awakeMs, 0.95) / 1000, percentile(s.awakeMs, 1.0) / 1000);
+    if (s.wakes) {
+        printf("  Radio on:         %.2f s\n", s.radioMs / s.wakes / 1000);
+        printf("  CPU clocked down: %.2f s\n", s.slowMs / s.wakes / 1000);
+        printf("  Charge:           %.1f uAh\n", awakeMah * 1000 / s.wakes);
+        printf("  EPD refreshes:    %.2f full, %.2f partial\n",
+               (double)s.epdFull / s.wakes, (double)s.epdPartial / s.wakes);
+        if (s.epdCut) printf("  Refresh cut off:  %u wakes slept before the panel was done\n", s.epdCut);
+        printf("  DNS lookups:      %.2f\n", (double)s.dnsLookups / s.wakes);
+        printf("  TLS handshakes:   %.2f full, %.2f resumed\n",
+               (double)s.tlsFull / s.wakes, (double)s.tlsResumed / s.wakes);
+        printf("  Downloaded:       %.1f KB\n", s.httpBytes / 1024.0 / s.wakes);
+        printf("  Flash written:    %.1f KB\n", s.flashBytes / 1024.0 / s.wakes);
+    }
+    if (!s.wakeErrorS.empty()) {
+        std::vector<double> late;
+        size_t early = 0;
+        for (double e : s.wakeErrorS) {
+            late.push_back(std::fabs(e));
+            if (e < 0) early++;
+        }
+        printf("  Scheduled wakes:  %.1f s from the hour on average, p95 %.1f s, max %.1f s, %zu early\n",
+               mean(late), percentile(late, 0.95), percentile(late, 1.0), early);
+    }
+
+    if (!s.tickAwakeMs.empty()) {
+        printf("\nPer clock tick:\n");
+        printf("  Awake:            mean %.0f ms, p95 %.0f ms, max %.0f ms\n",
+               mean(s.tickAwakeMs), percentile(s.tickAwakeMs, 0.95), percentile(s.tickAwakeMs, 1.0));
+        printf("  Charge:           %.1f uAh\n", s.tickMaMs / 3.6e3 / s.tickAwakeMs.size());
+    }
+
+    printf("\nFirst useful work, from reset:\n");
+    for (int p = 1; p < 4; p++) {
+        const std::vector<double>& v = s.firstWorkMs[p];
+        if (v.empty()) continue;
+        printf("  %-12s      mean %.0f ms, p95 %.0f ms (%zu wakes)\n", bootProfileName((BootProfile)p),
+               mean(v), percentile(v, 0.95), v.size());
+    }
+
+    printf("\nUpdate phases, wake budget %d s (mean / max):\n", budgetSeconds);
+    for (int p = 1; p < (int)WakePhase::Count; p++) {
+        const std::vector<double>& v = s.phaseMs[p];
+        if (v.empty()) continue;
+        printf("  %-8s          %.2f / %.2f s (%zu wakes", wakePhaseName((WakePhase)p), mean(v) / 1000,
+               percentile(v, 1.0) / 1000, v.size());
+        if (s.overruns[p]) printf(", %u over", s.overruns[p]);
+        printf(")\n");
+    }
+    if (!s.overrunAwakeMs.empty()) {
+        printf("  Over budget:      %zu wakes, awake max %.2f s\n", s.overrunAwakeMs.size(),
+               percentile(s.overrunAwakeMs, 1.0) / 1000);
+    }
+    if (s.cachedFallbacks) {
+        printf("  Failed wakes that showed the cached forecast: %u\n", s.cachedFallbacks);
+    }
+
+    if (!s.arenaPeak.empty()) {
+        printf("\nWake arena, %d KB:\n", WAKE_ARENA_BYTES / 1024);
+        printf("  Allocations:      %.0f per wake\n", (double)s.arenaAllocations / s.arenaPeak.size());
+        printf("  Peak:             mean %.1f KB, max %.1f KB\n", mean(s.arenaPeak) / 1024,
+               percentile(s.arenaPeak, 1.0) / 1024);
+        printf("  From the heap:    %u\n", s.arenaFallbacks);
+    }
+
+    if (s.frames) {
+        printf("\nDrawing, %u full frames:\n", s.frames);
+#ifndef __SANITIZE_ADDRESS__
+        printf("  Heap allocations: mean %.1f, max %u per frame\n",
+               (double)s.frameAllocations / s.frames, s.frameAllocationsMax);
+#endif
+    }
+    if (!s.listItems.empty()) {
+        printf("  Display list:     mean %.0f, max %.0f of %d items; text max %u of %d B\n",
+               mean(s.listItems), percentile(s.listItems, 1.0), DISPLAY_LIST_MAX_ITEMS,
+               s.listTextMax, DISPLAY_LIST_TEXT_BYTES);
+        printf("  Stored:           mean %.1f KB, max %.1f KB per frame\n", mean(s.listBytes) / 1024,
+               percentile(s.listBytes, 1.0) / 1024);
+        if (s.listOverflows) printf("  Overflowed:       %u frames lost items\n", s.listOverflows);
+    }
+    if (!s.changedPercent.empty()) {
+        printf("  Changed:          mean %.1f%%, p95 %.1f%% of the screen in %.1f regions, from the frame before\n",
+               mean(s.changedPercent), percentile(s.changedPercent, 0.95), mean(s.changedRegions));
+    }
+
+    if (s.memWakes) {
+        printf("\nMemory, lowest over %u wakes (internal KB free / lowest / block, PSRAM KB lowest, stack B):\n",
+               s.memWakes);
+        for (int p = 0; p < (int)WakePhase::Count; p++) {
+            if (!(s.memSampled & (1 << p))) continue;
+            const MemSample& m = s.memLowest[p];
+            printf("  %-8s          %6.1f / %6.1f / %6.1f   %6lu   %5lu\n",
+                   p ? wakePhaseName((WakePhase)p) : "start", m.internalFree / 1024.0,
+                   m.internalMinFree / 1024.0, m.internalLargest / 1024.0,
+                   (unsigned long)m.psramMinFree / 1024, (unsigned long)m.stackFree);
+        }
+        printf("  Over budget:      %u wakes (heap %d KB, block %d KB, stack %d B)\n", s.memOverBudget,
+               MEM_BUDGET_INTERNAL_FREE / 1024, MEM_BUDGET_INTERNAL_BLOCK / 1024, MEM_BUDGET_STACK_FREE);
+    }
+
+    printf("\nShown vs a fresh fetch (|difference|, mean / p95):\n");
+    static const char* KIND[2] = {"fetched", "rolled"};
+    for (int k = 0; k < 2; k++) {
+        if (s.currentError[k].empty()) continue;
+        printf("  %-8s current  %.2f / %.2f deg, hourly %.2f / %.2f deg\n", KIND[k],
+               mean(s.currentError[k]), percentile(s.currentError[k], 0.95),
+               mean(s.hourlyError[k]), percentile(s.hourlyError[k], 0.95));
+    }
+
+    printf("\nCharge per day:\n");
+    for (int i = 0; i < SIM_LOAD_COUNT; i++) {
+        double mah = s.chargeMaMs[i] / 3.6e6;
+        printf("  %-6s            %7.3f mAh (%4.1f%%)\n", simLoadName(i),
+               days > 0 ? mah / days : 0, totalMah > 0 ? 100 * mah / totalMah : 0);
+    }
+    printf("  total             %7.3f mAh\n", perDay);
+
+    printf("\nProjected battery life: %.0f days (%.0f mAh)\n",
+           perDay > 0 ? simParams.capacityMah / perDay : 0, simParams.capacityMah);
+    printf("RTC memory:             %zu of %d bytes%s\n", rtcBytes, RTC_SLOW_MEMORY_BYTES,
+           rtcBytes > RTC_SLOW_MEMORY_BYTES ? "  ** over **" : "");
+}
+
+// --- Setup ---
+
+static int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+    return remove(path);
+}
+
+// Screen area (percent) and number of the regions where frame b differs
+// from a; the regions do not overlap
+static void diffFrames(const DisplayList& a, const DisplayList& b, double& percent, int& count) {
+    DlRect regions[16];
+    count = dlDiff(a, b, regions, 16);
+
+    long pixels = 0;
+    for (int i = 0; i < count; i++) {
+        int x0 = std::max<int>(regions[i].x, 0);
+        int y0 = std::max<int>(regions[i].y, 0);
+        int x1 = std::min<int>(regions[i].x + regions[i].w, DISPLAY_WIDTH);
+        int y1 = std::min<int>(regions[i].y + regions[i].h, DISPLAY_HEIGHT);
+        if (x1 > x0 && y1 > y0) pixels += (long)(x1 - x0) * (y1 - y0);
+    }
+    percent = 100.0 * pixels / (DISPLAY_WIDTH * DISPLAY_HEIGHT);
+}
+
+static bool writeFrame(const char* dir, uint32_t index, const DisplayList& frame) {
+    static uint8_t buffer[sizeof(DisplayList) + 64];
+    size_t length = dlSerialize(frame, buffer, sizeof(buffer));
+    char path[512];
+    snprintf(path, sizeof(path), "%s/wake-%05u.dl", dir, index);
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    bool ok = length > 0 && fwrite(buffer, 1, length, f) == length;
+    return fclose(f) == 0 && ok;
+}
+
+// Print a frame saved with --frames, one item per line
+static int showFrame(const char* path) {
+    static uint8_t buffer[sizeof(DisplayList) + 64];
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    size_t length = fread(buffer, 1, sizeof(buffer), f);
+    fclose(f);
+
+    static DisplayList frame;
+    if (!dlDeserialize(buffer, length, frame)) {
+        fprintf(stderr, "%s: not a display list\n", path);
+        return 1;
+    }
+
+    static const char* const OP_NAMES[] = {"line", "rect", "fill_rect", "circle", "fill_circle",
+                                           "fill_triangle", "shade", "text", "icon"};
+    printf("%s: %u items, %u text bytes\n", path, (unsigned)frame.count, (unsigned)frame.textUsed);
+    for (int i = 0; i < frame.count; i++) {
+        const DlItem& item = frame.items[i];
+        DlRect bounds = dlItemBounds(item);
+        printf("%4d %-13s %4d,%-4d %4dx%-4d color %04x style %u", i, OP_NAMES[(int)item.op], bounds.x,
+               bounds.y, bounds.w, bounds.h, item.color, item.style);
+        if (item.op == DlOp::Text) printf(" \"%s\"", dlItemText(frame, item));
+        if (item.op == DlOp::Icon) printf(" id %u moon %u", item.arg, (uint16_t)item.x1);
+        printf("\n");
+    }
+    return 0;
+}
+
+static void usage() {
+    printf("usage: wake_sim [name=value ...] [--set key=value] [--csv FILE] [--log FILE] [--trace]\n"
+           "                [--frames DIR]\n"
+           "       wake_sim --show FRAME.dl\n\n");
+    printf("Model parameters:\n");
+    size_t count;
+    const SimParamInfo* table = simParamTable(count);
+    for (size_t i = 0; i < count; i++) {
+        printf("  %-18s %-12g %s\n", table[i].name, table[i].defaultValue, table[i].help);
+    }
+}
+
+int main(int argc, char** argv) {
+    simParamsDefaults(simParams);
+
+    // Provisioned like a device on the bench; --set overrides
+    Settings settings;
+    settingsDefaults(settings);
+    settingsSet(settings, "ssid", "simulated");
+    settingsSet(settings, "password", "simulated");
+    settingsSet(settings, "apikey", "simulated");
+
+    const char* csvPath = nullptr;
+    const char* logPath = nullptr;
+    const char* framesDir = nullptr;
+    bool trace = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            usage();
+            return 0;
+        } else if (strcmp(arg, "--show") == 0 && i + 1 < argc) {
+            return showFrame(argv[i + 1]);
+        } else if (strcmp(arg, "--trace") == 0) {
+            trace = true;
+        } else if (strcmp(arg, "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (strcmp(arg, "--log") == 0 && i + 1 < argc) {
+            logPath = argv[++i];
+        } else if (strcmp(arg, "--frames") == 0 && i + 1 < argc) {
+            framesDir = argv[++i];
+        } else if (strcmp(arg, "--set") == 0 && i + 1 < argc) {
+            std::string kv = argv[++i];
+            size_t eq = kv.find('=');
+            if (eq == std::string::npos ||
+                !settingsSet(settings, kv.substr(0, eq).c_str(), kv.substr(eq + 1).c_str())) {
+                fprintf(stderr, "bad setting: %s\n", kv.c_str());
+                return 1;
+            }
+        } else {
+            std::string kv = arg;
+            size_t eq = kv.find('=');
+            if (eq == std::string::npos ||
+                !simParamSet(simParams, kv.substr(0, eq).c_str(), kv.substr(eq + 1).c_str())) {
+                fprintf(stderr, "bad parameter: %s (see --help)\n", arg);
+                return 1;
+            }
+        }
+    }
+
+    FILE* csv = nullptr;
+    if (csvPath && !(csv = fopen(csvPath, "w"))) {
+        perror(csvPath);
+        return 1;
+    }
+    if (logPath && !(simSerialLog = fopen(logPath, "w"))) {
+        perror(logPath);
+        return 1;
+    }
+
+    // Scratch directory standing in for the LittleFS partition
+    char fsRoot[] = "/tmp/wake_sim.XXXXXX";
+    if (!mkdtemp(fsRoot)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    LittleFS.setRoot(fsRoot);
+
+    SettingsStore store;
+    if (!store.save(settings)) {
+        fprintf(stderr, "settings rejected by the firmware\n");
+        return 1;
+    }
+
+    // Power-on at the start time with an unset clock
+    simState.trueUs = (int64_t)simParams.start * 1000000;
+    simState.deviceUs = 0;
+    simState.deviceClockSet = false;
+    simState.timerWake = false;
+    simState.rng = (uint64_t)simParams.seed * 0x9E3779B97F4A7C15ULL | 1;
+    simState.consumedMah = 0;
+    const int64_t endUs = simState.trueUs + (int64_t)(simParams.days * 86400e6);
+
+    if (csv) {
+        fprintf(csv, "wake,time_utc,cause,result,awake_ms,radio_ms,epd_ms,epd_full,epd_partial,"
+                     "dns_lookups,tls_full,tls_resumed,http_bytes,flash_bytes,charge_uah,sleep_s\n");
+    }
+
+    Summary summary;
+    static DisplayList lastFrame;
+    bool haveLastFrame = false;
+    int hangStreak = 0;
+    int exitCode = 0;
+    bool lastWakeOk = false;
+
+    while (simState.trueUs < endUs) {
+        if (simSerialLog) {
+            char when[32];
+            formatTime(simState.trueUs, when, sizeof(when));
+            fprintf(simSerialLog, "\n===== wake %u at %s UTC =====\n", simState.wakeIndex, when);
+        }
+
+        WakeReport r;
+        int status;
+        if (!runWake(r, status)) {
+            fprintf(stderr, "wake %u crashed (%s %d)\n", simState.wakeIndex,
+                    WIFSIGNALED(status) ? "signal" : "exit status",
+                    WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status));
+            exitCode = 2;
+            break;
+        }
+
+        bool timerWake = simState.timerWake;
+        uint32_t index = simState.wakeIndex;
+        simState = r.state;
+        const SimWakeLedger& w = r.ledger;
+
+        double wakeMaMs = 0;
+        for (int i = 0; i < SIM_LOAD_COUNT; i++) {
+            summary.chargeMaMs[i] += w.chargeMaMs[i];
+            wakeMaMs += w.chargeMaMs[i];
+        }
+        simState.consumedMah += wakeMaMs / 3.6e6;
+        bool tick = !w.hung && r.metrics.clockTick;
+        int profile = (int)r.metrics.bootProfile;
+        if (profile > 0 && profile < 4) {
+            summary.firstWorkMs[profile].push_back(simParams.bootMs + r.metrics.firstWorkMs);
+        }
+        if (tick) {
+            summary.tickAwakeMs.push_back(w.awakeMs);
+            summary.tickMaMs += wakeMaMs;
+        } else {
+            summary.wakes++;
+            summary.awakeMs.push_back(w.awakeMs);
+            summary.radioMs += w.radioMs;
+            summary.slowMs += w.slowMs;
+            summary.epdFull += r.metrics.epdFullRefreshes;
+            summary.epdPartial += r.metrics.epdPartialRefreshes;
+            summary.dnsLookups += r.metrics.dnsLookups;
+            summary.tlsFull += r.metrics.tlsFullHandshakes;
+            summary.tlsResumed += r.metrics.tlsResumedHandshakes;
+            summary.httpBytes += w.httpBytes;
+            summary.flashBytes += w.flashBytes;
+            for (int p = 1; p < (int)WakePhase::Count; p++) {
+                if (r.metrics.phaseMs[p]) summary.phaseMs[p].push_back(r.metrics.phaseMs[p]);
+            }
+            if (!w.hung && r.metrics.overrun != WakePhase::None) {
+                summary.overruns[(int)r.metrics.overrun]++;
+                summary.overrunAwakeMs.push_back(w.awakeMs);
+            }
+            if (!w.hung && r.metrics.cachedFallback) summary.cachedFallbacks++;
+            if (r.arena.allocations || r.arena.fallbacks) {
+                summary.arenaPeak.push_back(r.arena.peak);
+                summary.arenaAllocations += r.arena.allocations;
+                summary.arenaFallbacks += r.arena.fallbacks;
+            }
+            if (w.frames) {
+                summary.frames += w.frames;
+                summary.frameAllocations += w.frameAllocations;
+                summary.frameAllocationsMax = std::max(summary.frameAllocationsMax, w.frameAllocations);
+            }
+            if (w.hung) {
+                summary.hangs++;
+            } else if (r.metrics.failure == FailureClass::None) {
+                summary.ok++;
+                if (r.shown.rolled) summary.rolled++;
+            } else {
+                summary.failures[(int)r.metrics.failure]++;
+            }
+
+            // Update hours are whole local hours, so a scheduled wake (one after
+            // a successful wake) should land just past a whole UTC hour
+            if (timerWake && lastWakeOk) {
+                double e = fmod(w.bootUs / 1e6, 3600.0);
+                summary.wakeErrorS.push_back(e >= 1800 ? e - 3600 : e);
+            }
+            lastWakeOk = !w.hung && r.metrics.failure == FailureClass::None;
+
+            if (!w.hung && r.shown.valid) {
+                int k = r.shown.rolled ? 1 : 0;
+                summary.currentError[k].push_back(std::fabs(r.shown.currentTemp));
+                for (int i = 0; i < r.shown.hourlyCount; i++) {
+                    summary.hourlyError[k].push_back(std::fabs(r.shown.hourlyTemp[i]));
+                }
+            }
+        }
+
+        // Deep sleep on the RTC timer (which drifts), or a watchdog reset
+        uint64_t sleepUs = w.hung ? 0 : w.sleepUs;
+        double noise = simParams.rtcDriftNoisePpm > 0
+                           ? simParams.rtcDriftNoisePpm * ((simRandom() / 4294967295.0) * 2.0 - 1.0)
+                           : 0;
+        int64_t realSleepUs = (int64_t)(sleepUs * (1.0 + (simParams.rtcDriftPpm + noise) * 1e-6));
+        int64_t countedUs = std::min(realSleepUs, std::max<int64_t>(0, endUs - simState.trueUs));
+        double sleepMaMs = simParams.sleepMa * countedUs / 1000.0;
+        summary.chargeMaMs[SIM_LOAD_SLEEP] += sleepMaMs;
+        simState.consumedMah += sleepMaMs / 3.6e6;
+        simState.trueUs += realSleepUs;
+        simState.deviceUs += sleepUs;
+        simState.timerWake = !w.hung;
+        simState.wakeIndex = index + 1;
+
+        char when[32];
+        formatTime(w.bootUs, when, sizeof(when));
+        if (csv) {
+            fprintf(csv, "%u,%s,%s,%s,%.0f,%.0f,%.0f,%u,%u,%u,%u,%u,%u,%u,%.1f,%.0f\n",
+                    index, when, timerWake ? "timer" : "reset", resultName(r), w.awakeMs, w.radioMs,
+                    w.epdMs, r.metrics.epdFullRefreshes, r.metrics.epdPartialRefreshes,
+                    r.metrics.dnsLookups, r.metrics.tlsFullHandshakes, r.metrics.tlsResumedHandshakes,
+                    w.httpBytes, w.flashBytes, wakeMaMs / 3.6e3, sleepUs / 1e6);
+        }
+        if (trace) {
+            printf("%5u %s %-5s %-9s awake %6.2f s  radio %5.2f s  %6.1f uAh  sleep %6.0f s\n",
+                   index, when, timerWake ? "timer" : "reset", resultName(r), w.awakeMs / 1000,
+                   w.radioMs / 1000, wakeMaMs / 3.6e3, sleepUs / 1e6);
+        }
+
+        if (!w.hung && r.framed) {
+            const DisplayList& frame = r.frame;
+            summary.listItems.push_back(frame.count);
+            summary.listTextMax = std::max<uint32_t>(summary.listTextMax, frame.textUsed);
+            summary.listBytes.push_back(dlSerializedSize(frame));
+            if (frame.overflowed) summary.listOverflows++;
+            if (haveLastFrame) {
+                double percent;
+                int regions;
+                diffFrames(lastFrame, frame, percent, regions);
+                summary.changedPercent.push_back(percent);
+                summary.changedRegions.push_back(regions);
+            }
+            lastFrame = frame;
+            haveLastFrame = true;
+            if (framesDir && !writeFrame(framesDir, index, frame)) exitCode = 2;
+        }
+
+        if (r.memSampled) {
+            summary.memWakes++;
+            for (int p = 0; p < (int)WakePhase::Count; p++) {
+                if (!(r.mem.sampled & (1 << p))) continue;
+                const MemSample& m = r.mem.samples[p];
+                MemSample& low = summary.memLowest[p];
+                if (!(summary.memSampled & (1 << p))) {
+                    low = m;
+                    summary.memSampled |= 1 << p;
+                    continue;
+                }
+                low.internalFree = std::min(low.internalFree, m.internalFree);
+                low.internalMinFree = std::min(low.internalMinFree, m.internalMinFree);
+                low.internalLargest = std::min(low.internalLargest, m.internalLargest);
+                low.psramMinFree = std::min(low.psramMinFree, m.psramMinFree);
+                low.stackFree = std::min(low.stackFree, m.stackFree);
+            }
+            WakePhase phase;
+            const char* what;
+            if (memProbeOverBudget(r.mem, phase, what)) {
+                fprintf(stderr, "wake %u: %s below budget in %s\n", index, what,
+                        phase == WakePhase::None ? "start" : wakePhaseName(phase));
+                summary.memOverBudget++;
+                exitCode = 2;
+            }
+        }
+
+        if (w.epdCutMs > 0) {
+            fprintf(stderr, "wake %u: deep sleep %.0f ms before the panel refresh ended\n", index,
+                    w.epdCutMs);
+            summary.epdCut++;
+            exitCode = 2;
+        }
+
+        hangStreak = w.hung ? hangStreak + 1 : 0;
+        if (w.hung) exitCode = 2;
+        if (hangStreak >= MAX_CONSECUTIVE_HANGS) {
+            fprintf(stderr, "%d consecutive wakes hung, giving up\n", hangStreak);
+            break;
+        }
+    }
+
+    if (trace) printf("\n");
+    double days = (std::min(simState.trueUs, endUs) - (int64_t)simParams.start * 1000000) / 86400e6;
+    printSummary(summary, days, rtcSize(), settings.wakeBudgetSeconds);
+
+    if (csv) fclose(csv);
+    if (simSerialLog) fclose(simSerialLog);
+    nftw(fsRoot, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    return exitCode;
+}